@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Actors/Public/BombFieldActor.h"
+#include "Components/SphereComponent.h"
+#include "Field/FieldSystemComponent.h"
+#include "Field/FieldSystemObjects.h"
+#include "Steelheart/Steelheart.h"
+
+DECLARE_CYCLE_STAT(TEXT("Bomb Field Explode"), STAT_BombFieldExplode, STATGROUP_Steelheart);
+
+ABombFieldActor::ABombFieldActor(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	Sphere = CreateDefaultSubobject<USphereComponent>(TEXT("Sphere"));
+	Sphere->SetupAttachment(GetFieldSystemComponent());
+	Sphere->SetSphereRadius(1000.f);
+
+	RadialFalloff = CreateDefaultSubobject<URadialFalloff>(TEXT("RadialFalloff"));
+	RadialVector = CreateDefaultSubobject<URadialVector>(TEXT("RadialVector"));
+	CullingField = CreateDefaultSubobject<UCullingField>(TEXT("CullingField"));
+}
+
+void ABombFieldActor::Explode()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BombFieldExplode);
+
+	FVector SphereLoc = Sphere->GetComponentLocation();
+
+	// Strain the clusters within the sphere
+	UFieldNodeBase* RadialFalloffNode = RadialFalloff->SetRadialFalloff(FalloffMagnitude, 0.f, 1.f, 0.f,
+		Sphere->GetScaledSphereRadius(), SphereLoc, Field_FallOff_None);
+	GetFieldSystemComponent()->ApplyPhysicsField(true, Field_ExternalClusterStrain, nullptr, RadialFalloffNode);
+
+	// Push the released pieces outwards, culled to the sphere
+	UFieldNodeBase* RadialVectorNode = RadialVector->SetRadialVector(VectorMagnitude, SphereLoc);
+	UFieldNodeBase* CullingFieldNode = CullingField->SetCullingField(RadialFalloffNode, RadialVectorNode, Field_Culling_Outside);
+	GetFieldSystemComponent()->ApplyPhysicsField(true, Field_LinearVelocity, nullptr, CullingFieldNode);
+}
@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Actors/Public/DestroyerActor.h"
+#include "Components/StaticMeshComponent.h"
+
+ADestroyerActor::ADestroyerActor()
+{
+	// Nothing in this actor needs to run per frame
+	PrimaryActorTick.bCanEverTick = false;
+
+	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
+	RootComponent = Mesh;
+}
+
+void ADestroyerActor::TheDestroy()
+{
+	Mesh->SetVisibility(false, true);
+
+	UE_LOG(LogTemp, Log, TEXT("%s destroyed."), *GetName());
+}
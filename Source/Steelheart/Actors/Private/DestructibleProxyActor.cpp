@@ -0,0 +1,270 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Actors/Public/DestructibleProxyActor.h"
+#include "Chaos/CacheCollection.h"
+#include "Chaos/CacheManagerActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "GeometryCollection/GeometryCollectionComponent.h"
+#include "GeometryCollection/GeometryCollectionObject.h"
+#include "Steelheart/Data/Public/DestructionCacheLibrary.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/DestructibleProxySubsystem.h"
+#include "Steelheart/Subsystems/Public/DestructibleSupportSubsystem.h"
+#include "Steelheart/Subsystems/Public/DestructibleRegistrySubsystem.h"
+#include "Steelheart/Subsystems/Public/DestructionJournalSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Destructible Proxy Swap"), STAT_DestructibleProxySwap, STATGROUP_Steelheart);
+
+// Name of the recorded fracture within each cache collection
+static const FName DestructionCacheName(TEXT("Fracture"));
+
+ADestructibleProxyActor::ADestructibleProxyActor()
+{
+	// Swaps are driven by the proxy subsystem
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	RootComponent->SetMobility(EComponentMobility::Static);
+
+	ProxyMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("ProxyMesh"));
+	ProxyMesh->SetupAttachment(RootComponent);
+	ProxyMesh->SetMobility(EComponentMobility::Static);
+
+	// Struck by dashes before the swap, which only listen to destructible object types
+	ProxyMesh->SetCollisionObjectType(ECC_Destructible);
+
+	CollectionClass = UGeometryCollectionComponent::StaticClass();
+}
+
+void ADestructibleProxyActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UDestructibleRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDestructibleRegistrySubsystem>())
+	{
+		Registry->RegisterDestructible(this);
+	}
+
+	if (UDestructibleProxySubsystem* Proxies = GetWorld()->GetSubsystem<UDestructibleProxySubsystem>())
+	{
+		Proxies->RegisterProxy(this);
+	}
+
+	// Proxies destroyed in an earlier visit stream their collection in to show the recorded destruction
+	UDestructionJournalSubsystem* Journal = GetGameInstance() ? GetGameInstance()->GetSubsystem<UDestructionJournalSubsystem>() : nullptr;
+	if (Journal != nullptr && Journal->HasRecord(this))
+	{
+		RequestLive(false);
+	}
+}
+
+void ADestructibleProxyActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UDestructibleProxySubsystem* Proxies = GetWorld()->GetSubsystem<UDestructibleProxySubsystem>())
+	{
+		Proxies->UnregisterProxy(this);
+	}
+
+	if (LoadHandle.IsValid())
+	{
+		LoadHandle->CancelHandle();
+		LoadHandle.Reset();
+	}
+
+	if (CacheManager != nullptr)
+	{
+		CacheManager->Destroy();
+		CacheManager = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool ADestructibleProxyActor::RequestLive(bool bImmediate)
+{
+	LastWantedTime = GetWorld()->GetTimeSeconds();
+
+	if (Collection != nullptr || RestCollection.IsNull())
+	{
+		return Collection != nullptr;
+	}
+
+	if (!LoadHandle.IsValid())
+	{
+		// The recorded fractures stream in with the collection, so playback never waits on them
+		TArray<FSoftObjectPath> Assets;
+		Assets.Add(RestCollection.ToSoftObjectPath());
+		if (CacheLibrary != nullptr)
+		{
+			CacheLibrary->GetCollectionCaches(RestCollection, Assets);
+		}
+
+		TWeakObjectPtr<ADestructibleProxyActor> WeakThis(this);
+		LoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Assets,
+			FStreamableDelegate::CreateLambda([WeakThis]()
+			{
+				if (WeakThis.IsValid())
+				{
+					WeakThis->SwapToCollection();
+				}
+			}), FStreamableManager::AsyncLoadHighPriority);
+	}
+
+	// A flyer is already touching the proxy, so a loaded collection cannot wait for the next frames. One still streaming in
+	// is swapped in by the load callback instead of stalling the frame, the caller strikes it once live
+	if (bImmediate && Collection == nullptr && LoadHandle.IsValid() && LoadHandle->HasLoadCompleted())
+	{
+		SwapToCollection();
+	}
+
+	return Collection != nullptr;
+}
+
+void ADestructibleProxyActor::SwapToCollection()
+{
+	UGeometryCollection* LoadedCollection = RestCollection.Get();
+	if (Collection != nullptr || LoadedCollection == nullptr)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DestructibleProxySwap);
+
+	Collection = NewObject<UGeometryCollectionComponent>(this, CollectionClass ? CollectionClass.Get() : UGeometryCollectionComponent::StaticClass(), NAME_None, RF_Transient);
+	Collection->SetupAttachment(RootComponent);
+	Collection->SetRestCollection(LoadedCollection);
+
+	// Recorded destruction is given as rest state before the physics state exists, and keeps the collection from swapping back out
+	UDestructionJournalSubsystem* Journal = GetGameInstance() ? GetGameInstance()->GetSubsystem<UDestructionJournalSubsystem>() : nullptr;
+	if (Journal != nullptr && Journal->RestoreCollection(Collection))
+	{
+		bDamaged = true;
+	}
+	else
+	{
+		Collection->SetNotifyBreaks(true);
+		Collection->OnChaosBreakEvent.AddDynamic(this, &ADestructibleProxyActor::HandleBreak);
+	}
+
+	Collection->RegisterComponent();
+
+	UDestructibleSupportSubsystem* Support = GetWorld()->GetSubsystem<UDestructibleSupportSubsystem>();
+	if (Support != nullptr && SupportGraph != nullptr)
+	{
+		Support->RegisterBuilding(Collection, SupportGraph);
+	}
+
+	ProxyCollision = ProxyMesh->GetCollisionEnabled();
+	ProxyMesh->SetVisibility(false);
+	ProxyMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	BodyCount = LoadedCollection->NumElements(FGeometryCollection::TransformGroup);
+}
+
+void ADestructibleProxyActor::ReturnToProxy()
+{
+	// Broken pieces cannot be folded back into the static mesh
+	if (bDamaged)
+	{
+		return;
+	}
+
+	if (Collection != nullptr)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_DestructibleProxySwap);
+
+		// The next swap in registers a fresh building for the new collection
+		if (UDestructibleSupportSubsystem* Support = GetWorld()->GetSubsystem<UDestructibleSupportSubsystem>())
+		{
+			Support->UnregisterBuilding(Collection);
+		}
+
+		Collection->DestroyComponent();
+		Collection = nullptr;
+
+		if (CacheManager != nullptr)
+		{
+			CacheManager->Destroy();
+			CacheManager = nullptr;
+		}
+
+		ProxyMesh->SetVisibility(true);
+		ProxyMesh->SetCollisionEnabled(ProxyCollision);
+	}
+
+	if (LoadHandle.IsValid())
+	{
+		LoadHandle->ReleaseHandle();
+		LoadHandle.Reset();
+	}
+}
+
+bool ADestructibleProxyActor::PlayImpact(const FVector& Direction, float Strength, bool bRecord)
+{
+	// A collection fractures once, whether simulated or played back
+	if (Collection == nullptr || CacheManager != nullptr || bDamaged || CacheLibrary == nullptr)
+	{
+		return false;
+	}
+
+	int32 DirectionBucket = CacheLibrary->GetDirectionBucket(GetActorTransform().InverseTransformVectorNoScale(Direction));
+	int32 StrengthBucket = CacheLibrary->GetStrengthBucket(Strength);
+
+	const FDestructionCacheEntry* Entry = CacheLibrary->FindEntry(RestCollection, DirectionBucket, StrengthBucket);
+	UChaosCacheCollection* Cache = Entry != nullptr ? Entry->Cache.Get() : nullptr;
+
+	// Caches not streamed in yet, or never recorded, leave the fracture to the simulation
+	if (Cache == nullptr || (!bRecord && Cache->Caches.Num() == 0))
+	{
+		return false;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	SpawnParams.bDeferConstruction = true;
+
+	CacheManager = GetWorld()->SpawnActor<AChaosCacheManager>(GetActorLocation(), GetActorRotation(), SpawnParams);
+	if (CacheManager == nullptr)
+	{
+		return false;
+	}
+
+	CacheManager->CacheCollection = Cache;
+	CacheManager->CacheMode = bRecord ? ECacheMode::Record : ECacheMode::Play;
+	CacheManager->StartMode = bRecord ? EStartMode::Timed : EStartMode::Triggered;
+	CacheManager->FindOrAddObservedComponent(Collection, DestructionCacheName, true);
+	CacheManager->FinishSpawning(GetActorTransform());
+
+	if (bRecord)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s: recording the fracture of direction bucket %d and strength bucket %d into %s."),
+			*GetName(), DirectionBucket, StrengthBucket, *Cache->GetName());
+
+		return false;
+	}
+
+	CacheManager->TriggerAll();
+	bDamaged = true;
+
+	return true;
+}
+
+void ADestructibleProxyActor::HandleBreak(const FChaosBreakEvent& BreakEvent)
+{
+	bDamaged = true;
+
+	// The first break is all that is needed here, the support subsystem keeps listening to the later ones
+	Collection->OnChaosBreakEvent.RemoveDynamic(this, &ADestructibleProxyActor::HandleBreak);
+	if (SupportGraph == nullptr)
+	{
+		Collection->SetNotifyBreaks(false);
+	}
+}
+
+SIZE_T ADestructibleProxyActor::GetLiveMemory() const
+{
+	return Collection != nullptr ? Collection->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal) : 0;
+}
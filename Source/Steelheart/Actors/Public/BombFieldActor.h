@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Field/FieldSystemActor.h"
+#include "BombFieldActor.generated.h"
+
+// Forward declarations
+class USphereComponent;
+class URadialFalloff;
+class URadialVector;
+class UCullingField;
+
+/**
+ * Field system actor that strains and pushes destructibles within its sphere.
+ * Native replacement for the BP_BombField test blueprint.
+ */
+UCLASS()
+class STEELHEART_API ABombFieldActor : public AFieldSystemActor
+{
+	GENERATED_BODY()
+
+	// Sphere defining the area of effect
+	UPROPERTY(VisibleAnywhere, Category = Field)
+		USphereComponent* Sphere;
+
+	// Radial falloff used for the strain field
+	UPROPERTY(VisibleAnywhere, Category = Field)
+		URadialFalloff* RadialFalloff;
+
+	// Radial vector used for the velocity field
+	UPROPERTY(VisibleAnywhere, Category = Field)
+		URadialVector* RadialVector;
+
+	// Culling field restricting the velocity field to the sphere
+	UPROPERTY(VisibleAnywhere, Category = Field)
+		UCullingField* CullingField;
+
+public:
+	ABombFieldActor(const FObjectInitializer& ObjectInitializer);
+
+	// Apply the strain and velocity fields within the sphere
+	UFUNCTION(BlueprintCallable, Category = Field)
+		void Explode();
+
+private:
+	// Magnitude of the falloff field
+	UPROPERTY(EditAnywhere, Category = Field)
+		float FalloffMagnitude = 500000.f;
+
+	// Magnitude of the radial vector field
+	UPROPERTY(EditAnywhere, Category = Field)
+		float VectorMagnitude = 1000.f;
+};
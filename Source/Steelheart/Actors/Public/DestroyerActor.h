@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "DestroyerActor.generated.h"
+
+// Forward declarations
+class UStaticMeshComponent;
+
+/**
+ * Test actor whose mesh can be hidden on demand.
+ * Native replacement for the BP_Destroyer test blueprint.
+ */
+UCLASS()
+class STEELHEART_API ADestroyerActor : public AActor
+{
+	GENERATED_BODY()
+
+	// Mesh hidden when the actor is destroyed
+	UPROPERTY(VisibleAnywhere, Category = Destroyer)
+		UStaticMeshComponent* Mesh;
+
+public:
+	ADestroyerActor();
+
+	// Hide the mesh of this actor
+	UFUNCTION(BlueprintCallable, Category = Destroyer)
+		void TheDestroy();
+};
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/ChaosGameplayEventDispatcher.h"
+#include "GameFramework/Actor.h"
+#include "DestructibleProxyActor.generated.h"
+
+// Forward declarations
+class AChaosCacheManager;
+class UDestructibleSupportGraph;
+class UDestructionCacheLibrary;
+class UGeometryCollection;
+class UGeometryCollectionComponent;
+class UStaticMeshComponent;
+struct FStreamableHandle;
+
+/**
+ * Destructible drawn and collided with as a plain static mesh until a flyer comes near.
+ * The live geometry collection is streamed in and swapped in on request, and swapped back out to the static mesh
+ * once it has gone unwanted, unless it was damaged in the meantime.
+ * Impacts with a fracture recorded in the cache library play the recording back instead of simulating it.
+ */
+UCLASS()
+class STEELHEART_API ADestructibleProxyActor : public AActor
+{
+	GENERATED_BODY()
+
+	// Cheap stand-in for the collection while nobody is near
+	UPROPERTY(VisibleAnywhere, Category = Destruction)
+		UStaticMeshComponent* ProxyMesh;
+
+	// Live collection, only exists while swapped in
+	UPROPERTY(Transient)
+		UGeometryCollectionComponent* Collection;
+
+public:
+	ADestructibleProxyActor();
+
+	/**
+	 * Marks the live collection as wanted, streaming it in and swapping it in if needed.
+	 *
+	 * @param bImmediate If true, a collection already loaded is swapped in right away. One still streaming in is never waited for.
+	 * @return True if the collection is live by the end of the call.
+	 */
+	bool RequestLive(bool bImmediate);
+
+	// Swap the live collection back out for the static mesh, damaged collections are kept live
+	void ReturnToProxy();
+
+	/**
+	 * Plays back the fracture recorded for an impact on the live collection, or records it.
+	 *
+	 * @param Direction World direction of the impact.
+	 * @param Strength Speed of the impact.
+	 * @param bRecord If true, the simulated fracture is recorded into the cache of the impact bucket instead.
+	 * @return True if a recording is played back, false if the fracture is left to the simulation.
+	 */
+	bool PlayImpact(const FVector& Direction, float Strength, bool bRecord);
+
+	// Getter for the live collection state
+	FORCEINLINE bool IsLive() const { return Collection != nullptr; }
+
+	// Getter for the streaming state of the collection
+	FORCEINLINE bool IsLoading() const { return Collection == nullptr && LoadHandle.IsValid(); }
+
+	// Getter for the damaged state
+	FORCEINLINE bool IsDamaged() const { return bDamaged; }
+
+	// Getter for the last time the live collection was wanted
+	FORCEINLINE float GetLastWantedTime() const { return LastWantedTime; }
+
+	// Number of transforms of the collection simulated while live, zero until it has been loaded once
+	FORCEINLINE int32 GetBodyCount() const { return BodyCount; }
+
+	// Memory of the live collection component, zero while swapped out
+	SIZE_T GetLiveMemory() const;
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Replace the static mesh with the loaded collection
+	void SwapToCollection();
+
+	// Remember the collection was broken, so it is never swapped back out
+	UFUNCTION()
+		void HandleBreak(const FChaosBreakEvent& BreakEvent);
+
+	// Collection swapped in near flyers
+	UPROPERTY(EditAnywhere, Category = Destruction)
+		TSoftObjectPtr<UGeometryCollection> RestCollection;
+
+	// Fractures recorded for the collection, streamed in along with it
+	UPROPERTY(EditAnywhere, Category = Destruction)
+		UDestructionCacheLibrary* CacheLibrary;
+
+	// Structural support of the collection, collapsing what its broken pieces held up
+	UPROPERTY(EditAnywhere, Category = Destruction)
+		UDestructibleSupportGraph* SupportGraph;
+
+	// Cache manager playing back or recording the fracture of the collection
+	UPROPERTY(Transient)
+		AChaosCacheManager* CacheManager;
+
+	// Class of the live collection component, a blueprint subclass can carry the simulation settings
+	UPROPERTY(EditAnywhere, Category = Destruction)
+		TSubclassOf<UGeometryCollectionComponent> CollectionClass;
+
+	// Handle keeping the collection loaded while it is wanted
+	TSharedPtr<FStreamableHandle> LoadHandle;
+
+	float LastWantedTime = 0.f;
+
+	int32 BodyCount = 0;
+
+	// Collision of the static mesh, restored when swapped back in
+	TEnumAsByte<ECollisionEnabled::Type> ProxyCollision = ECollisionEnabled::QueryAndPhysics;
+
+	bool bDamaged = false;
+};
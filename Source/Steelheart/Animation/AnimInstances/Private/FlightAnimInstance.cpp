@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Animation/AnimInstances/Public/FlightAnimInstance.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Kismet/GameplayStatics.h"
+
+void UFlightAnimInstance::NativeInitializeAnimation()
+{
+	Super::NativeInitializeAnimation();
+
+	// Start with the ground graph linked, the flight graph is only linked once the character takes off
+	LinkLayerClass(LayerMode);
+	UpdateAdditiveLayers();
+}
+
+void UFlightAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeUpdateAnimation(DeltaSeconds);
+
+	UpdateSignificance(DeltaSeconds);
+}
+
+void UFlightAnimInstance::SetLocomotionLayerMode(EFlightAnimLayerMode NewMode)
+{
+	if (LayerMode != NewMode)
+	{
+		LayerMode = NewMode;
+
+		LinkLayerClass(NewMode);
+		UpdateAdditiveLayers();
+	}
+}
+
+void UFlightAnimInstance::LinkLayerClass(EFlightAnimLayerMode Mode)
+{
+	TSubclassOf<UAnimInstance> NewLayerClass = Mode == EFlightAnimLayerMode::Flight ? FlightLayerClass : GroundLayerClass;
+
+	if (NewLayerClass == LinkedLayerClass)
+	{
+		return;
+	}
+
+	// Unlinking tears down the previous layer instance, so its nodes stop being updated and evaluated
+	if (LinkedLayerClass != nullptr)
+	{
+		UnlinkAnimClassLayers(LinkedLayerClass);
+	}
+
+	if (NewLayerClass != nullptr)
+	{
+		LinkAnimClassLayers(NewLayerClass);
+	}
+
+	LinkedLayerClass = NewLayerClass;
+}
+
+void UFlightAnimInstance::UpdateSignificance(float DeltaSeconds)
+{
+	SignificanceTimeCounter += DeltaSeconds;
+	if (SignificanceTimeCounter < SignificanceUpdateInterval)
+	{
+		return;
+	}
+	SignificanceTimeCounter = 0.f;
+
+	USkeletalMeshComponent* MeshComp = GetSkelMeshComponent();
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+
+	EFlightAnimSignificance NewSignificance = EFlightAnimSignificance::High;
+	if (MeshComp != nullptr && CameraManager != nullptr)
+	{
+		if (!MeshComp->WasRecentlyRendered(SignificanceUpdateInterval))
+		{
+			// Off-screen meshes never need the additive detail
+			NewSignificance = EFlightAnimSignificance::Low;
+		}
+		else
+		{
+			float DistanceSquared = FVector::DistSquared(MeshComp->GetComponentLocation(), CameraManager->GetCameraLocation());
+
+			if (DistanceSquared > FMath::Square(LowSignificanceDistance))
+			{
+				NewSignificance = EFlightAnimSignificance::Low;
+			}
+			else if (DistanceSquared > FMath::Square(MediumSignificanceDistance))
+			{
+				NewSignificance = EFlightAnimSignificance::Medium;
+			}
+		}
+	}
+
+	if (Significance != NewSignificance)
+	{
+		Significance = NewSignificance;
+		UpdateAdditiveLayers();
+	}
+}
+
+void UFlightAnimInstance::UpdateAdditiveLayers()
+{
+	bool bInFlight = LayerMode == EFlightAnimLayerMode::Flight;
+
+	// Turns carry the most readable motion, so they are the last additives to be dropped
+	bHoverTurnsAdditive = bInFlight && Significance != EFlightAnimSignificance::Low;
+	bFastFlightTurnsAdditive = bInFlight && Significance != EFlightAnimSignificance::Low;
+
+	bHoverLeansAdditive = bInFlight && Significance == EFlightAnimSignificance::High;
+	bHoverVerticalsAdditive = bInFlight && Significance == EFlightAnimSignificance::High;
+}
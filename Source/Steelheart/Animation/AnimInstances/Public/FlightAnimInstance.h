@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "FlightAnimInstance.generated.h"
+
+// Locomotion graph currently linked into the base anim instance
+UENUM(BlueprintType)
+enum class EFlightAnimLayerMode : uint8
+{
+	Ground,
+	Flight
+};
+
+// Significance tier used to drop additive flight layers
+UENUM(BlueprintType)
+enum class EFlightAnimSignificance : uint8
+{
+	High,
+	Medium,
+	Low
+};
+
+/**
+ * Native base anim instance that links either the ground or the flight locomotion graph as anim layers.
+ * Only the linked graph is instantiated, so the inactive graph and its additive layers are never evaluated.
+ */
+UCLASS()
+class STEELHEART_API UFlightAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Swaps the linked locomotion layers to match the given mode.
+	 *
+	 * @param NewMode The locomotion graph that should be evaluated from now on.
+	 */
+	void SetLocomotionLayerMode(EFlightAnimLayerMode NewMode);
+
+	// Getter for the currently linked locomotion graph
+	FORCEINLINE EFlightAnimLayerMode GetLocomotionLayerMode() const { return LayerMode; }
+
+protected:
+	virtual void NativeInitializeAnimation() override;
+
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+
+private:
+	// Link the layer class associated with the given mode, unlinking the previous one
+	void LinkLayerClass(EFlightAnimLayerMode Mode);
+
+	// Re-evaluate the significance tier of the owning mesh
+	void UpdateSignificance(float DeltaSeconds);
+
+	// Update which additive flight layers are evaluated for the current mode and significance
+	void UpdateAdditiveLayers();
+
+public:
+	// Locomotion graph currently linked
+	UPROPERTY(BlueprintReadOnly, Category = LocomotionLayers)
+		EFlightAnimLayerMode LayerMode = EFlightAnimLayerMode::Ground;
+
+	// Current significance tier of the owning mesh
+	UPROPERTY(BlueprintReadOnly, Category = Significance)
+		EFlightAnimSignificance Significance = EFlightAnimSignificance::High;
+
+	// Whether the Hover_Turns_Add layer should be evaluated
+	UPROPERTY(BlueprintReadOnly, Category = AdditiveLayers)
+		bool bHoverTurnsAdditive;
+
+	// Whether the Hover_Leans_Add layer should be evaluated
+	UPROPERTY(BlueprintReadOnly, Category = AdditiveLayers)
+		bool bHoverLeansAdditive;
+
+	// Whether the Hover_Verticals_Add layer should be evaluated
+	UPROPERTY(BlueprintReadOnly, Category = AdditiveLayers)
+		bool bHoverVerticalsAdditive;
+
+	// Whether the FastFlightTurns_Add layer should be evaluated
+	UPROPERTY(BlueprintReadOnly, Category = AdditiveLayers)
+		bool bFastFlightTurnsAdditive;
+
+private:
+	// Anim class implementing the locomotion layers while on the ground
+	UPROPERTY(EditDefaultsOnly, Category = LocomotionLayers)
+		TSubclassOf<UAnimInstance> GroundLayerClass;
+
+	// Anim class implementing the locomotion layers while flying
+	UPROPERTY(EditDefaultsOnly, Category = LocomotionLayers)
+		TSubclassOf<UAnimInstance> FlightLayerClass;
+
+	// Distance from the view beyond which the mesh drops to medium significance
+	UPROPERTY(EditDefaultsOnly, Category = Significance)
+		float MediumSignificanceDistance = 2500.f;
+
+	// Distance from the view beyond which the mesh drops to low significance
+	UPROPERTY(EditDefaultsOnly, Category = Significance)
+		float LowSignificanceDistance = 6000.f;
+
+	// Time between significance evaluations
+	UPROPERTY(EditDefaultsOnly, Category = Significance)
+		float SignificanceUpdateInterval = 0.25f;
+
+	// Layer class currently linked into this instance
+	TSubclassOf<UAnimInstance> LinkedLayerClass;
+
+	float SignificanceTimeCounter = 0.f;
+};
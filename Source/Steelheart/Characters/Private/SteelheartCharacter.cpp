@@ -3,6 +3,7 @@
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
@@ -11,6 +12,11 @@
 #include "Steelheart/Components/Public/FlightLocomotionComponent.h"
 #include "Steelheart/Components/Public/FlightTakeoffComponent.h"
 #include "Steelheart/Components/Public/FlightEffectsComponent.h"
+#include "Steelheart/Components/Public/FlightScalabilityComponent.h"
+#include "Steelheart/Components/Public/FlightStreamingComponent.h"
+#include "Steelheart/Steelheart.h"
+
+DECLARE_CYCLE_STAT(TEXT("Character Tick"), STAT_CharacterTick, STATGROUP_Steelheart);
 
 //////////////////////////////////////////////////////////////////////////
 // ASteelheartCharacter
@@ -69,21 +75,60 @@ ASteelheartCharacter::ASteelheartCharacter()
 
 	FlightCollision = CreateDefaultSubobject<UFlightCollisionComponent>(TEXT("FlightCollisionComponent"));
 
+	FlightStreaming = CreateDefaultSubobject<UFlightStreamingComponent>(TEXT("FlightStreamingComponent"));
+
+	FlightScalability = CreateDefaultSubobject<UFlightScalabilityComponent>(TEXT("FlightScalabilityComponent"));
+
 	bLocomotionEnabled = true;
 }
 
 //////////////////////////////////////////////////////////////////////////
 // Lifecycle Functions
 
+void ASteelheartCharacter::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// Blueprints saved before the tuning profiles get theirs once, on their default object. The profile lives in the blueprint
+	// package, so it is saved and cooked along with it and every instance shares it by pointer
+	if (HasAnyFlags(RF_ClassDefaultObject) && TuningProfile == nullptr && GetClass()->ClassGeneratedBy != nullptr)
+	{
+		TuningProfile = MigrateDeprecatedTuning(GetOutermost(), RF_Public);
+	}
+#endif
+}
+
+void ASteelheartCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// Flight components fetch the profile in their BeginPlay, it has to exist by then
+	if (TuningProfile == nullptr)
+	{
+		TuningProfile = GetClassTuningProfile(GetClass());
+	}
+}
+
 void ASteelheartCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	GetCapsuleComponent()->OnComponentHit.AddDynamic(FlightCollision, &UFlightCollisionComponent::OnCharacterHit);
+	HandleTuningChanged(GetFlightTuningProfile());
+	TuningChangedHandle = UFlightTuningProfile::OnTuningChanged().AddUObject(this, &ASteelheartCharacter::HandleTuningChanged);
+}
+
+void ASteelheartCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UFlightTuningProfile::OnTuningChanged().Remove(TuningChangedHandle);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ASteelheartCharacter::Tick(float DeltaSeconds)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CharacterTick);
+
 	Super::Tick(DeltaSeconds);
 
 	UpdateLocomotion(DeltaSeconds);
@@ -164,6 +209,8 @@ void ASteelheartCharacter::HandleFlyInput()
 
 			FlightLocomotion->StopFlying();
 			GetCharacterMovement()->bNotifyApex = true;
+
+			SetAnimLayerMode(EFlightAnimLayerMode::Ground);
 		}
 		else if (GetCharacterMovement()->IsFalling()) // Fly
 		{
@@ -175,6 +222,8 @@ void ASteelheartCharacter::HandleFlyInput()
 			FlightLocomotion->StopDivebomb();
 			FlightLocomotion->Fly();
 
+			SetAnimLayerMode(EFlightAnimLayerMode::Flight);
+
 			FlightEffects->ActivateHover();
 
 			if (bIsDashing)
@@ -323,7 +372,7 @@ void ASteelheartCharacter::Turn(float Value)
 	if (GetWorld()->GetFirstPlayerController()->IsInputKeyDown(MouseRotationKey))
 	{
 		// Interpolate the current turn value towards the target turn value over time
-		float CurrentTurnValue = FMath::FInterpTo(LastTurnValue, Value, GetWorld()->GetDeltaSeconds(), MouseRotationInterpSpeed);
+		float CurrentTurnValue = FMath::FInterpTo(LastTurnValue, Value, GetWorld()->GetDeltaSeconds(), GetFlightTuningProfile()->Character.MouseRotationInterpSpeed);
 
 		// Apply the smooth rotation by gradually adjusting the yaw of the character over time
 		AddControllerYawInput(CurrentTurnValue * BaseTurnRate * GetWorld()->GetDeltaSeconds());
@@ -333,7 +382,7 @@ void ASteelheartCharacter::Turn(float Value)
 	}
 	else //reverse the functionality to interpolate back to zero
 	{
-		float CurrentTurnValue = FMath::FInterpTo(LastTurnValue, 0, GetWorld()->GetDeltaSeconds(), MouseRotationInterpSpeed);
+		float CurrentTurnValue = FMath::FInterpTo(LastTurnValue, 0, GetWorld()->GetDeltaSeconds(), GetFlightTuningProfile()->Character.MouseRotationInterpSpeed);
 
 		AddControllerYawInput(CurrentTurnValue * BaseTurnRate * GetWorld()->GetDeltaSeconds());
 
@@ -353,7 +402,7 @@ void ASteelheartCharacter::LookUp(float Value)
 	if (GetWorld()->GetFirstPlayerController()->IsInputKeyDown(MouseRotationKey))
 	{
 		// Interpolate the current look-up value towards the target look-up value over time
-		float CurrentLookUpValue = FMath::FInterpTo(LastLookUpValue, Value, GetWorld()->GetDeltaSeconds(), MouseRotationInterpSpeed);
+		float CurrentLookUpValue = FMath::FInterpTo(LastLookUpValue, Value, GetWorld()->GetDeltaSeconds(), GetFlightTuningProfile()->Character.MouseRotationInterpSpeed);
 
 		// Apply the smooth rotation by gradually adjusting the pitch of the character over time
 		AddControllerPitchInput(CurrentLookUpValue * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
@@ -363,7 +412,7 @@ void ASteelheartCharacter::LookUp(float Value)
 	}
 	else //reverse the functionality to interpolate back to zero
 	{
-		float CurrentLookUpValue = FMath::FInterpTo(LastLookUpValue, 0, GetWorld()->GetDeltaSeconds(), MouseRotationInterpSpeed);
+		float CurrentLookUpValue = FMath::FInterpTo(LastLookUpValue, 0, GetWorld()->GetDeltaSeconds(), GetFlightTuningProfile()->Character.MouseRotationInterpSpeed);
 
 		AddControllerPitchInput(CurrentLookUpValue * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
 
@@ -418,7 +467,7 @@ void ASteelheartCharacter::UpdateSpeeds(float DeltaSeconds)
 	CurrentSpeed = GetVelocity().Size();
 
 	// Interpolate the maximum ground speed towards the target speed
-	float MaxGroundSpeed = FMath::FInterpTo(GetCharacterMovement()->MaxWalkSpeed, MaxSpeedTarget, DeltaSeconds, MaxGroundSpeedInterpSpeed);
+	float MaxGroundSpeed = FMath::FInterpTo(GetCharacterMovement()->MaxWalkSpeed, MaxSpeedTarget, DeltaSeconds, GetFlightTuningProfile()->Character.MaxGroundSpeedInterpSpeed);
 	GetCharacterMovement()->MaxWalkSpeed = MaxGroundSpeed;
 }
 
@@ -428,7 +477,7 @@ void ASteelheartCharacter::UpdateSpeeds(float DeltaSeconds)
 void ASteelheartCharacter::Walk()
 {
 	// Set the target maximum speed to the walk speed
-	MaxSpeedTarget = WalkSpeed;
+	MaxSpeedTarget = GetFlightTuningProfile()->Character.WalkSpeed;
 }
 
 void ASteelheartCharacter::StopWalking()
@@ -446,6 +495,9 @@ void ASteelheartCharacter::Dash()
 	// Set the character to a dashing state
 	bIsDashing = true;
 
+	// Strike destructibles from the very first move of the dash
+	FlightCollision->StartDash();
+
 	// Activate visual effects for dashing
 	FlightEffects->ActivateSonicBoom();
 	FlightEffects->ToggleDashTrail(true);
@@ -458,15 +510,15 @@ void ASteelheartCharacter::Dash()
 	else
 	{
 		// If character is not flying, set the maximum acceleration to dash acceleration
-		GetCharacterMovement()->MaxAcceleration = DashAcceleration;
+		GetCharacterMovement()->MaxAcceleration = GetFlightTuningProfile()->Character.DashAcceleration;
 	}
 
 	// Set the target maximum speed to the dash speed
-	MaxSpeedTarget = DashSpeed;
-	GetCharacterMovement()->JumpZVelocity = DashJumpZVelocity;
+	MaxSpeedTarget = GetFlightTuningProfile()->Character.DashSpeed;
+	GetCharacterMovement()->JumpZVelocity = GetFlightTuningProfile()->Character.DashJumpZVelocity;
 
 	// Set the camera boom lerp time to the dash lerp time and start the lerping process
-	CameraBoomLerpTime = DashCameraLerpTime;
+	CameraBoomLerpTime = GetFlightTuningProfile()->Character.DashCameraLerpTime;
 	StartCameraBoomLerp();
 }
 
@@ -517,13 +569,13 @@ void ASteelheartCharacter::OnWalkingOffLedge_Implementation(const FVector& Previ
 {
 	if (CurrentSpeed >= SpeedRequiredForLeap)
 	{
-		if (ensure(LeapStartMontage != nullptr))
-			PlayAnimMontage(LeapStartMontage);
+		if (ensure(GetFlightTuningProfile()->Character.LeapStartMontage != nullptr))
+			PlayAnimMontage(GetFlightTuningProfile()->Character.LeapStartMontage);
 	}
 	else
 	{
-		if (ensure(JumpStartMontage != nullptr))
-			PlayAnimMontage(JumpStartMontage);
+		if (ensure(GetFlightTuningProfile()->Character.JumpStartMontage != nullptr))
+			PlayAnimMontage(GetFlightTuningProfile()->Character.JumpStartMontage);
 	}
 
 	// Set the landing initiation location Z-coordinate for flight locomotion
@@ -544,7 +596,7 @@ void ASteelheartCharacter::Dive()
 	FlightEffects->ActivateDiveTrail();
 
 	// Set the camera boom lerp time to the dive lerp time and start the lerping process
-	CameraBoomLerpTime = DiveCameraLerpTime;
+	CameraBoomLerpTime = GetFlightTuningProfile()->Character.DiveCameraLerpTime;
 	StartCameraBoomLerp();
 }
 
@@ -553,6 +605,9 @@ void ASteelheartCharacter::LandDive(FVector LandLocation)
 	// Activate landing dive visual effect
 	FlightEffects->ActivateDiveLand(LandLocation);
 
+	// Strain the destructibles and push the physics props around the landing
+	FlightCollision->EmitShockwave(LandLocation);
+
 	// Stop the camera boom lerping process
 	StopCameraBoomLerp();
 }
@@ -566,6 +621,8 @@ void ASteelheartCharacter::ReleaseTakeoff(bool Activate)
 
 		// Activate flight locomotion for takeoff
 		FlightLocomotion->Fly();
+
+		SetAnimLayerMode(EFlightAnimLayerMode::Flight);
 	}
 
 	// Toggle takeoff charge visual effect
@@ -611,12 +668,12 @@ void ASteelheartCharacter::ProcessCameraBoomLerp(float DeltaSeconds)
 	{
 		// If dash lerp process is active, set initial boom length to base length and target boom length to target length
 		InitialBoomLength = CameraBoomBaseLength;
-		TargetBoomLength = CameraBoomTargetLength;
+		TargetBoomLength = GetFlightTuningProfile()->Character.CameraBoomTargetLength;
 	}
 	else if (bProcessStopDashLerp)
 	{
 		// If stop dash lerp process is active, set initial boom length to target length and target boom length to base length
-		InitialBoomLength = CameraBoomTargetLength;
+		InitialBoomLength = GetFlightTuningProfile()->Character.CameraBoomTargetLength;
 		TargetBoomLength = CameraBoomBaseLength;
 	}
 
@@ -645,6 +702,123 @@ void ASteelheartCharacter::ProcessCameraBoomLerp(float DeltaSeconds)
 void ASteelheartCharacter::InverseCameraBoomLerp()
 {
 	// Inverse the lerp time counter and alpha values to reverse the lerp process
-	CameraBoomLerpTimeCounter = DashCameraLerpTime - CameraBoomLerpTimeCounter;
+	CameraBoomLerpTimeCounter = GetFlightTuningProfile()->Character.DashCameraLerpTime - CameraBoomLerpTimeCounter;
 	CameraBoomLerpAlpha = 1.f - CameraBoomLerpAlpha;
-}
\ No newline at end of file
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Animation Helper Functions
+
+void ASteelheartCharacter::SetAnimLayerMode(EFlightAnimLayerMode Mode)
+{
+	// Only the linked locomotion graph is evaluated, so swap it on every flight transition
+	if (UFlightAnimInstance* FlightAnimInstance = Cast<UFlightAnimInstance>(GetMesh()->GetAnimInstance()))
+	{
+		FlightAnimInstance->SetLocomotionLayerMode(Mode);
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Tuning Functions
+
+const UFlightTuningProfile* ASteelheartCharacter::GetFlightTuningProfile()
+{
+	// Never the default object of the profile class, the tuning console writes to the profiles it gets from here
+	if (TuningProfile == nullptr)
+	{
+		TuningProfile = GetClassTuningProfile(GetClass());
+	}
+
+	return TuningProfile;
+}
+
+void ASteelheartCharacter::SetFlightTuningProfile(UFlightTuningProfile* NewProfile)
+{
+	TuningProfile = NewProfile;
+
+	// Flight components pick up the swap through the change notification
+	GetFlightTuningProfile()->NotifyTuningChanged();
+}
+
+UFlightTuningProfile* ASteelheartCharacter::GetClassTuningProfile(UClass* Class)
+{
+	// Rooted, as nothing but the instances of the class reference them
+	static TMap<TWeakObjectPtr<UClass>, UFlightTuningProfile*> ClassProfiles;
+
+	if (UFlightTuningProfile** Profile = ClassProfiles.Find(Class))
+	{
+		return *Profile;
+	}
+
+	// Drop the profiles of the classes recompiled or unloaded since
+	for (auto It = ClassProfiles.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.Value()->RemoveFromRoot();
+			It.RemoveCurrent();
+		}
+	}
+
+#if WITH_EDITORONLY_DATA
+	UFlightTuningProfile* Profile = Class->GetDefaultObject<ASteelheartCharacter>()->MigrateDeprecatedTuning(GetTransientPackage(), RF_Transient);
+#else
+	UFlightTuningProfile* Profile = NewObject<UFlightTuningProfile>(GetTransientPackage(), NAME_None, RF_Transient);
+#endif
+
+	Profile->AddToRoot();
+	ClassProfiles.Add(Class, Profile);
+
+	UE_LOG(LogTemp, Warning, TEXT("%s has no tuning profile, its instances share one built for the class. Assign a profile asset to tune it."),
+		*Class->GetName());
+
+	return Profile;
+}
+
+#if WITH_EDITORONLY_DATA
+UFlightTuningProfile* ASteelheartCharacter::MigrateDeprecatedTuning(UObject* Outer, EObjectFlags Flags) const
+{
+	FName ProfileName = MakeUniqueObjectName(Outer, UFlightTuningProfile::StaticClass(), *FString::Printf(TEXT("%s_TuningProfile"), *GetClass()->GetName()));
+	UFlightTuningProfile* Profile = NewObject<UFlightTuningProfile>(Outer, ProfileName, Flags);
+
+	FSteelheartCharacterTuning& Tuning = Profile->Character;
+	Tuning.JumpStartMontage = JumpStartMontage_DEPRECATED;
+	Tuning.LeapStartMontage = LeapStartMontage_DEPRECATED;
+	Tuning.SpeedRequiredForLeap = SpeedRequiredForLeap;
+	Tuning.WalkSpeed = WalkSpeed_DEPRECATED;
+	Tuning.MaxGroundSpeedInterpSpeed = MaxGroundSpeedInterpSpeed_DEPRECATED;
+	Tuning.DashJumpZVelocity = DashJumpZVelocity_DEPRECATED;
+	Tuning.DashSpeed = DashSpeed_DEPRECATED;
+	Tuning.DashAcceleration = DashAcceleration_DEPRECATED;
+	Tuning.MouseRotationInterpSpeed = MouseRotationInterpSpeed_DEPRECATED;
+	Tuning.DashCameraLerpTime = DashCameraLerpTime_DEPRECATED;
+	Tuning.DiveCameraLerpTime = DiveCameraLerpTime_DEPRECATED;
+	Tuning.CameraBoomTargetLength = CameraBoomTargetLength_DEPRECATED;
+
+	// Read from the default subobjects, which hold the tuning of the components on the default object
+	TArray<UObject*> Subobjects;
+	GetDefaultSubobjects(Subobjects);
+	for (const UObject* Subobject : Subobjects)
+	{
+		if (const UFlightComponent* FlightComponent = Cast<UFlightComponent>(Subobject))
+		{
+			FlightComponent->MigrateDeprecatedTuning(Profile);
+		}
+	}
+
+	// The montages are hard referenced by the deprecated tuning, so they are already loaded
+	Profile->BakeDerivedValues();
+
+	return Profile;
+}
+#endif
+
+void ASteelheartCharacter::HandleTuningChanged(const UFlightTuningProfile* ChangedProfile)
+{
+	if (ChangedProfile == GetFlightTuningProfile())
+	{
+		SpeedRequiredForLeap = ChangedProfile->Character.SpeedRequiredForLeap;
+	}
+}
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Steelheart/Animation/AnimInstances/Public/FlightAnimInstance.h"
+#include "Steelheart/Data/Public/FlightTuningProfile.h"
 #include "Steelheart/Interfaces/Public/FlightLocomotionInterface.h"
 #include "SteelheartCharacter.generated.h"
 
@@ -36,6 +38,14 @@ class ASteelheartCharacter : public ACharacter, public IFlightLocomotionInterfac
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = FlightLocomotion, meta = (AllowPrivateAccess = "true"))
 		class UFlightCollisionComponent* FlightCollision;
 
+	/** Flight asset streaming */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = FlightLocomotion, meta = (AllowPrivateAccess = "true"))
+		class UFlightStreamingComponent* FlightStreaming;
+
+	/** Flight speed driven scalability */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = FlightLocomotion, meta = (AllowPrivateAccess = "true"))
+		class UFlightScalabilityComponent* FlightScalability;
+
 public:
 	ASteelheartCharacter();
 
@@ -48,9 +58,21 @@ public:
 	// Override function from IFlightLocomotionInterface to set locomotion enabled or disabled
 	FORCEINLINE virtual void SetLocomotionEnabled(bool Enabled) override { bLocomotionEnabled = Enabled; }
 
+	// Override function from IFlightLocomotionInterface to get the shared tuning profile
+	virtual const UFlightTuningProfile* GetFlightTuningProfile() override;
+
+	// Swap the tuning profile of this character and re-apply it to its flight components
+	void SetFlightTuningProfile(UFlightTuningProfile* NewProfile);
+
 protected:
+	virtual void PostLoad() override;
+
+	virtual void PostInitializeComponents() override;
+
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void Tick(float DeltaSeconds) override;
 
 	// APawn interface
@@ -160,6 +182,20 @@ private:
 	// Inverse the camera boom lerp
 	void InverseCameraBoomLerp();
 
+	// Link the locomotion anim layers matching the given mode
+	void SetAnimLayerMode(EFlightAnimLayerMode Mode);
+
+	// Refresh the values mirrored from the tuning profile
+	void HandleTuningChanged(const UFlightTuningProfile* ChangedProfile);
+
+	// Get the profile shared by every instance of a class saved without one, built on first use
+	static UFlightTuningProfile* GetClassTuningProfile(UClass* Class);
+
+#if WITH_EDITORONLY_DATA
+	// Build a profile from the tuning saved on this character and its flight components before the tuning profiles
+	UFlightTuningProfile* MigrateDeprecatedTuning(UObject* Outer, EObjectFlags Flags) const;
+#endif
+
 public:
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = CameraHandling)
@@ -177,16 +213,8 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = CameraHandling)
 		FKey MouseRotationKey = EKeys::LeftMouseButton;
 
-	/**
-	* Interpolation speed for mouse rotation.
-	* Determines how quickly the character's rotation interpolates when smoothly turning with the mouse.
-	* Higher values result in faster interpolation and smoother turning, while lower values yield slower interpolation and more gradual turning.
-	*/
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = CameraHandling)
-		float MouseRotationInterpSpeed = 10.f;
-
-	// Speed required for the character to perform a leap
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Locomotion)
+	// Speed required for the character to perform a leap, mirrored from the tuning profile for the anim blueprints
+	UPROPERTY(BlueprintReadOnly, Category = Locomotion)
 		float SpeedRequiredForLeap = 2500.f;
 
 	UPROPERTY(BlueprintReadOnly, Category = Locomotion)
@@ -202,37 +230,49 @@ public:
 		bool bIsDashing;
 
 private:
-	// Animation montage to play when the character starts a regular jump
-	UPROPERTY(EditDefaultsOnly, Category = JumpAnimations)
-		UAnimMontage* JumpStartMontage = nullptr;
+	// Tuning shared by every instance of this archetype, migrated from the deprecated tuning below when an older blueprint loads
+	UPROPERTY(EditDefaultsOnly, Category = Tuning)
+		UFlightTuningProfile* TuningProfile = nullptr;
 
-	// Animation montage to play when the character starts a leap
-	UPROPERTY(EditDefaultsOnly, Category = JumpAnimations)
-		UAnimMontage* LeapStartMontage = nullptr;
+#if WITH_EDITORONLY_DATA
+	//////////////////////////////////////////////////////////////////////////
+	// Deprecated tuning, loaded through the core redirects from blueprints saved before the tuning profiles, editor only
 
-	UPROPERTY(EditDefaultsOnly, Category = Locomotion)
-		float WalkSpeed = 150.f;
-	
-	UPROPERTY(EditDefaultsOnly, Category = Locomotion)
-		float MaxGroundSpeedInterpSpeed = 4.f;
+	UPROPERTY()
+		float MouseRotationInterpSpeed_DEPRECATED = 10.f;
+
+	UPROPERTY()
+		UAnimMontage* JumpStartMontage_DEPRECATED = nullptr;
+
+	UPROPERTY()
+		UAnimMontage* LeapStartMontage_DEPRECATED = nullptr;
+
+	UPROPERTY()
+		float WalkSpeed_DEPRECATED = 150.f;
+
+	UPROPERTY()
+		float MaxGroundSpeedInterpSpeed_DEPRECATED = 4.f;
+
+	UPROPERTY()
+		float DashJumpZVelocity_DEPRECATED = 1200.f;
 
-	UPROPERTY(EditDefaultsOnly, Category = Locomotion)
-		float DashJumpZVelocity = 1200.f;
+	UPROPERTY()
+		float DashSpeed_DEPRECATED = 3000.f;
 
-	UPROPERTY(EditDefaultsOnly, Category = Locomotion)
-		float DashSpeed = 3000.f;
+	UPROPERTY()
+		float DashAcceleration_DEPRECATED = 50000.f;
 
-	UPROPERTY(EditDefaultsOnly, Category = Locomotion)
-		float DashAcceleration = 50000.f;
+	UPROPERTY()
+		float DashCameraLerpTime_DEPRECATED = 1.f;
 
-	UPROPERTY(EditDefaultsOnly, Category = CameraHandling)
-		float DashCameraLerpTime = 1.f;
+	UPROPERTY()
+		float DiveCameraLerpTime_DEPRECATED = 0.4f;
 
-	UPROPERTY(EditDefaultsOnly, Category = CameraHandling)
-		float DiveCameraLerpTime = 0.4f;
+	UPROPERTY()
+		float CameraBoomTargetLength_DEPRECATED = 900.f;
+#endif
 
-	UPROPERTY(EditDefaultsOnly, Category = CameraHandling)
-		float CameraBoomTargetLength = 900.f;
+	FDelegateHandle TuningChangedHandle;
 
 	FVector FrameInputs;
 
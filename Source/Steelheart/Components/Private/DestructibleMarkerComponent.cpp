@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Components/Public/DestructibleMarkerComponent.h"
+#include "GeometryCollection/GeometryCollectionComponent.h"
+#include "Steelheart/Subsystems/Public/DestructibleRegistrySubsystem.h"
+#include "Steelheart/Subsystems/Public/DestructibleSupportSubsystem.h"
+
+// Sets default values for this component's properties
+UDestructibleMarkerComponent::UDestructibleMarkerComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	SupportGraph = nullptr;
+}
+
+// Called when the game starts
+void UDestructibleMarkerComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// The registry removes the owner itself when it ends play
+	if (UDestructibleRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDestructibleRegistrySubsystem>())
+	{
+		Registry->RegisterDestructible(GetOwner());
+	}
+
+	UDestructibleSupportSubsystem* Support = GetWorld()->GetSubsystem<UDestructibleSupportSubsystem>();
+	if (Support != nullptr && SupportGraph != nullptr)
+	{
+		TInlineComponentArray<UGeometryCollectionComponent*> Collections(GetOwner());
+		for (UGeometryCollectionComponent* Collection : Collections)
+		{
+			Support->RegisterBuilding(Collection, SupportGraph);
+		}
+	}
+}
@@ -1,81 +1,388 @@
 #include "Steelheart/Components/Public/FlightCollisionComponent.h"
-#include "Components/SphereComponent.h"
-#include "Field/FieldSystemComponent.h"
-#include "Field/FieldSystemObjects.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/PrimitiveComponent.h"
 #include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Steelheart/Actors/Public/DestructibleProxyActor.h"
+#include "Steelheart/Data/Public/FlightTuningProfile.h"
 #include "Steelheart/Interfaces/Public/FlightLocomotionInterface.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/DestructibleProxySubsystem.h"
+#include "Steelheart/Subsystems/Public/DestructibleRegistrySubsystem.h"
+#include "Steelheart/Subsystems/Public/FlightFieldSubsystem.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Collision Lookahead"), STAT_FlightCollisionLookahead, STATGROUP_Steelheart);
+DECLARE_CYCLE_STAT(TEXT("Flight Collision Prepare"), STAT_FlightCollisionPrepare, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<bool> CVarFlightCollisionLookahead(
+	TEXT("Flight.Collision.Lookahead"),
+	true,
+	TEXT("Prepare the destructibles on the path of fast flyers ahead of the impact."));
+
+static TAutoConsoleVariable<int32> CVarFlightCollisionMaxPreparesPerFrame(
+	TEXT("Flight.Collision.MaxPreparesPerFrame"),
+	1,
+	TEXT("Maximum number of destructibles prepared by a flyer in a frame, the rest wait for the next frames."));
+
+static FAutoConsoleCommandWithWorld FlightCollisionReportCommand(
+	TEXT("Flight.Collision.Report"),
+	TEXT("Log the destructibles prepared ahead of every flyer along with how many impacts were prepared for"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		for (TObjectIterator<UFlightCollisionComponent> It; It; ++It)
+		{
+			if (It->GetWorld() == World)
+			{
+				It->LogReport();
+			}
+		}
+	}));
 
 // Sets default values for this component's properties
 UFlightCollisionComponent::UFlightCollisionComponent()
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.
 	// You can turn these features off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+// Called every frame
+void UFlightCollisionComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	// Bind the ResetHit function to the HitBufferTimerDelegate
-	HitBufferTimerDelegate.BindUFunction(this, "ResetHit");
+	if (Destructibles == nullptr)
+	{
+		return;
+	}
+
+	ProcessDeferredStrikes();
+	ProcessHits();
+	UpdateHitBinding();
+
+	if (!CVarFlightCollisionLookahead.GetValueOnGameThread())
+	{
+		return;
+	}
+
+	TimeSinceLookahead += DeltaTime;
+	if (TimeSinceLookahead >= TuningProfile->Collision.LookaheadInterval)
+	{
+		TimeSinceLookahead = 0.f;
+		LookAhead();
+	}
+
+	// Spread the preparation over the frames before the impact
+	int32 PreparesLeft = CVarFlightCollisionMaxPreparesPerFrame.GetValueOnGameThread();
+	while (PreparesLeft > 0 && PrepareQueue.Num() > 0)
+	{
+		if (AActor* Destructible = PrepareQueue[0].Get())
+		{
+			PrepareDestructible(Destructible);
+			PreparesLeft--;
+		}
+
+		PrepareQueue.RemoveAt(0, 1, false);
+	}
 }
 
 void UFlightCollisionComponent::OnCharacterHit(UPrimitiveComponent* HitComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
-	if (bCanExplode && FlightLocomotionInterface->IsDashing() && OtherActor->ActorHasTag(DestructibleTag))
+	ReceivedHits++;
+
+	// Floor scrapes and other flyers are dropped on the object type alone
+	if (OtherActor == nullptr || OtherComp == nullptr || (HitObjectTypes & ECC_TO_BITFIELD(OtherComp->GetCollisionObjectType())) == 0
+		|| !Destructibles->IsDestructible(OtherActor))
 	{
-		Explode();
+		FilteredHits++;
+		return;
+	}
 
-		bCanExplode = false;
-		GetWorld()->GetTimerManager().SetTimer(HitBufferTimerHandle, HitBufferTimerDelegate, HitBufferTime, false);
+	// Every contact against a destructible and its pieces in the frame comes down to one strike
+	if (PendingHits.Contains(OtherActor))
+	{
+		DuplicateHits++;
+		return;
 	}
+
+	PendingHits.Add(OtherActor);
 }
 
 void UFlightCollisionComponent::InitializeFlightComponent()
 {
 	Super::InitializeFlightComponent();
 
-	// Setup the FieldSystemComponent associated with the owning character's root component
-	FieldSystem = SetupAssociatedComponent<UFieldSystemComponent>(OwnerCharacter->GetRootComponent());
+	// Tick after the owner has moved, so the hits of its move are struck in the same frame
+	if (CharacterMovement != nullptr)
+	{
+		AddTickPrerequisiteComponent(CharacterMovement);
+	}
+
+	Fields = GetWorld()->GetSubsystem<UFlightFieldSubsystem>();
+	Proxies = GetWorld()->GetSubsystem<UDestructibleProxySubsystem>();
+
+	// Actors carrying the destructible tag are registered alongside the marked ones
+	Destructibles = GetWorld()->GetSubsystem<UDestructibleRegistrySubsystem>();
+	if (Destructibles != nullptr)
+	{
+		Destructibles->RegisterTaggedActors(TuningProfile->Collision.DestructibleTag);
+	}
+}
+
+#if WITH_EDITORONLY_DATA
+void UFlightCollisionComponent::MigrateDeprecatedTuning(UFlightTuningProfile* Profile) const
+{
+	FFlightCollisionTuning& Tuning = Profile->Collision;
+	Tuning.SphereRadius = SphereRadius_DEPRECATED;
+	Tuning.FalloffMagnitude = FalloffMagnitude_DEPRECATED;
+	Tuning.VectorMagnitude = VectorMagnitude_DEPRECATED;
+	Tuning.DestructibleTag = DestructibleTag_DEPRECATED;
+	Tuning.HitBufferTime = HitBufferTime_DEPRECATED;
+}
+#endif
+
+void UFlightCollisionComponent::ApplyTuning()
+{
+	HitObjectTypes = 0;
+	for (ECollisionChannel ObjectType : TuningProfile->Collision.DestructibleObjectTypes)
+	{
+		HitObjectTypes |= ECC_TO_BITFIELD(ObjectType);
+	}
+
+	// Destructibles of a type left out of the filter would silently stop taking dash impacts
+	if (Destructibles != nullptr)
+	{
+		Destructibles->AddStrikableObjectTypes(HitObjectTypes);
+	}
+}
+
+void UFlightCollisionComponent::StartDash()
+{
+	// The tick runs after the owner has moved, which would miss the contacts of the dash's first move
+	if (Destructibles != nullptr)
+	{
+		UpdateHitBinding();
+	}
+}
+
+void UFlightCollisionComponent::UpdateHitBinding()
+{
+	if (CapsuleComponent == nullptr)
+	{
+		return;
+	}
+
+	// Outside of dashes nothing is struck, so the capsule's hits need not reach the game thread at all
+	bool bDashing = FlightLocomotionInterface->IsDashing();
+	if (bDashing && !bHitsBound)
+	{
+		CapsuleComponent->OnComponentHit.AddDynamic(this, &UFlightCollisionComponent::OnCharacterHit);
+		bHitsBound = true;
+	}
+	else if (!bDashing && bHitsBound)
+	{
+		CapsuleComponent->OnComponentHit.RemoveDynamic(this, &UFlightCollisionComponent::OnCharacterHit);
+		bHitsBound = false;
+	}
+}
+
+void UFlightCollisionComponent::ProcessHits()
+{
+	if (PendingHits.Num() == 0)
+	{
+		return;
+	}
+
+	float CurrentTime = GetWorld()->GetTimeSeconds();
+	float HitBufferTime = TuningProfile->Collision.HitBufferTime;
+
+	// Forget the targets whose buffer has expired
+	for (auto It = TargetHitTimes.CreateIterator(); It; ++It)
+	{
+		if (!It->Key.IsValid() || CurrentTime - It->Value >= HitBufferTime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (const TWeakObjectPtr<AActor>& Target : PendingHits)
+	{
+		AActor* OtherActor = Target.Get();
+		if (OtherActor == nullptr || TargetHitTimes.Contains(OtherActor))
+		{
+			continue;
+		}
 
-	// Setup the CollisionSphere component associated with the FieldSystemComponent
-	CollisionSphere = SetupAssociatedComponent<USphereComponent>(FieldSystem);
-	CollisionSphere->SetSphereRadius(SphereRadius);
+		TargetHitTimes.Add(OtherActor, CurrentTime);
 
-	// Setup the RadialFalloff component
-	RadialFalloff = SetupAssociatedComponent<URadialFalloff>(nullptr);
+		// A proxy struck before its collection was swapped in has to be swapped in now. One still streaming in is struck
+		// once it lands rather than stalling this frame on the load, the static mesh holding the flyer back meanwhile
+		if (Proxies != nullptr && !Proxies->RequestLive(OtherActor, true))
+		{
+			FDeferredStrike& Deferred = DeferredStrikes.AddDefaulted_GetRef();
+			Deferred.Target = OtherActor;
+			Deferred.Location = OwnerCharacter->GetActorLocation();
+			Deferred.Velocity = OwnerCharacter->GetVelocity();
+			continue;
+		}
 
-	// Setup the RadialVector component
-	RadialVector = SetupAssociatedComponent<URadialVector>(nullptr);
+		Strike(OtherActor, OwnerCharacter->GetActorLocation(), OwnerCharacter->GetVelocity());
+	}
 
-	// Setup the CullingField component
-	CullingField = SetupAssociatedComponent<UCullingField>(nullptr);
+	PendingHits.Reset();
 }
 
-void UFlightCollisionComponent::Explode()
+void UFlightCollisionComponent::ProcessDeferredStrikes()
 {
-	// Get the location of the CollisionSphere component
-	FVector SphereLoc = CollisionSphere->GetComponentLocation();
+	for (int32 StrikeIndex = DeferredStrikes.Num() - 1; StrikeIndex >= 0; StrikeIndex--)
+	{
+		const FDeferredStrike& Deferred = DeferredStrikes[StrikeIndex];
 
-	// Set up the RadialFalloff field properties
-	UFieldNodeBase* RadialFalloffNode = RadialFalloff->SetRadialFalloff(FalloffMagnitude, 0.f, 1.f, 0.f,
-		CollisionSphere->GetScaledSphereRadius(), SphereLoc, Field_FallOff_None);
+		// Proxies that stopped streaming in, swapped back out or destroyed, are not struck anymore
+		ADestructibleProxyActor* Proxy = Cast<ADestructibleProxyActor>(Deferred.Target.Get());
+		if (Proxy == nullptr || (!Proxy->IsLive() && !Proxy->IsLoading()))
+		{
+			DeferredStrikes.RemoveAtSwap(StrikeIndex, 1, false);
+			continue;
+		}
 
-	// Apply the RadialFalloff field to the FieldSystemComponent
-	FieldSystem->ApplyPhysicsField(true, Field_ExternalClusterStrain, nullptr, RadialFalloffNode);
+		if (Proxy->IsLive())
+		{
+			Strike(Proxy, Deferred.Location, Deferred.Velocity);
+			DeferredImpacts++;
+			DeferredStrikes.RemoveAtSwap(StrikeIndex, 1, false);
+		}
+	}
+}
 
-	// Set up the RadialVector field properties
-	UFieldNodeBase* RadialVectorNode = RadialVector->SetRadialVector(VectorMagnitude, SphereLoc);
+void UFlightCollisionComponent::Strike(AActor* Target, const FVector& Location, const FVector& Velocity)
+{
+	// Plays the recorded fracture of a proxy if there is one for this impact
+	if (Proxies != nullptr)
+	{
+		Proxies->PlayImpact(Target, Velocity);
+	}
 
-	// Set up the CullingField properties using the RadialFalloff and RadialVector nodes
-	UFieldNodeBase* CullingFieldNode = CullingField->SetCullingField(RadialFalloffNode, RadialVectorNode, Field_Culling_Outside);
+	Explode(Location);
 
-	// Apply the CullingField to the FieldSystemComponent
-	FieldSystem->ApplyPhysicsField(true, Field_LinearVelocity, nullptr, CullingFieldNode);
+	if (PreparedTimes.Contains(Target))
+	{
+		PreparedImpacts++;
+	}
+	else
+	{
+		UnpreparedImpacts++;
+	}
 }
 
-void UFlightCollisionComponent::ResetHit()
+void UFlightCollisionComponent::Explode(const FVector& Location)
 {
-	// Reset the flag to allow future explosions
-	bCanExplode = true;
+	// The field is submitted with the impacts of every other flyer at the end of the frame
+	if (Fields != nullptr)
+	{
+		const FFlightCollisionTuning& Tuning = TuningProfile->Collision;
+		Fields->QueueImpact(Location, Tuning.SphereRadius, Tuning.FalloffMagnitude, Tuning.VectorMagnitude);
+	}
+}
 
-	// Clear the HitBufferTimerHandle
-	GetWorld()->GetTimerManager().ClearTimer(HitBufferTimerHandle);
+void UFlightCollisionComponent::EmitShockwave(FVector LandLocation)
+{
+	// Nothing is pushed per object, the shockwave joins the field submission of the frame once something is found within it
+	if (Fields != nullptr)
+	{
+		const FFlightCollisionTuning& Tuning = TuningProfile->Collision;
+		Fields->QueueShockwave(LandLocation, Tuning.ShockwaveRadius, Tuning.ShockwaveStrain, Tuning.ShockwaveVelocity);
+	}
+}
+
+void UFlightCollisionComponent::LookAhead()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightCollisionLookahead);
+
+	const FFlightCollisionTuning& Tuning = TuningProfile->Collision;
+	float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	// Forget the destructibles prepared long enough ago
+	for (auto It = PreparedTimes.CreateIterator(); It; ++It)
+	{
+		if (!It->Key.IsValid() || CurrentTime - It->Value >= Tuning.PreparedTime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// Dashes and divebombs are the only movements fast enough to break anything
+	FVector Velocity = OwnerCharacter->GetVelocity();
+	if (!FlightLocomotionInterface->IsDashing() && Velocity.SizeSquared() < FMath::Square(Tuning.LookaheadMinSpeed))
+	{
+		return;
+	}
+
+	FVector Start = OwnerCharacter->GetActorLocation();
+	FVector End = Start + Velocity * Tuning.LookaheadTime;
+
+	FoundDestructibles.Reset();
+	Destructibles->FindAlongSegment(Start, End, Tuning.LookaheadRadius, FoundDestructibles);
+
+	for (AActor* Destructible : FoundDestructibles)
+	{
+		if (!PreparedTimes.Contains(Destructible) && !PrepareQueue.Contains(Destructible))
+		{
+			PrepareQueue.Add(Destructible);
+		}
+	}
+}
+
+void UFlightCollisionComponent::PrepareDestructible(AActor* Destructible)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightCollisionPrepare);
+
+	const FFlightCollisionTuning& Tuning = TuningProfile->Collision;
+
+	// Sleeping bodies would otherwise be woken by the impact itself
+	Destructible->ForEachComponent<UPrimitiveComponent>(false, [](UPrimitiveComponent* Primitive)
+	{
+		if (Primitive->IsSimulatingPhysics())
+		{
+			Primitive->WakeAllRigidBodies();
+		}
+	});
+
+	// Proxies start streaming their collection in, if not already near enough to another flyer
+	if (Proxies != nullptr)
+	{
+		Proxies->RequestLive(Destructible, false);
+	}
+
+	// Interior faces are never seen before the fracture, so their textures are usually not streamed in
+	Destructible->PrestreamTextures(Tuning.PrestreamTime, false);
+
+	PreparedTimes.Add(Destructible, GetWorld()->GetTimeSeconds());
+	PreparedCount++;
+
+	// Have a field graph ready for each destructible that may be struck in the same frame
+	if (Fields != nullptr)
+	{
+		Fields->ReserveGraphs(PreparedTimes.Num());
+	}
+}
+
+void UFlightCollisionComponent::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("%s: %d destructibles prepared, %d ready, %d queued"),
+		*GetNameSafe(GetOwner()), PreparedCount, PreparedTimes.Num(), PrepareQueue.Num());
+
+	UE_LOG(LogTemp, Log, TEXT("  %d impacts against prepared destructibles, %d against unprepared ones, %d struck once streamed in, %d waiting"),
+		PreparedImpacts, UnpreparedImpacts, DeferredImpacts, DeferredStrikes.Num());
+
+	UE_LOG(LogTemp, Log, TEXT("  %d hit notifications, %d filtered out, %d repeated within a frame, listening: %s"),
+		ReceivedHits, FilteredHits, DuplicateHits, bHitsBound ? TEXT("yes") : TEXT("no"));
+
+	for (const TPair<TWeakObjectPtr<AActor>, float>& Prepared : PreparedTimes)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %s  prepared at %.2f"), *GetNameSafe(Prepared.Key.Get()), Prepared.Value);
+	}
 }
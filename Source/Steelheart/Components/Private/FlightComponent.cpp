@@ -2,6 +2,7 @@
 
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Steelheart/Data/Public/FlightTuningProfile.h"
 #include "Steelheart/Interfaces/Public/FlightLocomotionInterface.h"
 
 // Sets default values for this component's properties
@@ -19,6 +20,22 @@ void UFlightComponent::BeginPlay()
 
 	// Initialize the flight component
 	InitializeFlightComponent();
+
+	if (TuningProfile != nullptr)
+	{
+		ApplyTuning();
+
+		// Re-apply whenever a profile is edited or swapped at runtime
+		TuningChangedHandle = UFlightTuningProfile::OnTuningChanged().AddUObject(this, &UFlightComponent::HandleTuningChanged);
+	}
+}
+
+// Called when the game ends
+void UFlightComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UFlightTuningProfile::OnTuningChanged().Remove(TuningChangedHandle);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UFlightComponent::InitializeFlightComponent()
@@ -37,6 +54,7 @@ void UFlightComponent::InitializeFlightComponent()
 			CameraComponent = FlightLocomotionInterface->GetCameraComponent();
 			CapsuleComponent = OwnerCharacter->GetCapsuleComponent();
 			CharacterMovement = OwnerCharacter->GetCharacterMovement();
+			TuningProfile = FlightLocomotionInterface->GetFlightTuningProfile();
 		}
 		else
 		{
@@ -50,3 +68,14 @@ void UFlightComponent::InitializeFlightComponent()
 		UE_LOG(LogTemp, Error, TEXT("FlightComponent owner is not a character."));
 	}
 }
+
+void UFlightComponent::HandleTuningChanged(const UFlightTuningProfile* ChangedProfile)
+{
+	// The owner may have swapped to another profile, so always fetch the current one
+	const UFlightTuningProfile* CurrentProfile = FlightLocomotionInterface->GetFlightTuningProfile();
+	if (CurrentProfile == ChangedProfile || CurrentProfile != TuningProfile)
+	{
+		TuningProfile = CurrentProfile;
+		ApplyTuning();
+	}
+}
@@ -3,11 +3,57 @@
 #include "Steelheart/Components/Public/FlightEffectsComponent.h"
 
 #include "Components/AudioComponent.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "GameFramework/Character.h"
-#include "Kismet/GameplayStatics.h"
+#include "HAL/IConsoleManager.h"
 #include "NiagaraComponent.h"
-#include "NiagaraFunctionLibrary.h"
-#include "Particles/ParticleSystemComponent.h"
+#include "NiagaraSystem.h"
+#include "NiagaraTypes.h"
+#include "Particles/ParticleSystem.h"
+#include "Sound/SoundBase.h"
+#include "Steelheart/Data/Public/FlightTuningProfile.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/FlightEffectsBudgetSubsystem.h"
+#include "Steelheart/Subsystems/Public/FlightEffectsPoolSubsystem.h"
+#include "Steelheart/Subsystems/Public/FlightImpactSubsystem.h"
+#include "Steelheart/Subsystems/Public/FlightTrailSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Effects Acquire"), STAT_FlightEffectsAcquire, STATGROUP_Steelheart);
+DECLARE_CYCLE_STAT(TEXT("Flight Effects Activate"), STAT_FlightEffectsActivate, STATGROUP_Steelheart);
+
+// Scoped timer adding the cost of one effect activation to the stats and the per character totals
+struct FActivationTimer
+{
+	FActivationTimer(int32& InCount, uint64& InCycles)
+		: Count(InCount), Cycles(InCycles), CycleCounter(GET_STATID(STAT_FlightEffectsActivate)), StartCycles(FPlatformTime::Cycles64())
+	{
+	}
+
+	~FActivationTimer()
+	{
+		Cycles += FPlatformTime::Cycles64() - StartCycles;
+		Count++;
+	}
+
+	int32& Count;
+	uint64& Cycles;
+	FScopeCycleCounter CycleCounter;
+	uint64 StartCycles;
+};
+
+static FAutoConsoleCommandWithWorld FlightEffectsReportCommand(
+	TEXT("Flight.Effects.Report"),
+	TEXT("Log the effect components held by every flyer along with their memory and acquisition cost"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		for (TObjectIterator<UFlightEffectsComponent> It; It; ++It)
+		{
+			if (It->GetWorld() == World)
+			{
+				It->LogReport();
+			}
+		}
+	}));
 
 // Sets default values for this component's properties
 UFlightEffectsComponent::UFlightEffectsComponent()
@@ -15,87 +61,165 @@ UFlightEffectsComponent::UFlightEffectsComponent()
 	// Set this component to be initialized when the game starts, and to be ticked every frame.
 	// You can turn these features off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = false;
+
+	IdleReleaseTimerDelegate.BindUFunction(this, "ReleaseIdleComponents");
+	WindUpdateTimerDelegate.BindUFunction(this, "UpdateWindVoice");
 }
 
 void UFlightEffectsComponent::ActivateSonicBoom()
 {
-	// Set the relative rotation of SonicBoomParticles
-	SonicBoomParticles->SetRelativeRotation(SonicBoomDefaultOrientation);
+	FActivationTimer ActivationTimer(ActivationCount, ActivationCycles);
 
-	// Activate SonicBoomParticles and play the associated sound
-	SonicBoomParticles->Activate(true);
-	UGameplayStatics::SpawnSoundAttached(SonicBoomSound, OwnerCharacter->GetMesh());
+	PlaySonicBoom(TuningProfile->Effects.SonicBoomDefaultOrientation);
 }
 
 void UFlightEffectsComponent::ActivateHover()
 {
-	// Set the Niagara asset for HoverNiagara and activate it
-	HoverNiagara->SetAsset(HoverEffect);
-	HoverNiagara->Activate(true);
+	FActivationTimer ActivationTimer(ActivationCount, ActivationCycles);
+
+	// Hover puffs of every flyer are drawn by the shared trail system when the profile provides one
+	if (UseSharedTrails())
+	{
+		FVector PuffLocation = OwnerCharacter->GetMesh()->GetComponentTransform().TransformPosition(TuningProfile->Effects.HoverPosition);
+		Trails->AddPuff(PuffLocation, OwnerCharacter->GetVelocity(), EFlightTrailKind::HoverPuff);
+		return;
+	}
+
+	// Activate HoverNiagara
+	if (UNiagaraComponent* Niagara = UseNiagara(HoverNiagara, TuningProfile->Effects.HoverEffect, TuningProfile->Effects.HoverPosition))
+	{
+		Niagara->Activate(true);
+	}
 }
 
 void UFlightEffectsComponent::ActivateDodge(bool Right)
 {
-	// Set the Niagara asset for HoverNiagara and set the direction parameter based on 'Right' flag
-	HoverNiagara->SetAsset(DodgeEffect);
-	HoverNiagara->SetNiagaraVariableFloat(FString(TEXT("User.Direction")), Right ? 1.f : -1.f);
-	HoverNiagara->Activate(true);
+	FActivationTimer ActivationTimer(ActivationCount, ActivationCycles);
+
+	// Set the direction parameter of DodgeNiagara based on 'Right' flag and activate it
+	if (UNiagaraComponent* Niagara = UseNiagara(DodgeNiagara, TuningProfile->Effects.DodgeEffect, TuningProfile->Effects.HoverPosition,
+		FRotator::ZeroRotator, EEffectPlacement::Absolute))
+	{
+		SetUserParameter(Niagara, DodgeDirectionOffset, Right ? 1.f : -1.f);
+		Niagara->Activate(true);
+	}
 }
 
 void UFlightEffectsComponent::ActivateDiveTrail()
 {
-	// Set the relative rotation of SonicBoomParticles for diving
-	SonicBoomParticles->SetRelativeRotation(SonicBoomDiveOrientation);
+	FActivationTimer ActivationTimer(ActivationCount, ActivationCycles);
 
-	// Activate SonicBoomParticles and play the associated sound
-	SonicBoomParticles->Activate(true);
-	SonicBoomAudio = UGameplayStatics::SpawnSoundAttached(SonicBoomSound, OwnerCharacter->GetMesh());
+	PlaySonicBoom(TuningProfile->Effects.SonicBoomDiveOrientation, true);
 
-	// Activate DiveTrailParticles
-	DiveTrailParticles->Activate(true);
+	// Activate DiveTrailNiagara
+	if (UNiagaraComponent* Niagara = UseNiagara(DiveTrailNiagara, TuningProfile->Effects.DiveTrailEffect))
+	{
+		Niagara->Activate(true);
+	}
 }
 
 void UFlightEffectsComponent::ActivateHardLanding(FVector LandLocation)
 {
+	if (!bEffectsEnabled)
+	{
+		return;
+	}
+
+	FActivationTimer ActivationTimer(ActivationCount, ActivationCycles);
+
 	// Spawn LandEffect Niagara system at the specified location
-	UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, LandEffect, LandLocation);
+	EffectsPool->SpawnSystemAtLocation(UFlightTuningProfile::ResolveAsset(TuningProfile->Effects.LandEffect), LandLocation);
+
+	// Stamp a crater under the landing
+	StampCrater(LandLocation, TuningProfile->Effects.HardLandingCraterRadius);
 
 	// Play the DiveLandSound attached to the OwnerCharacter's mesh
-	UGameplayStatics::SpawnSoundAttached(DiveLandSound, OwnerCharacter->GetMesh());
+	PlayOneShotSound(TuningProfile->Effects.DiveLandSound, TEXT("FlightDiveLand"), TuningProfile->Effects.DiveLandConcurrency);
 }
 
 void UFlightEffectsComponent::ActivateDiveLand(FVector LandLocation)
 {
-	// Deactivate DiveTrailParticles
-	DiveTrailParticles->Deactivate();
+	// Deactivate DiveTrailNiagara
+	if (DiveTrailNiagara != nullptr)
+	{
+		DeactivateEffect(DiveTrailNiagara);
+	}
+
+	if (!bEffectsEnabled)
+	{
+		return;
+	}
+
+	FActivationTimer ActivationTimer(ActivationCount, ActivationCycles);
 
 	// Spawn DiveLandEffect Niagara system at the specified location
-	UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, DiveLandEffect, LandLocation);
+	EffectsPool->SpawnSystemAtLocation(UFlightTuningProfile::ResolveAsset(TuningProfile->Effects.DiveLandEffect), LandLocation);
+
+	// Stamp a crater under the landing
+	StampCrater(LandLocation, TuningProfile->Effects.DiveCraterRadius);
 
-	// Stop and reset SonicBoomAudio if it exists
-	if (SonicBoomAudio != nullptr)
+	// Stop the sonic boom of the dive if it is still ours. The pool may have destroyed it along with its sound, or stolen it
+	// for another user before the finish notification came back
+	UAudioComponent* DiveSonicBoomAudio = SonicBoomAudio.Get();
+	if (IsValid(DiveSonicBoomAudio) && DiveSonicBoomAudio->IsPlaying() && DiveSonicBoomAudio->GetAttachParent() == OwnerCharacter->GetMesh()
+		&& DiveSonicBoomAudio->Sound == TuningProfile->Effects.SonicBoomSound.Get())
 	{
-		SonicBoomAudio->Stop();
-		SonicBoomAudio = nullptr;
+		DiveSonicBoomAudio->Stop();
 	}
 
+	ForgetSonicBoomAudio();
+
 	// Play the DiveLandSound attached to the OwnerCharacter's mesh
-	UGameplayStatics::SpawnSoundAttached(DiveLandSound, OwnerCharacter->GetMesh());
+	PlayOneShotSound(TuningProfile->Effects.DiveLandSound, TEXT("FlightDiveLand"), TuningProfile->Effects.DiveLandConcurrency);
 }
 
 void UFlightEffectsComponent::ToggleDashTrail(bool Enable)
 {
 	if (Enable)
 	{
-		// Activate DashTrailNiagara and WindAudio
-		DashTrailNiagara->Activate(true);
-		WindAudio->Activate(true);
+		FActivationTimer ActivationTimer(ActivationCount, ActivationCycles);
+
+		// Follow the mesh with a shared trail source, or activate DashTrailNiagara, and WindAudio
+		if (UseSharedTrails())
+		{
+			if (DashTrailSourceId == INDEX_NONE)
+			{
+				DashTrailSourceId = Trails->AddTrailSource(OwnerCharacter->GetMesh(), FVector::ZeroVector, EFlightTrailKind::DashTrail);
+			}
+		}
+		else if (UNiagaraComponent* Niagara = UseNiagara(DashTrailNiagara, TuningProfile->Effects.DashTrailEffect,
+			FVector::ZeroVector, TuningProfile->Effects.DashTrailOrientation))
+		{
+			Niagara->Activate(true);
+		}
+
+		// The wind voice is started and kept in step with the flight speed by its update timer
+		if (UseAudio(WindAudio, TuningProfile->Effects.WindSound) != nullptr)
+		{
+			GetWorld()->GetTimerManager().SetTimer(WindUpdateTimerHandle, WindUpdateTimerDelegate, TuningProfile->Effects.WindUpdateInterval, true);
+			UpdateWindVoice();
+		}
 	}
 	else
 	{
-		// Deactivate DashTrailNiagara and WindAudio
-		DashTrailNiagara->Deactivate();
-		WindAudio->Deactivate();
+		// Stop the shared trail source or deactivate DashTrailNiagara, and WindAudio
+		if (DashTrailSourceId != INDEX_NONE)
+		{
+			Trails->RemoveTrailSource(DashTrailSourceId);
+			DashTrailSourceId = INDEX_NONE;
+		}
+
+		if (DashTrailNiagara != nullptr)
+		{
+			DeactivateEffect(DashTrailNiagara);
+		}
+
+		GetWorld()->GetTimerManager().ClearTimer(WindUpdateTimerHandle);
+
+		if (WindAudio != nullptr)
+		{
+			WindAudio->Deactivate();
+		}
 	}
 }
 
@@ -103,94 +227,465 @@ void UFlightEffectsComponent::ToggleTakeOffCharge(bool Enable, bool Activate)
 {
 	if (Enable)
 	{
-		// Activate TakeoffChargeParticles
-		TakeoffChargeParticles->Activate(true);
+		FActivationTimer ActivationTimer(ActivationCount, ActivationCycles);
+
+		// Activate TakeoffChargeNiagara
+		if (UNiagaraComponent* Niagara = UseNiagara(TakeoffChargeNiagara, TuningProfile->Effects.TakeoffChargeEffect))
+		{
+			Niagara->Activate(true);
+		}
 	}
 	else
 	{
-		// Deactivate TakeoffChargeParticles
-
-		TakeoffChargeParticles->Deactivate();
+		// Deactivate TakeoffChargeNiagara
+		if (TakeoffChargeNiagara != nullptr)
+		{
+			DeactivateEffect(TakeoffChargeNiagara);
+		}
 
 		if (Activate)
 		{
-			// Set the relative rotation of SonicBoomParticles for takeoff
-			SonicBoomParticles->SetRelativeRotation(SonicBoomTakeoffOrientation);
+			FActivationTimer ActivationTimer(ActivationCount, ActivationCycles);
+
+			PlaySonicBoom(TuningProfile->Effects.SonicBoomTakeoffOrientation);
+		}
+	}
+}
+
+void UFlightEffectsComponent::LogReport() const
+{
+	const USceneComponent* HeldComponents[] = { SonicBoomNiagara, DiveTrailNiagara, TakeoffChargeNiagara, HoverNiagara, DodgeNiagara, DashTrailNiagara, WindAudio };
+
+	int32 HeldCount = 0;
+	SIZE_T HeldBytes = 0;
+	for (const USceneComponent* Component : HeldComponents)
+	{
+		if (Component != nullptr)
+		{
+			HeldCount++;
+			HeldBytes += Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+	}
 
-			// Activate SonicBoomParticles and play the associated sound
-			SonicBoomParticles->Activate(true);
-			UGameplayStatics::SpawnSoundAttached(SonicBoomSound, OwnerCharacter->GetMesh());
+	float AverageAcquireTime = AcquireCount > 0 ? FPlatformTime::ToMilliseconds64(AcquireCycles) / AcquireCount : 0.f;
+
+	float AverageActivationTime = ActivationCount > 0 ? FPlatformTime::ToMilliseconds64(ActivationCycles) / ActivationCount : 0.f;
+
+	// Sample the child transform propagation paid by every movement update of the mesh
+	USkeletalMeshComponent* Mesh = OwnerCharacter->GetMesh();
+	uint64 StartCycles = FPlatformTime::Cycles64();
+	Mesh->UpdateChildTransforms();
+	double ChildUpdateTime = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	UE_LOG(LogTemp, Log, TEXT("%s: %d effect components held (%.1f KB), %d acquired, %.3f ms average acquire, %d activations, %.3f ms average activation%s"),
+		*GetNameSafe(GetOwner()), HeldCount, HeldBytes / 1024.f, AcquireCount, AverageAcquireTime, ActivationCount, AverageActivationTime,
+		bEffectsEnabled ? TEXT("") : TEXT(", effects disabled"));
+
+	UE_LOG(LogTemp, Log, TEXT("%s: %d components attached to the mesh, %.4f ms to propagate a mesh move to them"),
+		*GetNameSafe(GetOwner()), Mesh->GetAttachChildren().Num(), ChildUpdateTime);
+}
+
+void UFlightEffectsComponent::GatherBudgetedEffects(TArray<FFlightBudgetedEffect>& OutEffects) const
+{
+	bool bLocallyControlled = OwnerCharacter->IsLocallyControlled();
+
+	auto AddEffect = [this, &OutEffects, bLocallyControlled](UFXSystemComponent* Component, EFlightEffectType Type, bool bSustained)
+	{
+		if (Component != nullptr && Component->IsActive())
+		{
+			FFlightBudgetedEffect& Effect = OutEffects.AddDefaulted_GetRef();
+			Effect.Component = Component;
+			Effect.Type = Type;
+			Effect.bLocallyControlled = bLocallyControlled;
+			Effect.bSustained = bSustained && !DeactivatingEffects.Contains(Component);
 		}
+	};
+
+	// Trails and the takeoff charge play until deactivated, the others are one-shots
+	AddEffect(DashTrailNiagara, EFlightEffectType::DashTrail, true);
+	AddEffect(HoverNiagara, EFlightEffectType::Hover, false);
+	AddEffect(DodgeNiagara, EFlightEffectType::Hover, false);
+	AddEffect(SonicBoomNiagara, EFlightEffectType::SonicBoom, false);
+	AddEffect(DiveTrailNiagara, EFlightEffectType::DiveTrail, true);
+	AddEffect(TakeoffChargeNiagara, EFlightEffectType::TakeoffCharge, true);
+}
+
+void UFlightEffectsComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorld()->GetTimerManager().ClearTimer(IdleReleaseTimerHandle);
+	GetWorld()->GetTimerManager().ClearTimer(WindUpdateTimerHandle);
+
+	if (EffectsBudget != nullptr)
+	{
+		EffectsBudget->UnregisterEffects(this);
+	}
+
+	if (DashTrailSourceId != INDEX_NONE)
+	{
+		Trails->RemoveTrailSource(DashTrailSourceId);
+		DashTrailSourceId = INDEX_NONE;
 	}
+
+	ForgetSonicBoomAudio();
+	ReleaseAllComponents();
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UFlightEffectsComponent::InitializeFlightComponent()
 {
 	Super::InitializeFlightComponent();
 
-	// Set up SonicBoomParticles with the specified particle system, position, and rotation
-	SonicBoomParticles = SetupParticleSystemComponent(SonicBoomEffect, SonicBoomDefaultPosition, SonicBoomDefaultOrientation);
+	EffectsPool = GetWorld()->GetSubsystem<UFlightEffectsPoolSubsystem>();
+
+	// Nothing is rendered or heard on a dedicated server, so no effect components are ever acquired there
+	bEffectsEnabled = GetNetMode() != NM_DedicatedServer;
 
-	// Set up DiveTrailParticles with the specified particle system
-	DiveTrailParticles = SetupParticleSystemComponent(DiveTrailEffect);
+	// Effect components are acquired on first activation, so characters that never use an effect hold none
+	if (bEffectsEnabled)
+	{
+		GetWorld()->GetTimerManager().SetTimer(IdleReleaseTimerHandle, IdleReleaseTimerDelegate, 1.f, true);
+
+		EffectsBudget = GetWorld()->GetSubsystem<UFlightEffectsBudgetSubsystem>();
+		EffectsBudget->RegisterEffects(this);
 
-	// Set up TakeoffChargeParticles with the specified particle system
-	TakeoffChargeParticles = SetupParticleSystemComponent(TakeoffChargeEffect);
+		Trails = GetWorld()->GetSubsystem<UFlightTrailSubsystem>();
+	}
+}
+
+#if WITH_EDITORONLY_DATA
+void UFlightEffectsComponent::MigrateDeprecatedTuning(UFlightTuningProfile* Profile) const
+{
+	FFlightEffectsTuning& Tuning = Profile->Effects;
+	Tuning.HoverEffect = HoverEffect_DEPRECATED;
+	Tuning.HoverPosition = HoverPosition_DEPRECATED;
+	Tuning.DashTrailEffect = DashTrailEffect_DEPRECATED;
+	Tuning.DashTrailOrientation = DashTrailOrientation_DEPRECATED;
+	Tuning.DodgeEffect = DodgeEffect_DEPRECATED;
+	Tuning.LandEffect = LandEffect_DEPRECATED;
+	Tuning.WindSound = WindSound_DEPRECATED;
+	Tuning.SonicBoomSound = SonicBoomSound_DEPRECATED;
+	Tuning.SonicBoomDefaultPosition = SonicBoomDefaultPosition_DEPRECATED;
+	Tuning.SonicBoomDivePosition = SonicBoomDivePosition_DEPRECATED;
+	Tuning.SonicBoomDefaultOrientation = SonicBoomDefaultOrientation_DEPRECATED;
+	Tuning.SonicBoomDiveOrientation = SonicBoomDiveOrientation_DEPRECATED;
+	Tuning.SonicBoomTakeoffOrientation = SonicBoomTakeoffOrientation_DEPRECATED;
+	Tuning.SonicBoomSoundStartTime = SonicBoomSoundStartTime_DEPRECATED;
+	Tuning.DiveLandEffect = DiveLandEffect_DEPRECATED;
+	Tuning.DiveLandSound = DiveLandSound_DEPRECATED;
+
+	// The Cascade effects were ported to Niagara and have no slot to go to
+	for (const UParticleSystem* CascadeEffect : { TakeoffChargeEffect_DEPRECATED, SonicBoomEffect_DEPRECATED, DiveTrailEffect_DEPRECATED })
+	{
+		if (CascadeEffect != nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s: Cascade effect %s needs a Niagara replacement in a tuning profile."),
+				*GetPathName(), *CascadeEffect->GetName());
+		}
+	}
+}
+#endif
 
-	// Set up HoverNiagara with the specified Niagara system and position
-	HoverNiagara = SetupNiagaraComponent(HoverEffect, HoverPosition);
+void UFlightEffectsComponent::ApplyTuning()
+{
+	const FFlightEffectsTuning& Tuning = TuningProfile->Effects;
 
-	// Set up DashTrailNiagara with the specified Niagara system and orientation
-	DashTrailNiagara = SetupNiagaraComponent(DashTrailEffect, FVector::Zero(), DashTrailOrientation);
+	// Only attached components already held need updating, the rest pick up their placement on acquisition or activation
+	if (HoverNiagara != nullptr)
+	{
+		HoverNiagara->SetRelativeLocation(Tuning.HoverPosition);
+	}
 
-	// Set up WindAudio component with the specified sound
-	WindAudio = SetupAudioComponent(WindSound);
+	if (DashTrailNiagara != nullptr)
+	{
+		DashTrailNiagara->SetRelativeRotation(Tuning.DashTrailOrientation);
+	}
 }
 
-UParticleSystemComponent* UFlightEffectsComponent::SetupParticleSystemComponent(UParticleSystem* ParticleTemplate, FVector CompLoc, FRotator CompRot)
+UNiagaraComponent* UFlightEffectsComponent::UseNiagara(UNiagaraComponent*& Niagara, const TSoftObjectPtr<UNiagaraSystem>& Effect, FVector CompLoc, FRotator CompRot, EEffectPlacement Placement)
 {
-	// Set up and configure a new particle system component
-	UParticleSystemComponent* NewParticles = SetupAssociatedComponent<UParticleSystemComponent>(OwnerCharacter->GetMesh());
-	if (NewParticles != nullptr)
+	if (!bEffectsEnabled || Effect.IsNull())
 	{
-		// Set the relative location and rotation of the particle system component
-		NewParticles->SetRelativeLocationAndRotation(CompLoc, CompRot);
+		return nullptr;
+	}
 
-		// Set the particle template for the particle system component
-		NewParticles->SetTemplate(ParticleTemplate);
+	if (Niagara == nullptr)
+	{
+		Niagara = AcquireEffectComponent<UNiagaraComponent>(CompLoc, CompRot, Placement);
+	}
+
+	// Set-and-forget effects are placed once per activation and left behind by the flyer
+	if (Placement == EEffectPlacement::Absolute)
+	{
+		Niagara->SetWorldTransform(FTransform(CompRot, CompLoc) * OwnerCharacter->GetMesh()->GetComponentTransform());
 	}
 
-	return NewParticles;
+	// Every slot plays a single system, so the asset is only assigned after acquisition or a profile swap
+	UNiagaraSystem* NiagaraSystemAsset = UFlightTuningProfile::ResolveAsset(Effect);
+	if (Niagara->GetAsset() != NiagaraSystemAsset)
+	{
+		Niagara->SetAsset(NiagaraSystemAsset);
+
+		// Initialize the system now so the first activation only resets it, and cache the offsets of the parameters written on activation
+		Niagara->InitializeSystem();
+
+		if (Niagara == SonicBoomNiagara)
+		{
+			SonicBoomOrientationOffset = FindUserParameterOffset(Niagara, FNiagaraTypeDefinition::GetQuatDef(), TEXT("User.Orientation"));
+		}
+		else if (Niagara == DodgeNiagara)
+		{
+			DodgeDirectionOffset = FindUserParameterOffset(Niagara, FNiagaraTypeDefinition::GetFloatDef(), TEXT("User.Direction"));
+		}
+	}
+
+	LastUsedTimes.Add(Niagara, GetWorld()->GetTimeSeconds());
+	DeactivatingEffects.Remove(Niagara);
+
+	return Niagara;
+}
+
+void UFlightEffectsComponent::DeactivateEffect(UNiagaraComponent* Niagara)
+{
+	// A system culled by the budget is paused and would never finish, and has nothing on screen left to fade out
+	if (EffectsBudget->ForgetEffect(Niagara) == EFlightEffectTier::Culled)
+	{
+		Niagara->DeactivateImmediate();
+		return;
+	}
+
+	Niagara->Deactivate();
+	DeactivatingEffects.Add(Niagara);
+}
+
+UAudioComponent* UFlightEffectsComponent::UseAudio(UAudioComponent*& Audio, const TSoftObjectPtr<USoundBase>& Sound)
+{
+	if (!bEffectsEnabled || Sound.IsNull())
+	{
+		return nullptr;
+	}
+
+	if (Audio == nullptr)
+	{
+		Audio = AcquireEffectComponent<UAudioComponent>(FVector::ZeroVector, FRotator::ZeroRotator, EEffectPlacement::Attached);
+	}
+
+	// Skip the sound reset if already assigned
+	USoundBase* AudioSound = UFlightTuningProfile::ResolveAsset(Sound);
+	if (Audio->Sound != AudioSound)
+	{
+		Audio->SetSound(AudioSound);
+	}
+
+	LastUsedTimes.Add(Audio, GetWorld()->GetTimeSeconds());
+
+	return Audio;
+}
+
+bool UFlightEffectsComponent::UseSharedTrails() const
+{
+	if (Trails == nullptr || TuningProfile->Effects.SharedTrailEffect.IsNull())
+	{
+		return false;
+	}
+
+	// Profiles pointing at another shared system than the one already drawing fall back to their own components
+	return Trails->SetTrailSystem(UFlightTuningProfile::ResolveAsset(TuningProfile->Effects.SharedTrailEffect));
 }
 
-UNiagaraComponent* UFlightEffectsComponent::SetupNiagaraComponent(UNiagaraSystem* NiagaraSystemAsset, FVector CompLoc, FRotator CompRot)
+void UFlightEffectsComponent::PlaySonicBoom(const FRotator& Orientation, bool bKeepSound)
 {
-	// Set up and configure a new Niagara component
-	UNiagaraComponent* NewNiagara = SetupAssociatedComponent<UNiagaraComponent>(OwnerCharacter->GetMesh());
-	if (NewNiagara != nullptr)
+	// The orientation variants are a parameter of one initialized system rather than a component rotation
+	if (UNiagaraComponent* Niagara = UseNiagara(SonicBoomNiagara, TuningProfile->Effects.SonicBoomEffect, TuningProfile->Effects.SonicBoomDefaultPosition,
+		FRotator::ZeroRotator, EEffectPlacement::Absolute))
 	{
-		// Set the relative location and rotation of the Niagara component
-		NewNiagara->SetRelativeLocationAndRotation(CompLoc, CompRot);
+		SetUserParameter(Niagara, SonicBoomOrientationOffset, FQuat4f(Orientation.Quaternion()));
+		Niagara->Activate(true);
+	}
+
+	// Play the associated sound
+	if (bEffectsEnabled)
+	{
+		UAudioComponent* Audio = PlayOneShotSound(TuningProfile->Effects.SonicBoomSound, TEXT("FlightSonicBoom"), TuningProfile->Effects.SonicBoomConcurrency);
+		if (bKeepSound && Audio != nullptr)
+		{
+			ForgetSonicBoomAudio();
 
-		// Set the Niagara asset for the Niagara component
-		NewNiagara->SetAsset(NiagaraSystemAsset);
+			SonicBoomAudio = Audio;
+			Audio->OnAudioFinishedNative.AddUObject(this, &UFlightEffectsComponent::HandleSonicBoomAudioFinished);
+		}
 	}
+}
+
+void UFlightEffectsComponent::HandleSonicBoomAudioFinished(UAudioComponent* AudioComponent)
+{
+	AudioComponent->OnAudioFinishedNative.RemoveAll(this);
 
-	return NewNiagara;
+	if (SonicBoomAudio.Get() == AudioComponent)
+	{
+		SonicBoomAudio.Reset();
+	}
 }
 
-UAudioComponent* UFlightEffectsComponent::SetupAudioComponent(USoundBase* AudioSound, FVector CompLoc, FRotator CompRot)
+void UFlightEffectsComponent::ForgetSonicBoomAudio()
 {
-	// Set up and configure a new audio component
-	UAudioComponent* NewAudio = SetupAssociatedComponent<UAudioComponent>(OwnerCharacter->GetMesh());
-	if (NewAudio != nullptr)
+	if (UAudioComponent* Audio = SonicBoomAudio.Get())
 	{
-		// Set the relative location and rotation of the audio component
-		NewAudio->SetRelativeLocationAndRotation(CompLoc, CompRot);
+		Audio->OnAudioFinishedNative.RemoveAll(this);
+	}
 
-		// Set the sound for the audio component
-		NewAudio->SetSound(AudioSound);
+	SonicBoomAudio.Reset();
+}
+
+void UFlightEffectsComponent::StampCrater(FVector LandLocation, float Radius)
+{
+	// Without a decal the landing still presses its crater into the procedural meshes under it
+	if (UFlightImpactSubsystem* Impacts = GetWorld()->GetSubsystem<UFlightImpactSubsystem>())
+	{
+		Impacts->StampImpact(LandLocation, Radius, TuningProfile->Effects.CraterDepth, UFlightTuningProfile::ResolveAsset(TuningProfile->Effects.CraterDecal));
 	}
+}
+
+UAudioComponent* UFlightEffectsComponent::PlayOneShotSound(const TSoftObjectPtr<USoundBase>& Sound, FName ConcurrencyGroup, const FSoundConcurrencySettings& Concurrency)
+{
+	return EffectsPool->SpawnSoundAttached(UFlightTuningProfile::ResolveAsset(Sound), OwnerCharacter->GetMesh(),
+		EffectsPool->GetConcurrencyGroup(ConcurrencyGroup, Concurrency), TuningProfile->Effects.OneShotAudibleDistance);
+}
+
+void UFlightEffectsComponent::UpdateWindVoice()
+{
+	if (WindAudio == nullptr)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(WindUpdateTimerHandle);
+		return;
+	}
+
+	const FFlightEffectsTuning& Tuning = TuningProfile->Effects;
+
+	// Keep the slot from being released while the wind is wanted but virtualized
+	LastUsedTimes.Add(WindAudio, GetWorld()->GetTimeSeconds());
+
+	// Out of earshot the voice is stopped rather than mixed silently, and restarted once back in range
+	if (EffectsPool->GetListenerDistance(OwnerCharacter->GetActorLocation()) > Tuning.WindVirtualizeDistance)
+	{
+		if (WindAudio->IsPlaying())
+		{
+			WindAudio->Stop();
+		}
+
+		return;
+	}
+
+	if (!WindAudio->IsPlaying())
+	{
+		WindAudio->Play();
+	}
+
+	float NormalizedSpeed = OwnerCharacter->GetVelocity().Size() / FMath::Max(TuningProfile->Character.DashSpeed, 1.f);
+	WindAudio->SetFloatParameter(Tuning.WindSpeedParameter, NormalizedSpeed);
+}
+
+int32 UFlightEffectsComponent::FindUserParameterOffset(UNiagaraComponent* Niagara, const FNiagaraTypeDefinition& Type, FName Name)
+{
+	const int32* Offset = Niagara->GetOverrideParameters().FindParameterOffset(FNiagaraVariable(Type, Name));
+	if (Offset == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s does not expose the %s parameter"), *GetNameSafe(Niagara->GetAsset()), *Name.ToString());
+		return INDEX_NONE;
+	}
+
+	return *Offset;
+}
+
+template<typename T>
+void UFlightEffectsComponent::SetUserParameter(UNiagaraComponent* Niagara, int32 Offset, const T& Value)
+{
+	if (Offset != INDEX_NONE)
+	{
+		Niagara->GetOverrideParameters().SetParameterData(reinterpret_cast<const uint8*>(&Value), Offset, sizeof(T));
+	}
+}
+
+template<typename T>
+T* UFlightEffectsComponent::AcquireEffectComponent(FVector CompLoc, FRotator CompRot, EEffectPlacement Placement)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightEffectsAcquire);
+
+	uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// Pooled components come back detached, registered and inactive. None stays attached to the mesh while idle,
+	// so moving the character only updates the transforms of the effects actually playing
+	T* NewComp = EffectsPool->AcquireComponent<T>(nullptr);
+
+	if (Placement == EEffectPlacement::Attached)
+	{
+		// Attach on activation and detach once the effect completes, keeping the offset relative to the mesh
+		NewComp->bAutoManageAttachment = true;
+		NewComp->AutoAttachParent = OwnerCharacter->GetMesh();
+		NewComp->AutoAttachSocketName = NAME_None;
+		NewComp->AutoAttachLocationRule = EAttachmentRule::KeepRelative;
+		NewComp->AutoAttachRotationRule = EAttachmentRule::KeepRelative;
+		NewComp->AutoAttachScaleRule = EAttachmentRule::KeepWorld;
+		NewComp->SetRelativeLocationAndRotation(CompLoc, CompRot);
+	}
+	else
+	{
+		NewComp->SetUsingAbsoluteLocation(true);
+		NewComp->SetUsingAbsoluteRotation(true);
+		NewComp->SetUsingAbsoluteScale(true);
+	}
+
+	AcquireCycles += FPlatformTime::Cycles64() - StartCycles;
+	AcquireCount++;
+
+	return NewComp;
+}
+
+template<typename T>
+void UFlightEffectsComponent::ReleaseIfIdle(T*& Slot, float CurrentTime, bool bForce)
+{
+	if (Slot == nullptr)
+	{
+		return;
+	}
+
+	if (bForce || (!Slot->IsActive() && CurrentTime - LastUsedTimes.FindRef(Slot) > TuningProfile->Effects.IdleReleaseTime))
+	{
+		LastUsedTimes.Remove(Slot);
+		DeactivatingEffects.Remove(Slot);
+		EffectsBudget->ForgetEffect(Slot);
+		EffectsPool->ReleaseComponent(Slot);
+		Slot = nullptr;
+	}
+}
+
+void UFlightEffectsComponent::ReleaseIdleComponents()
+{
+	float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	ReleaseIfIdle(SonicBoomNiagara, CurrentTime);
+	ReleaseIfIdle(DiveTrailNiagara, CurrentTime);
+	ReleaseIfIdle(TakeoffChargeNiagara, CurrentTime);
+	ReleaseIfIdle(HoverNiagara, CurrentTime);
+	ReleaseIfIdle(DodgeNiagara, CurrentTime);
+	ReleaseIfIdle(DashTrailNiagara, CurrentTime);
+	ReleaseIfIdle(WindAudio, CurrentTime);
+}
+
+void UFlightEffectsComponent::ReleaseAllComponents()
+{
+	if (EffectsPool == nullptr)
+	{
+		return;
+	}
+
+	float CurrentTime = GetWorld()->GetTimeSeconds();
 
-	return NewAudio;
+	ReleaseIfIdle(SonicBoomNiagara, CurrentTime, true);
+	ReleaseIfIdle(DiveTrailNiagara, CurrentTime, true);
+	ReleaseIfIdle(TakeoffChargeNiagara, CurrentTime, true);
+	ReleaseIfIdle(HoverNiagara, CurrentTime, true);
+	ReleaseIfIdle(DodgeNiagara, CurrentTime, true);
+	ReleaseIfIdle(DashTrailNiagara, CurrentTime, true);
+	ReleaseIfIdle(WindAudio, CurrentTime, true);
 }
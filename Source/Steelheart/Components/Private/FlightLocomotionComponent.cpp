@@ -1,12 +1,17 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Steelheart/Components/Public/FlightLocomotionComponent.h"
+#include "Animation/AnimMontage.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Steelheart/Data/Public/FlightTuningProfile.h"
 #include "Steelheart/Interfaces/Public/FlightLocomotionInterface.h"
+#include "Steelheart/Steelheart.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Locomotion Tick"), STAT_FlightLocomotionTick, STATGROUP_Steelheart);
 
 // Sets default values for this component's properties
 UFlightLocomotionComponent::UFlightLocomotionComponent()
@@ -33,27 +38,57 @@ void UFlightLocomotionComponent::BeginPlay()
 	CapsuleHalfHeight = CapsuleComponent->GetUnscaledCapsuleHalfHeight();
 
 	// Set character movement properties
-	CharacterMovement->MaxAcceleration = BaseAcceleration;
-	CharacterMovement->BrakingDecelerationFlying = BrakingDecelerationFlying;
-
-	// Calculate divebomb start and land section lengths based on montage
-	if (ensure(DivebombMontage != nullptr))
-	{
-		int32 StartSectionIndex = DivebombMontage->GetSectionIndex("Default");
-		DivebombStartSectionLength = DivebombMontage->GetSectionLength(StartSectionIndex) / DIVEBOMB_RATE_SCALE;
-
-		int32 LandSectionIndex = DivebombMontage->GetSectionIndex(DiveMontageLandSectionName);
-		DivebombLandSectionLength = DivebombMontage->GetSectionLength(LandSectionIndex) / DIVEBOMB_RATE_SCALE;
-	}
+	CharacterMovement->MaxAcceleration = TuningProfile->Locomotion.BaseAcceleration;
 
 	// Set trace parameters for divebomb
 	DivebombTraceParams.AddIgnoredActor(OwnerCharacter);
 	DivebombTraceParams.bTraceComplex = true;
 }
 
+#if WITH_EDITORONLY_DATA
+void UFlightLocomotionComponent::MigrateDeprecatedTuning(UFlightTuningProfile* Profile) const
+{
+	FFlightLocomotionTuning& Tuning = Profile->Locomotion;
+	Tuning.HardLandingMontage = HardLandingMontage_DEPRECATED;
+	Tuning.DivebombMontage = DivebombMontage_DEPRECATED;
+	Tuning.DiveMontageLandSectionName = DiveMontageLandSectionName_DEPRECATED;
+	Tuning.DiveEngageHeightBuffer = DiveEngageHeightBuffer_DEPRECATED;
+	Tuning.DiveEngageFloorCheckTraceRatio = DiveEngageFloorCheckTraceRatio_DEPRECATED;
+	Tuning.DiveLandFloorCheckTraceRatio = DiveLandFloorCheckTraceRatio_DEPRECATED;
+	Tuning.DivebombVelocity = DivebombVelocity_DEPRECATED;
+	Tuning.SoftLandingLimit = SoftLandingLimit_DEPRECATED;
+	Tuning.BaseSpeed = BaseSpeed_DEPRECATED;
+	Tuning.DashSpeed = DashSpeed_DEPRECATED;
+	Tuning.BaseAcceleration = BaseAcceleration_DEPRECATED;
+	Tuning.DashAcceleration = DashAcceleration_DEPRECATED;
+	Tuning.BaseDodgeForce = BaseDodgeForce_DEPRECATED;
+	Tuning.BrakingDecelerationFlying = BrakingDecelerationFlying_DEPRECATED;
+	Tuning.RotationInterpSpeed = RotationInterpSpeed_DEPRECATED;
+	Tuning.DodgeInterpSpeed = DodgeInterpSpeed_DEPRECATED;
+	Tuning.ZMomentumCoeff = ZMomentumCoeff_DEPRECATED;
+	Tuning.DodgeTime = DodgeTime_DEPRECATED;
+	Tuning.DodgeBufferTime = DodgeBufferTime_DEPRECATED;
+}
+#endif
+
+void UFlightLocomotionComponent::ApplyTuning()
+{
+	CharacterMovement->BrakingDecelerationFlying = TuningProfile->Locomotion.BrakingDecelerationFlying;
+
+	// Refresh the flight limits if the profile changed mid-flight
+	if (CharacterMovement->IsFlying())
+	{
+		bool bDashing = FlightLocomotionInterface->IsDashing();
+		CharacterMovement->MaxFlySpeed = bDashing ? TuningProfile->Locomotion.DashSpeed : TuningProfile->Locomotion.BaseSpeed;
+		CharacterMovement->MaxAcceleration = bDashing ? TuningProfile->Locomotion.DashAcceleration : TuningProfile->Locomotion.BaseAcceleration;
+	}
+}
+
 // Called every frame
 void UFlightLocomotionComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
+	SCOPE_CYCLE_COUNTER(STAT_FlightLocomotionTick);
+
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
 	// Check if the character is flying
@@ -88,8 +123,8 @@ void UFlightLocomotionComponent::TickComponent(float DeltaTime, ELevelTick TickT
 void UFlightLocomotionComponent::Fly()
 {
 	// Set character movement properties for flight
-	CharacterMovement->MaxFlySpeed = BaseSpeed;
-	CharacterMovement->MaxAcceleration = BaseAcceleration;
+	CharacterMovement->MaxFlySpeed = TuningProfile->Locomotion.BaseSpeed;
+	CharacterMovement->MaxAcceleration = TuningProfile->Locomotion.BaseAcceleration;
 
 	CharacterMovement->SetMovementMode(MOVE_Flying);
 }
@@ -103,7 +138,7 @@ void UFlightLocomotionComponent::StopFlying()
 	FVector CapsuleLinearVelocity = CapsuleComponent->GetPhysicsLinearVelocity();
 	float ZMomentum = CapsuleLinearVelocity.Z;
 
-	FVector LaunchVelocity(0.f, 0.f, ZMomentum * ZMomentumCoeff);
+	FVector LaunchVelocity(0.f, 0.f, ZMomentum * TuningProfile->Locomotion.ZMomentumCoeff);
 	OwnerCharacter->LaunchCharacter(LaunchVelocity, false, true);
 
 	// Set movement mode to falling and restore capsule half height
@@ -114,8 +149,8 @@ void UFlightLocomotionComponent::StopFlying()
 void UFlightLocomotionComponent::Dash()
 {
 	// Set character movement properties for dashing
-	CharacterMovement->MaxFlySpeed = DashSpeed;
-	CharacterMovement->MaxAcceleration = DashAcceleration;
+	CharacterMovement->MaxFlySpeed = TuningProfile->Locomotion.DashSpeed;
+	CharacterMovement->MaxAcceleration = TuningProfile->Locomotion.DashAcceleration;
 
 	// Adjust capsule half height
 	CapsuleComponent->SetCapsuleHalfHeight(CapsuleComponent->GetUnscaledCapsuleRadius());
@@ -126,8 +161,8 @@ void UFlightLocomotionComponent::Dash()
 void UFlightLocomotionComponent::StopDashing()
 {
 	// Reset character movement properties after dashing
-	CharacterMovement->MaxFlySpeed = BaseSpeed;
-	CharacterMovement->MaxAcceleration = BaseAcceleration;
+	CharacterMovement->MaxFlySpeed = TuningProfile->Locomotion.BaseSpeed;
+	CharacterMovement->MaxAcceleration = TuningProfile->Locomotion.BaseAcceleration;
 
 	// Restore capsule half height
 	CapsuleComponent->SetCapsuleHalfHeight(CapsuleHalfHeight);
@@ -146,10 +181,10 @@ void UFlightLocomotionComponent::RightDodge()
 		bIsDodging = true;
 		bIsDodgingRight = true;
 
-		CurrentDodgeForce = BaseDodgeForce;
+		CurrentDodgeForce = TuningProfile->Locomotion.BaseDodgeForce;
 
 		// Set a timer to reset the dodge state
-		GetWorld()->GetTimerManager().SetTimer(DodgeTimerHandle, DodgeTimerDelegate, DodgeTime, false);
+		GetWorld()->GetTimerManager().SetTimer(DodgeTimerHandle, DodgeTimerDelegate, TuningProfile->Locomotion.DodgeTime, false);
 	}
 }
 
@@ -161,10 +196,10 @@ void UFlightLocomotionComponent::LeftDodge()
 		bIsDodging = true;
 		bIsDodgingLeft = true;
 
-		CurrentDodgeForce = BaseDodgeForce;
+		CurrentDodgeForce = TuningProfile->Locomotion.BaseDodgeForce;
 
 		// Set a timer to reset the dodge state
-		GetWorld()->GetTimerManager().SetTimer(DodgeTimerHandle, DodgeTimerDelegate, DodgeTime, false);
+		GetWorld()->GetTimerManager().SetTimer(DodgeTimerHandle, DodgeTimerDelegate, TuningProfile->Locomotion.DodgeTime, false);
 	}
 }
 
@@ -176,11 +211,12 @@ bool UFlightLocomotionComponent::HandleCharacterLanding(const FHitResult& Hit)
 		float FallDistance = LandingInitiationLocationZ - OwnerCharacter->GetActorLocation().Z;
 
 		// Check if the character fell from a significant height and divebomb was not initiated
-		if (FallDistance > SoftLandingLimit && !bInitiatedDivebomb)
+		if (FallDistance > TuningProfile->Locomotion.SoftLandingLimit && !bInitiatedDivebomb)
 		{
 			OwnerCharacter->DisableInput(UGameplayStatics::GetPlayerController(GetWorld(), 0));
 
 			// Play hard landing montage if available
+			UAnimMontage* HardLandingMontage = UFlightTuningProfile::ResolveAsset(TuningProfile->Locomotion.HardLandingMontage);
 			if (ensure(HardLandingMontage != nullptr))
 				OwnerCharacter->PlayAnimMontage(HardLandingMontage);
 
@@ -199,7 +235,8 @@ void UFlightLocomotionComponent::SetLandingInitiationLocationZ(float Value)
 void UFlightLocomotionComponent::StopDivebomb()
 {
 	bInitiatedDivebomb = false;
-	OwnerCharacter->StopAnimMontage(DivebombMontage);
+	// A montage that was never streamed in cannot be playing
+	OwnerCharacter->StopAnimMontage(TuningProfile->Locomotion.DivebombMontage.Get());
 
 	// Clear the divebomb timer
 	GetWorld()->GetTimerManager().ClearTimer(DivebombTimerHandle);
@@ -233,7 +270,7 @@ void UFlightLocomotionComponent::UpdateRotation(float DeltaTime)
 	}
 
 	// Interpolate the current rotation towards the target rotation
-	FRotator NewRotation = FMath::RInterpTo(CurrentRotation, TargetRotation, DeltaTime, RotationInterpSpeed);
+	FRotator NewRotation = FMath::RInterpTo(CurrentRotation, TargetRotation, DeltaTime, TuningProfile->Locomotion.RotationInterpSpeed);
 	OwnerCharacter->SetActorRotation(NewRotation);
 }
 
@@ -265,7 +302,7 @@ void UFlightLocomotionComponent::ApplyDodgeForce(float DeltaTime)
 	CharacterMovement->AddForce(DodgeForce);
 
 	// Interpolate the dodge force towards 0 over time
-	CurrentDodgeForce = FMath::FInterpTo(CurrentDodgeForce, 0.f, DeltaTime, DodgeInterpSpeed);
+	CurrentDodgeForce = FMath::FInterpTo(CurrentDodgeForce, 0.f, DeltaTime, TuningProfile->Locomotion.DodgeInterpSpeed);
 }
 
 void UFlightLocomotionComponent::SmoothResetPitch(float DeltaTime)
@@ -289,7 +326,7 @@ void UFlightLocomotionComponent::SmoothResetPitch(float DeltaTime)
 		FRotator TargetRotation = CapsuleComponent->GetComponentRotation();
 		TargetRotation.Pitch = 0.f;
 
-		FRotator NewRotation = FMath::RInterpTo(CurrentRotation, TargetRotation, DeltaTime, RotationInterpSpeed);
+		FRotator NewRotation = FMath::RInterpTo(CurrentRotation, TargetRotation, DeltaTime, TuningProfile->Locomotion.RotationInterpSpeed);
 		OwnerCharacter->SetActorRotation(NewRotation);
 	}
 }
@@ -299,11 +336,11 @@ void UFlightLocomotionComponent::InitiateDivebombStart()
 	float FallDistance = LandingInitiationLocationZ - OwnerCharacter->GetActorLocation().Z;
 
 	// Check if the character has fallen from a distance greater than the dive engage height buffer
-	if (FallDistance > DiveEngageHeightBuffer)
+	if (FallDistance > TuningProfile->Locomotion.DiveEngageHeightBuffer)
 	{
 		FHitResult Hit;
 		FVector TraceStart = OwnerCharacter->GetActorLocation();
-		FVector TraceEnd = TraceStart - FVector::UpVector * DiveEngageHeightBuffer * DiveEngageFloorCheckTraceRatio;
+		FVector TraceEnd = TraceStart - FVector::UpVector * TuningProfile->Locomotion.DiveEngageHeightBuffer * TuningProfile->Locomotion.DiveEngageFloorCheckTraceRatio;
 
 		// Perform a line trace to check for obstacles
 		if (!GetWorld()->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, ECC_WorldStatic, DivebombTraceParams))
@@ -311,11 +348,12 @@ void UFlightLocomotionComponent::InitiateDivebombStart()
 			bInitiatedDivebomb = true;
 
 			// Play the divebomb montage if available
+			UAnimMontage* DivebombMontage = UFlightTuningProfile::ResolveAsset(TuningProfile->Locomotion.DivebombMontage);
 			if (ensure(DivebombMontage != nullptr))
 				OwnerCharacter->PlayAnimMontage(DivebombMontage);
 
 			// Set a timer for the divebomb start section length
-			GetWorld()->GetTimerManager().SetTimer(DivebombTimerHandle, DivebombTimerDelegate, DivebombStartSectionLength, false);
+			GetWorld()->GetTimerManager().SetTimer(DivebombTimerHandle, DivebombTimerDelegate, TuningProfile->Baked.DivebombStartSectionLength, false);
 		}
 	}
 }
@@ -324,18 +362,19 @@ void UFlightLocomotionComponent::UpdateDivebomb(float DeltaTime)
 {
 	FHitResult Hit;
 	FVector TraceStart = OwnerCharacter->GetActorLocation();
-	FVector TraceEnd = TraceStart - FVector::UpVector * CapsuleHalfHeight * DiveLandFloorCheckTraceRatio;
+	FVector TraceEnd = TraceStart - FVector::UpVector * CapsuleHalfHeight * TuningProfile->Locomotion.DiveLandFloorCheckTraceRatio;
 
 	// Set the character's velocity for divebombing
-	CharacterMovement->Velocity = -FVector::UpVector * DivebombVelocity;
+	CharacterMovement->Velocity = -FVector::UpVector * TuningProfile->Locomotion.DivebombVelocity;
 
 	// Perform a line trace to check for the landing surface
 	if (!bIsLandingDivebomb && GetWorld()->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, ECC_WorldStatic, DivebombTraceParams))
 	{
+		UAnimMontage* DivebombMontage = UFlightTuningProfile::ResolveAsset(TuningProfile->Locomotion.DivebombMontage);
 		if (ensure(DivebombMontage != nullptr))
 		{
 			// Play the divebomb montage at a specified section and disable character input
-			OwnerCharacter->PlayAnimMontage(DivebombMontage, 1.f, DiveMontageLandSectionName);
+			OwnerCharacter->PlayAnimMontage(DivebombMontage, 1.f, TuningProfile->Locomotion.DiveMontageLandSectionName);
 			OwnerCharacter->DisableInput(UGameplayStatics::GetPlayerController(GetWorld(), 0));
 
 			// Execute the divebomb land event and set flags
@@ -344,7 +383,7 @@ void UFlightLocomotionComponent::UpdateDivebomb(float DeltaTime)
 			bIsLandingDivebomb = true;
 
 			// Set a timer for the divebomb land section length
-			GetWorld()->GetTimerManager().SetTimer(DivebombLandTimerHandle, DivebombLandTimerDelegate, DivebombLandSectionLength, false);
+			GetWorld()->GetTimerManager().SetTimer(DivebombLandTimerHandle, DivebombLandTimerDelegate, TuningProfile->Baked.DivebombLandSectionLength, false);
 		}
 	}
 }
@@ -356,7 +395,7 @@ void UFlightLocomotionComponent::ResetDodge()
 	bIsDodgingLeft = false;
 
 	GetWorld()->GetTimerManager().ClearTimer(DodgeTimerHandle);
-	GetWorld()->GetTimerManager().SetTimer(DodgeResetBufferTimerHandle, DodgeResetBufferTimerDelegate, DodgeBufferTime, false);
+	GetWorld()->GetTimerManager().SetTimer(DodgeResetBufferTimerHandle, DodgeResetBufferTimerDelegate, TuningProfile->Locomotion.DodgeBufferTime, false);
 }
 
 void UFlightLocomotionComponent::ResetDodgeTimer()
@@ -0,0 +1,260 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Components/Public/FlightScalabilityComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Steelheart/Data/Public/FlightTuningProfile.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/FlightEffectsBudgetSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Scalability Tick"), STAT_FlightScalabilityTick, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight Throttled Meshes"), STAT_FlightThrottledMeshes, STATGROUP_Steelheart);
+
+static FAutoConsoleCommandWithWorld FlightScalabilityReportCommand(
+	TEXT("Flight.Scalability.Report"),
+	TEXT("Log the speed driven detail scaling of the local flyers along with the frame times at normal and lowered detail"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		for (TObjectIterator<UFlightScalabilityComponent> It; It; ++It)
+		{
+			if (It->GetWorld() == World)
+			{
+				It->LogReport();
+			}
+		}
+	}));
+
+// Sets default values for this component's properties
+UFlightScalabilityComponent::UFlightScalabilityComponent()
+{
+	// Set this component to be initialized when the game starts, and to be ticked every frame.
+	// You can turn these features off to improve performance if you don't need them.
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+void UFlightScalabilityComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (OwnerCharacter != nullptr)
+	{
+		OwnerCharacter->ReceiveControllerChangedDelegate.AddUniqueDynamic(this, &UFlightScalabilityComponent::HandleControllerChanged);
+		HandleControllerChanged(OwnerCharacter, nullptr, OwnerCharacter->GetController());
+	}
+}
+
+void UFlightScalabilityComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (OwnerCharacter != nullptr)
+	{
+		OwnerCharacter->ReceiveControllerChangedDelegate.RemoveDynamic(this, &UFlightScalabilityComponent::HandleControllerChanged);
+	}
+
+	RestoreAll();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame
+void UFlightScalabilityComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightScalabilityTick);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const FFlightScalabilityTuning& Tuning = TuningProfile->Scalability;
+
+	// Scale by speed while flying or falling, divebombs are far past the full speed
+	float TargetAlpha = 0.f;
+	if (CharacterMovement->IsFlying() || CharacterMovement->IsFalling())
+	{
+		float Speed = OwnerCharacter->GetVelocity().Size();
+		TargetAlpha = FMath::SmoothStep(Tuning.DetailBiasStartSpeed, Tuning.DetailBiasFullSpeed, Speed);
+	}
+
+	float BlendSpeed = TargetAlpha > ScalingAlpha ? Tuning.BlendInSpeed : Tuning.BlendOutSpeed;
+	ScalingAlpha = FMath::FInterpConstantTo(ScalingAlpha, TargetAlpha, DeltaTime, BlendSpeed);
+
+	// Apply in steps so the render console variables are not set every frame
+	if (FMath::Abs(ScalingAlpha - AppliedAlpha) >= 0.1f || (ScalingAlpha != AppliedAlpha && (ScalingAlpha == 0.f || ScalingAlpha == 1.f)))
+	{
+		AppliedAlpha = ScalingAlpha;
+		ApplyScaling();
+	}
+
+	TimeSinceDistantUpdate += DeltaTime;
+	if (TimeSinceDistantUpdate >= Tuning.DistantActorUpdateInterval)
+	{
+		TimeSinceDistantUpdate = 0.f;
+		UpdateDistantActors();
+	}
+
+	// Accumulate the frame times at either end, in headless runs these track the game thread time
+	if (AppliedAlpha == 0.f)
+	{
+		NormalFrameTime += DeltaTime;
+		NormalFrameCount++;
+	}
+	else if (AppliedAlpha == 1.f)
+	{
+		ScaledFrameTime += DeltaTime;
+		ScaledFrameCount++;
+	}
+}
+
+void UFlightScalabilityComponent::HandleControllerChanged(APawn* Pawn, AController* OldController, AController* NewController)
+{
+	// Only the view of the local flyer is scaled, the other flyers never tick
+	bool bLocallyControlled = OwnerCharacter->IsLocallyControlled();
+	if (!bLocallyControlled)
+	{
+		RestoreAll();
+	}
+
+	SetComponentTickEnabled(bLocallyControlled);
+}
+
+void UFlightScalabilityComponent::ApplyScaling()
+{
+	const FFlightScalabilityTuning& Tuning = TuningProfile->Scalability;
+
+	ScaleVariable(SkeletalMeshLODBias, TEXT("r.SkeletalMeshLODBias"), Tuning.SkeletalMeshLODBias);
+	ScaleVariable(StaticMeshLODDistanceScale, TEXT("r.StaticMeshLODDistanceScale"), Tuning.StaticMeshLODDistanceScale);
+	ScaleVariable(ShadowDistanceScale, TEXT("r.Shadow.DistanceScale"), Tuning.ShadowDistanceScale);
+	ScaleVariable(StreamingBoost, TEXT("r.Streaming.Boost"), Tuning.StreamingBoost);
+
+	// Drop the secondary effects of every flyer first
+	if (UFlightEffectsBudgetSubsystem* EffectsBudget = GetWorld()->GetSubsystem<UFlightEffectsBudgetSubsystem>())
+	{
+		EffectsBudget->SetDetailScale(FMath::Lerp(1.f, Tuning.EffectsDetailScale, AppliedAlpha));
+	}
+}
+
+void UFlightScalabilityComponent::ScaleVariable(FScaledConsoleVariable& Scaled, const TCHAR* Name, float LoweredValue)
+{
+	if (Scaled.Variable == nullptr)
+	{
+		if (AppliedAlpha == 0.f)
+		{
+			return;
+		}
+
+		// Values set from the console, a device profile or the game settings outrank the scalability settings
+		// and are left alone
+		IConsoleVariable* Variable = IConsoleManager::Get().FindConsoleVariable(Name);
+		if (Variable == nullptr || (uint32)(Variable->GetFlags() & ECVF_SetByMask) > (uint32)ECVF_SetByScalability)
+		{
+			return;
+		}
+
+		Scaled.Variable = Variable;
+		Scaled.BaseValue = Variable->GetFloat();
+		Scaled.BasePriority = Variable->GetFlags() & ECVF_SetByMask;
+	}
+	else if ((uint32)(Scaled.Variable->GetFlags() & ECVF_SetByMask) > (uint32)ECVF_SetByScalability)
+	{
+		// Set from the console or the game settings while scaled, which takes over from here
+		Scaled.Variable = nullptr;
+		return;
+	}
+	else if (Scaled.Variable->GetFloat() != Scaled.AppliedValue)
+	{
+		// Changed by the scalability settings while scaled, the new value is blended from and restored instead
+		Scaled.BaseValue = Scaled.Variable->GetFloat();
+	}
+
+	// Set with the priority of the scalability settings, so sg.* changes still reach the variable while it is scaled
+	Scaled.AppliedValue = FMath::Lerp(Scaled.BaseValue, LoweredValue, AppliedAlpha);
+	if (Scaled.Variable->IsVariableInt())
+	{
+		Scaled.AppliedValue = FMath::RoundToFloat(Scaled.AppliedValue);
+		Scaled.Variable->Set(FMath::RoundToInt(Scaled.AppliedValue), ECVF_SetByScalability);
+	}
+	else
+	{
+		Scaled.Variable->Set(Scaled.AppliedValue, ECVF_SetByScalability);
+	}
+
+	// Once restored, give the variable back its own priority and forget the captured value, so later changes to it are picked up
+	if (AppliedAlpha == 0.f)
+	{
+		Scaled.Variable->SetFlags((EConsoleVariableFlags)((Scaled.Variable->GetFlags() & ~ECVF_SetByMask) | Scaled.BasePriority));
+		Scaled.Variable = nullptr;
+	}
+}
+
+void UFlightScalabilityComponent::UpdateDistantActors()
+{
+	const FFlightScalabilityTuning& Tuning = TuningProfile->Scalability;
+
+	// Only slow down distant characters once detail is mostly lowered, and let them go as soon as it comes back
+	bool bThrottle = AppliedAlpha >= 0.5f;
+	FVector ViewLocation = OwnerCharacter->GetActorLocation();
+	float RangeSquared = FMath::Square(Tuning.DistantActorRange);
+
+	for (TActorIterator<ACharacter> It(GetWorld()); It; ++It)
+	{
+		USkeletalMeshComponent* Mesh = It->GetMesh();
+		if (*It == OwnerCharacter || Mesh == nullptr)
+		{
+			continue;
+		}
+
+		bool bDistant = bThrottle && FVector::DistSquared(It->GetActorLocation(), ViewLocation) > RangeSquared;
+		float* OriginalInterval = ThrottledMeshes.Find(Mesh);
+
+		if (bDistant && OriginalInterval == nullptr)
+		{
+			ThrottledMeshes.Add(Mesh, Mesh->GetComponentTickInterval());
+			Mesh->SetComponentTickInterval(FMath::Max(Mesh->GetComponentTickInterval(), Tuning.DistantAnimTickInterval));
+		}
+		else if (!bDistant && OriginalInterval != nullptr)
+		{
+			Mesh->SetComponentTickInterval(*OriginalInterval);
+			ThrottledMeshes.Remove(Mesh);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_FlightThrottledMeshes, ThrottledMeshes.Num());
+}
+
+void UFlightScalabilityComponent::RestoreAll()
+{
+	if (AppliedAlpha > 0.f)
+	{
+		ScalingAlpha = 0.f;
+		AppliedAlpha = 0.f;
+		ApplyScaling();
+	}
+
+	for (const TPair<TWeakObjectPtr<USkeletalMeshComponent>, float>& ThrottledMesh : ThrottledMeshes)
+	{
+		if (USkeletalMeshComponent* Mesh = ThrottledMesh.Key.Get())
+		{
+			Mesh->SetComponentTickInterval(ThrottledMesh.Value);
+		}
+	}
+
+	ThrottledMeshes.Empty();
+}
+
+void UFlightScalabilityComponent::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("%s: detail scaling %.2f, %d distant meshes throttled"), *GetNameSafe(GetOwner()), AppliedAlpha, ThrottledMeshes.Num());
+
+	const FScaledConsoleVariable* ScaledVariables[] = { &SkeletalMeshLODBias, &StaticMeshLODDistanceScale, &ShadowDistanceScale, &StreamingBoost };
+	for (const FScaledConsoleVariable* Scaled : ScaledVariables)
+	{
+		if (Scaled->Variable != nullptr)
+		{
+			UE_LOG(LogTemp, Log, TEXT("  %-32s %.2f -> %.2f"), *IConsoleManager::Get().FindConsoleObjectName(Scaled->Variable), Scaled->BaseValue, Scaled->AppliedValue);
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("  Frame time at normal detail %.2f ms over %d frames, at lowered detail %.2f ms over %d frames"),
+		NormalFrameCount > 0 ? NormalFrameTime * 1000.0 / NormalFrameCount : 0.0, NormalFrameCount,
+		ScaledFrameCount > 0 ? ScaledFrameTime * 1000.0 / ScaledFrameCount : 0.0, ScaledFrameCount);
+}
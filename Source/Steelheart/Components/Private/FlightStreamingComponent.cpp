@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Components/Public/FlightStreamingComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Steelheart/Interfaces/Public/FlightLocomotionInterface.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/FlightEffectsPoolSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Streaming Tick"), STAT_FlightStreamingTick, STATGROUP_Steelheart);
+
+// Movement states the asset groups are wanted in, as bits of a mask
+static constexpr uint8 FlightStandingState = 1 << 0;
+static constexpr uint8 FlightRunningState = 1 << 1;
+static constexpr uint8 FlightFallingState = 1 << 2;
+static constexpr uint8 FlightFlyingState = 1 << 3;
+
+// States each asset group is wanted in, indexed by EFlightAssetGroup. A group is wanted in the states it is used in
+// and in the states one input away from them, so it has landed by the time it is used
+static constexpr uint8 FlightGroupStates[(uint8)EFlightAssetGroup::Count] =
+{
+	// Takeoff: engaged standing still on the ground
+	FlightStandingState,
+	// Divebomb: initiated while falling, flyers are one stop away from falling
+	FlightFallingState | FlightFlyingState,
+	// Landing: hard and divebomb landings end a fall
+	FlightFallingState,
+	// Dash: started while running on the ground or flying
+	FlightRunningState | FlightFlyingState,
+	// Hover: shown while flying, which starts from a fall or at the end of a takeoff
+	FlightStandingState | FlightFallingState | FlightFlyingState
+};
+
+// Sets default values for this component's properties
+UFlightStreamingComponent::UFlightStreamingComponent()
+{
+	// Set this component to be initialized when the game starts, and to be ticked every frame.
+	// You can turn these features off to improve performance if you don't need them.
+	PrimaryComponentTick.bCanEverTick = true;
+
+	// Movement state only needs sampling a few times per second
+	PrimaryComponentTick.TickInterval = UpdateInterval;
+}
+
+void UFlightStreamingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ReleaseAllGroups();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame
+void UFlightStreamingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightStreamingTick);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	UpdateWantedGroups();
+
+	ReleaseUnusedGroups();
+}
+
+void UFlightStreamingComponent::ApplyTuning()
+{
+	// Only the groups whose soft references changed are streamed in afresh, the others keep their handle
+	TArray<FSoftObjectPath> Assets;
+	for (EFlightAssetGroup Group : TEnumRange<EFlightAssetGroup>())
+	{
+		FAssetGroupState& GroupState = GroupStates[(uint8)Group];
+		if (!GroupState.Handle.IsValid())
+		{
+			continue;
+		}
+
+		Assets.Reset();
+		TuningProfile->GetAssetGroup(Group, Assets);
+
+		if (Assets != GroupState.Assets)
+		{
+			ReleaseGroup(Group);
+		}
+	}
+
+	SetComponentTickInterval(UpdateInterval);
+	UpdateWantedGroups();
+}
+
+void UFlightStreamingComponent::RequestGroup(EFlightAssetGroup Group)
+{
+	FAssetGroupState& GroupState = GroupStates[(uint8)Group];
+	GroupState.LastWantedTime = GetWorld()->GetTimeSeconds();
+
+	if (GroupState.Handle.IsValid())
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> Assets;
+	TuningProfile->GetAssetGroup(Group, Assets);
+
+	if (Assets.Num() > 0)
+	{
+		TArray<FSoftObjectPath> OneShotAssets;
+		TuningProfile->GetOneShotAssets(Group, OneShotAssets);
+
+		// Prewarm the pooled one-shots as soon as the group lands so first use does not create them.
+		// A handle released while loading still completes, and only the group's current handle prewarms
+		TWeakObjectPtr<UFlightStreamingComponent> WeakThis(this);
+		FStreamableDelegate LoadedDelegate = FStreamableDelegate::CreateLambda([WeakThis, Group, OneShotAssets]()
+		{
+			UFlightEffectsPoolSubsystem* EffectsPool = WeakThis.IsValid() ? WeakThis->GetWorld()->GetSubsystem<UFlightEffectsPoolSubsystem>() : nullptr;
+			if (EffectsPool == nullptr)
+			{
+				return;
+			}
+
+			FAssetGroupState& LoadedState = WeakThis->GroupStates[(uint8)Group];
+			if (LoadedState.Handle.IsValid() && LoadedState.PrewarmedAssets.Num() == 0 && OneShotAssets.Num() > 0)
+			{
+				EffectsPool->PrewarmAssets(OneShotAssets);
+				LoadedState.PrewarmedAssets = OneShotAssets;
+			}
+		});
+
+		GroupState.Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Assets, LoadedDelegate,
+			FStreamableManager::AsyncLoadHighPriority);
+		GroupState.Assets = MoveTemp(Assets);
+	}
+}
+
+bool UFlightStreamingComponent::IsGroupLoaded(EFlightAssetGroup Group) const
+{
+	const TSharedPtr<FStreamableHandle>& Handle = GroupStates[(uint8)Group].Handle;
+	return Handle.IsValid() && Handle->HasLoadCompleted();
+}
+
+void UFlightStreamingComponent::UpdateWantedGroups()
+{
+	// Takeoffs need the character standing still and ground dashes need it running, so the two never stream in together
+	uint8 State = 0;
+	if (CharacterMovement->IsMovingOnGround())
+	{
+		State = CharacterMovement->GetCurrentAcceleration().IsNearlyZero() && !FlightLocomotionInterface->IsDashing()
+			? FlightStandingState : FlightRunningState;
+	}
+	else if (CharacterMovement->IsFalling())
+	{
+		State = FlightFallingState;
+	}
+	else if (CharacterMovement->IsFlying())
+	{
+		State = FlightFlyingState;
+	}
+
+	for (EFlightAssetGroup Group : TEnumRange<EFlightAssetGroup>())
+	{
+		if (FlightGroupStates[(uint8)Group] & State)
+		{
+			RequestGroup(Group);
+		}
+	}
+}
+
+void UFlightStreamingComponent::ReleaseUnusedGroups()
+{
+	float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	for (EFlightAssetGroup Group : TEnumRange<EFlightAssetGroup>())
+	{
+		FAssetGroupState& GroupState = GroupStates[(uint8)Group];
+		if (GroupState.Handle.IsValid() && CurrentTime - GroupState.LastWantedTime > ReleaseDelay)
+		{
+			ReleaseGroup(Group);
+		}
+	}
+}
+
+void UFlightStreamingComponent::ReleaseGroup(EFlightAssetGroup Group)
+{
+	FAssetGroupState& GroupState = GroupStates[(uint8)Group];
+
+	// The pooled instances reference their assets, so they go first or the handle release would unload nothing
+	if (GroupState.PrewarmedAssets.Num() > 0)
+	{
+		if (UFlightEffectsPoolSubsystem* EffectsPool = GetWorld() ? GetWorld()->GetSubsystem<UFlightEffectsPoolSubsystem>() : nullptr)
+		{
+			EffectsPool->ReleaseAssets(GroupState.PrewarmedAssets);
+		}
+
+		GroupState.PrewarmedAssets.Reset();
+	}
+
+	// Assets shared with a group still in use stay referenced by that group's handle
+	if (GroupState.Handle.IsValid())
+	{
+		GroupState.Handle->ReleaseHandle();
+		GroupState.Handle.Reset();
+	}
+
+	GroupState.Assets.Reset();
+}
+
+void UFlightStreamingComponent::ReleaseAllGroups()
+{
+	for (EFlightAssetGroup Group : TEnumRange<EFlightAssetGroup>())
+	{
+		ReleaseGroup(Group);
+	}
+}
@@ -1,8 +1,15 @@
 #include "Steelheart/Components/Public/FlightTakeoffComponent.h"
 
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Steelheart/Data/Public/FlightTuningProfile.h"
 #include "Steelheart/Interfaces/Public/FlightLocomotionInterface.h"
+#include "Steelheart/Steelheart.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Takeoff Tick"), STAT_FlightTakeoffTick, STATGROUP_Steelheart);
 
 // Sets default values for this component's properties
 UFlightTakeoffComponent::UFlightTakeoffComponent()
@@ -16,29 +23,22 @@ UFlightTakeoffComponent::UFlightTakeoffComponent()
 	TakeOffEndTimerDelegate.BindUFunction(this, "EndTakeOff");
 }
 
-void UFlightTakeoffComponent::BeginPlay()
+#if WITH_EDITORONLY_DATA
+void UFlightTakeoffComponent::MigrateDeprecatedTuning(UFlightTuningProfile* Profile) const
 {
-	Super::BeginPlay();
-
-	// Retrieve information from the animation montage
-	if (ensure(TakeOffMontage != nullptr))
-	{
-		BaseBlendOutTime = TakeOffMontage->BlendOut.GetBlendTime();
-
-		int32 EngageSectionIndex = TakeOffMontage->GetSectionIndex("Default");
-		EngageSectionLength = TakeOffMontage->GetSectionLength(EngageSectionIndex);
-
-		int32 LoopSectionIndex = TakeOffMontage->GetSectionIndex(LoopSectionName);
-		LoopSectionLength = TakeOffMontage->GetSectionLength(LoopSectionIndex);
-
-		int32 ReleaseSectionIndex = TakeOffMontage->GetSectionIndex(ReleaseSectionName);
-		ReleaseSectionLength = TakeOffMontage->GetSectionLength(ReleaseSectionIndex);
-	}
+	FFlightTakeoffTuning& Tuning = Profile->Takeoff;
+	Tuning.TakeOffMontage = TakeOffMontage_DEPRECATED;
+	Tuning.LoopSectionName = LoopSectionName_DEPRECATED;
+	Tuning.ReleaseSectionName = ReleaseSectionName_DEPRECATED;
+	Tuning.BaseTakeOffForce = BaseTakeOffForce_DEPRECATED;
 }
+#endif
 
 // Called every frame
 void UFlightTakeoffComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
+	SCOPE_CYCLE_COUNTER(STAT_FlightTakeoffTick);
+
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
 	// Apply takeoff force and calculate release force
@@ -47,33 +47,32 @@ void UFlightTakeoffComponent::TickComponent(float DeltaTime, ELevelTick TickType
 		CharacterMovement->AddForce(FVector::UpVector * CurrentTakeOffForce);
 
 		ReleaseTimeCounter += DeltaTime;
-		float ReleaseForceAlpha = ReleaseTimeCounter / ReleaseSectionLength;
-		CurrentTakeOffForce = FMath::Lerp(BaseTakeOffForce, 0.f, ReleaseForceAlpha);
+		float ReleaseForceAlpha = ReleaseTimeCounter / FMath::Max(TuningProfile->Baked.TakeOffReleaseSectionLength, KINDA_SMALL_NUMBER);
+		CurrentTakeOffForce = FMath::Lerp(TuningProfile->Takeoff.BaseTakeOffForce, 0.f, ReleaseForceAlpha);
 	}
 }
 
 void UFlightTakeoffComponent::EngageTakeOff()
 {
 	// Initiate takeoff if conditions are met
-	if (ensure(TakeOffMontage != nullptr) &&
+	if (ensure(GetTakeOffMontage() != nullptr) &&
 		OwnerCharacter->GetCharacterMovement()->IsMovingOnGround() && !bIsTakeOffInitiating)
 	{
 		bIsTakeOffInitiating = true;
 		FlightLocomotionInterface->SetLocomotionEnabled(false);
 
 		// Start the takeoff animation
-		TakeOffMontage->BlendOut.SetBlendTime(BaseBlendOutTime);
-		OwnerCharacter->PlayAnimMontage(TakeOffMontage);
+		OwnerCharacter->PlayAnimMontage(GetTakeOffMontage());
 
 		// Trigger the loop timer
-		GetWorld()->GetTimerManager().SetTimer(TakeOffLoopTimerHandle, TakeOffLoopTimerDelegate, EngageSectionLength, false);
+		GetWorld()->GetTimerManager().SetTimer(TakeOffLoopTimerHandle, TakeOffLoopTimerDelegate, TuningProfile->Baked.TakeOffEngageSectionLength, false);
 	}
 }
 
 void UFlightTakeoffComponent::ReleaseTakeOff()
 {
 	// Release takeoff if initiated
-	if (ensure(TakeOffMontage != nullptr) && bIsTakeOffInitiating)
+	if (ensure(GetTakeOffMontage() != nullptr) && bIsTakeOffInitiating)
 	{
 		bIsTakeOffInitiating = false;
 		float SectionLength;
@@ -85,22 +84,25 @@ void UFlightTakeoffComponent::ReleaseTakeOff()
 			bIsTakeOffCharged = false;
 			bIsTakingOff = true;
 
-			OwnerCharacter->PlayAnimMontage(TakeOffMontage, RATE_SCALE, ReleaseSectionName);
+			OwnerCharacter->PlayAnimMontage(GetTakeOffMontage(), RATE_SCALE, TuningProfile->Takeoff.ReleaseSectionName);
 			OnReleaseTakeoff.ExecuteIfBound(true);
 
 			ReleaseTimeCounter = 0.f;
-			CurrentTakeOffForce = BaseTakeOffForce;
+			CurrentTakeOffForce = TuningProfile->Takeoff.BaseTakeOffForce;
 
-			SectionLength = ReleaseSectionLength;
+			SectionLength = TuningProfile->Baked.TakeOffReleaseSectionLength;
 		}
 		else
 		{
 			// Cancel the takeoff initiation
-			TakeOffMontage->BlendOut.SetBlendTime(EngageSectionLength / 2);
-			OwnerCharacter->StopAnimMontage(TakeOffMontage);
+			// Blend out over half the engage section without touching the shared montage's blend settings
+			if (UAnimInstance* AnimInstance = OwnerCharacter->GetMesh()->GetAnimInstance())
+			{
+				AnimInstance->Montage_Stop(TuningProfile->Baked.TakeOffEngageSectionLength / 2, GetTakeOffMontage());
+			}
 			OnReleaseTakeoff.ExecuteIfBound(false);
 
-			SectionLength = EngageSectionLength / 2;
+			SectionLength = TuningProfile->Baked.TakeOffEngageSectionLength / 2;
 			GetWorld()->GetTimerManager().ClearTimer(TakeOffLoopTimerHandle);
 		}
 
@@ -112,7 +114,7 @@ void UFlightTakeoffComponent::ReleaseTakeOff()
 void UFlightTakeoffComponent::LoopTakeOff()
 {
 	// Loop the takeoff animation if not already looping
-	if (ensure(TakeOffMontage != nullptr))
+	if (ensure(GetTakeOffMontage() != nullptr))
 	{
 		if (bIsTakeOffLooping)
 		{
@@ -124,11 +126,11 @@ void UFlightTakeoffComponent::LoopTakeOff()
 		{
 			// Start looping the takeoff animation
 			bIsTakeOffLooping = true;
-			OwnerCharacter->PlayAnimMontage(TakeOffMontage, RATE_SCALE, LoopSectionName);
+			OwnerCharacter->PlayAnimMontage(GetTakeOffMontage(), RATE_SCALE, TuningProfile->Takeoff.LoopSectionName);
 
 			// Reset and restart the loop timer
 			GetWorld()->GetTimerManager().ClearTimer(TakeOffLoopTimerHandle);
-			GetWorld()->GetTimerManager().SetTimer(TakeOffLoopTimerHandle, TakeOffLoopTimerDelegate, LoopSectionLength, false);
+			GetWorld()->GetTimerManager().SetTimer(TakeOffLoopTimerHandle, TakeOffLoopTimerDelegate, TuningProfile->Baked.TakeOffLoopSectionLength, false);
 			;
 		}
 	}
@@ -137,7 +139,7 @@ void UFlightTakeoffComponent::LoopTakeOff()
 void UFlightTakeoffComponent::EndTakeOff()
 {
 	// Finish the takeoff process
-	if (ensure(TakeOffMontage != nullptr))
+	if (ensure(GetTakeOffMontage() != nullptr))
 	{
 		bIsTakingOff = false;
 		FlightLocomotionInterface->SetLocomotionEnabled(true);
@@ -146,3 +148,8 @@ void UFlightTakeoffComponent::EndTakeOff()
 		GetWorld()->GetTimerManager().ClearTimer(TakeOffEndTimerHandle);
 	}
 }
+
+UAnimMontage* UFlightTakeoffComponent::GetTakeOffMontage() const
+{
+	return UFlightTuningProfile::ResolveAsset(TuningProfile->Takeoff.TakeOffMontage);
+}
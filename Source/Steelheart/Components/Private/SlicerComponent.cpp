@@ -0,0 +1,307 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Components/Public/SlicerComponent.h"
+#include "Async/Async.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "KismetProceduralMeshLibrary.h"
+#include "ProceduralMeshComponent.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/ProceduralPiecePoolSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Slicer Tick"), STAT_SlicerTick, STATGROUP_Steelheart);
+DECLARE_CYCLE_STAT(TEXT("Slicer Slice Mesh"), STAT_SlicerSliceMesh, STATGROUP_Steelheart);
+DECLARE_CYCLE_STAT(TEXT("Slicer Commit"), STAT_SlicerCommit, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Slicer Sliced Triangles"), STAT_SlicerSlicedTriangles, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<bool> CVarFlightSlicerAsync(
+	TEXT("Flight.Slicer.Async"),
+	true,
+	TEXT("If true, meshes are sliced on a worker thread and committed on a later frame"));
+
+static TAutoConsoleVariable<bool> CVarFlightSlicerVectorized(
+	TEXT("Flight.Slicer.Vectorized"),
+	true,
+	TEXT("If true, vertices are classified against the slicing plane four at a time"));
+
+static TAutoConsoleVariable<int32> CVarFlightSlicerMaxHullVertices(
+	TEXT("Flight.Slicer.MaxHullVertices"),
+	64,
+	TEXT("Most vertices sampled into the convex collision of a sliced half"));
+
+// Sets default values for this component's properties
+USlicerComponent::USlicerComponent()
+{
+	// The component only ticks while a slice stroke is in progress
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	SliceObjectTypes.Add(UEngineTypes::ConvertToObjectType(ECC_GameTraceChannel1));
+}
+
+// Called every frame
+void USlicerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SlicerTick);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Keep track of the stroke end while the slice is held
+	FHitResult Hit;
+	if (bIsSlicing && TraceUnderCursor(Hit) && Hit.GetComponent() == SliceTarget.Get())
+	{
+		SliceCurrent = Hit.ImpactPoint;
+	}
+
+	if (PendingSlice.IsValid() && PendingSlice.IsReady())
+	{
+		TArray<FSlicerMesh> Buffers = PendingSlice.Consume();
+
+		CommitSlice(Buffers);
+	}
+
+	// The component also ticks until the slice in flight is committed
+	if (!bIsSlicing && !PendingSlice.IsValid())
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void USlicerComponent::BeginSlice()
+{
+	FHitResult Hit;
+	if (!bIsSlicing && TraceUnderCursor(Hit) && Hit.GetComponent() != nullptr)
+	{
+		bIsSlicing = true;
+
+		SliceTarget = Hit.GetComponent();
+		SliceStart = Hit.ImpactPoint;
+		SliceCurrent = SliceStart;
+
+		SetComponentTickEnabled(true);
+	}
+}
+
+void USlicerComponent::EndSlice()
+{
+	if (bIsSlicing)
+	{
+		bIsSlicing = false;
+
+		UPrimitiveComponent* Target = SliceTarget.Get();
+		SliceTarget.Reset();
+
+		if (Target == nullptr || FVector::Dist(SliceStart, SliceCurrent) < MinSliceDistance)
+		{
+			return;
+		}
+
+		UProceduralMeshComponent* ProcMesh = Cast<UProceduralMeshComponent>(Target);
+		if (ProcMesh == nullptr)
+		{
+			if (UStaticMeshComponent* StaticMeshComp = Cast<UStaticMeshComponent>(Target))
+			{
+				ProcMesh = SetupProcMesh(StaticMeshComp);
+			}
+		}
+
+		if (ProcMesh != nullptr)
+		{
+			SliceMesh(ProcMesh, SliceStart, SliceCurrent);
+		}
+
+		SetComponentTickEnabled(PendingSlice.IsValid());
+	}
+}
+
+APlayerController* USlicerComponent::GetSlicingController() const
+{
+	if (APlayerController* OwnerController = Cast<APlayerController>(GetOwner()))
+	{
+		return OwnerController;
+	}
+
+	return UGameplayStatics::GetPlayerController(this, 0);
+}
+
+bool USlicerComponent::TraceUnderCursor(FHitResult& OutHit) const
+{
+	APlayerController* Controller = GetSlicingController();
+
+	return Controller != nullptr && Controller->GetHitResultUnderCursorForObjects(SliceObjectTypes, true, OutHit);
+}
+
+UProceduralMeshComponent* USlicerComponent::SetupProcMesh(UStaticMeshComponent* StaticMeshComp)
+{
+	if (ProcMeshClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Spawn the procedural holder in place of the static mesh
+	AActor* ProcActor = GetWorld()->SpawnActor<AActor>(ProcMeshClass, StaticMeshComp->GetComponentTransform());
+	if (ProcActor == nullptr)
+	{
+		return nullptr;
+	}
+
+	UProceduralMeshComponent* ProcMesh = ProcActor->FindComponentByClass<UProceduralMeshComponent>();
+	if (ProcMesh != nullptr)
+	{
+		UKismetProceduralMeshLibrary::CopyProceduralMeshFromStaticMeshComponent(StaticMeshComp, 0, ProcMesh, true);
+
+		// The original actor is replaced by its procedural copy
+		StaticMeshComp->GetOwner()->Destroy();
+	}
+
+	return ProcMesh;
+}
+
+void USlicerComponent::SliceMesh(UProceduralMeshComponent* ProcMesh, const FVector& Start, const FVector& End)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SlicerSliceMesh);
+
+	// Strokes ending while a slice is in flight are dropped, the mesh they were drawn on is about to change
+	APlayerController* Controller = GetSlicingController();
+	if (PendingSlice.IsValid() || Controller == nullptr || Controller->PlayerCameraManager == nullptr)
+	{
+		return;
+	}
+
+	// The plane contains the stroke and the view direction
+	FVector ViewDirection = Controller->PlayerCameraManager->GetCameraRotation().Vector();
+	FVector PlaneNormal = FVector::CrossProduct(End - Start, ViewDirection).GetSafeNormal();
+	FVector PlanePosition = (Start + End) * 0.5f;
+
+	if (PlaneNormal.IsNearlyZero())
+	{
+		return;
+	}
+
+	// Sections are sliced in the space of the component, as the procedural mesh library does
+	const FTransform& MeshTransform = ProcMesh->GetComponentTransform();
+	FVector LocalNormal = MeshTransform.InverseTransformVectorNoScale(PlaneNormal).GetSafeNormal();
+	FPlane LocalPlane(MeshTransform.InverseTransformPosition(PlanePosition), LocalNormal);
+
+	// The buffers travel to the worker and back, so no slice allocates what the previous one already had
+	SliceBuffers.SetNum(3);
+	SliceBuffers[0].CopyFrom(ProcMesh);
+
+	PendingMesh = ProcMesh;
+	PendingNormal = PlaneNormal;
+
+	bool bVectorized = CVarFlightSlicerVectorized.GetValueOnGameThread();
+	auto Slice = [Buffers = MoveTemp(SliceBuffers), LocalPlane, bVectorized]() mutable
+	{
+		FMeshSlicer::SlicePlane(Buffers[0], LocalPlane, true, Buffers[1], Buffers[2], bVectorized);
+
+		return MoveTemp(Buffers);
+	};
+
+	if (CVarFlightSlicerAsync.GetValueOnGameThread())
+	{
+		PendingSlice = Async(EAsyncExecution::ThreadPool, MoveTemp(Slice));
+	}
+	else
+	{
+		TArray<FSlicerMesh> Buffers = Slice();
+		CommitSlice(Buffers);
+	}
+}
+
+void USlicerComponent::CommitSlice(TArray<FSlicerMesh>& Buffers)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SlicerCommit);
+
+	// The buffers are kept whatever becomes of the slice
+	SliceBuffers = MoveTemp(Buffers);
+
+	UProceduralMeshComponent* ProcMesh = PendingMesh.Get();
+	PendingMesh.Reset();
+
+	UProceduralPiecePoolSubsystem* PiecePool = GetWorld()->GetSubsystem<UProceduralPiecePoolSubsystem>();
+
+	// A plane missing the mesh leaves it whole
+	if (ProcMesh == nullptr || PiecePool == nullptr || SliceBuffers.Num() != 3 || SliceBuffers[1].IsEmpty() || SliceBuffers[2].IsEmpty())
+	{
+		return;
+	}
+
+	// The other half comes from the pool, with the collision settings of the sliced mesh. It belongs to the actor
+	// of the sliced mesh, or to the actor the sliced mesh was itself cut for when it is a pooled piece
+	AActor* PieceOwner = PiecePool->GetPieceOwner(ProcMesh);
+	if (PieceOwner == nullptr)
+	{
+		PieceOwner = ProcMesh->GetOwner();
+	}
+
+	UProceduralMeshComponent* OtherHalf = PiecePool->AcquirePiece(ProcMesh->GetComponentTransform(), PieceOwner, ProcMesh);
+
+	// Past the piece budget, with no fallen piece to take back, the mesh is left whole
+	if (OtherHalf == nullptr)
+	{
+		return;
+	}
+
+	const FSlicerMesh& Front = SliceBuffers[1];
+	const FSlicerMesh& Back = SliceBuffers[2];
+
+	INC_DWORD_STAT_BY(STAT_SlicerSlicedTriangles, Front.NumTriangles() + Back.NumTriangles());
+
+	// Collision of the halves is cooked on a worker thread, the game thread keeps the previous one until then
+	ProcMesh->bUseAsyncCooking = true;
+
+	// The back half reads the materials of the sections before the front half replaces them
+	PiecePool->WriteSections(OtherHalf, Back, ProcMesh, CapMaterial);
+	PiecePool->WriteSections(ProcMesh, Front, ProcMesh, CapMaterial);
+
+	UpdateHullCollision(ProcMesh, Front);
+	UpdateHullCollision(OtherHalf, Back);
+
+	// Let both halves fall apart
+	ProcMesh->SetSimulatePhysics(true);
+	ProcMesh->AddImpulse(PendingNormal * SliceImpulseStrength, NAME_None, true);
+
+	OtherHalf->SetSimulatePhysics(true);
+	OtherHalf->AddImpulse(-PendingNormal * SliceImpulseStrength, NAME_None, true);
+}
+
+void USlicerComponent::UpdateHullCollision(UProceduralMeshComponent* ProcMesh, const FSlicerMesh& Half)
+{
+	if (ProcMesh->bUseComplexAsSimpleCollision)
+	{
+		return;
+	}
+
+	int32 NumVertices = 0;
+	for (const FSlicerSection& Section : Half.Sections)
+	{
+		NumVertices += Section.Vertices.Num();
+	}
+
+	// Vertices are sampled at an even stride, the hull only needs to roughly follow the half
+	int32 MaxHullVertices = FMath::Max(CVarFlightSlicerMaxHullVertices.GetValueOnGameThread(), 4);
+	int32 Stride = FMath::Max(FMath::DivideAndRoundUp(NumVertices, MaxHullVertices), 1);
+
+	HullMeshes.SetNum(1);
+	TArray<FVector>& HullVertices = HullMeshes[0];
+	HullVertices.Reset(MaxHullVertices);
+
+	int32 VertexCount = 0;
+	for (const FSlicerSection& Section : Half.Sections)
+	{
+		for (const FVector& Vertex : Section.Vertices)
+		{
+			if (VertexCount++ % Stride == 0)
+			{
+				HullVertices.Add(Vertex);
+			}
+		}
+	}
+
+	// Replacing the hull in one call cooks the collision once rather than once to clear it and once to add it
+	ProcMesh->SetCollisionConvexMeshes(HullMeshes);
+}
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "DestructibleMarkerComponent.generated.h"
+
+// Forward declarations
+class UDestructibleSupportGraph;
+
+/**
+ * Marker registering its owner with the destructible registry for as long as it plays.
+ * Add it to destructible actors in place of the destructible tag.
+ * Buildings also give it the support graph baked from their collection.
+ */
+UCLASS(ClassGroup = (Destruction), meta = (BlueprintSpawnableComponent))
+class STEELHEART_API UDestructibleMarkerComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UDestructibleMarkerComponent();
+
+	// Structural support of the owner's collection, collapsing what its broken pieces held up
+	UPROPERTY(EditAnywhere, Category = Destruction)
+		UDestructibleSupportGraph* SupportGraph;
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+};
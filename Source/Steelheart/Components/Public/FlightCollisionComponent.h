@@ -5,77 +5,157 @@
 #include "FlightCollisionComponent.generated.h"
 
 // Forward declarations
-class UFieldSystemComponent;
-class USphereComponent;
-class URadialFalloff;
-class URadialVector;
-class UCullingField;
+class UDestructibleProxySubsystem;
+class UDestructibleRegistrySubsystem;
+class UFlightFieldSubsystem;
 
 /**
  * Flight collision component responsible for handling collision events and generating collision effects.
+ * Looks ahead of fast flyers for the destructibles on their path and prepares them over the preceding frames,
+ * so the frame of the impact only pays for the fracture itself.
+ * Listens to the hits of the owner's capsule only while dashing, drops the hits against other object types on arrival,
+ * and strikes each destructible hit during a frame once, after the owner has moved.
+ * Divebomb landings send a shockwave through the same batched field submission as the dash impacts.
  */
 UCLASS(ClassGroup = (FlightLocomotion))
 class STEELHEART_API UFlightCollisionComponent : public UFlightComponent
 {
 	GENERATED_BODY()
 
-	// Field System Component used for collision effects
-	UFieldSystemComponent* FieldSystem;
+	// World subsystem batching the fields of every flyer's impacts
+	UFlightFieldSubsystem* Fields = nullptr;
 
-	// Collision sphere component for collision detection
-	USphereComponent* CollisionSphere;
+	// World registry telling destructibles apart from the rest of the world
+	UDestructibleRegistrySubsystem* Destructibles = nullptr;
 
-	// Radial falloff used for field properties
-	URadialFalloff* RadialFalloff;
-
-	// Radial vector used for field properties
-	URadialVector* RadialVector;
-
-	// Culling field used for field properties
-	UCullingField* CullingField;
+	// World subsystem swapping destructible proxies for their live collections
+	UDestructibleProxySubsystem* Proxies = nullptr;
 
 public:
 	// Sets default values for this component's properties
 	UFlightCollisionComponent();
 
-	// Event called when the component hits another primitive component
+#if WITH_EDITORONLY_DATA
+	// Copy the tuning saved on this component before the tuning profiles into a profile
+	virtual void MigrateDeprecatedTuning(UFlightTuningProfile* Profile) const override;
+#endif
+
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Event called when the owner's capsule hits another primitive component while dashing, queues the destructibles hit for the next tick
 	UFUNCTION()
 		void OnCharacterHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	// Listen to the hits of the owner's capsule from the start of a dash, before the move of its first frame
+	void StartDash();
+
+	// Send the shockwave of a divebomb landing through the destructibles and physics props around it
+	void EmitShockwave(FVector LandLocation);
+
+	// Log the destructibles prepared ahead of the flyer along with how many of its impacts were prepared for
+	void LogReport() const;
+
 protected:
 	virtual void InitializeFlightComponent() override;
 
+	virtual void ApplyTuning() override;
+
 private:
+	// Listen to the hits of the owner's capsule while dashing only
+	void UpdateHitBinding();
+
+	// Strike the destructibles hit since the last tick
+	void ProcessHits();
+
+	// Strike the proxies hit while their collection was streaming in, once it is live
+	void ProcessDeferredStrikes();
+
+	/**
+	 * Strikes a destructible, playing back its recorded fracture if there is one and exploding where it was hit.
+	 *
+	 * @param Target The destructible struck.
+	 * @param Location Location of the flyer when it hit the destructible.
+	 * @param Velocity Velocity of the flyer when it hit the destructible.
+	 */
+	void Strike(AActor* Target, const FVector& Location, const FVector& Velocity);
+
 	// Method to perform explosion effect
-	void Explode();
+	void Explode(const FVector& Location);
 
-	// Event called when the hit buffer timer expires
-	UFUNCTION()
-		void ResetHit();
+	// Queue the destructibles on the projected path of the flyer for preparation
+	void LookAhead();
+
+	// Get a destructible ready for an impact: swap in its collection, wake its bodies, stream its textures in and build the field graphs it will need
+	void PrepareDestructible(AActor* Destructible);
+
+	// Time of the last explosion against each destructible, so one target cannot be struck repeatedly
+	// while simultaneous impacts against different targets all go through
+	TMap<TWeakObjectPtr<AActor>, float> TargetHitTimes;
 
-	// Radius of the collision sphere
-	UPROPERTY(EditDefaultsOnly, Category = CollisionParameters)
-		float SphereRadius = 1800.f;
+	// Time each destructible ahead of the flyer was prepared at
+	TMap<TWeakObjectPtr<AActor>, float> PreparedTimes;
 
-	// Magnitude of the falloff field
-	UPROPERTY(EditDefaultsOnly, Category = CollisionParameters)
-		float FalloffMagnitude = 500000.f;
+	// Destructibles found ahead of the flyer, prepared a few per frame
+	TArray<TWeakObjectPtr<AActor>> PrepareQueue;
+
+	// Destructibles found by the last projection, kept between projections so finding them does not allocate
+	TArray<AActor*> FoundDestructibles;
+
+	// Destructibles hit since the last tick, each listed once however many contacts it made
+	TArray<TWeakObjectPtr<AActor>> PendingHits;
+
+	// Proxy hit while its collection was still streaming in, struck where it was hit once the collection is live
+	struct FDeferredStrike
+	{
+		TWeakObjectPtr<AActor> Target;
+
+		FVector Location = FVector::ZeroVector;
+
+		FVector Velocity = FVector::ZeroVector;
+	};
+
+	TArray<FDeferredStrike> DeferredStrikes;
+
+	// Bit per object type in DestructibleObjectTypes
+	int32 HitObjectTypes = 0;
+
+	bool bHitsBound = false;
+
+	float TimeSinceLookahead = 0.f;
+
+	int32 PreparedCount = 0;
+
+	// Impacts against destructibles prepared ahead of time and against ones that were not
+	int32 PreparedImpacts = 0;
+	int32 UnpreparedImpacts = 0;
+
+	// Impacts against proxies struck once their collection had streamed in
+	int32 DeferredImpacts = 0;
+
+	// Hit notifications received, dropped for their object type or for not being a destructible, and repeated within a frame
+	int32 ReceivedHits = 0;
+	int32 FilteredHits = 0;
+	int32 DuplicateHits = 0;
+
+private:
+#if WITH_EDITORONLY_DATA
+	//////////////////////////////////////////////////////////////////////////
+	// Deprecated tuning, loaded through the core redirects from blueprints saved before the tuning profiles, editor only
 
-	// Magnitude of the radial vector field
-	UPROPERTY(EditDefaultsOnly, Category = CollisionParameters)
-		float VectorMagnitude = 1000.f;
+	UPROPERTY()
+		float SphereRadius_DEPRECATED = 1800.f;
 
-	// Tag to identify destructible objects
-	UPROPERTY(EditDefaultsOnly, Category = CollisionParameters)
-		FName DestructibleTag = "Destructible";
+	UPROPERTY()
+		float FalloffMagnitude_DEPRECATED = 500000.f;
 
-	// Time buffer to prevent multiple hits in a short interval
-	UPROPERTY(EditDefaultsOnly, Category = CollisionParameters)
-		float HitBufferTime = 0.8f;
+	UPROPERTY()
+		float VectorMagnitude_DEPRECATED = 1000.f;
 
-	FTimerHandle HitBufferTimerHandle;
-	FTimerDelegate HitBufferTimerDelegate;
+	UPROPERTY()
+		FName DestructibleTag_DEPRECATED = "Destructible";
 
-	// Flag indicating if explosion can occur
-	bool bCanExplode = true;
+	UPROPERTY()
+		float HitBufferTime_DEPRECATED = 0.8f;
+#endif
 };
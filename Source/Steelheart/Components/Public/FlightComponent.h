@@ -11,6 +11,7 @@ class IFlightLocomotionInterface;
 class UCameraComponent;
 class UCapsuleComponent;
 class UCharacterMovementComponent;
+class UFlightTuningProfile;
 
 UCLASS(Abstract, ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class STEELHEART_API UFlightComponent : public UActorComponent
@@ -21,12 +22,26 @@ public:
 	// Sets default values for this component's properties
 	UFlightComponent();
 
+#if WITH_EDITORONLY_DATA
+	// Copy the tuning saved on this component before the tuning profiles into a profile
+	virtual void MigrateDeprecatedTuning(UFlightTuningProfile* Profile) const {}
+#endif
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void InitializeFlightComponent();
 
+	// Apply the values of the tuning profile, called after initialization and whenever the profile changes
+	virtual void ApplyTuning() {}
+
+	// Tuning profile shared by every flyer of the owner's archetype
+	const UFlightTuningProfile* TuningProfile = nullptr;
+
 	// Owner character of the flight component
 	ACharacter* OwnerCharacter = nullptr;
 
@@ -69,4 +84,10 @@ protected:
 
 		return nullptr;
 	}
+
+private:
+	// Refresh the tuning profile from the owner and re-apply it
+	void HandleTuningChanged(const UFlightTuningProfile* ChangedProfile);
+
+	FDelegateHandle TuningChangedHandle;
 };
\ No newline at end of file
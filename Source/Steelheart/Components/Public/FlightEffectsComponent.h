@@ -7,37 +7,74 @@
 #include "FlightEffectsComponent.generated.h"
 
 // Forward declarations
-class UParticleSystem;
-class UParticleSystemComponent;
 class UNiagaraSystem;
 class UNiagaraComponent;
+class UParticleSystem;
+class USoundBase;
+class UFlightEffectsPoolSubsystem;
+class UFlightEffectsBudgetSubsystem;
+class UFlightTrailSubsystem;
+struct FFlightBudgetedEffect;
+struct FNiagaraTypeDefinition;
+struct FSoundConcurrencySettings;
 
 UCLASS(ClassGroup = (FlightLocomotion))
 class STEELHEART_API UFlightEffectsComponent : public UFlightComponent
 {
 	GENERATED_BODY()
 
-	// Particle system components for various effects
-	UParticleSystemComponent* SonicBoomParticles;
+	// Niagara components dedicated to each effect, acquired from the world pool on first activation
+	UPROPERTY(Transient)
+		UNiagaraComponent* SonicBoomNiagara;
+
+	UPROPERTY(Transient)
+		UNiagaraComponent* DiveTrailNiagara;
+
+	UPROPERTY(Transient)
+		UNiagaraComponent* TakeoffChargeNiagara;
+
+	UPROPERTY(Transient)
+		UNiagaraComponent* HoverNiagara;
 
-	UParticleSystemComponent* DiveTrailParticles;
+	UPROPERTY(Transient)
+		UNiagaraComponent* DodgeNiagara;
 
-	UParticleSystemComponent* TakeoffChargeParticles;
+	UPROPERTY(Transient)
+		UNiagaraComponent* DashTrailNiagara;
 
-	// Niagara components for hover and dash trail effects
-	UNiagaraComponent* HoverNiagara;
+	// Offsets of the user parameters written on activation, cached when the system is assigned
+	int32 SonicBoomOrientationOffset = INDEX_NONE;
 
-	UNiagaraComponent* DashTrailNiagara;
+	int32 DodgeDirectionOffset = INDEX_NONE;
 
 	// Audio components for wind and sonic boom sounds
-	UAudioComponent* WindAudio;
+	UPROPERTY(Transient)
+		UAudioComponent* WindAudio;
 
-	UAudioComponent* SonicBoomAudio;
+	// Sonic boom sound of the current dive, a pooled one-shot forgotten as soon as the pool takes it back
+	TWeakObjectPtr<UAudioComponent> SonicBoomAudio;
+
+	// World pool providing the one-shot effects and sounds
+	UFlightEffectsPoolSubsystem* EffectsPool;
+
+	// World budget ranking the attached effects against those of the other flyers
+	UFlightEffectsBudgetSubsystem* EffectsBudget;
+
+	// World renderer drawing the dash trails and hover puffs of every flyer in one system
+	UFlightTrailSubsystem* Trails;
+
+	// Shared trail source of the active dash trail
+	int32 DashTrailSourceId = INDEX_NONE;
 
 public:
 	// Sets default values for this component's properties
 	UFlightEffectsComponent();
 
+#if WITH_EDITORONLY_DATA
+	// Copy the tuning saved on this component before the tuning profiles into a profile
+	virtual void MigrateDeprecatedTuning(UFlightTuningProfile* Profile) const override;
+#endif
+
 	// Functions to activate various flight effects
 	void ActivateSonicBoom();
 
@@ -55,77 +92,171 @@ public:
 
 	void ToggleTakeOffCharge(bool Enable, bool Activate = false);
 
+	// Log the effect components held by this character along with their memory and acquisition cost
+	void LogReport() const;
+
+	// Add the attached effects currently playing to the list ranked by the effects budget
+	void GatherBudgetedEffects(TArray<FFlightBudgetedEffect>& OutEffects) const;
+
 protected:
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void InitializeFlightComponent() override;
 
+	virtual void ApplyTuning() override;
+
 private:
-	// Miscellaneous Flight
+	// How an effect component follows the mesh
+	enum class EEffectPlacement : uint8
+	{
+		// Attached while playing and detached once complete
+		Attached,
+
+		// Placed in world space on each activation and never attached
+		Absolute
+	};
+
+	/**
+	 * Helper functions acquiring the component of an effect slot on first use and resolving its streamed asset.
+	 *
+	 * @return The component ready to activate, or null if effects are disabled or the asset is unset.
+	 */
+	UNiagaraComponent* UseNiagara(UNiagaraComponent*& Niagara, const TSoftObjectPtr<UNiagaraSystem>& Effect, FVector CompLoc = FVector(0, 0, 0), FRotator CompRot = FRotator(0, 0, 0),
+		EEffectPlacement Placement = EEffectPlacement::Attached);
+
+	UAudioComponent* UseAudio(UAudioComponent*& Audio, const TSoftObjectPtr<USoundBase>& Sound);
+
+	// Deactivate the component of an effect slot, at once if the effects budget had culled it
+	void DeactivateEffect(UNiagaraComponent* Niagara);
+
+	// Check if the dash trail and hover puffs are drawn by the shared trail system
+	bool UseSharedTrails() const;
 
-	UPROPERTY(EditDefaultsOnly, Category = MiscFlightEffect)
-		UParticleSystem* TakeoffChargeEffect;
+	// Stamp a landing crater through the world impact subsystem
+	void StampCrater(FVector LandLocation, float Radius);
 
-	UPROPERTY(EditDefaultsOnly, Category = MiscFlightEffect)
-		UNiagaraSystem* HoverEffect;
+	// Play a sound on the mesh within a concurrency group shared by every flyer, unless out of earshot
+	UAudioComponent* PlayOneShotSound(const TSoftObjectPtr<USoundBase>& Sound, FName ConcurrencyGroup, const FSoundConcurrencySettings& Concurrency);
 
-	UPROPERTY(EditDefaultsOnly, Category = MiscFlightEffect)
-		FVector HoverPosition = FVector(0, 0, 89);
+	// Drive the wind voice by the flight speed and virtualize it by distance
+	UFUNCTION()
+		void UpdateWindVoice();
 
-	UPROPERTY(EditDefaultsOnly, Category = MiscFlightEffect)
-		UNiagaraSystem* DashTrailEffect;
+	// Play the sonic boom with the given orientation and its sound
+	void PlaySonicBoom(const FRotator& Orientation, bool bKeepSound = false);
 
-	UPROPERTY(EditDefaultsOnly, Category = MiscFlightEffect)
-		FRotator DashTrailOrientation = FRotator(0, 90, 0);
+	// Forget the kept sonic boom sound once it finishes, stopped, stolen or not
+	void HandleSonicBoomAudioFinished(UAudioComponent* AudioComponent);
+
+	// Stop listening to the kept sonic boom sound and forget it
+	void ForgetSonicBoomAudio();
+
+	// Find the offset of a user parameter in the override parameters of a Niagara component
+	static int32 FindUserParameterOffset(UNiagaraComponent* Niagara, const FNiagaraTypeDefinition& Type, FName Name);
+
+	// Write a user parameter through its cached offset
+	template<typename T>
+	static void SetUserParameter(UNiagaraComponent* Niagara, int32 Offset, const T& Value);
+
+	// Acquire a component of the given type from the world pool and set up its placement, recording the cost
+	template<typename T>
+	T* AcquireEffectComponent(FVector CompLoc, FRotator CompRot, EEffectPlacement Placement);
+
+	// Return the component of an effect slot to the world pool if it has been inactive long enough
+	template<typename T>
+	void ReleaseIfIdle(T*& Slot, float CurrentTime, bool bForce = false);
+
+	// Release the effect components that have gone idle
+	UFUNCTION()
+		void ReleaseIdleComponents();
+
+	// Release every effect component held by this character
+	void ReleaseAllComponents();
+
+	FTimerHandle IdleReleaseTimerHandle;
+	FTimerDelegate IdleReleaseTimerDelegate;
+
+	FTimerHandle WindUpdateTimerHandle;
+	FTimerDelegate WindUpdateTimerDelegate;
+
+	// Last time each held effect component was activated
+	TMap<USceneComponent*, float> LastUsedTimes;
+
+	// Held effect components deactivated and still finishing, which the budget stops rather than culls
+	TSet<USceneComponent*> DeactivatingEffects;
+
+	// False on dedicated servers, where nothing is rendered or heard
+	bool bEffectsEnabled = true;
+
+	int32 AcquireCount = 0;
+
+	uint64 AcquireCycles = 0;
+
+	int32 ActivationCount = 0;
+
+	uint64 ActivationCycles = 0;
+
+private:
+#if WITH_EDITORONLY_DATA
+	//////////////////////////////////////////////////////////////////////////
+	// Deprecated tuning, loaded through the core redirects from blueprints saved before the tuning profiles, editor only
 
-	UPROPERTY(EditDefaultsOnly, Category = MiscFlightEffect)
-		UNiagaraSystem* DodgeEffect;
+	UPROPERTY()
+		UParticleSystem* TakeoffChargeEffect_DEPRECATED = nullptr;
 
-	UPROPERTY(EditDefaultsOnly, Category = MiscFlightEffect)
-		UNiagaraSystem* LandEffect;
+	UPROPERTY()
+		UNiagaraSystem* HoverEffect_DEPRECATED = nullptr;
 
-	UPROPERTY(EditDefaultsOnly, Category = MiscFlightEffect)
-		USoundBase* WindSound;
+	UPROPERTY()
+		FVector HoverPosition_DEPRECATED = FVector(0, 0, 89);
 
-	// Sonic Boom
+	UPROPERTY()
+		UNiagaraSystem* DashTrailEffect_DEPRECATED = nullptr;
 
-	UPROPERTY(EditDefaultsOnly, Category = SonicBoomEffect)
-		UParticleSystem* SonicBoomEffect;
+	UPROPERTY()
+		FRotator DashTrailOrientation_DEPRECATED = FRotator(0, 90, 0);
 
-	UPROPERTY(EditDefaultsOnly, Category = SonicBoomEffect)
-		USoundBase* SonicBoomSound;
+	UPROPERTY()
+		UNiagaraSystem* DodgeEffect_DEPRECATED = nullptr;
 
-	UPROPERTY(EditDefaultsOnly, Category = SonicBoomEffect)
-		FVector SonicBoomDefaultPosition = FVector(0, 0, 89);
+	UPROPERTY()
+		UNiagaraSystem* LandEffect_DEPRECATED = nullptr;
 
-	UPROPERTY(EditDefaultsOnly, Category = SonicBoomEffect)
-		FVector SonicBoomDivePosition = FVector(0, 0, 178);
+	UPROPERTY()
+		USoundBase* WindSound_DEPRECATED = nullptr;
 
-	UPROPERTY(EditDefaultsOnly, Category = SonicBoomEffect)
-		FRotator SonicBoomDefaultOrientation = FRotator(0, -90, 0);
+	UPROPERTY()
+		UParticleSystem* SonicBoomEffect_DEPRECATED = nullptr;
 
-	UPROPERTY(EditDefaultsOnly, Category = SonicBoomEffect)
-		FRotator SonicBoomDiveOrientation = FRotator(90, 0, 0);;
+	UPROPERTY()
+		USoundBase* SonicBoomSound_DEPRECATED = nullptr;
 
-	UPROPERTY(EditDefaultsOnly, Category = SonicBoomEffect)
-		FRotator SonicBoomTakeoffOrientation = FRotator(-90, 0, 0);;
+	UPROPERTY()
+		FVector SonicBoomDefaultPosition_DEPRECATED = FVector(0, 0, 89);
 
-	UPROPERTY(EditDefaultsOnly, Category = SonicBoomEffect)
-		float SonicBoomSoundStartTime = 1.f;
+	UPROPERTY()
+		FVector SonicBoomDivePosition_DEPRECATED = FVector(0, 0, 178);
 
-	// Dive
+	UPROPERTY()
+		FRotator SonicBoomDefaultOrientation_DEPRECATED = FRotator(0, -90, 0);
 
-	UPROPERTY(EditDefaultsOnly, Category = DiveEffect)
-		UParticleSystem* DiveTrailEffect;
+	UPROPERTY()
+		FRotator SonicBoomDiveOrientation_DEPRECATED = FRotator(90, 0, 0);
 
-	UPROPERTY(EditDefaultsOnly, Category = DiveEffect)
-		UNiagaraSystem* DiveLandEffect;
+	UPROPERTY()
+		FRotator SonicBoomTakeoffOrientation_DEPRECATED = FRotator(-90, 0, 0);
 
-	UPROPERTY(EditDefaultsOnly, Category = DiveEffect)
-		USoundBase* DiveLandSound;
+	UPROPERTY()
+		float SonicBoomSoundStartTime_DEPRECATED = 1.f;
 
-	// Helper functions for setting up particle system, Niagara, and audio components
-	UParticleSystemComponent* SetupParticleSystemComponent(UParticleSystem* ParticleTemplate, FVector CompLoc = FVector(0, 0, 0), FRotator CompRot = FRotator(0, 0, 0));
+	UPROPERTY()
+		UParticleSystem* DiveTrailEffect_DEPRECATED = nullptr;
 
-	UNiagaraComponent* SetupNiagaraComponent(UNiagaraSystem* NiagaraSystemAsset, FVector CompLoc = FVector(0, 0, 0), FRotator CompRot = FRotator(0, 0, 0));
+	UPROPERTY()
+		UNiagaraSystem* DiveLandEffect_DEPRECATED = nullptr;
 
-	UAudioComponent* SetupAudioComponent(USoundBase* AudioSound, FVector CompLoc = FVector(0, 0, 0), FRotator CompRot = FRotator(0, 0, 0));
+	UPROPERTY()
+		USoundBase* DiveLandSound_DEPRECATED = nullptr;
+#endif
 };
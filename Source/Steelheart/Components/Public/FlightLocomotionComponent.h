@@ -4,8 +4,8 @@
 #include "FlightComponent.h"
 #include "FlightLocomotionComponent.generated.h"
 
-// Macro defining a scaling factor for divebomb rate
-#define DIVEBOMB_RATE_SCALE 2.f
+// Forward declarations
+class UAnimMontage;
 
 // Delegate for initiated divebomb event
 DECLARE_DELEGATE(FInitiatedDivebomb);
@@ -22,6 +22,11 @@ public:
 	// Sets default values for this component's properties
 	UFlightLocomotionComponent();
 
+#if WITH_EDITORONLY_DATA
+	// Copy the tuning saved on this component before the tuning profiles into a profile
+	virtual void MigrateDeprecatedTuning(UFlightTuningProfile* Profile) const override;
+#endif
+
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
@@ -63,6 +68,8 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	virtual void ApplyTuning() override;
+
 private:
 	// Update flight locomotion
 	void UpdateFlightLocomotion(float DeltaTime);
@@ -119,82 +126,6 @@ public:
 		bool bIsDodgingLeft;
 
 private:
-	// Montage for hard landing
-	UPROPERTY(EditDefaultsOnly, Category = FlightLanding)
-		UAnimMontage* HardLandingMontage = nullptr;
-
-	// Montage for divebomb action
-	UPROPERTY(EditDefaultsOnly, Category = Divebomb)
-		UAnimMontage* DivebombMontage = nullptr;
-
-	// Section name in the divebomb montage for landing
-	UPROPERTY(EditDefaultsOnly, Category = Divebomb)
-		FName DiveMontageLandSectionName = "Land";
-
-	// Height buffer for divebomb engagement
-	UPROPERTY(EditDefaultsOnly, Category = Divebomb)
-		float DiveEngageHeightBuffer = 2400.f;
-
-	// Floor check trace ratio for divebomb engagement
-	UPROPERTY(EditDefaultsOnly, Category = Divebomb)
-		float DiveEngageFloorCheckTraceRatio = 1.5f;
-
-	// Floor check trace ratio for divebomb landing
-	UPROPERTY(EditDefaultsOnly, Category = Divebomb)
-		float DiveLandFloorCheckTraceRatio = 20.f;
-
-	// Velocity for divebomb action
-	UPROPERTY(EditDefaultsOnly, Category = Divebomb)
-		float DivebombVelocity = 65000.f;
-
-	// Soft landing limit
-	UPROPERTY(EditDefaultsOnly, Category = FlightLanding)
-		float SoftLandingLimit = 1500.f;
-
-	// Base flight speed
-	UPROPERTY(EditDefaultsOnly, Category = FlightLocomotion)
-		float BaseSpeed = 850.f;
-
-	// Dash speed
-	UPROPERTY(EditDefaultsOnly, Category = FlightLocomotion)
-		float DashSpeed = 9000.f;
-
-	// Base acceleration
-	UPROPERTY(EditDefaultsOnly, Category = FlightLocomotion)
-		float BaseAcceleration = 2500.f;
-
-	// Dash acceleration
-	UPROPERTY(EditDefaultsOnly, Category = FlightLocomotion)
-		float DashAcceleration = 80000.f;
-
-	// Base dodge force
-	UPROPERTY(EditDefaultsOnly, Category = FlightLocomotion)
-		float BaseDodgeForce = 32000000.f;
-
-	// Braking deceleration while flying
-	UPROPERTY(EditDefaultsOnly, Category = FlightLocomotion)
-		float BrakingDecelerationFlying = 2800.f;
-
-	// Interpolation speed for rotation
-	UPROPERTY(EditDefaultsOnly, Category = FlightLocomotionRatios)
-		float RotationInterpSpeed = 8.f;
-
-	// Interpolation speed for dodging
-	UPROPERTY(EditDefaultsOnly, Category = FlightLocomotionRatios)
-		float DodgeInterpSpeed = 8.f;
-
-	// Z-axis momentum coefficient
-	UPROPERTY(EditDefaultsOnly, Category = FlightLocomotionRatios)
-		float ZMomentumCoeff = 0.7f;
-
-	// Duration of the dodge animation
-	UPROPERTY(EditDefaultsOnly, Category = AnimationHandling)
-		float DodgeTime = 1.5f;
-
-	// Buffer time after dodge for resetting dodge state
-	UPROPERTY(EditDefaultsOnly, Category = AnimationHandling)
-		float DodgeBufferTime = 0.1f;
-
 	FTimerHandle DodgeTimerHandle;
 	FTimerHandle DodgeResetBufferTimerHandle;
 	FTimerHandle DivebombTimerHandle;
@@ -219,6 +150,67 @@ private:
 	float CapsuleHalfHeight;
 	float CurrentDodgeForce;
 	float LandingInitiationLocationZ;
-	float DivebombStartSectionLength;
-	float DivebombLandSectionLength;
+
+private:
+#if WITH_EDITORONLY_DATA
+	//////////////////////////////////////////////////////////////////////////
+	// Deprecated tuning, loaded through the core redirects from blueprints saved before the tuning profiles, editor only
+
+	UPROPERTY()
+		UAnimMontage* HardLandingMontage_DEPRECATED = nullptr;
+
+	UPROPERTY()
+		UAnimMontage* DivebombMontage_DEPRECATED = nullptr;
+
+	UPROPERTY()
+		FName DiveMontageLandSectionName_DEPRECATED = "Land";
+
+	UPROPERTY()
+		float DiveEngageHeightBuffer_DEPRECATED = 2400.f;
+
+	UPROPERTY()
+		float DiveEngageFloorCheckTraceRatio_DEPRECATED = 1.5f;
+
+	UPROPERTY()
+		float DiveLandFloorCheckTraceRatio_DEPRECATED = 20.f;
+
+	UPROPERTY()
+		float DivebombVelocity_DEPRECATED = 65000.f;
+
+	UPROPERTY()
+		float SoftLandingLimit_DEPRECATED = 1500.f;
+
+	UPROPERTY()
+		float BaseSpeed_DEPRECATED = 850.f;
+
+	UPROPERTY()
+		float DashSpeed_DEPRECATED = 9000.f;
+
+	UPROPERTY()
+		float BaseAcceleration_DEPRECATED = 2500.f;
+
+	UPROPERTY()
+		float DashAcceleration_DEPRECATED = 80000.f;
+
+	UPROPERTY()
+		float BaseDodgeForce_DEPRECATED = 32000000.f;
+
+	UPROPERTY()
+		float BrakingDecelerationFlying_DEPRECATED = 2800.f;
+
+	UPROPERTY()
+		float RotationInterpSpeed_DEPRECATED = 8.f;
+
+	UPROPERTY()
+		float DodgeInterpSpeed_DEPRECATED = 8.f;
+
+	UPROPERTY()
+		float ZMomentumCoeff_DEPRECATED = 0.7f;
+
+	UPROPERTY()
+		float DodgeTime_DEPRECATED = 1.5f;
+
+	UPROPERTY()
+		float DodgeBufferTime_DEPRECATED = 0.1f;
+#endif
 };
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FlightComponent.h"
+#include "FlightScalabilityComponent.generated.h"
+
+// Forward declarations
+class AController;
+class IConsoleVariable;
+class USkeletalMeshComponent;
+
+/**
+ * Flight scalability component responsible for lowering the detail the locally controlled flyer cannot make out at speed.
+ * Biases the mesh LODs, shadows and streaming, trims the flight effects budget and slows the animation of distant characters
+ * while dashing or diving, and restores everything smoothly once the flyer slows down.
+ */
+UCLASS(ClassGroup = (FlightLocomotion))
+class STEELHEART_API UFlightScalabilityComponent : public UFlightComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UFlightScalabilityComponent();
+
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Log the current detail scaling along with the frame times measured at normal and lowered detail
+	void LogReport() const;
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Console variable blended between its value when scaling started and a lowered value
+	struct FScaledConsoleVariable
+	{
+		IConsoleVariable* Variable = nullptr;
+
+		float BaseValue = 0.f;
+
+		float AppliedValue = 0.f;
+
+		// Priority the variable was set with before scaling, given back once restored
+		uint32 BasePriority = 0;
+	};
+
+	// Only tick while the owner is locally controlled, restoring everything when it stops being
+	UFUNCTION()
+		void HandleControllerChanged(APawn* Pawn, AController* OldController, AController* NewController);
+
+	// Blend the console variables and the effects budget to the current amount of scaling
+	void ApplyScaling();
+
+	// Slow down or restore the animation of the characters out of range
+	void UpdateDistantActors();
+
+	// Restore everything this component changed
+	void RestoreAll();
+
+	// Capture the current value and priority of a console variable the first time it is scaled
+	void ScaleVariable(FScaledConsoleVariable& Scaled, const TCHAR* Name, float LoweredValue);
+
+	FScaledConsoleVariable SkeletalMeshLODBias;
+
+	FScaledConsoleVariable StaticMeshLODDistanceScale;
+
+	FScaledConsoleVariable ShadowDistanceScale;
+
+	FScaledConsoleVariable StreamingBoost;
+
+	// Distant meshes slowed down by this component, along with their original tick interval
+	TMap<TWeakObjectPtr<USkeletalMeshComponent>, float> ThrottledMeshes;
+
+	// Amount of detail lowering, from 0 for none to 1 for full
+	float ScalingAlpha = 0.f;
+
+	// Scaling amount last applied, so console variables are only set when it changes noticeably
+	float AppliedAlpha = 0.f;
+
+	float TimeSinceDistantUpdate = 0.f;
+
+	// Frame times accumulated at normal and fully lowered detail
+	double NormalFrameTime = 0.0;
+	double ScaledFrameTime = 0.0;
+
+	int32 NormalFrameCount = 0;
+	int32 ScaledFrameCount = 0;
+};
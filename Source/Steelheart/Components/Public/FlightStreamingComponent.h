@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FlightComponent.h"
+#include "Steelheart/Data/Public/FlightTuningProfile.h"
+#include "FlightStreamingComponent.generated.h"
+
+// Forward declarations
+struct FStreamableHandle;
+
+/**
+ * Flight streaming component responsible for loading the flight asset groups ahead of the states that need them,
+ * and releasing the groups that have gone unused.
+ */
+UCLASS(ClassGroup = (FlightLocomotion))
+class STEELHEART_API UFlightStreamingComponent : public UFlightComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UFlightStreamingComponent();
+
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Request the given asset group immediately, regardless of the current movement state
+	void RequestGroup(EFlightAssetGroup Group);
+
+	// Check if every asset of the given group is loaded
+	bool IsGroupLoaded(EFlightAssetGroup Group) const;
+
+protected:
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void ApplyTuning() override;
+
+private:
+	// Mark the asset groups used by the current movement state or by the states it can change to
+	void UpdateWantedGroups();
+
+	// Release the asset groups that have not been wanted for ReleaseDelay seconds
+	void ReleaseUnusedGroups();
+
+	// Release the handle of an asset group along with the pooled one-shots prewarmed for it
+	void ReleaseGroup(EFlightAssetGroup Group);
+
+	// Release every handle held by this component
+	void ReleaseAllGroups();
+
+	// Seconds an asset group may go unwanted before it is released
+	UPROPERTY(EditDefaultsOnly, Category = Streaming)
+		float ReleaseDelay = 20.f;
+
+	// Seconds between two evaluations of the movement state
+	UPROPERTY(EditDefaultsOnly, Category = Streaming)
+		float UpdateInterval = 0.25f;
+
+	// Streaming state of one asset group
+	struct FAssetGroupState
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+
+		// Soft references the handle was requested for, compared against the profile when the tuning changes
+		TArray<FSoftObjectPath> Assets;
+
+		// One-shot assets the effects pool was prewarmed with once the group loaded
+		TArray<FSoftObjectPath> PrewarmedAssets;
+
+		float LastWantedTime = 0.f;
+	};
+
+	FAssetGroupState GroupStates[(uint8)EFlightAssetGroup::Count];
+};
@@ -4,6 +4,9 @@
 #include "FlightComponent.h"
 #include "FlightTakeoffComponent.generated.h"
 
+// Forward declarations
+class UAnimMontage;
+
 // Scale factor for the rate of takeoff
 #define RATE_SCALE 1.f
 
@@ -19,6 +22,11 @@ public:
 	// Sets default values for this component's properties
 	UFlightTakeoffComponent();
 
+#if WITH_EDITORONLY_DATA
+	// Copy the tuning saved on this component before the tuning profiles into a profile
+	virtual void MigrateDeprecatedTuning(UFlightTuningProfile* Profile) const override;
+#endif
+
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
@@ -31,10 +39,6 @@ public:
 	// Get the delegate for the released takeoff event
 	FORCEINLINE FReleasedTakeoff* GetTakeoffReleaseDelegate() { return &OnReleaseTakeoff; }
 
-protected:
-	// Called when the game starts
-	virtual void BeginPlay() override;
-
 private:
 	// Loop the takeoff animation
 	UFUNCTION()
@@ -44,21 +48,8 @@ private:
 	UFUNCTION()
 		void EndTakeOff();
 
-	// Animation montage for takeoff
-	UPROPERTY(EditDefaultsOnly, Category = TakeOffAnimation)
-		UAnimMontage* TakeOffMontage = nullptr;
-
-	// Name of the loop section within the takeoff montage
-	UPROPERTY(EditDefaultsOnly, Category = TakeOffAnimation)
-		FName LoopSectionName = "ChargeLoop";
-
-	// Name of the release section within the takeoff montage
-	UPROPERTY(EditDefaultsOnly, Category = TakeOffAnimation)
-		FName ReleaseSectionName = "TakeOff";
-
-	// Base force applied during takeoff
-	UPROPERTY(EditDefaultsOnly)
-		float BaseTakeOffForce = 3500000.f;
+	// Resolve the takeoff montage from the tuning profile
+	UAnimMontage* GetTakeOffMontage() const;
 
 	FTimerHandle TakeOffLoopTimerHandle;
 
@@ -71,14 +62,6 @@ private:
 	// Delegate for the released takeoff event
 	FReleasedTakeoff OnReleaseTakeoff;
 
-	float BaseBlendOutTime;
-
-	float EngageSectionLength;
-
-	float LoopSectionLength;
-
-	float ReleaseSectionLength;
-
 	float ReleaseTimeCounter;
 
 	float CurrentTakeOffForce;
@@ -90,4 +73,22 @@ private:
 	bool bIsTakeOffCharged;
 
 	bool bIsTakingOff;
+
+private:
+#if WITH_EDITORONLY_DATA
+	//////////////////////////////////////////////////////////////////////////
+	// Deprecated tuning, loaded through the core redirects from blueprints saved before the tuning profiles, editor only
+
+	UPROPERTY()
+		UAnimMontage* TakeOffMontage_DEPRECATED = nullptr;
+
+	UPROPERTY()
+		FName LoopSectionName_DEPRECATED = "ChargeLoop";
+
+	UPROPERTY()
+		FName ReleaseSectionName_DEPRECATED = "TakeOff";
+
+	UPROPERTY()
+		float BaseTakeOffForce_DEPRECATED = 3500000.f;
+#endif
 };
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Components/ActorComponent.h"
+#include "Engine/EngineTypes.h"
+#include "Steelheart/Slicing/Public/MeshSlicer.h"
+#include "SlicerComponent.generated.h"
+
+// Forward declarations
+class APlayerController;
+class UMaterialInterface;
+class UProceduralMeshComponent;
+class UStaticMeshComponent;
+
+/**
+ * Slicer component that cuts procedural meshes along a plane drawn with the cursor.
+ * Native replacement for the BP_SlicerComp test blueprint. The mesh is copied on the game thread and sliced on a
+ * worker thread, both halves then being written back to procedural mesh components in a single game thread commit.
+ */
+UCLASS(ClassGroup = (Slicing), meta = (BlueprintSpawnableComponent))
+class STEELHEART_API USlicerComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	USlicerComponent();
+
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Start a slice at the surface under the cursor
+	UFUNCTION(BlueprintCallable, Category = Slicing)
+		void BeginSlice();
+
+	// Finish the slice at the surface under the cursor, cutting the mesh if the stroke is long enough
+	UFUNCTION(BlueprintCallable, Category = Slicing)
+		void EndSlice();
+
+	// Getter for slicing state
+	FORCEINLINE bool IsSlicing() const { return bIsSlicing; }
+
+private:
+	// Get the player controller used for cursor traces
+	APlayerController* GetSlicingController() const;
+
+	// Trace the configured object types under the cursor
+	bool TraceUnderCursor(FHitResult& OutHit) const;
+
+	// Replace a static mesh with a procedural copy that can be sliced
+	UProceduralMeshComponent* SetupProcMesh(UStaticMeshComponent* StaticMeshComp);
+
+	// Cut the procedural mesh with the plane defined by the slice stroke
+	void SliceMesh(UProceduralMeshComponent* ProcMesh, const FVector& Start, const FVector& End);
+
+	// Write the halves of the finished slice to the sliced mesh and a pooled piece, and let them fall apart
+	void CommitSlice(TArray<FSlicerMesh>& Buffers);
+
+	// Replace the simple collision of a half with a convex hull of its vertices
+	void UpdateHullCollision(UProceduralMeshComponent* ProcMesh, const FSlicerMesh& Half);
+
+	// Object types that can be sliced
+	UPROPERTY(EditDefaultsOnly, Category = Slicing)
+		TArray<TEnumAsByte<EObjectTypeQuery>> SliceObjectTypes;
+
+	// Actor class spawned to hold the procedural copy of a sliced static mesh
+	UPROPERTY(EditDefaultsOnly, Category = Slicing)
+		TSubclassOf<AActor> ProcMeshClass;
+
+	// Material applied to the cap created on the slicing plane
+	UPROPERTY(EditDefaultsOnly, Category = Slicing)
+		UMaterialInterface* CapMaterial = nullptr;
+
+	// Minimum stroke length for a slice to be applied
+	UPROPERTY(EditDefaultsOnly, Category = Slicing)
+		float MinSliceDistance = 10.f;
+
+	// Impulse pushing the two halves apart after a slice
+	UPROPERTY(EditDefaultsOnly, Category = Slicing)
+		float SliceImpulseStrength = 500.f;
+
+	// Component being sliced
+	TWeakObjectPtr<UPrimitiveComponent> SliceTarget;
+
+	FVector SliceStart;
+
+	FVector SliceCurrent;
+
+	bool bIsSlicing;
+
+	// Slice in flight on a worker thread, at most one at a time, handing the slice buffers back when done
+	TFuture<TArray<FSlicerMesh>> PendingSlice;
+
+	// Copy of the sliced mesh and its front and back halves, reused from slice to slice so their buffers stop growing
+	TArray<FSlicerMesh> SliceBuffers;
+
+	// Hull sampled into the collision of a half, a single convex mesh kept between slices
+	TArray<TArray<FVector>> HullMeshes;
+
+	// Component sliced by the slice in flight
+	TWeakObjectPtr<UProceduralMeshComponent> PendingMesh;
+
+	// World normal of the plane of the slice in flight
+	FVector PendingNormal;
+};
@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Controllers/Public/SteelheartPlayerController.h"
+#include "Blueprint/UserWidget.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/InputComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "Steelheart/Components/Public/SlicerComponent.h"
+#include "Steelheart/Steelheart.h"
+
+DECLARE_CYCLE_STAT(TEXT("Player Controller Update Ray Angle"), STAT_PlayerControllerUpdateRayAngle, STATGROUP_Steelheart);
+
+ASteelheartPlayerController::ASteelheartPlayerController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	bShowMouseCursor = true;
+
+	Slicer = CreateDefaultSubobject<USlicerComponent>(TEXT("Slicer"));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void ASteelheartPlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (IsLocalController() && InstructionsMenuClass != nullptr)
+	{
+		InstructionsMenu = CreateWidget<UUserWidget>(this, InstructionsMenuClass);
+		if (InstructionsMenu != nullptr)
+		{
+			InstructionsMenu->AddToViewport();
+		}
+	}
+}
+
+void ASteelheartPlayerController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bRayActive)
+	{
+		UpdateRayAngle(DeltaSeconds);
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Input
+
+void ASteelheartPlayerController::SetupInputComponent()
+{
+	Super::SetupInputComponent();
+
+	check(InputComponent);
+
+	InputComponent->BindKey(EKeys::RightMouseButton, IE_Pressed, this, &ASteelheartPlayerController::HandleSlicePressed);
+	InputComponent->BindKey(EKeys::RightMouseButton, IE_Released, this, &ASteelheartPlayerController::HandleSliceReleased);
+
+	InputComponent->BindKey(EKeys::Escape, IE_Pressed, this, &ASteelheartPlayerController::Quit);
+	InputComponent->BindKey(EKeys::Z, IE_Pressed, this, &ASteelheartPlayerController::Restart);
+	InputComponent->BindKey(EKeys::C, IE_Pressed, this, &ASteelheartPlayerController::ToggleControls);
+}
+
+void ASteelheartPlayerController::HandleSlicePressed()
+{
+	Slicer->BeginSlice();
+
+	ActivateRay();
+}
+
+void ASteelheartPlayerController::HandleSliceReleased()
+{
+	Slicer->EndSlice();
+
+	DeactivateRay();
+}
+
+void ASteelheartPlayerController::Quit()
+{
+	UKismetSystemLibrary::QuitGame(this, this, EQuitPreference::Quit, false);
+}
+
+void ASteelheartPlayerController::Restart()
+{
+	ConsoleCommand(TEXT("RestartLevel"));
+}
+
+void ASteelheartPlayerController::ToggleControls()
+{
+	if (InstructionsMenu != nullptr)
+	{
+		InstructionsMenu->SetVisibility(InstructionsMenu->IsVisible() ? ESlateVisibility::Hidden : ESlateVisibility::Visible);
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Ray Handling
+
+void ASteelheartPlayerController::ActivateRay()
+{
+	ACharacter* OwnerCharacter = GetCharacter();
+	if (RayClass == nullptr || OwnerCharacter == nullptr)
+	{
+		return;
+	}
+
+	if (Ray == nullptr)
+	{
+		Ray = GetWorld()->SpawnActor<AActor>(RayClass, OwnerCharacter->GetActorTransform());
+		if (Ray == nullptr)
+		{
+			return;
+		}
+	}
+
+	FAttachmentTransformRules AttachmentTransformRules(EAttachmentRule::SnapToTarget, false);
+	Ray->AttachToComponent(OwnerCharacter->GetMesh(), AttachmentTransformRules, RaySocketName);
+	Ray->SetActorHiddenInGame(false);
+
+	bRayActive = true;
+}
+
+void ASteelheartPlayerController::DeactivateRay()
+{
+	if (Ray != nullptr)
+	{
+		Ray->SetActorHiddenInGame(true);
+	}
+
+	bRayActive = false;
+}
+
+void ASteelheartPlayerController::UpdateRayAngle(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PlayerControllerUpdateRayAngle);
+
+	ACharacter* OwnerCharacter = GetCharacter();
+	if (Ray == nullptr || OwnerCharacter == nullptr || PlayerCameraManager == nullptr)
+	{
+		return;
+	}
+
+	FVector WorldPosition, WorldDirection;
+	if (!DeprojectMousePositionToWorld(WorldPosition, WorldDirection))
+	{
+		return;
+	}
+
+	// Deactivate the ray when the cursor points too far away from the view direction
+	float ViewAngle = FMath::RadiansToDegrees(FMath::Acos(
+		FVector::DotProduct(PlayerCameraManager->GetCameraRotation().Vector(), WorldDirection)));
+	if (ViewAngle > LaserFrustrumAngle)
+	{
+		DeactivateRay();
+		return;
+	}
+
+	// Aim at whatever is under the cursor, or at the maximum ray length
+	FHitResult Hit;
+	FVector Target = GetHitResultUnderCursor(ECC_Visibility, true, Hit) ?
+		Hit.ImpactPoint : WorldPosition + WorldDirection * MaxRayLength;
+
+	FVector SocketLocation = OwnerCharacter->GetMesh()->GetSocketLocation(RaySocketName);
+	FRotator TargetRotation = UKismetMathLibrary::FindLookAtRotation(SocketLocation, Target);
+	FRotator NewRotation = FMath::RInterpTo(Ray->GetActorRotation(), TargetRotation, DeltaSeconds, RayInterpSpeed);
+	Ray->SetActorRotation(NewRotation);
+
+	// Stretch the ray along its forward axis to reach the target
+	FVector RayScale = Ray->GetActorScale3D();
+	RayScale.X = FVector::Dist(SocketLocation, Target) * RayLengthRatio;
+	Ray->SetActorScale3D(RayScale);
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Steelheart/TempPlayerController.h"
+#include "SteelheartPlayerController.generated.h"
+
+// Forward declarations
+class USlicerComponent;
+class UUserWidget;
+
+/**
+ * Native player controller hosting the instructions menu, the slicing input and the cursor ray.
+ * BP_SteelheartPlayerController_Temp and BP_ProcController derive from it as data-only blueprints.
+ */
+UCLASS()
+class STEELHEART_API ASteelheartPlayerController : public ATempPlayerController
+{
+	GENERATED_BODY()
+
+	/** Slicer used by the right mouse button */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Slicing, meta = (AllowPrivateAccess = "true"))
+		USlicerComponent* Slicer;
+
+public:
+	ASteelheartPlayerController();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void SetupInputComponent() override;
+
+private:
+	// Handle the slicing and ray input
+	void HandleSlicePressed();
+
+	void HandleSliceReleased();
+
+	// Quit the game
+	void Quit();
+
+	// Restart the current level
+	void Restart();
+
+	// Show or hide the instructions menu
+	void ToggleControls();
+
+	// Spawn and attach the ray to the pawn, showing it
+	void ActivateRay();
+
+	// Hide the ray
+	void DeactivateRay();
+
+	// Aim the ray at the cursor
+	void UpdateRayAngle(float DeltaSeconds);
+
+	// Widget listing the controls, shown on begin play
+	UPROPERTY(EditDefaultsOnly, Category = Interface)
+		TSubclassOf<UUserWidget> InstructionsMenuClass;
+
+	// Actor used to visualize the ray while slicing
+	UPROPERTY(EditDefaultsOnly, Category = Ray)
+		TSubclassOf<AActor> RayClass;
+
+	// Socket on the pawn mesh the ray originates from
+	UPROPERTY(EditDefaultsOnly, Category = Ray)
+		FName RaySocketName = "headSocket";
+
+	// Maximum angle between the view and the ray before it is deactivated
+	UPROPERTY(EditDefaultsOnly, Category = Ray)
+		float LaserFrustrumAngle = 60.f;
+
+	// Scale applied to the ray per unit of distance to the target
+	UPROPERTY(EditDefaultsOnly, Category = Ray)
+		float RayLengthRatio = 0.01f;
+
+	// Length of the ray when nothing is under the cursor
+	UPROPERTY(EditDefaultsOnly, Category = Ray)
+		float MaxRayLength = 10000.f;
+
+	// Interpolation speed of the ray rotation
+	UPROPERTY(EditDefaultsOnly, Category = Ray)
+		float RayInterpSpeed = 20.f;
+
+	UPROPERTY()
+		UUserWidget* InstructionsMenu = nullptr;
+
+	UPROPERTY()
+		AActor* Ray = nullptr;
+
+	bool bRayActive;
+};
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Data/Public/DestructibleSupportGraph.h"
+#include "GeometryCollection/GeometryCollectionAlgo.h"
+#include "GeometryCollection/GeometryCollectionObject.h"
+
+#if WITH_EDITOR
+void UDestructibleSupportGraph::Bake()
+{
+	UGeometryCollection* LoadedCollection = Collection.LoadSynchronous();
+	TSharedPtr<FGeometryCollection, ESPMode::ThreadSafe> RestCollection = LoadedCollection ? LoadedCollection->GetGeometryCollection() : nullptr;
+	if (!RestCollection.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: no collection to bake the support graph from."), *GetName());
+		return;
+	}
+
+	Modify();
+
+	Nodes.Reset();
+	Edges.Reset();
+
+	TArray<FTransform> Globals;
+	GeometryCollectionAlgo::GlobalMatrices(RestCollection->Transform, RestCollection->Parent, Globals);
+
+	// Leaf pieces carry the load, clusters only group them
+	TArray<FBox> NodeBounds;
+	FBox CollectionBounds(ForceInit);
+
+	for (int32 TransformIndex = 0; TransformIndex < RestCollection->NumElements(FGeometryCollection::TransformGroup); TransformIndex++)
+	{
+		int32 GeometryIndex = RestCollection->TransformToGeometryIndex[TransformIndex];
+		if (GeometryIndex == INDEX_NONE || RestCollection->Children[TransformIndex].Num() > 0)
+		{
+			continue;
+		}
+
+		FBox Bounds = RestCollection->BoundingBox[GeometryIndex].TransformBy(Globals[TransformIndex]);
+
+		FDestructibleSupportNode& Node = Nodes.AddDefaulted_GetRef();
+		Node.TransformIndex = TransformIndex;
+		Node.Center = Bounds.GetCenter();
+		Node.Radius = Bounds.GetExtent().Size();
+
+		NodeBounds.Add(Bounds);
+		CollectionBounds += Bounds;
+	}
+
+	// Contacts between every pair, only ever paid for in editor
+	TArray<TArray<int32>> Neighbours;
+	Neighbours.SetNum(Nodes.Num());
+
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); NodeIndex++)
+	{
+		FBox Expanded = NodeBounds[NodeIndex].ExpandBy(ContactTolerance);
+		for (int32 OtherIndex = NodeIndex + 1; OtherIndex < Nodes.Num(); OtherIndex++)
+		{
+			if (Expanded.Intersect(NodeBounds[OtherIndex]))
+			{
+				Neighbours[NodeIndex].Add(OtherIndex);
+				Neighbours[OtherIndex].Add(NodeIndex);
+			}
+		}
+	}
+
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); NodeIndex++)
+	{
+		Nodes[NodeIndex].FirstEdge = Edges.Num();
+		Nodes[NodeIndex].NumEdges = Neighbours[NodeIndex].Num();
+		Edges.Append(Neighbours[NodeIndex]);
+	}
+
+	// Distances to the anchors guide the runtime search for support towards them
+	TArray<int32> Frontier;
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); NodeIndex++)
+	{
+		const FBox& Bounds = NodeBounds[NodeIndex];
+		bool bAnchored = Bounds.Min.Z <= CollectionBounds.Min.Z + AnchorHeight
+			|| AnchorBoxes.ContainsByPredicate([&Bounds](const FBox& AnchorBox) { return AnchorBox.Intersect(Bounds); });
+
+		if (bAnchored)
+		{
+			Nodes[NodeIndex].AnchorDistance = 0;
+			Frontier.Add(NodeIndex);
+		}
+	}
+
+	for (int32 FrontierIndex = 0; FrontierIndex < Frontier.Num(); FrontierIndex++)
+	{
+		int32 NodeIndex = Frontier[FrontierIndex];
+		for (int32 Neighbour : GetNeighbours(NodeIndex))
+		{
+			if (Nodes[Neighbour].AnchorDistance == INDEX_NONE)
+			{
+				Nodes[Neighbour].AnchorDistance = Nodes[NodeIndex].AnchorDistance + 1;
+				Frontier.Add(Neighbour);
+			}
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s: baked %d nodes and %d contacts, %d nodes reach no anchor."),
+		*GetName(), Nodes.Num(), Edges.Num() / 2, Nodes.Num() - Frontier.Num());
+}
+#endif
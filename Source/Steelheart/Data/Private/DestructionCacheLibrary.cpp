@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Data/Public/DestructionCacheLibrary.h"
+#include "Chaos/CacheCollection.h"
+#include "GeometryCollection/GeometryCollectionObject.h"
+
+UDestructionCacheLibrary::UDestructionCacheLibrary()
+{
+	StrengthThresholds = { 4000.f, 8000.f };
+}
+
+int32 UDestructionCacheLibrary::GetDirectionBucket(const FVector& LocalDirection) const
+{
+	FVector Direction = LocalDirection.GetSafeNormal();
+	if (Direction.Z < -DownwardThreshold)
+	{
+		return DirectionBuckets;
+	}
+
+	// Sectors are centered on the axes, the first one facing down the X axis
+	float SectorAngle = 2.f * PI / DirectionBuckets;
+	float Angle = FMath::Atan2(Direction.Y, Direction.X) + SectorAngle * 0.5f;
+	if (Angle < 0.f)
+	{
+		Angle += 2.f * PI;
+	}
+
+	return FMath::Clamp(FMath::FloorToInt(Angle / SectorAngle), 0, DirectionBuckets - 1);
+}
+
+int32 UDestructionCacheLibrary::GetStrengthBucket(float Strength) const
+{
+	int32 Bucket = 0;
+	while (Bucket < StrengthThresholds.Num() && Strength >= StrengthThresholds[Bucket])
+	{
+		Bucket++;
+	}
+
+	return Bucket;
+}
+
+const FDestructionCacheEntry* UDestructionCacheLibrary::FindEntry(const TSoftObjectPtr<UGeometryCollection>& Collection, int32 DirectionBucket, int32 StrengthBucket) const
+{
+	return Entries.FindByPredicate([&](const FDestructionCacheEntry& Entry)
+	{
+		return Entry.Collection == Collection && Entry.DirectionBucket == DirectionBucket && Entry.StrengthBucket == StrengthBucket;
+	});
+}
+
+void UDestructionCacheLibrary::GetCollectionCaches(const TSoftObjectPtr<UGeometryCollection>& Collection, TArray<FSoftObjectPath>& OutCaches) const
+{
+	for (const FDestructionCacheEntry& Entry : Entries)
+	{
+		if (Entry.Collection == Collection && !Entry.Cache.IsNull())
+		{
+			OutCaches.Add(Entry.Cache.ToSoftObjectPath());
+		}
+	}
+}
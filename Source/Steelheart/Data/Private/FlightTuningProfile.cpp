@@ -0,0 +1,256 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Data/Public/FlightTuningProfile.h"
+#include "Animation/AnimMontage.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Steelheart/Characters/Public/SteelheartCharacter.h"
+#include "UObject/ObjectSaveContext.h"
+#include "UObject/UObjectIterator.h"
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UFlightTuningProfile::PreSave(FObjectPreSaveContext SaveContext)
+{
+	BakeDerivedValues();
+
+	Super::PreSave(SaveContext);
+}
+
+#if WITH_EDITOR
+void UFlightTuningProfile::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Push edits made while playing in editor to the live flyers
+	BakeDerivedValues();
+	NotifyTuningChanged();
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Tuning Functions
+
+void UFlightTuningProfile::BakeDerivedValues()
+{
+	// Baking happens at save or reload time, so loading the montages here keeps them off the runtime path
+	if (UAnimMontage* DivebombMontage = Locomotion.DivebombMontage.LoadSynchronous())
+	{
+		int32 StartSectionIndex = DivebombMontage->GetSectionIndex("Default");
+		Baked.DivebombStartSectionLength = DivebombMontage->GetSectionLength(StartSectionIndex) / DIVEBOMB_RATE_SCALE;
+
+		int32 LandSectionIndex = DivebombMontage->GetSectionIndex(Locomotion.DiveMontageLandSectionName);
+		Baked.DivebombLandSectionLength = DivebombMontage->GetSectionLength(LandSectionIndex) / DIVEBOMB_RATE_SCALE;
+	}
+
+	if (UAnimMontage* TakeOffMontage = Takeoff.TakeOffMontage.LoadSynchronous())
+	{
+		int32 EngageSectionIndex = TakeOffMontage->GetSectionIndex("Default");
+		Baked.TakeOffEngageSectionLength = TakeOffMontage->GetSectionLength(EngageSectionIndex);
+
+		int32 LoopSectionIndex = TakeOffMontage->GetSectionIndex(Takeoff.LoopSectionName);
+		Baked.TakeOffLoopSectionLength = TakeOffMontage->GetSectionLength(LoopSectionIndex);
+
+		int32 ReleaseSectionIndex = TakeOffMontage->GetSectionIndex(Takeoff.ReleaseSectionName);
+		Baked.TakeOffReleaseSectionLength = TakeOffMontage->GetSectionLength(ReleaseSectionIndex);
+	}
+}
+
+void UFlightTuningProfile::NotifyTuningChanged() const
+{
+	OnTuningChanged().Broadcast(this);
+}
+
+void UFlightTuningProfile::GetAssetGroup(EFlightAssetGroup Group, TArray<FSoftObjectPath>& OutAssets) const
+{
+	auto AddAsset = [&OutAssets](const auto& Asset)
+	{
+		if (!Asset.IsNull())
+		{
+			OutAssets.AddUnique(Asset.ToSoftObjectPath());
+		}
+	};
+
+	switch (Group)
+	{
+	case EFlightAssetGroup::Takeoff:
+		AddAsset(Takeoff.TakeOffMontage);
+		AddAsset(Effects.TakeoffChargeEffect);
+		AddAsset(Effects.SonicBoomEffect);
+		AddAsset(Effects.SonicBoomSound);
+		break;
+
+	case EFlightAssetGroup::Divebomb:
+		AddAsset(Locomotion.DivebombMontage);
+		AddAsset(Effects.DiveTrailEffect);
+		AddAsset(Effects.DiveLandEffect);
+		AddAsset(Effects.DiveLandSound);
+		AddAsset(Effects.CraterDecal);
+		AddAsset(Effects.SonicBoomEffect);
+		AddAsset(Effects.SonicBoomSound);
+		break;
+
+	case EFlightAssetGroup::Landing:
+		AddAsset(Locomotion.HardLandingMontage);
+		AddAsset(Effects.LandEffect);
+		AddAsset(Effects.DiveLandSound);
+		AddAsset(Effects.CraterDecal);
+		break;
+
+	case EFlightAssetGroup::Dash:
+		AddAsset(Effects.DashTrailEffect);
+		AddAsset(Effects.SharedTrailEffect);
+		AddAsset(Effects.DodgeEffect);
+		AddAsset(Effects.WindSound);
+		AddAsset(Effects.SonicBoomEffect);
+		AddAsset(Effects.SonicBoomSound);
+		break;
+
+	case EFlightAssetGroup::Hover:
+		AddAsset(Effects.HoverEffect);
+		AddAsset(Effects.SharedTrailEffect);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UFlightTuningProfile::GetOneShotAssets(EFlightAssetGroup Group, TArray<FSoftObjectPath>& OutAssets) const
+{
+	TArray<FSoftObjectPath> GroupAssets;
+	GetAssetGroup(Group, GroupAssets);
+
+	// The other effects and sounds play on components attached to the character, which the pool never prewarms
+	const FSoftObjectPath OneShotAssets[] =
+	{
+		Effects.LandEffect.ToSoftObjectPath(),
+		Effects.DiveLandEffect.ToSoftObjectPath(),
+		Effects.DiveLandSound.ToSoftObjectPath(),
+		Effects.SonicBoomSound.ToSoftObjectPath()
+	};
+
+	for (const FSoftObjectPath& Asset : GroupAssets)
+	{
+		if (MakeArrayView(OneShotAssets).Contains(Asset))
+		{
+			OutAssets.AddUnique(Asset);
+		}
+	}
+}
+
+FFlightTuningChanged& UFlightTuningProfile::OnTuningChanged()
+{
+	static FFlightTuningChanged TuningChangedDelegate;
+	return TuningChangedDelegate;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Console Commands
+
+namespace FlightTuningConsole
+{
+	// Collect the profiles currently used by the flyers of the given world
+	static TArray<UFlightTuningProfile*> GetProfilesInUse(UWorld* World)
+	{
+		TArray<UFlightTuningProfile*> Profiles;
+		for (TActorIterator<ASteelheartCharacter> It(World); It; ++It)
+		{
+			// Profiles are immutable to gameplay code, the console is the one place allowed to edit them
+			Profiles.AddUnique(const_cast<UFlightTuningProfile*>(It->GetFlightTuningProfile()));
+		}
+
+		return Profiles;
+	}
+
+	static void SetValue(const TArray<FString>& Args, UWorld* World)
+	{
+		if (Args.Num() < 2)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Usage: Flight.Tuning.Set <Section.Property> <Value>  (e.g. Locomotion.DashSpeed 12000)"));
+			return;
+		}
+
+		FString SectionName, PropertyName;
+		if (!Args[0].Split(TEXT("."), &SectionName, &PropertyName))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Flight.Tuning.Set: expected <Section.Property>, got %s."), *Args[0]);
+			return;
+		}
+
+		FStructProperty* SectionProperty = FindFProperty<FStructProperty>(UFlightTuningProfile::StaticClass(), *SectionName);
+		FProperty* ValueProperty = SectionProperty ? SectionProperty->Struct->FindPropertyByName(*PropertyName) : nullptr;
+		if (ValueProperty == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Flight.Tuning.Set: no tuning value named %s."), *Args[0]);
+			return;
+		}
+
+		for (UFlightTuningProfile* Profile : GetProfilesInUse(World))
+		{
+			void* SectionPtr = SectionProperty->ContainerPtrToValuePtr<void>(Profile);
+			void* ValuePtr = ValueProperty->ContainerPtrToValuePtr<void>(SectionPtr);
+
+			if (ValueProperty->ImportText_Direct(*Args[1], ValuePtr, Profile, PPF_None) == nullptr)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Flight.Tuning.Set: could not parse %s for %s."), *Args[1], *Args[0]);
+				return;
+			}
+
+			Profile->BakeDerivedValues();
+			Profile->NotifyTuningChanged();
+
+			UE_LOG(LogTemp, Log, TEXT("%s: %s = %s"), *Profile->GetName(), *Args[0], *Args[1]);
+		}
+	}
+
+	static void UseProfile(const TArray<FString>& Args, UWorld* World)
+	{
+		if (Args.Num() < 1)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Usage: Flight.Tuning.Use <ProfileAssetPath>"));
+			return;
+		}
+
+		UFlightTuningProfile* Profile = LoadObject<UFlightTuningProfile>(nullptr, *Args[0]);
+		if (Profile == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Flight.Tuning.Use: could not load profile %s."), *Args[0]);
+			return;
+		}
+
+		for (TActorIterator<ASteelheartCharacter> It(World); It; ++It)
+		{
+			It->SetFlightTuningProfile(Profile);
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Flyers now use tuning profile %s."), *Profile->GetName());
+	}
+
+	static void Reload(const TArray<FString>& Args, UWorld* World)
+	{
+		// Re-bake and re-apply every loaded profile, picking up edits to the profiles and their montages
+		for (TObjectIterator<UFlightTuningProfile> It; It; ++It)
+		{
+			It->BakeDerivedValues();
+			It->NotifyTuningChanged();
+		}
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs SetCommand(
+		TEXT("Flight.Tuning.Set"),
+		TEXT("Set a value on the tuning profiles in use: Flight.Tuning.Set <Section.Property> <Value>"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SetValue));
+
+	static FAutoConsoleCommandWithWorldAndArgs UseCommand(
+		TEXT("Flight.Tuning.Use"),
+		TEXT("Swap the tuning profile of every flyer: Flight.Tuning.Use <ProfileAssetPath>"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&UseProfile));
+
+	static FAutoConsoleCommandWithWorldAndArgs ReloadCommand(
+		TEXT("Flight.Tuning.Reload"),
+		TEXT("Re-bake and re-apply every loaded flight tuning profile"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Reload));
+}
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "DestructibleSupportGraph.generated.h"
+
+// Forward declarations
+class UGeometryCollection;
+
+/**
+ * Piece of a building carrying or carried by its neighbours.
+ */
+USTRUCT()
+struct FDestructibleSupportNode
+{
+	GENERATED_BODY()
+
+	// Transform index of the piece in the collection
+	UPROPERTY(VisibleAnywhere, Category = Support)
+		int32 TransformIndex = INDEX_NONE;
+
+	// Center of the piece at rest, in the space of the collection
+	UPROPERTY(VisibleAnywhere, Category = Support)
+		FVector Center = FVector::ZeroVector;
+
+	// Radius of the piece at rest
+	UPROPERTY(VisibleAnywhere, Category = Support)
+		float Radius = 0.f;
+
+	// First of the edges of the node in the edge array
+	UPROPERTY(VisibleAnywhere, Category = Support)
+		int32 FirstEdge = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = Support)
+		int32 NumEdges = 0;
+
+	// Fewest edges between the node and an anchored node, zero for anchored nodes, INDEX_NONE if none can be reached
+	UPROPERTY(VisibleAnywhere, Category = Support)
+		int32 AnchorDistance = INDEX_NONE;
+};
+
+/**
+ * Structural support graph of a destructible building, baked in editor from its collection.
+ * Nodes are the leaf pieces of the collection, edges join the pieces in contact at rest,
+ * and anchored nodes hold the building up the way the anchor fields do at runtime.
+ */
+UCLASS(BlueprintType)
+class STEELHEART_API UDestructibleSupportGraph : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	FORCEINLINE bool IsAnchor(int32 NodeIndex) const { return Nodes[NodeIndex].AnchorDistance == 0; }
+
+	// Neighbours of a node
+	FORCEINLINE TArrayView<const int32> GetNeighbours(int32 NodeIndex) const
+	{
+		return MakeArrayView(Edges.GetData() + Nodes[NodeIndex].FirstEdge, Nodes[NodeIndex].NumEdges);
+	}
+
+#if WITH_EDITOR
+	// Build the graph from the pieces of the collection
+	UFUNCTION(CallInEditor, Category = Bake)
+		void Bake();
+#endif
+
+	// Collection the graph was baked from
+	UPROPERTY(EditAnywhere, Category = Bake)
+		TSoftObjectPtr<UGeometryCollection> Collection;
+
+	// Gap between the bounds of two pieces still counted as contact
+	UPROPERTY(EditAnywhere, Category = Bake)
+		float ContactTolerance = 2.f;
+
+	// Pieces reaching down to within this height of the bottom of the collection are anchored to the ground
+	UPROPERTY(EditAnywhere, Category = Bake)
+		float AnchorHeight = 20.f;
+
+	// Additional anchored regions, in the space of the collection, matching the anchor fields placed on the building
+	UPROPERTY(EditAnywhere, Category = Bake)
+		TArray<FBox> AnchorBoxes;
+
+	UPROPERTY(VisibleAnywhere, Category = Support)
+		TArray<FDestructibleSupportNode> Nodes;
+
+	// Neighbours of every node, one run per node
+	UPROPERTY(VisibleAnywhere, Category = Support)
+		TArray<int32> Edges;
+};
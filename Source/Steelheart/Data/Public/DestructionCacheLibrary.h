@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "DestructionCacheLibrary.generated.h"
+
+// Forward declarations
+class UChaosCacheCollection;
+class UGeometryCollection;
+
+/**
+ * Recorded fracture of one collection for one bucket of impact direction and strength.
+ */
+USTRUCT(BlueprintType)
+struct FDestructionCacheEntry
+{
+	GENERATED_BODY()
+
+	// Collection the fracture was recorded from
+	UPROPERTY(EditAnywhere, Category = Cache)
+		TSoftObjectPtr<UGeometryCollection> Collection;
+
+	// Bucket of the impact direction, in the space of the collection
+	UPROPERTY(EditAnywhere, Category = Cache)
+		int32 DirectionBucket = 0;
+
+	// Bucket of the impact speed
+	UPROPERTY(EditAnywhere, Category = Cache)
+		int32 StrengthBucket = 0;
+
+	// Recorded fracture, filled in by recording an impact of this bucket
+	UPROPERTY(EditAnywhere, Category = Cache)
+		TSoftObjectPtr<UChaosCacheCollection> Cache;
+};
+
+/**
+ * Library of fractures recorded offline for the destructible collections, keyed by impact direction and strength.
+ * Impacts matching a recorded bucket play the cache back instead of simulating the fracture.
+ */
+UCLASS(BlueprintType)
+class STEELHEART_API UDestructionCacheLibrary : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UDestructionCacheLibrary();
+
+	// Bucket of an impact direction given in the space of the collection
+	int32 GetDirectionBucket(const FVector& LocalDirection) const;
+
+	// Bucket of an impact speed
+	int32 GetStrengthBucket(float Strength) const;
+
+	/**
+	 * Finds the entry recorded for a collection and an impact bucket.
+	 *
+	 * @param Collection The collection struck.
+	 * @param DirectionBucket Bucket of the impact direction.
+	 * @param StrengthBucket Bucket of the impact speed.
+	 * @return The entry of the bucket, or null if none was set up.
+	 */
+	const FDestructionCacheEntry* FindEntry(const TSoftObjectPtr<UGeometryCollection>& Collection, int32 DirectionBucket, int32 StrengthBucket) const;
+
+	// Collect the caches recorded for a collection, to stream them in along with it
+	void GetCollectionCaches(const TSoftObjectPtr<UGeometryCollection>& Collection, TArray<FSoftObjectPath>& OutCaches) const;
+
+	// Number of sectors the horizontal impact directions are split into, downward impacts have a bucket of their own numbered after them
+	UPROPERTY(EditAnywhere, Category = Buckets, meta = (ClampMin = 1))
+		int32 DirectionBuckets = 8;
+
+	// Impacts pointing down more steeply than this go to the downward bucket
+	UPROPERTY(EditAnywhere, Category = Buckets)
+		float DownwardThreshold = 0.7f;
+
+	// Impact speeds separating the strength buckets, in increasing order
+	UPROPERTY(EditAnywhere, Category = Buckets)
+		TArray<float> StrengthThresholds;
+
+	UPROPERTY(EditAnywhere, Category = Cache)
+		TArray<FDestructionCacheEntry> Entries;
+};
@@ -0,0 +1,561 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/EngineTypes.h"
+#include "Sound/SoundConcurrency.h"
+#include "FlightTuningProfile.generated.h"
+
+// Forward declarations
+class UAnimMontage;
+class UMaterialInterface;
+class UNiagaraSystem;
+class USoundBase;
+
+// Macro defining a scaling factor for divebomb rate
+#define DIVEBOMB_RATE_SCALE 2.f
+
+// Groups of flight assets streamed in together ahead of the states that need them
+UENUM(BlueprintType)
+enum class EFlightAssetGroup : uint8
+{
+	Takeoff,
+	Divebomb,
+	Landing,
+	Dash,
+	Hover,
+	Count UMETA(Hidden)
+};
+ENUM_RANGE_BY_COUNT(EFlightAssetGroup, EFlightAssetGroup::Count);
+
+/**
+ * Tuning of the ground locomotion and camera handling of ASteelheartCharacter.
+ */
+USTRUCT(BlueprintType)
+struct FSteelheartCharacterTuning
+{
+	GENERATED_BODY()
+
+	// Animation montage to play when the character starts a regular jump
+	UPROPERTY(EditAnywhere, Category = JumpAnimations)
+		UAnimMontage* JumpStartMontage = nullptr;
+
+	// Animation montage to play when the character starts a leap
+	UPROPERTY(EditAnywhere, Category = JumpAnimations)
+		UAnimMontage* LeapStartMontage = nullptr;
+
+	// Speed required for the character to perform a leap
+	UPROPERTY(EditAnywhere, Category = Locomotion)
+		float SpeedRequiredForLeap = 2500.f;
+
+	UPROPERTY(EditAnywhere, Category = Locomotion)
+		float WalkSpeed = 150.f;
+
+	UPROPERTY(EditAnywhere, Category = Locomotion)
+		float MaxGroundSpeedInterpSpeed = 4.f;
+
+	UPROPERTY(EditAnywhere, Category = Locomotion)
+		float DashJumpZVelocity = 1200.f;
+
+	UPROPERTY(EditAnywhere, Category = Locomotion)
+		float DashSpeed = 3000.f;
+
+	UPROPERTY(EditAnywhere, Category = Locomotion)
+		float DashAcceleration = 50000.f;
+
+	/**
+	* Interpolation speed for mouse rotation.
+	* Determines how quickly the character's rotation interpolates when smoothly turning with the mouse.
+	*/
+	UPROPERTY(EditAnywhere, Category = CameraHandling)
+		float MouseRotationInterpSpeed = 10.f;
+
+	UPROPERTY(EditAnywhere, Category = CameraHandling)
+		float DashCameraLerpTime = 1.f;
+
+	UPROPERTY(EditAnywhere, Category = CameraHandling)
+		float DiveCameraLerpTime = 0.4f;
+
+	UPROPERTY(EditAnywhere, Category = CameraHandling)
+		float CameraBoomTargetLength = 900.f;
+};
+
+/**
+ * Tuning of UFlightLocomotionComponent.
+ */
+USTRUCT(BlueprintType)
+struct FFlightLocomotionTuning
+{
+	GENERATED_BODY()
+
+	// Montage for hard landing
+	UPROPERTY(EditAnywhere, Category = FlightLanding)
+		TSoftObjectPtr<UAnimMontage> HardLandingMontage;
+
+	// Soft landing limit
+	UPROPERTY(EditAnywhere, Category = FlightLanding)
+		float SoftLandingLimit = 1500.f;
+
+	// Montage for divebomb action
+	UPROPERTY(EditAnywhere, Category = Divebomb)
+		TSoftObjectPtr<UAnimMontage> DivebombMontage;
+
+	// Section name in the divebomb montage for landing
+	UPROPERTY(EditAnywhere, Category = Divebomb)
+		FName DiveMontageLandSectionName = "Land";
+
+	// Height buffer for divebomb engagement
+	UPROPERTY(EditAnywhere, Category = Divebomb)
+		float DiveEngageHeightBuffer = 2400.f;
+
+	// Floor check trace ratio for divebomb engagement
+	UPROPERTY(EditAnywhere, Category = Divebomb)
+		float DiveEngageFloorCheckTraceRatio = 1.5f;
+
+	// Floor check trace ratio for divebomb landing
+	UPROPERTY(EditAnywhere, Category = Divebomb)
+		float DiveLandFloorCheckTraceRatio = 20.f;
+
+	// Velocity for divebomb action
+	UPROPERTY(EditAnywhere, Category = Divebomb)
+		float DivebombVelocity = 65000.f;
+
+	// Base flight speed
+	UPROPERTY(EditAnywhere, Category = FlightLocomotion)
+		float BaseSpeed = 850.f;
+
+	// Dash speed
+	UPROPERTY(EditAnywhere, Category = FlightLocomotion)
+		float DashSpeed = 9000.f;
+
+	// Base acceleration
+	UPROPERTY(EditAnywhere, Category = FlightLocomotion)
+		float BaseAcceleration = 2500.f;
+
+	// Dash acceleration
+	UPROPERTY(EditAnywhere, Category = FlightLocomotion)
+		float DashAcceleration = 80000.f;
+
+	// Base dodge force
+	UPROPERTY(EditAnywhere, Category = FlightLocomotion)
+		float BaseDodgeForce = 32000000.f;
+
+	// Braking deceleration while flying
+	UPROPERTY(EditAnywhere, Category = FlightLocomotion)
+		float BrakingDecelerationFlying = 2800.f;
+
+	// Interpolation speed for rotation
+	UPROPERTY(EditAnywhere, Category = FlightLocomotionRatios)
+		float RotationInterpSpeed = 8.f;
+
+	// Interpolation speed for dodging
+	UPROPERTY(EditAnywhere, Category = FlightLocomotionRatios)
+		float DodgeInterpSpeed = 8.f;
+
+	// Z-axis momentum coefficient
+	UPROPERTY(EditAnywhere, Category = FlightLocomotionRatios)
+		float ZMomentumCoeff = 0.7f;
+
+	// Duration of the dodge animation
+	UPROPERTY(EditAnywhere, Category = AnimationHandling)
+		float DodgeTime = 1.5f;
+
+	// Buffer time after dodge for resetting dodge state
+	UPROPERTY(EditAnywhere, Category = AnimationHandling)
+		float DodgeBufferTime = 0.1f;
+};
+
+/**
+ * Tuning of UFlightTakeoffComponent.
+ */
+USTRUCT(BlueprintType)
+struct FFlightTakeoffTuning
+{
+	GENERATED_BODY()
+
+	// Animation montage for takeoff
+	UPROPERTY(EditAnywhere, Category = TakeOffAnimation)
+		TSoftObjectPtr<UAnimMontage> TakeOffMontage;
+
+	// Name of the loop section within the takeoff montage
+	UPROPERTY(EditAnywhere, Category = TakeOffAnimation)
+		FName LoopSectionName = "ChargeLoop";
+
+	// Name of the release section within the takeoff montage
+	UPROPERTY(EditAnywhere, Category = TakeOffAnimation)
+		FName ReleaseSectionName = "TakeOff";
+
+	// Base force applied during takeoff
+	UPROPERTY(EditAnywhere, Category = TakeOffForce)
+		float BaseTakeOffForce = 3500000.f;
+};
+
+/**
+ * Tuning of UFlightCollisionComponent.
+ */
+USTRUCT(BlueprintType)
+struct FFlightCollisionTuning
+{
+	GENERATED_BODY()
+
+	// Radius of the dash impact field
+	UPROPERTY(EditAnywhere, Category = CollisionParameters)
+		float SphereRadius = 1800.f;
+
+	// Magnitude of the falloff field
+	UPROPERTY(EditAnywhere, Category = CollisionParameters)
+		float FalloffMagnitude = 500000.f;
+
+	// Magnitude of the radial vector field
+	UPROPERTY(EditAnywhere, Category = CollisionParameters)
+		float VectorMagnitude = 1000.f;
+
+	// Tag registering actors with the destructible registry, for destructibles without a marker component
+	UPROPERTY(EditAnywhere, Category = CollisionParameters)
+		FName DestructibleTag = "Destructible";
+
+	// Time before the same destructible can be struck again by the same flyer
+	UPROPERTY(EditAnywhere, Category = CollisionParameters)
+		float HitBufferTime = 0.8f;
+
+	// Object types of the components a dash can strike, hits against any other type are dropped on arrival.
+	// World static is left out so floor and wall scrapes never reach the destructible registry
+	UPROPERTY(EditAnywhere, Category = CollisionParameters)
+		TArray<TEnumAsByte<ECollisionChannel>> DestructibleObjectTypes = { ECC_WorldDynamic, ECC_Destructible };
+
+	// Time ahead of a fast flyer that the destructibles on its path are prepared for the impact
+	UPROPERTY(EditAnywhere, Category = CollisionLookahead)
+		float LookaheadTime = 0.4f;
+
+	// Speed above which destructibles are looked for ahead of the flyer, dashes are always looked ahead of
+	UPROPERTY(EditAnywhere, Category = CollisionLookahead)
+		float LookaheadMinSpeed = 3000.f;
+
+	// Distance to the projected path within which destructibles are prepared
+	UPROPERTY(EditAnywhere, Category = CollisionLookahead)
+		float LookaheadRadius = 400.f;
+
+	// Time between two projections of the path
+	UPROPERTY(EditAnywhere, Category = CollisionLookahead)
+		float LookaheadInterval = 0.1f;
+
+	// Time the textures of a prepared destructible are kept streamed in, interior faces included
+	UPROPERTY(EditAnywhere, Category = CollisionLookahead)
+		float PrestreamTime = 3.f;
+
+	// Time before a prepared destructible is prepared again
+	UPROPERTY(EditAnywhere, Category = CollisionLookahead)
+		float PreparedTime = 5.f;
+
+	// Radius of the shockwave of a divebomb landing
+	UPROPERTY(EditAnywhere, Category = LandingShockwave)
+		float ShockwaveRadius = 1500.f;
+
+	// Strain applied to the destructibles at the center of the shockwave
+	UPROPERTY(EditAnywhere, Category = LandingShockwave)
+		float ShockwaveStrain = 250000.f;
+
+	// Outward velocity given to the pieces and physics props within the shockwave
+	UPROPERTY(EditAnywhere, Category = LandingShockwave)
+		float ShockwaveVelocity = 1500.f;
+};
+
+/**
+ * Tuning of UFlightEffectsComponent.
+ */
+USTRUCT(BlueprintType)
+struct FFlightEffectsTuning
+{
+	GENERATED_BODY()
+
+	// Miscellaneous Flight
+
+	UPROPERTY(EditAnywhere, Category = MiscFlightEffect)
+		TSoftObjectPtr<UNiagaraSystem> TakeoffChargeEffect;
+
+	UPROPERTY(EditAnywhere, Category = MiscFlightEffect)
+		TSoftObjectPtr<UNiagaraSystem> HoverEffect;
+
+	UPROPERTY(EditAnywhere, Category = MiscFlightEffect)
+		FVector HoverPosition = FVector(0, 0, 89);
+
+	UPROPERTY(EditAnywhere, Category = MiscFlightEffect)
+		TSoftObjectPtr<UNiagaraSystem> DashTrailEffect;
+
+	UPROPERTY(EditAnywhere, Category = MiscFlightEffect)
+		FRotator DashTrailOrientation = FRotator(0, 90, 0);
+
+	// World level system drawing the dash trails and hover puffs of every flyer, replaces DashTrailEffect and HoverEffect when set.
+	// Reads the User.TrailPositions, User.TrailVelocities, User.TrailKinds and User.TrailSources arrays in world space
+	UPROPERTY(EditAnywhere, Category = MiscFlightEffect)
+		TSoftObjectPtr<UNiagaraSystem> SharedTrailEffect;
+
+	UPROPERTY(EditAnywhere, Category = MiscFlightEffect)
+		TSoftObjectPtr<UNiagaraSystem> DodgeEffect;
+
+	UPROPERTY(EditAnywhere, Category = MiscFlightEffect)
+		TSoftObjectPtr<UNiagaraSystem> LandEffect;
+
+	// Looping wind voice, a MetaSound or a cue with a continuous parameter driven by the flight speed
+	UPROPERTY(EditAnywhere, Category = MiscFlightEffect)
+		TSoftObjectPtr<USoundBase> WindSound;
+
+	// Sonic Boom
+
+	// Rotated through its User.Orientation quaternion parameter rather than the component transform
+	UPROPERTY(EditAnywhere, Category = SonicBoomEffect)
+		TSoftObjectPtr<UNiagaraSystem> SonicBoomEffect;
+
+	UPROPERTY(EditAnywhere, Category = SonicBoomEffect)
+		TSoftObjectPtr<USoundBase> SonicBoomSound;
+
+	UPROPERTY(EditAnywhere, Category = SonicBoomEffect)
+		FVector SonicBoomDefaultPosition = FVector(0, 0, 89);
+
+	UPROPERTY(EditAnywhere, Category = SonicBoomEffect)
+		FVector SonicBoomDivePosition = FVector(0, 0, 178);
+
+	UPROPERTY(EditAnywhere, Category = SonicBoomEffect)
+		FRotator SonicBoomDefaultOrientation = FRotator(0, -90, 0);
+
+	UPROPERTY(EditAnywhere, Category = SonicBoomEffect)
+		FRotator SonicBoomDiveOrientation = FRotator(90, 0, 0);
+
+	UPROPERTY(EditAnywhere, Category = SonicBoomEffect)
+		FRotator SonicBoomTakeoffOrientation = FRotator(-90, 0, 0);
+
+	UPROPERTY(EditAnywhere, Category = SonicBoomEffect)
+		float SonicBoomSoundStartTime = 1.f;
+
+	// Dive
+
+	UPROPERTY(EditAnywhere, Category = DiveEffect)
+		TSoftObjectPtr<UNiagaraSystem> DiveTrailEffect;
+
+	UPROPERTY(EditAnywhere, Category = DiveEffect)
+		TSoftObjectPtr<UNiagaraSystem> DiveLandEffect;
+
+	UPROPERTY(EditAnywhere, Category = DiveEffect)
+		TSoftObjectPtr<USoundBase> DiveLandSound;
+
+	// Landing Craters
+
+	// Decal stamped under divebomb and hard landings, only the deformation of procedural meshes is kept if unset
+	UPROPERTY(EditAnywhere, Category = LandingCrater)
+		TSoftObjectPtr<UMaterialInterface> CraterDecal;
+
+	UPROPERTY(EditAnywhere, Category = LandingCrater)
+		float DiveCraterRadius = 600.f;
+
+	UPROPERTY(EditAnywhere, Category = LandingCrater)
+		float HardLandingCraterRadius = 250.f;
+
+	// Depth of the decal projection and of the deformation pressed into procedural meshes
+	UPROPERTY(EditAnywhere, Category = LandingCrater)
+		float CraterDepth = 80.f;
+
+	// Flight Audio
+
+	// Float parameter of WindSound set to the flight speed, normalized by the dash speed
+	UPROPERTY(EditAnywhere, Category = FlightAudio)
+		FName WindSpeedParameter = "Speed";
+
+	// Seconds between two updates of the wind voice
+	UPROPERTY(EditAnywhere, Category = FlightAudio)
+		float WindUpdateInterval = 0.1f;
+
+	// Distance from the listener past which the wind voice is stopped, and restarted once back in range
+	UPROPERTY(EditAnywhere, Category = FlightAudio)
+		float WindVirtualizeDistance = 6000.f;
+
+	// Distance from the listener past which the sonic boom and landing sounds are not played
+	UPROPERTY(EditAnywhere, Category = FlightAudio)
+		float OneShotAudibleDistance = 15000.f;
+
+	// Voice limits shared by every flyer of the world
+	UPROPERTY(EditAnywhere, Category = FlightAudio)
+		FSoundConcurrencySettings SonicBoomConcurrency;
+
+	UPROPERTY(EditAnywhere, Category = FlightAudio)
+		FSoundConcurrencySettings DiveLandConcurrency;
+
+	// Seconds an effect component may stay inactive before it is returned to the world pool
+	UPROPERTY(EditAnywhere, Category = EffectPooling)
+		float IdleReleaseTime = 10.f;
+
+	FFlightEffectsTuning()
+	{
+		// Keep the nearest booms and landings when the sky gets crowded
+		SonicBoomConcurrency.MaxCount = 4;
+		SonicBoomConcurrency.ResolutionRule = EMaxConcurrentResolutionRule::StopFarthestThenOldest;
+
+		DiveLandConcurrency.MaxCount = 3;
+		DiveLandConcurrency.ResolutionRule = EMaxConcurrentResolutionRule::StopFarthestThenOldest;
+	}
+};
+
+/**
+ * Tuning of UFlightScalabilityComponent.
+ */
+USTRUCT(BlueprintType)
+struct FFlightScalabilityTuning
+{
+	GENERATED_BODY()
+
+	// Speed at which the detail starts being lowered
+	UPROPERTY(EditAnywhere, Category = SpeedScaling)
+		float DetailBiasStartSpeed = 3000.f;
+
+	// Speed at which the detail is fully lowered
+	UPROPERTY(EditAnywhere, Category = SpeedScaling)
+		float DetailBiasFullSpeed = 9000.f;
+
+	// Interpolation speeds towards lowered and restored detail, restoring slower so it does not pop back
+	UPROPERTY(EditAnywhere, Category = SpeedScaling)
+		float BlendInSpeed = 4.f;
+
+	UPROPERTY(EditAnywhere, Category = SpeedScaling)
+		float BlendOutSpeed = 1.5f;
+
+	// Values reached at fully lowered detail, blended from the values in effect when the flyer started
+
+	UPROPERTY(EditAnywhere, Category = SpeedScaling)
+		int32 SkeletalMeshLODBias = 1;
+
+	UPROPERTY(EditAnywhere, Category = SpeedScaling)
+		float StaticMeshLODDistanceScale = 1.5f;
+
+	UPROPERTY(EditAnywhere, Category = SpeedScaling)
+		float ShadowDistanceScale = 0.6f;
+
+	UPROPERTY(EditAnywhere, Category = SpeedScaling)
+		float StreamingBoost = 2.f;
+
+	// Scale of the full quality caps of the flight effects budget
+	UPROPERTY(EditAnywhere, Category = SpeedScaling)
+		float EffectsDetailScale = 0.5f;
+
+	// Distance past which other characters animate at a lower rate while detail is lowered
+	UPROPERTY(EditAnywhere, Category = DistantActors)
+		float DistantActorRange = 8000.f;
+
+	// Seconds between two animation updates of distant characters
+	UPROPERTY(EditAnywhere, Category = DistantActors)
+		float DistantAnimTickInterval = 0.1f;
+
+	// Seconds between two gatherings of the distant characters
+	UPROPERTY(EditAnywhere, Category = DistantActors)
+		float DistantActorUpdateInterval = 0.5f;
+};
+
+/**
+ * Values derived from the tuning assets, baked when the profile is saved so instances don't recompute them.
+ */
+USTRUCT(BlueprintType)
+struct FFlightBakedTimings
+{
+	GENERATED_BODY()
+
+	// Length of the divebomb start section, scaled by the divebomb rate
+	UPROPERTY(VisibleAnywhere, Category = Divebomb)
+		float DivebombStartSectionLength = 0.f;
+
+	// Length of the divebomb land section, scaled by the divebomb rate
+	UPROPERTY(VisibleAnywhere, Category = Divebomb)
+		float DivebombLandSectionLength = 0.f;
+
+	// Length of the takeoff engage section
+	UPROPERTY(VisibleAnywhere, Category = TakeOffAnimation)
+		float TakeOffEngageSectionLength = 0.f;
+
+	// Length of the takeoff loop section
+	UPROPERTY(VisibleAnywhere, Category = TakeOffAnimation)
+		float TakeOffLoopSectionLength = 0.f;
+
+	// Length of the takeoff release section
+	UPROPERTY(VisibleAnywhere, Category = TakeOffAnimation)
+		float TakeOffReleaseSectionLength = 0.f;
+};
+
+class UFlightTuningProfile;
+
+// Delegate for a changed tuning profile event
+DECLARE_MULTICAST_DELEGATE_OneParam(FFlightTuningChanged, const UFlightTuningProfile*);
+
+/**
+ * Immutable flight tuning shared by pointer across every flyer of an archetype.
+ * Can be edited and swapped live through the Flight.Tuning console commands.
+ */
+UCLASS(BlueprintType)
+class STEELHEART_API UFlightTuningProfile : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Recompute the baked values from the referenced assets
+	void BakeDerivedValues();
+
+	// Notify every flight component that this profile changed
+	void NotifyTuningChanged() const;
+
+	// Collect the soft references making up the given asset group
+	void GetAssetGroup(EFlightAssetGroup Group, TArray<FSoftObjectPath>& OutAssets) const;
+
+	// Collect the assets of the given group played as one-shots through the effects pool
+	void GetOneShotAssets(EFlightAssetGroup Group, TArray<FSoftObjectPath>& OutAssets) const;
+
+	/**
+	 * Resolves a soft reference of the profile, loading it synchronously if it was not streamed in ahead of use.
+	 *
+	 * @param Asset The soft reference to resolve.
+	 * @return The loaded asset, or null if the reference is unset.
+	 */
+	template<typename T>
+	static T* ResolveAsset(const TSoftObjectPtr<T>& Asset)
+	{
+		if (Asset.IsNull())
+		{
+			return nullptr;
+		}
+
+		if (T* LoadedAsset = Asset.Get())
+		{
+			return LoadedAsset;
+		}
+
+		UE_LOG(LogTemp, Warning, TEXT("Flight asset %s was not preloaded, loading synchronously."), *Asset.ToString());
+		return Asset.LoadSynchronous();
+	}
+
+	// Getter for the delegate broadcast whenever a profile is changed or swapped
+	static FFlightTuningChanged& OnTuningChanged();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Character)
+		FSteelheartCharacterTuning Character;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Locomotion)
+		FFlightLocomotionTuning Locomotion;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Takeoff)
+		FFlightTakeoffTuning Takeoff;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Collision)
+		FFlightCollisionTuning Collision;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Effects)
+		FFlightEffectsTuning Effects;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Scalability)
+		FFlightScalabilityTuning Scalability;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Baked)
+		FFlightBakedTimings Baked;
+};
@@ -1,6 +1,8 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Steelheart/GameModes/Public/SteelheartGameMode.h"
+#include "Kismet/GameplayStatics.h"
+#include "Steelheart/Subsystems/Public/DestructionJournalSubsystem.h"
 #include "UObject/ConstructorHelpers.h"
 
 ASteelheartGameMode::ASteelheartGameMode()
@@ -12,3 +14,23 @@ ASteelheartGameMode::ASteelheartGameMode()
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
 }
+
+void ASteelheartGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	UDestructionJournalSubsystem* Journal = GetGameInstance() ? GetGameInstance()->GetSubsystem<UDestructionJournalSubsystem>() : nullptr;
+	if (Journal == nullptr)
+	{
+		return;
+	}
+
+	// Maps opened without either option keep recording to the slot already open
+	bool bNewGame = UGameplayStatics::HasOption(Options, TEXT("NewGame"));
+	FString SlotName = UGameplayStatics::ParseOption(Options, TEXT("Slot"));
+
+	if (bNewGame || (!SlotName.IsEmpty() && SlotName != Journal->GetSlotName()))
+	{
+		Journal->OpenSlot(SlotName.IsEmpty() ? Journal->GetSlotName() : SlotName, bNewGame);
+	}
+}
@@ -13,6 +13,9 @@ class ASteelheartGameMode : public AGameModeBase
 
 public:
 	ASteelheartGameMode();
+
+	// Open the destruction journal slot given by the ?Slot= option, starting it over on ?NewGame
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
 };
 
 
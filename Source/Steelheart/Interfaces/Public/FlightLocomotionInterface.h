@@ -7,6 +7,7 @@
 #include "FlightLocomotionInterface.generated.h"
 
 class UCameraComponent;
+class UFlightTuningProfile;
 
 // This class does not need to be modified.
 UINTERFACE(MinimalAPI)
@@ -44,4 +45,11 @@ public:
 	 * @param Enabled - True to enable locomotion, false to disable locomotion.
 	 */
 	virtual void SetLocomotionEnabled(bool Enabled) = 0;
+
+	/**
+	 * Retrieves the tuning profile shared by the flight components of the character.
+	 *
+	 * @return The tuning profile, never null.
+	 */
+	virtual const UFlightTuningProfile* GetFlightTuningProfile() = 0;
 };
\ No newline at end of file
@@ -0,0 +1,815 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Slicing/Public/MeshSlicer.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Math/VectorRegister.h"
+#include "Steelheart/Steelheart.h"
+
+DECLARE_CYCLE_STAT(TEXT("Mesh Slicer Slice"), STAT_MeshSlicerSlice, STATGROUP_Steelheart);
+DECLARE_CYCLE_STAT(TEXT("Mesh Slicer Caps"), STAT_MeshSlicerCaps, STATGROUP_Steelheart);
+
+static FAutoConsoleCommand FlightSlicerBenchmarkCommand(
+	TEXT("Flight.Slicer.Benchmark"),
+	TEXT("Log the slicing throughput of a generated sphere. Arguments: rings (64), planes (1), iterations (20)"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		int32 Rings = Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 64;
+		int32 NumPlanes = Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 1;
+		int32 Iterations = Args.IsValidIndex(2) ? FCString::Atoi(*Args[2]) : 20;
+
+		FMeshSlicer::RunBenchmark(FMath::Max(Rings, 3), FMath::Max(NumPlanes, 1), FMath::Max(Iterations, 1));
+	}));
+
+// Vertices closer to the plane than this are on it, and belong to both halves
+static constexpr float SliceTolerance = 0.01f;
+
+// Cut points closer than this are welded together when the outlines are closed
+static constexpr float CapWeldDistance = 0.05f;
+
+// World units per cap texture repeat
+static constexpr float CapUVScale = 100.f;
+
+// Geometric normal of a triangle, as the procedural mesh library computes it
+static FVector TriangleNormal(const FVector& A, const FVector& B, const FVector& C)
+{
+	return FVector::CrossProduct(A - C, B - C);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Mesh Functions
+
+void FSlicerSection::Reset()
+{
+	Vertices.Reset();
+	Triangles.Reset();
+	Normals.Reset();
+	UVs.Reset();
+	Colors.Reset();
+	Tangents.Reset();
+	PositionsX.Reset();
+	PositionsY.Reset();
+	PositionsZ.Reset();
+
+	SourceSection = INDEX_NONE;
+}
+
+void FSlicerMesh::Reset(int32 NumSections)
+{
+	for (FSlicerSection& Section : Sections)
+	{
+		Section.Reset();
+	}
+
+	if (Sections.Num() < NumSections)
+	{
+		Sections.SetNum(NumSections);
+	}
+}
+
+void FSlicerMesh::CopyFrom(UProceduralMeshComponent* ProcMesh)
+{
+	Reset(ProcMesh->GetNumSections());
+
+	for (int32 SectionIndex = 0; SectionIndex < ProcMesh->GetNumSections(); SectionIndex++)
+	{
+		const FProcMeshSection* Source = ProcMesh->GetProcMeshSection(SectionIndex);
+
+		FSlicerSection& Section = Sections[SectionIndex];
+		Section.SourceSection = SectionIndex;
+
+		if (Source == nullptr)
+		{
+			continue;
+		}
+
+		int32 NumVertices = Source->ProcVertexBuffer.Num();
+		Section.Vertices.SetNumUninitialized(NumVertices);
+		Section.Normals.SetNumUninitialized(NumVertices);
+		Section.UVs.SetNumUninitialized(NumVertices);
+		Section.Colors.SetNumUninitialized(NumVertices);
+		Section.Tangents.SetNumUninitialized(NumVertices);
+		Section.PositionsX.SetNumUninitialized(NumVertices);
+		Section.PositionsY.SetNumUninitialized(NumVertices);
+		Section.PositionsZ.SetNumUninitialized(NumVertices);
+
+		for (int32 VertexIndex = 0; VertexIndex < NumVertices; VertexIndex++)
+		{
+			const FProcMeshVertex& Vertex = Source->ProcVertexBuffer[VertexIndex];
+			Section.Vertices[VertexIndex] = Vertex.Position;
+			Section.Normals[VertexIndex] = Vertex.Normal;
+			Section.UVs[VertexIndex] = Vertex.UV0;
+			Section.Colors[VertexIndex] = Vertex.Color;
+			Section.Tangents[VertexIndex] = Vertex.Tangent;
+			Section.PositionsX[VertexIndex] = (float)Vertex.Position.X;
+			Section.PositionsY[VertexIndex] = (float)Vertex.Position.Y;
+			Section.PositionsZ[VertexIndex] = (float)Vertex.Position.Z;
+		}
+
+		Section.Triangles.SetNumUninitialized(Source->ProcIndexBuffer.Num());
+		for (int32 Index = 0; Index < Source->ProcIndexBuffer.Num(); Index++)
+		{
+			Section.Triangles[Index] = (int32)Source->ProcIndexBuffer[Index];
+		}
+	}
+}
+
+int32 FSlicerMesh::CopyTo(UProceduralMeshComponent* ProcMesh, const UProceduralMeshComponent* Source, UMaterialInterface* CapMaterial) const
+{
+	// Materials are read before the sections are written, the source may be the mesh written to
+	TArray<UMaterialInterface*, TInlineAllocator<8>> Materials;
+	for (const FSlicerSection& Section : Sections)
+	{
+		if (Section.Triangles.Num() > 0)
+		{
+			Materials.Add(Section.SourceSection != INDEX_NONE ? Source->GetMaterial(Section.SourceSection) : CapMaterial);
+		}
+	}
+
+	// Collision is cooked whenever a section is set, so every section is filled in place with its collision off and the
+	// component is refreshed once at the end, cooking its collision a single time
+	for (int32 SectionIndex = 0; SectionIndex < ProcMesh->GetNumSections(); SectionIndex++)
+	{
+		ProcMesh->GetProcMeshSection(SectionIndex)->bEnableCollision = false;
+	}
+
+	int32 Allocations = 0;
+	int32 TargetIndex = 0;
+
+	for (const FSlicerSection& Section : Sections)
+	{
+		if (Section.Triangles.Num() == 0)
+		{
+			continue;
+		}
+
+		// Sections the component already has are filled in place, only new ones are allocated
+		FProcMeshSection NewSection;
+		FProcMeshSection* Target = TargetIndex < ProcMesh->GetNumSections() ? ProcMesh->GetProcMeshSection(TargetIndex) : &NewSection;
+
+		int32 VertexCapacity = Target->ProcVertexBuffer.Max();
+		int32 IndexCapacity = Target->ProcIndexBuffer.Max();
+
+		Target->ProcVertexBuffer.Reset(Section.Vertices.Num());
+		Target->ProcIndexBuffer.Reset(Section.Triangles.Num());
+		Target->SectionLocalBox.Init();
+
+		bool bHasNormals = Section.Normals.Num() == Section.Vertices.Num();
+		bool bHasUVs = Section.UVs.Num() == Section.Vertices.Num();
+		bool bHasColors = Section.Colors.Num() == Section.Vertices.Num();
+		bool bHasTangents = Section.Tangents.Num() == Section.Vertices.Num();
+
+		for (int32 VertexIndex = 0; VertexIndex < Section.Vertices.Num(); VertexIndex++)
+		{
+			FProcMeshVertex& Vertex = Target->ProcVertexBuffer.AddDefaulted_GetRef();
+			Vertex.Position = Section.Vertices[VertexIndex];
+			Vertex.Normal = bHasNormals ? Section.Normals[VertexIndex] : FVector(0.f, 0.f, 1.f);
+			Vertex.UV0 = bHasUVs ? Section.UVs[VertexIndex] : FVector2D::ZeroVector;
+			Vertex.Color = bHasColors ? Section.Colors[VertexIndex] : FColor(255, 255, 255);
+			Vertex.Tangent = bHasTangents ? Section.Tangents[VertexIndex] : FProcMeshTangent();
+
+			Target->SectionLocalBox += Vertex.Position;
+		}
+
+		for (int32 Index : Section.Triangles)
+		{
+			Target->ProcIndexBuffer.Add((uint32)Index);
+		}
+
+		Target->bSectionVisible = true;
+
+		if (Target == &NewSection)
+		{
+			// The component only takes new sections through a set, which cooks what it holds so far without the triangles
+			ProcMesh->SetProcMeshSection(TargetIndex, NewSection);
+			Allocations += 2;
+		}
+		else
+		{
+			Allocations += (Target->ProcVertexBuffer.Max() != VertexCapacity ? 1 : 0) + (Target->ProcIndexBuffer.Max() != IndexCapacity ? 1 : 0);
+		}
+
+		ProcMesh->SetMaterial(TargetIndex, Materials[TargetIndex]);
+
+		TargetIndex++;
+	}
+
+	int32 NumWritten = TargetIndex;
+
+	// Sections left over from a larger mesh are emptied, their buffers kept for the next one
+	for (; TargetIndex < ProcMesh->GetNumSections(); TargetIndex++)
+	{
+		FProcMeshSection* Target = ProcMesh->GetProcMeshSection(TargetIndex);
+		Target->ProcVertexBuffer.Reset();
+		Target->ProcIndexBuffer.Reset();
+		Target->SectionLocalBox.Init();
+		Target->bSectionVisible = false;
+	}
+
+	for (int32 SectionIndex = 0; SectionIndex < NumWritten; SectionIndex++)
+	{
+		ProcMesh->GetProcMeshSection(SectionIndex)->bEnableCollision = ProcMesh->bUseComplexAsSimpleCollision;
+	}
+
+	// Setting a section from itself refreshes the bounds, collision and render state of the whole component
+	if (ProcMesh->GetNumSections() > 0)
+	{
+		ProcMesh->SetProcMeshSection(0, *ProcMesh->GetProcMeshSection(0));
+	}
+
+	return Allocations;
+}
+
+int32 FSlicerMesh::NumTriangles() const
+{
+	int32 Triangles = 0;
+	for (const FSlicerSection& Section : Sections)
+	{
+		Triangles += Section.NumTriangles();
+	}
+
+	return Triangles;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Slicing Functions
+
+void FMeshSlicer::ClassifyVertices(const FSlicerSection& Section, const FPlane& Plane, TArrayView<float> OutDistances, bool bVectorized)
+{
+	int32 NumVertices = Section.Vertices.Num();
+	check(OutDistances.Num() == NumVertices);
+
+	int32 VertexIndex = 0;
+
+	// Sections filled without their position streams fall back to the scalar path
+	bool bHasPositions = Section.PositionsX.Num() == NumVertices && Section.PositionsY.Num() == NumVertices && Section.PositionsZ.Num() == NumVertices;
+	ensureMsgf(bHasPositions, TEXT("Slicer section of %d vertices is missing its position streams"), NumVertices);
+
+	if (bVectorized && bHasPositions)
+	{
+		// Vertices are in the space of their component, well within single precision
+		const VectorRegister4Float NormalX = VectorSetFloat1((float)Plane.X);
+		const VectorRegister4Float NormalY = VectorSetFloat1((float)Plane.Y);
+		const VectorRegister4Float NormalZ = VectorSetFloat1((float)Plane.Z);
+		const VectorRegister4Float PlaneW = VectorSetFloat1((float)Plane.W);
+
+		const float* X = Section.PositionsX.GetData();
+		const float* Y = Section.PositionsY.GetData();
+		const float* Z = Section.PositionsZ.GetData();
+		float* Distances = OutDistances.GetData();
+
+		// Four vertices at a time, loaded straight from one stream per axis
+		for (; VertexIndex + 4 <= NumVertices; VertexIndex += 4)
+		{
+			VectorRegister4Float Distance = VectorMultiply(VectorLoad(X + VertexIndex), NormalX);
+			Distance = VectorMultiplyAdd(VectorLoad(Y + VertexIndex), NormalY, Distance);
+			Distance = VectorMultiplyAdd(VectorLoad(Z + VertexIndex), NormalZ, Distance);
+
+			VectorStore(VectorSubtract(Distance, PlaneW), Distances + VertexIndex);
+		}
+	}
+
+	for (; VertexIndex < NumVertices; VertexIndex++)
+	{
+		OutDistances[VertexIndex] = (float)Plane.PlaneDot(Section.Vertices[VertexIndex]);
+	}
+}
+
+void FMeshSlicer::SlicePlane(const FSlicerMesh& Mesh, const FPlane& Plane, bool bCreateCaps, FSlicerMesh& OutFront, FSlicerMesh& OutBack, bool bVectorized)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeshSlicerSlice);
+
+	// Every temporary of the slice is released here at once
+	FMemMark Mark(FMemStack::Get());
+
+	OutFront.Reset(Mesh.Sections.Num());
+	OutBack.Reset(Mesh.Sections.Num());
+
+	FScratchSegments Segments;
+
+	for (int32 SectionIndex = 0; SectionIndex < Mesh.Sections.Num(); SectionIndex++)
+	{
+		SliceSection(Mesh.Sections[SectionIndex], Plane, OutFront.Sections[SectionIndex], OutBack.Sections[SectionIndex], Segments, bVectorized);
+	}
+
+	if (bCreateCaps && Segments.Num() >= 6)
+	{
+		BuildCaps(Segments, Plane, OutFront, OutBack);
+	}
+}
+
+void FMeshSlicer::SlicePlanes(const FSlicerMesh& Mesh, TArrayView<const FPlane> Planes, bool bCreateCaps, TArray<FSlicerMesh>& OutPieces, bool bVectorized)
+{
+	OutPieces.Reset();
+	OutPieces.Add(Mesh);
+
+	TArray<FSlicerMesh> Sliced;
+
+	for (const FPlane& Plane : Planes)
+	{
+		Sliced.Reset();
+
+		for (const FSlicerMesh& Piece : OutPieces)
+		{
+			FSlicerMesh Front;
+			FSlicerMesh Back;
+			SlicePlane(Piece, Plane, bCreateCaps, Front, Back, bVectorized);
+
+			if (!Front.IsEmpty())
+			{
+				Sliced.Add(MoveTemp(Front));
+			}
+
+			if (!Back.IsEmpty())
+			{
+				Sliced.Add(MoveTemp(Back));
+			}
+		}
+
+		Swap(OutPieces, Sliced);
+	}
+}
+
+void FMeshSlicer::SliceSection(const FSlicerSection& Section, const FPlane& Plane, FSlicerSection& OutFront, FSlicerSection& OutBack,
+	FScratchSegments& OutSegments, bool bVectorized)
+{
+	OutFront.SourceSection = Section.SourceSection;
+	OutBack.SourceSection = Section.SourceSection;
+
+	int32 NumVertices = Section.Vertices.Num();
+
+	// Attributes missing from the source stay missing from the halves
+	bool bHasNormals = Section.Normals.Num() == NumVertices;
+	bool bHasUVs = Section.UVs.Num() == NumVertices;
+	bool bHasColors = Section.Colors.Num() == NumVertices;
+	bool bHasTangents = Section.Tangents.Num() == NumVertices;
+
+	TArray<float, TMemStackAllocator<>> Distances;
+	Distances.SetNumUninitialized(NumVertices);
+	ClassifyVertices(Section, Plane, Distances, bVectorized);
+
+	TArray<int8, TMemStackAllocator<>> Sides;
+	Sides.SetNumUninitialized(NumVertices);
+	for (int32 VertexIndex = 0; VertexIndex < NumVertices; VertexIndex++)
+	{
+		Sides[VertexIndex] = Distances[VertexIndex] > SliceTolerance ? 1 : (Distances[VertexIndex] < -SliceTolerance ? -1 : 0);
+	}
+
+	// Vertices are copied into a half the first time one of its triangles uses them
+	TArray<int32, TMemStackAllocator<>> FrontRemap;
+	TArray<int32, TMemStackAllocator<>> BackRemap;
+	FrontRemap.Init(INDEX_NONE, NumVertices);
+	BackRemap.Init(INDEX_NONE, NumVertices);
+
+	// Cut vertices are shared by the two triangles of the edge
+	using FCutMap = TMap<uint64, int32, TSetAllocator<TSparseArrayAllocator<TMemStackAllocator<>, TMemStackAllocator<>>, TMemStackAllocator<>>>;
+	FCutMap FrontCuts;
+	FCutMap BackCuts;
+
+	auto CopyVertex = [&](FSlicerSection& Out, TArray<int32, TMemStackAllocator<>>& Remap, int32 VertexIndex)
+	{
+		if (Remap[VertexIndex] == INDEX_NONE)
+		{
+			Remap[VertexIndex] = Out.AddVertex(Section.Vertices[VertexIndex]);
+			if (bHasNormals) Out.Normals.Add(Section.Normals[VertexIndex]);
+			if (bHasUVs) Out.UVs.Add(Section.UVs[VertexIndex]);
+			if (bHasColors) Out.Colors.Add(Section.Colors[VertexIndex]);
+			if (bHasTangents) Out.Tangents.Add(Section.Tangents[VertexIndex]);
+		}
+
+		return Remap[VertexIndex];
+	};
+
+	auto CutVertex = [&](FSlicerSection& Out, FCutMap& Cuts, int32 A, int32 B)
+	{
+		// Always interpolate from the lower index, so both triangles of the edge agree on the point
+		if (A > B)
+		{
+			Swap(A, B);
+		}
+
+		uint64 EdgeKey = ((uint64)A << 32) | (uint32)B;
+		if (const int32* Existing = Cuts.Find(EdgeKey))
+		{
+			return *Existing;
+		}
+
+		float Alpha = Distances[A] / (Distances[A] - Distances[B]);
+
+		int32 NewIndex = Out.AddVertex(FMath::Lerp(Section.Vertices[A], Section.Vertices[B], Alpha));
+		if (bHasNormals) Out.Normals.Add(FMath::Lerp(Section.Normals[A], Section.Normals[B], Alpha).GetSafeNormal());
+		if (bHasUVs) Out.UVs.Add(FMath::Lerp(Section.UVs[A], Section.UVs[B], Alpha));
+		if (bHasColors) Out.Colors.Add(FMath::Lerp(FLinearColor(Section.Colors[A]), FLinearColor(Section.Colors[B]), Alpha).ToFColor(false));
+		if (bHasTangents)
+		{
+			FProcMeshTangent Tangent;
+			Tangent.TangentX = FMath::Lerp(Section.Tangents[A].TangentX, Section.Tangents[B].TangentX, Alpha).GetSafeNormal();
+			Tangent.bFlipTangentY = Section.Tangents[A].bFlipTangentY;
+			Out.Tangents.Add(Tangent);
+		}
+
+		Cuts.Add(EdgeKey, NewIndex);
+		return NewIndex;
+	};
+
+	TArray<int32, TInlineAllocator<4>> Polygon;
+	TArray<FVector, TInlineAllocator<2>> OnPlane;
+
+	for (int32 TriangleStart = 0; TriangleStart + 2 < Section.Triangles.Num(); TriangleStart += 3)
+	{
+		const int32 Corners[3] = { Section.Triangles[TriangleStart], Section.Triangles[TriangleStart + 1], Section.Triangles[TriangleStart + 2] };
+		const int8 CornerSides[3] = { Sides[Corners[0]], Sides[Corners[1]], Sides[Corners[2]] };
+
+		bool bAnyFront = CornerSides[0] > 0 || CornerSides[1] > 0 || CornerSides[2] > 0;
+		bool bAnyBack = CornerSides[0] < 0 || CornerSides[1] < 0 || CornerSides[2] < 0;
+
+		// Whole triangles, including those lying on the plane, go to the front
+		if (!bAnyBack || !bAnyFront)
+		{
+			bool bFront = !bAnyBack;
+			FSlicerSection& Out = bFront ? OutFront : OutBack;
+			TArray<int32, TMemStackAllocator<>>& Remap = bFront ? FrontRemap : BackRemap;
+
+			for (int32 Corner : Corners)
+			{
+				Out.Triangles.Add(CopyVertex(Out, Remap, Corner));
+			}
+
+			// An edge lying on the plane bounds the cut too, taken from the front triangle only so it is counted once
+			if (bFront && bAnyFront)
+			{
+				for (int32 Edge = 0; Edge < 3; Edge++)
+				{
+					int32 Next = (Edge + 1) % 3;
+					if (CornerSides[Edge] == 0 && CornerSides[Next] == 0)
+					{
+						OutSegments.Add(Section.Vertices[Corners[Edge]]);
+						OutSegments.Add(Section.Vertices[Corners[Next]]);
+					}
+				}
+			}
+
+			continue;
+		}
+
+		// Clip the triangle against each side of the plane, vertices on the plane going to both
+		for (int8 Side : { (int8)1, (int8)-1 })
+		{
+			FSlicerSection& Out = Side > 0 ? OutFront : OutBack;
+			TArray<int32, TMemStackAllocator<>>& Remap = Side > 0 ? FrontRemap : BackRemap;
+			FCutMap& Cuts = Side > 0 ? FrontCuts : BackCuts;
+
+			Polygon.Reset();
+			OnPlane.Reset();
+
+			for (int32 Edge = 0; Edge < 3; Edge++)
+			{
+				int32 Next = (Edge + 1) % 3;
+
+				if (CornerSides[Edge] * Side >= 0)
+				{
+					Polygon.Add(CopyVertex(Out, Remap, Corners[Edge]));
+					if (CornerSides[Edge] == 0)
+					{
+						OnPlane.Add(Section.Vertices[Corners[Edge]]);
+					}
+				}
+
+				if (CornerSides[Edge] * CornerSides[Next] < 0)
+				{
+					int32 CutIndex = CutVertex(Out, Cuts, Corners[Edge], Corners[Next]);
+					Polygon.Add(CutIndex);
+					OnPlane.Add(Out.Vertices[CutIndex]);
+				}
+			}
+
+			for (int32 Fan = 1; Fan + 1 < Polygon.Num(); Fan++)
+			{
+				Out.Triangles.Add(Polygon[0]);
+				Out.Triangles.Add(Polygon[Fan]);
+				Out.Triangles.Add(Polygon[Fan + 1]);
+			}
+
+			if (Side > 0 && OnPlane.Num() == 2)
+			{
+				OutSegments.Append(OnPlane);
+			}
+		}
+	}
+}
+
+void FMeshSlicer::BuildCaps(const FScratchSegments& Segments, const FPlane& Plane, FSlicerMesh& OutFront, FSlicerMesh& OutBack)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeshSlicerCaps);
+
+	FVector Normal = Plane.GetSafeNormal();
+	FVector AxisU;
+	FVector AxisV;
+	Normal.FindBestAxisVectors(AxisU, AxisV);
+
+	// Weld the segment ends into points, so the outlines can be followed from segment to segment
+	using FScratchSetAllocator = TSetAllocator<TSparseArrayAllocator<TMemStackAllocator<>, TMemStackAllocator<>>, TMemStackAllocator<>>;
+	TArray<FVector, TMemStackAllocator<>> Points;
+	TMap<FIntVector, int32, FScratchSetAllocator> PointIds;
+	TMultiMap<int32, int32, FScratchSetAllocator> PointEdges;
+	TArray<TPair<int32, int32>, TMemStackAllocator<>> Edges;
+
+	auto WeldPoint = [&](const FVector& Point)
+	{
+		FIntVector Key(FMath::RoundToInt(Point.X / CapWeldDistance), FMath::RoundToInt(Point.Y / CapWeldDistance), FMath::RoundToInt(Point.Z / CapWeldDistance));
+		if (const int32* Existing = PointIds.Find(Key))
+		{
+			return *Existing;
+		}
+
+		int32 NewId = Points.Add(Point);
+		PointIds.Add(Key, NewId);
+		return NewId;
+	};
+
+	for (int32 SegmentIndex = 0; SegmentIndex + 1 < Segments.Num(); SegmentIndex += 2)
+	{
+		int32 Start = WeldPoint(Segments[SegmentIndex]);
+		int32 End = WeldPoint(Segments[SegmentIndex + 1]);
+		if (Start != End)
+		{
+			int32 EdgeIndex = Edges.Emplace(Start, End);
+			PointEdges.Add(Start, EdgeIndex);
+			PointEdges.Add(End, EdgeIndex);
+		}
+	}
+
+	// Caps go to a section of their own, shared with the caps of earlier planes
+	auto FindCapSection = [](FSlicerMesh& Mesh) -> FSlicerSection&
+	{
+		if (FSlicerSection* Existing = Mesh.Sections.FindByPredicate([](const FSlicerSection& Section) { return Section.SourceSection == INDEX_NONE; }))
+		{
+			return *Existing;
+		}
+
+		return Mesh.Sections.AddDefaulted_GetRef();
+	};
+
+	FSlicerSection& FrontCap = FindCapSection(OutFront);
+	FSlicerSection& BackCap = FindCapSection(OutBack);
+
+	TBitArray<TMemStackAllocator<>> UsedEdges(false, Edges.Num());
+	TArray<int32, TMemStackAllocator<>> Loop;
+	TArray<FVector2D, TMemStackAllocator<>> Loop2D;
+	TArray<int32, TMemStackAllocator<>> Remaining;
+	TArray<int32, TMemStackAllocator<>> EdgesOfPoint;
+
+	for (int32 FirstEdge = 0; FirstEdge < Edges.Num(); FirstEdge++)
+	{
+		if (UsedEdges[FirstEdge])
+		{
+			continue;
+		}
+
+		// Follow the outline until it closes or runs out
+		Loop.Reset();
+		Loop.Add(Edges[FirstEdge].Key);
+		int32 Current = Edges[FirstEdge].Value;
+		UsedEdges[FirstEdge] = true;
+
+		while (Current != Loop[0])
+		{
+			Loop.Add(Current);
+
+			int32 NextEdge = INDEX_NONE;
+			EdgesOfPoint.Reset();
+			PointEdges.MultiFind(Current, EdgesOfPoint);
+			for (int32 EdgeIndex : EdgesOfPoint)
+			{
+				if (!UsedEdges[EdgeIndex])
+				{
+					NextEdge = EdgeIndex;
+					break;
+				}
+			}
+
+			if (NextEdge == INDEX_NONE)
+			{
+				break;
+			}
+
+			UsedEdges[NextEdge] = true;
+			Current = Edges[NextEdge].Key == Current ? Edges[NextEdge].Value : Edges[NextEdge].Key;
+		}
+
+		if (Loop.Num() < 3)
+		{
+			continue;
+		}
+
+		// Ear clipping in the plane, each outline capped on its own, so holes within an outline are filled over
+		Loop2D.Reset();
+		double Area = 0.0;
+		for (int32 LoopIndex = 0; LoopIndex < Loop.Num(); LoopIndex++)
+		{
+			const FVector& Point = Points[Loop[LoopIndex]];
+			Loop2D.Add(FVector2D(FVector::DotProduct(Point, AxisU), FVector::DotProduct(Point, AxisV)));
+		}
+
+		for (int32 LoopIndex = 0; LoopIndex < Loop2D.Num(); LoopIndex++)
+		{
+			const FVector2D& A = Loop2D[LoopIndex];
+			const FVector2D& B = Loop2D[(LoopIndex + 1) % Loop2D.Num()];
+			Area += A.X * B.Y - B.X * A.Y;
+		}
+
+		int32 FrontBase = FrontCap.Vertices.Num();
+		int32 BackBase = BackCap.Vertices.Num();
+
+		for (int32 LoopIndex = 0; LoopIndex < Loop.Num(); LoopIndex++)
+		{
+			const FVector& Point = Points[Loop[LoopIndex]];
+			FVector2D UV = Loop2D[LoopIndex] / CapUVScale;
+
+			FrontCap.AddVertex(Point);
+			FrontCap.Normals.Add(-Normal);
+			FrontCap.UVs.Add(UV);
+			FrontCap.Tangents.Add(FProcMeshTangent(AxisU, false));
+
+			BackCap.AddVertex(Point);
+			BackCap.Normals.Add(Normal);
+			BackCap.UVs.Add(UV);
+			BackCap.Tangents.Add(FProcMeshTangent(AxisU, false));
+		}
+
+		Remaining.Reset();
+		for (int32 LoopIndex = 0; LoopIndex < Loop.Num(); LoopIndex++)
+		{
+			Remaining.Add(LoopIndex);
+		}
+
+		double Orientation = Area >= 0.0 ? 1.0 : -1.0;
+
+		while (Remaining.Num() > 3)
+		{
+			bool bClipped = false;
+
+			for (int32 Corner = 0; Corner < Remaining.Num(); Corner++)
+			{
+				int32 Prev = Remaining[(Corner + Remaining.Num() - 1) % Remaining.Num()];
+				int32 Ear = Remaining[Corner];
+				int32 Next = Remaining[(Corner + 1) % Remaining.Num()];
+
+				const FVector2D& A = Loop2D[Prev];
+				const FVector2D& B = Loop2D[Ear];
+				const FVector2D& C = Loop2D[Next];
+
+				// Reflex corners cannot be ears
+				if (FVector2D::CrossProduct(B - A, C - B) * Orientation <= 0.0)
+				{
+					continue;
+				}
+
+				bool bContainsPoint = false;
+				for (int32 Other : Remaining)
+				{
+					if (Other != Prev && Other != Ear && Other != Next)
+					{
+						const FVector2D& P = Loop2D[Other];
+						if (FVector2D::CrossProduct(B - A, P - A) * Orientation >= 0.0
+							&& FVector2D::CrossProduct(C - B, P - B) * Orientation >= 0.0
+							&& FVector2D::CrossProduct(A - C, P - C) * Orientation >= 0.0)
+						{
+							bContainsPoint = true;
+							break;
+						}
+					}
+				}
+
+				if (bContainsPoint)
+				{
+					continue;
+				}
+
+				FrontCap.Triangles.Append({ FrontBase + Prev, FrontBase + Ear, FrontBase + Next });
+				BackCap.Triangles.Append({ BackBase + Prev, BackBase + Ear, BackBase + Next });
+
+				Remaining.RemoveAt(Corner);
+				bClipped = true;
+				break;
+			}
+
+			// Degenerate outlines have no ear left, the rest is fanned instead
+			if (!bClipped)
+			{
+				break;
+			}
+		}
+
+		for (int32 Fan = 1; Fan + 1 < Remaining.Num(); Fan++)
+		{
+			FrontCap.Triangles.Append({ FrontBase + Remaining[0], FrontBase + Remaining[Fan], FrontBase + Remaining[Fan + 1] });
+			BackCap.Triangles.Append({ BackBase + Remaining[0], BackBase + Remaining[Fan], BackBase + Remaining[Fan + 1] });
+		}
+	}
+
+	// Turn every cap triangle to face away from its half
+	auto OrientCap = [](FSlicerSection& Cap, const FVector& Facing)
+	{
+		for (int32 TriangleStart = 0; TriangleStart + 2 < Cap.Triangles.Num(); TriangleStart += 3)
+		{
+			const FVector& A = Cap.Vertices[Cap.Triangles[TriangleStart]];
+			const FVector& B = Cap.Vertices[Cap.Triangles[TriangleStart + 1]];
+			const FVector& C = Cap.Vertices[Cap.Triangles[TriangleStart + 2]];
+
+			if (FVector::DotProduct(TriangleNormal(A, B, C), Facing) < 0.f)
+			{
+				Swap(Cap.Triangles[TriangleStart + 1], Cap.Triangles[TriangleStart + 2]);
+			}
+		}
+	};
+
+	OrientCap(FrontCap, -Normal);
+	OrientCap(BackCap, Normal);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmark Functions
+
+void FMeshSlicer::RunBenchmark(int32 Rings, int32 NumPlanes, int32 Iterations)
+{
+	// UV sphere of a hundred units, dense enough to be worth slicing off the game thread
+	FSlicerMesh Sphere;
+	FSlicerSection& Section = Sphere.Sections.AddDefaulted_GetRef();
+	Section.SourceSection = 0;
+
+	int32 Segments = Rings * 2;
+	for (int32 Ring = 0; Ring <= Rings; Ring++)
+	{
+		float Polar = PI * Ring / Rings;
+		for (int32 Segment = 0; Segment <= Segments; Segment++)
+		{
+			float Azimuth = 2.f * PI * Segment / Segments;
+			FVector Direction(FMath::Sin(Polar) * FMath::Cos(Azimuth), FMath::Sin(Polar) * FMath::Sin(Azimuth), FMath::Cos(Polar));
+
+			Section.AddVertex(Direction * 100.f);
+			Section.Normals.Add(Direction);
+			Section.UVs.Add(FVector2D((float)Segment / Segments, (float)Ring / Rings));
+			Section.Tangents.Add(FProcMeshTangent(FVector(-FMath::Sin(Azimuth), FMath::Cos(Azimuth), 0.f), false));
+		}
+	}
+
+	for (int32 Ring = 0; Ring < Rings; Ring++)
+	{
+		for (int32 Segment = 0; Segment < Segments; Segment++)
+		{
+			int32 A = Ring * (Segments + 1) + Segment;
+			int32 B = A + Segments + 1;
+			Section.Triangles.Append({ A, B, A + 1, A + 1, B, B + 1 });
+		}
+	}
+
+	FRandomStream Random(Rings);
+	TArray<FPlane> Planes;
+	for (int32 PlaneIndex = 0; PlaneIndex < NumPlanes; PlaneIndex++)
+	{
+		Planes.Add(FPlane(Random.VRand() * Random.FRandRange(0.f, 50.f), Random.VRand()));
+	}
+
+	int32 Triangles = Sphere.NumTriangles();
+	TArray<FSlicerMesh> Pieces;
+
+	// Milliseconds per iteration of the vectorized and scalar paths, slicing then classification
+	double Milliseconds[2][2] = {};
+
+	for (bool bVectorized : { true, false })
+	{
+		TArray<float> Distances;
+		Distances.SetNumUninitialized(Section.Vertices.Num());
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			SlicePlanes(Sphere, Planes, true, Pieces, bVectorized);
+		}
+		double SliceSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			ClassifyVertices(Section, Planes[0], Distances, bVectorized);
+		}
+		double ClassifySeconds = FPlatformTime::Seconds() - StartTime;
+
+		double SliceMilliseconds = SliceSeconds * 1000.0 / Iterations;
+		double ClassifyMilliseconds = ClassifySeconds * 1000.0 / Iterations;
+
+		UE_LOG(LogTemp, Log, TEXT("Slicer benchmark (%s): %d triangles by %d planes into %d pieces in %.3f ms, %.0f triangles per ms, classification %.0f vertices per ms"),
+			bVectorized ? TEXT("vectorized") : TEXT("scalar"), Triangles, NumPlanes, Pieces.Num(), SliceMilliseconds,
+			SliceMilliseconds > 0.0 ? Triangles / SliceMilliseconds : 0.0,
+			ClassifyMilliseconds > 0.0 ? Section.Vertices.Num() / ClassifyMilliseconds : 0.0);
+
+		Milliseconds[bVectorized ? 0 : 1][0] = SliceMilliseconds;
+		Milliseconds[bVectorized ? 0 : 1][1] = ClassifyMilliseconds;
+	}
+
+	// The speedup is only what this machine measured, classification being a small share of a whole slice
+	UE_LOG(LogTemp, Log, TEXT("Slicer benchmark speedup of the vectorized path: slicing %.2fx, classification %.2fx"),
+		Milliseconds[0][0] > 0.0 ? Milliseconds[1][0] / Milliseconds[0][0] : 0.0,
+		Milliseconds[0][1] > 0.0 ? Milliseconds[1][1] / Milliseconds[0][1] : 0.0);
+}
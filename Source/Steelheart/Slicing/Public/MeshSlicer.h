@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+#include "ProceduralMeshComponent.h"
+
+/**
+ * One section of a mesh being sliced, laid out the way UProceduralMeshComponent takes it.
+ */
+struct STEELHEART_API FSlicerSection
+{
+	TArray<FVector> Vertices;
+
+	TArray<int32> Triangles;
+
+	TArray<FVector> Normals;
+
+	TArray<FVector2D> UVs;
+
+	TArray<FColor> Colors;
+
+	TArray<FProcMeshTangent> Tangents;
+
+	// Vertices in single precision, one stream per axis, so they are classified four at a time straight from memory
+	TArray<float> PositionsX;
+
+	TArray<float> PositionsY;
+
+	TArray<float> PositionsZ;
+
+	// Section of the source mesh the material comes from, INDEX_NONE for a cap
+	int32 SourceSection = INDEX_NONE;
+
+	FORCEINLINE int32 NumTriangles() const { return Triangles.Num() / 3; }
+
+	// Add a vertex along with its position streams, returning its index
+	FORCEINLINE int32 AddVertex(const FVector& Position)
+	{
+		PositionsX.Add((float)Position.X);
+		PositionsY.Add((float)Position.Y);
+		PositionsZ.Add((float)Position.Z);
+
+		return Vertices.Add(Position);
+	}
+
+	// Empty the section, keeping the memory of its buffers
+	void Reset();
+};
+
+/**
+ * Mesh being sliced, in the space of its component.
+ * Sections are only ever emptied, never freed, so a mesh reused from slice to slice stops allocating once its buffers
+ * have grown to the size of the meshes sliced. Empty sections are skipped when the mesh is written to a component.
+ */
+struct STEELHEART_API FSlicerMesh
+{
+	TArray<FSlicerSection> Sections;
+
+	// Empty every section, making sure there are at least the given number of them
+	void Reset(int32 NumSections);
+
+	// Copy the sections of a procedural mesh, on the game thread
+	void CopyFrom(UProceduralMeshComponent* ProcMesh);
+
+	/**
+	 * Replaces the sections of a procedural mesh, writing into the buffers the component already holds.
+	 * The bounds, collision and render state of the component are refreshed once, after every section is written.
+	 *
+	 * @param ProcMesh The mesh written to.
+	 * @param Source The mesh the materials of the sections are read from, which may be the one written to.
+	 * @param CapMaterial Material of the caps.
+	 * @return The number of section buffers that had to be allocated or grown.
+	 */
+	int32 CopyTo(UProceduralMeshComponent* ProcMesh, const UProceduralMeshComponent* Source, UMaterialInterface* CapMaterial) const;
+
+	int32 NumTriangles() const;
+
+	bool IsEmpty() const { return NumTriangles() == 0; }
+};
+
+/**
+ * Slicing of meshes by one or several planes, safe to run on worker threads.
+ * Vertices are classified against a plane four at a time with vector instructions, triangles crossing it are split
+ * with every vertex attribute interpolated, and the outlines left on the plane are closed with triangulated caps.
+ */
+class STEELHEART_API FMeshSlicer
+{
+public:
+	/**
+	 * Slices a mesh in two.
+	 *
+	 * @param Mesh The mesh sliced.
+	 * @param Plane The slicing plane, in the space of the mesh.
+	 * @param bCreateCaps If true, the cut is closed on both halves.
+	 * @param OutFront Half on the side the plane normal points to, its buffers reused.
+	 * @param OutBack Half on the other side, its buffers reused.
+	 * @param bVectorized If false, vertices are classified with the scalar reference path.
+	 */
+	static void SlicePlane(const FSlicerMesh& Mesh, const FPlane& Plane, bool bCreateCaps, FSlicerMesh& OutFront, FSlicerMesh& OutBack, bool bVectorized = true);
+
+	/**
+	 * Slices a mesh by several planes, every piece being sliced again by the following planes.
+	 *
+	 * @param Mesh The mesh sliced.
+	 * @param Planes The slicing planes, in the space of the mesh.
+	 * @param bCreateCaps If true, every cut is closed.
+	 * @param OutPieces Pieces left with triangles, the first one on the front side of every plane.
+	 * @param bVectorized If false, vertices are classified with the scalar reference path.
+	 */
+	static void SlicePlanes(const FSlicerMesh& Mesh, TArrayView<const FPlane> Planes, bool bCreateCaps, TArray<FSlicerMesh>& OutPieces, bool bVectorized = true);
+
+	/**
+	 * Computes the signed distance of the vertices of a section to a plane.
+	 *
+	 * @param Section The section classified, read from its position streams when vectorized.
+	 * @param Plane The plane.
+	 * @param OutDistances Distance of every vertex, positive on the side the normal points to, sized by the caller.
+	 * @param bVectorized If false, the scalar reference path is used instead.
+	 */
+	static void ClassifyVertices(const FSlicerSection& Section, const FPlane& Plane, TArrayView<float> OutDistances, bool bVectorized = true);
+
+	// Log the slicing throughput of a generated sphere, vectorized and scalar, and the speedup of the vectorized path
+	static void RunBenchmark(int32 Rings, int32 NumPlanes, int32 Iterations);
+
+private:
+	// Scratch memory of a slice is taken from the memory stack of the slicing thread and released at once when it ends
+	using FScratchSegments = TArray<FVector, TMemStackAllocator<>>;
+
+	// Split the triangles of one section, collecting the cut segments on the plane
+	static void SliceSection(const FSlicerSection& Section, const FPlane& Plane, FSlicerSection& OutFront, FSlicerSection& OutBack,
+		FScratchSegments& OutSegments, bool bVectorized);
+
+	// Close the outlines left by the segments with a cap on each side
+	static void BuildCaps(const FScratchSegments& Segments, const FPlane& Plane, FSlicerMesh& OutFront, FSlicerMesh& OutBack);
+};
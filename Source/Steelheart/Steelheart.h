@@ -3,3 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+// Stat group for the project's native gameplay code, viewed with "stat Steelheart"
+DECLARE_STATS_GROUP(TEXT("Steelheart"), STATGROUP_Steelheart, STATCAT_Advanced);
@@ -0,0 +1,378 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/DestructibleDebrisSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "EngineUtils.h"
+#include "Field/FieldSystemTypes.h"
+#include "GameFramework/Pawn.h"
+#include "GeometryCollection/GeometryCollectionComponent.h"
+#include "GeometryCollection/GeometryCollectionObject.h"
+#include "GeometryCollection/GeometryDynamicCollection.h"
+#include "HAL/IConsoleManager.h"
+#include "Steelheart/Interfaces/Public/FlightLocomotionInterface.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/DestructionJournalSubsystem.h"
+#include "Steelheart/Subsystems/Public/FlightFieldSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Destructible Debris Update"), STAT_DestructibleDebrisUpdate, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Debris Collections"), STAT_DebrisCollections, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Debris Moving Pieces"), STAT_DebrisMovingPieces, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<float> CVarFlightDebrisInterval(
+	TEXT("Flight.Debris.Interval"),
+	0.25f,
+	TEXT("Seconds between two updates of the debris of flight impacts."));
+
+static TAutoConsoleVariable<int32> CVarFlightDebrisMaxMovingPieces(
+	TEXT("Flight.Debris.MaxMovingPieces"),
+	300,
+	TEXT("Moving debris pieces allowed across the world. Past it, the oldest and farthest pieces are removed."));
+
+static TAutoConsoleVariable<int32> CVarFlightDebrisMaxRemovalsPerUpdate(
+	TEXT("Flight.Debris.MaxRemovalsPerUpdate"),
+	32,
+	TEXT("Pieces removed at most in one update, the rest of the excess waits for the next ones."));
+
+static TAutoConsoleVariable<float> CVarFlightDebrisSettleDistance(
+	TEXT("Flight.Debris.SettleDistance"),
+	5.f,
+	TEXT("Pieces moving less than this between two updates count as still."));
+
+static TAutoConsoleVariable<float> CVarFlightDebrisSettleTime(
+	TEXT("Flight.Debris.SettleTime"),
+	2.f,
+	TEXT("Seconds a piece has to stay still before it is frozen."));
+
+static TAutoConsoleVariable<float> CVarFlightDebrisSmallPieceRadius(
+	TEXT("Flight.Debris.SmallPieceRadius"),
+	50.f,
+	TEXT("Pieces with rest bounds smaller than this radius are frozen after the small piece settle time."));
+
+static TAutoConsoleVariable<float> CVarFlightDebrisSmallSettleTime(
+	TEXT("Flight.Debris.SmallSettleTime"),
+	0.5f,
+	TEXT("Seconds a small piece has to stay still before it is frozen."));
+
+static TAutoConsoleVariable<float> CVarFlightDebrisDistanceWeight(
+	TEXT("Flight.Debris.DistanceWeight"),
+	0.001f,
+	TEXT("Seconds of age a unit of distance to the nearest flyer is worth when picking the pieces to remove."));
+
+static TAutoConsoleVariable<float> CVarFlightDebrisReleaseTime(
+	TEXT("Flight.Debris.ReleaseTime"),
+	10.f,
+	TEXT("Seconds a collection has to go without a moving piece before it stops being tracked."));
+
+static FAutoConsoleCommandWithWorld FlightDebrisReportCommand(
+	TEXT("Flight.Debris.Report"),
+	TEXT("Log the debris of flight impacts along with the pieces frozen and removed"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UDestructibleDebrisSubsystem* Debris = World ? World->GetSubsystem<UDestructibleDebrisSubsystem>() : nullptr)
+		{
+			Debris->LogReport();
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UDestructibleDebrisSubsystem::Deinitialize()
+{
+	Collections.Empty();
+	MovingPieces.Empty();
+
+	Super::Deinitialize();
+}
+
+void UDestructibleDebrisSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TimeSinceUpdate += DeltaTime;
+	if (Collections.Num() == 0 || TimeSinceUpdate < CVarFlightDebrisInterval.GetValueOnGameThread())
+	{
+		return;
+	}
+
+	TimeSinceUpdate = 0.f;
+
+	SCOPE_CYCLE_COUNTER(STAT_DestructibleDebrisUpdate);
+
+	float CurrentTime = GetWorld()->GetTimeSeconds();
+	float ReleaseTime = CVarFlightDebrisReleaseTime.GetValueOnGameThread();
+
+	// Collections destroyed or long settled need no more attention
+	int32 CollectionsBefore = Collections.Num();
+	Collections.RemoveAllSwap([CurrentTime, ReleaseTime](const FTrackedCollection& Tracked)
+	{
+		return !Tracked.Component.IsValid() || (Tracked.MovingPieces == 0 && CurrentTime - Tracked.LastMovingTime > ReleaseTime);
+	});
+	ReleasedCollections += CollectionsBefore - Collections.Num();
+
+	FlyerLocations.Reset();
+	for (TActorIterator<APawn> It(GetWorld()); It; ++It)
+	{
+		if (It->Implements<UFlightLocomotionInterface>())
+		{
+			FlyerLocations.Add(It->GetActorLocation());
+		}
+	}
+
+	MovingPieces.Reset();
+	for (int32 CollectionIndex = 0; CollectionIndex < Collections.Num(); CollectionIndex++)
+	{
+		UpdateCollection(CollectionIndex, CurrentTime);
+	}
+
+	EnforceBudget();
+
+	SET_DWORD_STAT(STAT_DebrisCollections, Collections.Num());
+	SET_DWORD_STAT(STAT_DebrisMovingPieces, MovingPieces.Num());
+}
+
+TStatId UDestructibleDebrisSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDestructibleDebrisSubsystem, STATGROUP_Steelheart);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Debris Functions
+
+void UDestructibleDebrisSubsystem::TrackCollection(UGeometryCollectionComponent* Collection)
+{
+	if (Collection == nullptr || Collection->GetRestCollection() == nullptr)
+	{
+		return;
+	}
+
+	if (Collections.ContainsByPredicate([Collection](const FTrackedCollection& Tracked) { return Tracked.Component == Collection; }))
+	{
+		return;
+	}
+
+	TSharedPtr<FGeometryCollection, ESPMode::ThreadSafe> RestCollection = Collection->GetRestCollection()->GetGeometryCollection();
+	if (!RestCollection.IsValid())
+	{
+		return;
+	}
+
+	int32 NumPieces = RestCollection->NumElements(FGeometryCollection::TransformGroup);
+
+	FTrackedCollection& Tracked = Collections.AddDefaulted_GetRef();
+	Tracked.Component = Collection;
+	Tracked.LastMovingTime = GetWorld()->GetTimeSeconds();
+	Tracked.PieceRadii.SetNumZeroed(NumPieces);
+	Tracked.LastPositions.SetNumZeroed(NumPieces);
+	Tracked.MovingSince.Init(-1.f, NumPieces);
+	Tracked.StillSince.SetNumZeroed(NumPieces);
+	Tracked.Retired.Init(false, NumPieces);
+
+	// Clusters have no geometry of their own and keep a zero radius, they only count once broken off as a whole
+	for (int32 PieceIndex = 0; PieceIndex < NumPieces; PieceIndex++)
+	{
+		int32 GeometryIndex = RestCollection->TransformToGeometryIndex[PieceIndex];
+		if (GeometryIndex != INDEX_NONE)
+		{
+			Tracked.PieceRadii[PieceIndex] = RestCollection->BoundingBox[GeometryIndex].GetExtent().Size();
+		}
+	}
+}
+
+void UDestructibleDebrisSubsystem::UpdateCollection(int32 CollectionIndex, float CurrentTime)
+{
+	FTrackedCollection& Tracked = Collections[CollectionIndex];
+	UGeometryCollectionComponent* Component = Tracked.Component.Get();
+
+	const FGeometryDynamicCollection* DynamicCollection = Component->GetDynamicCollection();
+	const TArray<FMatrix>& GlobalMatrices = Component->GetGlobalMatrices();
+
+	int32 NumPieces = Tracked.PieceRadii.Num();
+	if (DynamicCollection == nullptr || DynamicCollection->NumElements(FTransformCollection::TransformGroup) != NumPieces || GlobalMatrices.Num() != NumPieces)
+	{
+		return;
+	}
+
+	float SettleDistanceSquared = FMath::Square(CVarFlightDebrisSettleDistance.GetValueOnGameThread());
+	float SettleTime = CVarFlightDebrisSettleTime.GetValueOnGameThread();
+	float SmallPieceRadius = CVarFlightDebrisSmallPieceRadius.GetValueOnGameThread();
+	float SmallSettleTime = CVarFlightDebrisSmallSettleTime.GetValueOnGameThread();
+	float DistanceWeight = CVarFlightDebrisDistanceWeight.GetValueOnGameThread();
+
+	const FTransform& ComponentTransform = Component->GetComponentTransform();
+
+	UDestructionJournalSubsystem* Journal = GetWorld()->GetGameInstance() ? GetWorld()->GetGameInstance()->GetSubsystem<UDestructionJournalSubsystem>() : nullptr;
+
+	Tracked.MovingPieces = 0;
+
+	for (int32 PieceIndex = 0; PieceIndex < NumPieces; PieceIndex++)
+	{
+		// Only the pieces broken off and simulating cost the solver anything
+		if (Tracked.Retired[PieceIndex] || !DynamicCollection->Active[PieceIndex]
+			|| DynamicCollection->DynamicState[PieceIndex] != (int32)EObjectStateTypeEnum::Chaos_Object_Dynamic)
+		{
+			continue;
+		}
+
+		FVector Location = ComponentTransform.TransformPosition(GlobalMatrices[PieceIndex].GetOrigin());
+
+		if (Tracked.MovingSince[PieceIndex] < 0.f)
+		{
+			Tracked.MovingSince[PieceIndex] = CurrentTime;
+			Tracked.StillSince[PieceIndex] = CurrentTime;
+			Tracked.LastPositions[PieceIndex] = Location;
+		}
+		else if (FVector::DistSquared(Location, Tracked.LastPositions[PieceIndex]) > SettleDistanceSquared)
+		{
+			Tracked.StillSince[PieceIndex] = CurrentTime;
+			Tracked.LastPositions[PieceIndex] = Location;
+		}
+
+		// Settled pieces are anchored, which takes them out of the simulation while they keep being drawn with the collection
+		float PieceSettleTime = Tracked.PieceRadii[PieceIndex] < SmallPieceRadius ? SmallSettleTime : SettleTime;
+		if (CurrentTime - Tracked.StillSince[PieceIndex] >= PieceSettleTime)
+		{
+			Component->SetAnchoredByIndex(PieceIndex, true);
+			Tracked.Retired[PieceIndex] = true;
+			FrozenPieces++;
+
+			if (Journal != nullptr)
+			{
+				Journal->RecordPiece(Component, PieceIndex, FTransform(GlobalMatrices[PieceIndex]), false);
+			}
+			continue;
+		}
+
+		float NearestFlyerDistance = 0.f;
+		if (FlyerLocations.Num() > 0)
+		{
+			float NearestDistanceSquared = TNumericLimits<float>::Max();
+			for (const FVector& FlyerLocation : FlyerLocations)
+			{
+				NearestDistanceSquared = FMath::Min<float>(NearestDistanceSquared, FVector::DistSquared(FlyerLocation, Location));
+			}
+
+			NearestFlyerDistance = FMath::Sqrt(NearestDistanceSquared);
+		}
+
+		FMovingPiece& Piece = MovingPieces.AddDefaulted_GetRef();
+		Piece.CollectionIndex = CollectionIndex;
+		Piece.PieceIndex = PieceIndex;
+		Piece.Location = Location;
+		Piece.Score = (CurrentTime - Tracked.MovingSince[PieceIndex]) + NearestFlyerDistance * DistanceWeight;
+
+		Tracked.MovingPieces++;
+	}
+
+	if (Tracked.MovingPieces > 0)
+	{
+		Tracked.LastMovingTime = CurrentTime;
+	}
+}
+
+void UDestructibleDebrisSubsystem::EnforceBudget()
+{
+	int32 Excess = MovingPieces.Num() - FMath::Max(CVarFlightDebrisMaxMovingPieces.GetValueOnGameThread(), 0);
+	if (Excess <= 0)
+	{
+		return;
+	}
+
+	UFlightFieldSubsystem* Fields = GetWorld()->GetSubsystem<UFlightFieldSubsystem>();
+	if (Fields == nullptr)
+	{
+		return;
+	}
+
+	UDestructionJournalSubsystem* Journal = GetWorld()->GetGameInstance() ? GetWorld()->GetGameInstance()->GetSubsystem<UDestructionJournalSubsystem>() : nullptr;
+
+	Excess = FMath::Min(Excess, FMath::Max(CVarFlightDebrisMaxRemovalsPerUpdate.GetValueOnGameThread(), 1));
+
+	// Oldest and farthest first
+	MovingPieces.Sort([](const FMovingPiece& A, const FMovingPiece& B) { return A.Score > B.Score; });
+
+	for (int32 Index = 0; Index < Excess; Index++)
+	{
+		const FMovingPiece& Piece = MovingPieces[Index];
+		FTrackedCollection& Tracked = Collections[Piece.CollectionIndex];
+
+		// Cover the piece itself only, clusters broken off as a whole get a radius of their own size
+		float Radius = FMath::Max(Tracked.PieceRadii[Piece.PieceIndex], 10.f);
+		Fields->QueueRemoval(Piece.Location, Radius);
+
+		Tracked.Retired[Piece.PieceIndex] = true;
+		Tracked.MovingPieces--;
+		RemovedPieces++;
+
+		if (Journal != nullptr && Tracked.Component.IsValid())
+		{
+			Journal->RecordPiece(Tracked.Component.Get(), Piece.PieceIndex, FTransform::Identity, true);
+		}
+	}
+}
+
+void UDestructibleDebrisSubsystem::RecordMovingPieces(ULevel* Level)
+{
+	UDestructionJournalSubsystem* Journal = GetWorld()->GetGameInstance() ? GetWorld()->GetGameInstance()->GetSubsystem<UDestructionJournalSubsystem>() : nullptr;
+	if (Journal == nullptr)
+	{
+		return;
+	}
+
+	for (const FTrackedCollection& Tracked : Collections)
+	{
+		UGeometryCollectionComponent* Component = Tracked.Component.Get();
+		if (Component == nullptr || (Level != nullptr && Component->GetComponentLevel() != Level))
+		{
+			continue;
+		}
+
+		const FGeometryDynamicCollection* DynamicCollection = Component->GetDynamicCollection();
+		const TArray<FMatrix>& GlobalMatrices = Component->GetGlobalMatrices();
+
+		int32 NumPieces = Tracked.PieceRadii.Num();
+		if (DynamicCollection == nullptr || DynamicCollection->NumElements(FTransformCollection::TransformGroup) != NumPieces || GlobalMatrices.Num() != NumPieces)
+		{
+			continue;
+		}
+
+		// Frozen and removed pieces are already recorded
+		for (int32 PieceIndex = 0; PieceIndex < NumPieces; PieceIndex++)
+		{
+			if (!Tracked.Retired[PieceIndex] && DynamicCollection->Active[PieceIndex] && Tracked.MovingSince[PieceIndex] >= 0.f)
+			{
+				Journal->RecordPiece(Component, PieceIndex, FTransform(GlobalMatrices[PieceIndex]), false);
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UDestructibleDebrisSubsystem::LogReport() const
+{
+	int32 MovingTotal = 0;
+	int32 RetiredTotal = 0;
+
+	for (const FTrackedCollection& Tracked : Collections)
+	{
+		MovingTotal += Tracked.MovingPieces;
+		RetiredTotal += Tracked.Retired.CountSetBits();
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Destructible debris: %d collections tracked, %d released, %d moving pieces out of a budget of %d"),
+		Collections.Num(), ReleasedCollections, MovingTotal, CVarFlightDebrisMaxMovingPieces.GetValueOnGameThread());
+
+	UE_LOG(LogTemp, Log, TEXT("  %d pieces frozen, %d removed over the budget, %d retired in the tracked collections"),
+		FrozenPieces, RemovedPieces, RetiredTotal);
+
+	for (const FTrackedCollection& Tracked : Collections)
+	{
+		if (Tracked.Component.IsValid())
+		{
+			UE_LOG(LogTemp, Log, TEXT("  %-40s %d moving  %d retired"), *Tracked.Component->GetOwner()->GetName(),
+				Tracked.MovingPieces, Tracked.Retired.CountSetBits());
+		}
+	}
+}
@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/DestructibleProxySubsystem.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Steelheart/Actors/Public/DestructibleProxyActor.h"
+#include "Steelheart/Interfaces/Public/FlightLocomotionInterface.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/DestructibleRegistrySubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Destructible Proxies Update"), STAT_DestructibleProxiesUpdate, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live Collections"), STAT_LiveCollections, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live Collection Bodies"), STAT_LiveCollectionBodies, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<bool> CVarFlightProxiesEnabled(
+	TEXT("Flight.Proxies.Enabled"),
+	true,
+	TEXT("Keep destructibles as static meshes away from flyers. When disabled, every proxy is swapped in and kept live."));
+
+static TAutoConsoleVariable<float> CVarFlightProxiesInterval(
+	TEXT("Flight.Proxies.Interval"),
+	0.2f,
+	TEXT("Seconds between two searches for the proxies near flyers."));
+
+static TAutoConsoleVariable<float> CVarFlightProxiesBaseRadius(
+	TEXT("Flight.Proxies.BaseRadius"),
+	3000.f,
+	TEXT("Radius around a still flyer within which proxies are swapped in."));
+
+static TAutoConsoleVariable<float> CVarFlightProxiesSpeedTime(
+	TEXT("Flight.Proxies.SpeedTime"),
+	1.f,
+	TEXT("Seconds of flyer travel added to the swap in radius, so fast flyers find the collections live when they arrive."));
+
+static TAutoConsoleVariable<float> CVarFlightProxiesIdleTime(
+	TEXT("Flight.Proxies.IdleTime"),
+	5.f,
+	TEXT("Seconds an undamaged live collection may go unwanted before it is swapped back out."));
+
+static TAutoConsoleVariable<bool> CVarFlightCacheEnabled(
+	TEXT("Flight.Cache.Enabled"),
+	true,
+	TEXT("Play back the recorded fracture of an impact when one matches, instead of simulating it."));
+
+static TAutoConsoleVariable<bool> CVarFlightCacheRecord(
+	TEXT("Flight.Cache.Record"),
+	false,
+	TEXT("Record the simulated fracture of impacts into the cache of their bucket. Save the cache assets after playing in editor."));
+
+static FAutoConsoleCommandWithWorld FlightProxiesReportCommand(
+	TEXT("Flight.Proxies.Report"),
+	TEXT("Log the destructible proxies along with the bodies and memory of the live collections"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UDestructibleProxySubsystem* Proxies = World ? World->GetSubsystem<UDestructibleProxySubsystem>() : nullptr)
+		{
+			Proxies->LogReport();
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UDestructibleProxySubsystem::Deinitialize()
+{
+	Proxies.Empty();
+
+	Super::Deinitialize();
+}
+
+void UDestructibleProxySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TimeSinceUpdate += DeltaTime;
+	if (Proxies.Num() == 0 || TimeSinceUpdate < CVarFlightProxiesInterval.GetValueOnGameThread())
+	{
+		return;
+	}
+
+	TimeSinceUpdate = 0.f;
+
+	SCOPE_CYCLE_COUNTER(STAT_DestructibleProxiesUpdate);
+
+	Proxies.RemoveAllSwap([](const TWeakObjectPtr<ADestructibleProxyActor>& Proxy) { return !Proxy.IsValid(); });
+
+	if (CVarFlightProxiesEnabled.GetValueOnGameThread())
+	{
+		RequestProxiesNearFlyers();
+		ReturnIdleProxies();
+	}
+	else
+	{
+		for (const TWeakObjectPtr<ADestructibleProxyActor>& Proxy : Proxies)
+		{
+			Proxy->RequestLive(false);
+		}
+	}
+
+	int32 LiveCollections = 0;
+	int32 LiveBodies = 0;
+
+	for (const TWeakObjectPtr<ADestructibleProxyActor>& Proxy : Proxies)
+	{
+		if (Proxy->IsLive())
+		{
+			LiveCollections++;
+			LiveBodies += Proxy->GetBodyCount();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_LiveCollections, LiveCollections);
+	SET_DWORD_STAT(STAT_LiveCollectionBodies, LiveBodies);
+}
+
+TStatId UDestructibleProxySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDestructibleProxySubsystem, STATGROUP_Steelheart);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Proxy Functions
+
+void UDestructibleProxySubsystem::RegisterProxy(ADestructibleProxyActor* Proxy)
+{
+	Proxies.AddUnique(Proxy);
+}
+
+void UDestructibleProxySubsystem::UnregisterProxy(ADestructibleProxyActor* Proxy)
+{
+	Proxies.RemoveSwap(Proxy);
+}
+
+bool UDestructibleProxySubsystem::RequestLive(AActor* Destructible, bool bImmediate)
+{
+	ADestructibleProxyActor* Proxy = Cast<ADestructibleProxyActor>(Destructible);
+	if (Proxy == nullptr)
+	{
+		return true;
+	}
+
+	if (!Proxy->IsLive() && !Proxy->IsLoading())
+	{
+		SwapsIn++;
+	}
+
+	// Proxies without a collection to stream in are struck as they are
+	Proxy->RequestLive(bImmediate);
+	return !Proxy->IsLoading();
+}
+
+bool UDestructibleProxySubsystem::PlayImpact(AActor* Destructible, const FVector& ImpactVelocity)
+{
+	ADestructibleProxyActor* Proxy = Cast<ADestructibleProxyActor>(Destructible);
+	if (Proxy == nullptr || !Proxy->IsLive() || Proxy->IsDamaged())
+	{
+		return false;
+	}
+
+	bool bRecord = CVarFlightCacheRecord.GetValueOnGameThread();
+	if (!bRecord && !CVarFlightCacheEnabled.GetValueOnGameThread())
+	{
+		SimulatedImpacts++;
+		return false;
+	}
+
+	bool bPlayed = Proxy->PlayImpact(ImpactVelocity.GetSafeNormal(), ImpactVelocity.Size(), bRecord);
+	if (bPlayed)
+	{
+		CachedImpacts++;
+	}
+	else
+	{
+		SimulatedImpacts++;
+	}
+
+	return bPlayed;
+}
+
+void UDestructibleProxySubsystem::RequestProxiesNearFlyers()
+{
+	UDestructibleRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UDestructibleRegistrySubsystem>();
+	if (Registry == nullptr)
+	{
+		return;
+	}
+
+	float BaseRadius = CVarFlightProxiesBaseRadius.GetValueOnGameThread();
+	float SpeedTime = CVarFlightProxiesSpeedTime.GetValueOnGameThread();
+
+	for (TActorIterator<APawn> It(GetWorld()); It; ++It)
+	{
+		if (!It->Implements<UFlightLocomotionInterface>())
+		{
+			continue;
+		}
+
+		// Look further ahead of faster flyers
+		float Radius = BaseRadius + It->GetVelocity().Size() * SpeedTime;
+
+		FoundDestructibles.Reset();
+		Registry->FindInRadius(It->GetActorLocation(), Radius, FoundDestructibles);
+
+		for (AActor* Destructible : FoundDestructibles)
+		{
+			RequestLive(Destructible, false);
+		}
+	}
+}
+
+void UDestructibleProxySubsystem::ReturnIdleProxies()
+{
+	float CurrentTime = GetWorld()->GetTimeSeconds();
+	float IdleTime = CVarFlightProxiesIdleTime.GetValueOnGameThread();
+
+	for (const TWeakObjectPtr<ADestructibleProxyActor>& Proxy : Proxies)
+	{
+		if ((Proxy->IsLive() || Proxy->IsLoading()) && !Proxy->IsDamaged() && CurrentTime - Proxy->GetLastWantedTime() > IdleTime)
+		{
+			Proxy->ReturnToProxy();
+			SwapsOut++;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UDestructibleProxySubsystem::LogReport() const
+{
+	int32 LiveCollections = 0;
+	int32 DamagedCollections = 0;
+	int32 LoadingCollections = 0;
+	int32 LiveBodies = 0;
+	int32 KnownBodies = 0;
+	SIZE_T LiveMemory = 0;
+
+	for (const TWeakObjectPtr<ADestructibleProxyActor>& Proxy : Proxies)
+	{
+		if (!Proxy.IsValid())
+		{
+			continue;
+		}
+
+		KnownBodies += Proxy->GetBodyCount();
+
+		if (Proxy->IsLive())
+		{
+			LiveCollections++;
+			LiveBodies += Proxy->GetBodyCount();
+			LiveMemory += Proxy->GetLiveMemory();
+			DamagedCollections += Proxy->IsDamaged() ? 1 : 0;
+		}
+		else if (Proxy->IsLoading())
+		{
+			LoadingCollections++;
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Destructible proxies: %d registered, %d live (%d damaged), %d streaming in, %d swaps in, %d swaps out"),
+		Proxies.Num(), LiveCollections, DamagedCollections, LoadingCollections, SwapsIn, SwapsOut);
+
+	// Proxies never swapped in yet have no known body count, so the all live figure is a lower bound
+	UE_LOG(LogTemp, Log, TEXT("  Solver bodies: %d live, at least %d with every collection live"), LiveBodies, KnownBodies);
+	UE_LOG(LogTemp, Log, TEXT("  Live collection memory: %.1f KB"), LiveMemory / 1024.f);
+	UE_LOG(LogTemp, Log, TEXT("  Impacts: %d played back from a recording, %d simulated"), CachedImpacts, SimulatedImpacts);
+
+	for (const TWeakObjectPtr<ADestructibleProxyActor>& Proxy : Proxies)
+	{
+		if (Proxy.IsValid() && (Proxy->IsLive() || Proxy->IsLoading()))
+		{
+			UE_LOG(LogTemp, Log, TEXT("  %-40s %s  %d bodies  %.1f KB"), *Proxy->GetName(),
+				Proxy->IsLive() ? (Proxy->IsDamaged() ? TEXT("damaged") : TEXT("live")) : TEXT("loading"),
+				Proxy->GetBodyCount(), Proxy->GetLiveMemory() / 1024.f);
+		}
+	}
+}
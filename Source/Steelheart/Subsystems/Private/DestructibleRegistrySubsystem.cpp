@@ -0,0 +1,342 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/DestructibleRegistrySubsystem.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GeometryCollection/GeometryCollectionComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/DestructionJournalSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Destructible Registry Query"), STAT_DestructibleRegistryQuery, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Registered Destructibles"), STAT_RegisteredDestructibles, STATGROUP_Steelheart);
+
+static FAutoConsoleCommandWithWorld DestructiblesReportCommand(
+	TEXT("Flight.Destructibles.Report"),
+	TEXT("Log the destructibles registered in the world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UDestructibleRegistrySubsystem* Registry = World ? World->GetSubsystem<UDestructibleRegistrySubsystem>() : nullptr)
+		{
+			Registry->LogReport();
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UDestructibleRegistrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UDestructibleRegistrySubsystem::HandleLevelAdded);
+}
+
+void UDestructibleRegistrySubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	if (ActorSpawnedHandle.IsValid())
+	{
+		GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+
+	Octree.Destroy();
+	ElementIds.Empty();
+	ScannedTags.Empty();
+
+	Super::Deinitialize();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Registration Functions
+
+void UDestructibleRegistrySubsystem::RegisterDestructible(AActor* Actor)
+{
+	if (Actor == nullptr)
+	{
+		return;
+	}
+
+	FVector Origin;
+	FVector Extent;
+	Actor->GetActorBounds(true, Origin, Extent);
+	FBox Bounds = FBox::BuildAABB(Origin, Extent);
+
+	if (const FOctreeElementId2* ElementId = ElementIds.Find(Actor))
+	{
+		// Small moves stay within the bounds already indexed
+		const FBox& IndexedBounds = Octree.GetElementById(*ElementId).Bounds;
+		if (IndexedBounds.Min.Equals(Bounds.Min, 1.f) && IndexedBounds.Max.Equals(Bounds.Max, 1.f))
+		{
+			return;
+		}
+
+		RemoveElement(Actor);
+		BoundsUpdates++;
+	}
+	else
+	{
+		Actor->OnEndPlay.AddUniqueDynamic(this, &UDestructibleRegistrySubsystem::HandleEndPlay);
+
+		// Destruction recorded in an earlier visit reappears as the actor streams back in
+		UDestructionJournalSubsystem* Journal = GetWorld()->GetGameInstance() ? GetWorld()->GetGameInstance()->GetSubsystem<UDestructionJournalSubsystem>() : nullptr;
+		if (Journal != nullptr && Journal->HasRecord(Actor))
+		{
+			TInlineComponentArray<UGeometryCollectionComponent*> Collections(Actor);
+			for (UGeometryCollectionComponent* Collection : Collections)
+			{
+				Journal->RestoreCollection(Collection);
+			}
+		}
+
+		USceneComponent* Root = Actor->GetRootComponent();
+		if (Root != nullptr && Root->Mobility == EComponentMobility::Movable)
+		{
+			Root->TransformUpdated.AddUObject(this, &UDestructibleRegistrySubsystem::HandleTransformUpdated);
+		}
+
+		WarnIfNotStrikable(Actor);
+	}
+
+	FDestructibleElement Element;
+	Element.Actor = Actor;
+	Element.Key = Actor;
+	Element.Bounds = Bounds;
+	Element.ElementIds = &ElementIds;
+	Octree.AddElement(Element);
+
+	SET_DWORD_STAT(STAT_RegisteredDestructibles, ElementIds.Num());
+}
+
+void UDestructibleRegistrySubsystem::UnregisterDestructible(AActor* Actor)
+{
+	if (Actor == nullptr || !ElementIds.Contains(Actor))
+	{
+		return;
+	}
+
+	Actor->OnEndPlay.RemoveDynamic(this, &UDestructibleRegistrySubsystem::HandleEndPlay);
+
+	if (USceneComponent* Root = Actor->GetRootComponent())
+	{
+		Root->TransformUpdated.RemoveAll(this);
+	}
+
+	RemoveElement(Actor);
+
+	SET_DWORD_STAT(STAT_RegisteredDestructibles, ElementIds.Num());
+}
+
+void UDestructibleRegistrySubsystem::RemoveElement(const AActor* Actor)
+{
+	FOctreeElementId2 ElementId;
+	if (ElementIds.RemoveAndCopyValue(Actor, ElementId))
+	{
+		Octree.RemoveElement(ElementId);
+	}
+}
+
+void UDestructibleRegistrySubsystem::RegisterTaggedActors(FName Tag)
+{
+	if (Tag.IsNone() || ScannedTags.Contains(Tag))
+	{
+		return;
+	}
+
+	ScannedTags.Add(Tag);
+
+	// Scan the loaded levels once, later actors are registered as they arrive
+	for (ULevel* Level : GetWorld()->GetLevels())
+	{
+		RegisterTaggedActorsInLevel(Level);
+	}
+
+	if (!ActorSpawnedHandle.IsValid())
+	{
+		ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UDestructibleRegistrySubsystem::HandleActorSpawned));
+	}
+}
+
+void UDestructibleRegistrySubsystem::AddStrikableObjectTypes(int32 ObjectTypes)
+{
+	int32 AddedTypes = ObjectTypes & ~StrikableObjectTypes;
+	if (AddedTypes == 0)
+	{
+		return;
+	}
+
+	// Only the first filter can leave registered destructibles unstrikable, later ones only widen it
+	bool bFirstFilter = StrikableObjectTypes == 0;
+	StrikableObjectTypes |= AddedTypes;
+
+	if (bFirstFilter)
+	{
+		for (const TPair<TObjectKey<AActor>, FOctreeElementId2>& Pair : ElementIds)
+		{
+			WarnIfNotStrikable(Pair.Key.ResolveObjectPtr());
+		}
+	}
+}
+
+void UDestructibleRegistrySubsystem::WarnIfNotStrikable(const AActor* Actor) const
+{
+	// Nothing is known of the dashes until a flyer has added its filter
+	if (Actor == nullptr || StrikableObjectTypes == 0)
+	{
+		return;
+	}
+
+	TInlineComponentArray<UPrimitiveComponent*> Primitives(Actor);
+	for (const UPrimitiveComponent* Primitive : Primitives)
+	{
+		if (Primitive->IsCollisionEnabled() && (StrikableObjectTypes & ECC_TO_BITFIELD(Primitive->GetCollisionObjectType())) != 0)
+		{
+			return;
+		}
+	}
+
+	UE_LOG(LogTemp, Warning, TEXT("Destructible %s has no colliding component of an object type in the DestructibleObjectTypes of the flight tuning profile, dashes will not strike it"),
+		*Actor->GetName());
+}
+
+void UDestructibleRegistrySubsystem::RegisterTaggedActorsInLevel(ULevel* Level)
+{
+	if (Level == nullptr)
+	{
+		return;
+	}
+
+	for (AActor* Actor : Level->Actors)
+	{
+		if (Actor != nullptr && !ElementIds.Contains(Actor) && HasScannedTag(Actor))
+		{
+			RegisterDestructible(Actor);
+		}
+	}
+}
+
+void UDestructibleRegistrySubsystem::HandleActorSpawned(AActor* Actor)
+{
+	if (HasScannedTag(Actor))
+	{
+		RegisterDestructible(Actor);
+	}
+}
+
+void UDestructibleRegistrySubsystem::HandleLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld() && ScannedTags.Num() > 0)
+	{
+		RegisterTaggedActorsInLevel(Level);
+	}
+}
+
+void UDestructibleRegistrySubsystem::HandleTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	RegisterDestructible(UpdatedComponent->GetOwner());
+}
+
+void UDestructibleRegistrySubsystem::HandleEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterDestructible(Actor);
+}
+
+bool UDestructibleRegistrySubsystem::HasScannedTag(const AActor* Actor) const
+{
+	for (FName Tag : ScannedTags)
+	{
+		if (Actor->ActorHasTag(Tag))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Query Functions
+
+void UDestructibleRegistrySubsystem::FindInRadius(const FVector& Center, float Radius, TArray<AActor*>& OutActors) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_DestructibleRegistryQuery);
+
+	Queries++;
+
+	FVector::FReal RadiusSquared = FMath::Square(Radius);
+	Octree.FindElementsWithBoundsTest(FBoxCenterAndExtent(Center, FVector(Radius)), [&](const FDestructibleElement& Element)
+	{
+		AActor* Actor = Element.Actor.Get();
+		if (Actor != nullptr && FMath::SphereAABBIntersection(Center, RadiusSquared, Element.Bounds))
+		{
+			OutActors.Add(Actor);
+		}
+	});
+}
+
+bool UDestructibleRegistrySubsystem::AnyInRadius(const FVector& Center, float Radius) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_DestructibleRegistryQuery);
+
+	Queries++;
+
+	FVector::FReal RadiusSquared = FMath::Square(Radius);
+	bool bFound = false;
+	Octree.FindFirstElementWithBoundsTest(FBoxCenterAndExtent(Center, FVector(Radius)), [&](const FDestructibleElement& Element)
+	{
+		bFound = Element.Actor.IsValid() && FMath::SphereAABBIntersection(Center, RadiusSquared, Element.Bounds);
+
+		// Keep searching until one is found
+		return !bFound;
+	});
+
+	return bFound;
+}
+
+void UDestructibleRegistrySubsystem::FindAlongSegment(const FVector& Start, const FVector& End, float Radius, TArray<AActor*>& OutActors) const
+{
+	// A segment of no length has no direction to intersect the bounds along, it is the sphere around its start
+	if (FVector::DistSquared(Start, End) < KINDA_SMALL_NUMBER)
+	{
+		FindInRadius(Start, Radius, OutActors);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DestructibleRegistryQuery);
+
+	Queries++;
+
+	FBox SegmentBounds = FBox(Start.ComponentMin(End), Start.ComponentMax(End)).ExpandBy(Radius);
+	FVector Direction = End - Start;
+
+	Octree.FindElementsWithBoundsTest(FBoxCenterAndExtent(SegmentBounds), [&](const FDestructibleElement& Element)
+	{
+		AActor* Actor = Element.Actor.Get();
+		if (Actor != nullptr && FMath::LineBoxIntersection(Element.Bounds.ExpandBy(Radius), Start, End, Direction))
+		{
+			OutActors.Add(Actor);
+		}
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UDestructibleRegistrySubsystem::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Destructibles: %d registered, %d queries, %d bounds updates, %.1f KB of index"),
+		ElementIds.Num(), Queries, BoundsUpdates, Octree.GetSizeBytes() / 1024.f);
+
+	for (FName Tag : ScannedTags)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  Registering actors tagged %s"), *Tag.ToString());
+	}
+
+	Octree.FindElementsWithBoundsTest(FBoxCenterAndExtent(FVector::ZeroVector, FVector(HALF_WORLD_MAX)), [](const FDestructibleElement& Element)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %s  %s"), *GetNameSafe(Element.Actor.Get()), *Element.Bounds.GetCenter().ToString());
+	});
+}
@@ -0,0 +1,430 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/DestructibleSupportSubsystem.h"
+#include "Async/Async.h"
+#include "GeometryCollection/GeometryCollectionComponent.h"
+#include "GeometryCollection/GeometryCollectionObject.h"
+#include "HAL/IConsoleManager.h"
+#include "Steelheart/Data/Public/DestructibleSupportGraph.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/FlightFieldSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Destructible Support Evaluate"), STAT_DestructibleSupportEvaluate, STATGROUP_Steelheart);
+DECLARE_CYCLE_STAT(TEXT("Destructible Support Apply"), STAT_DestructibleSupportApply, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<bool> CVarFlightSupportEnabled(
+	TEXT("Flight.Support.Enabled"),
+	true,
+	TEXT("Collapse the pieces of buildings left without support by the pieces broken off them."));
+
+static TAutoConsoleVariable<float> CVarFlightSupportCollapseStrain(
+	TEXT("Flight.Support.CollapseStrain"),
+	1000000.f,
+	TEXT("Strain applied to the pieces collapsing, enough to break them free of their cluster."));
+
+static FAutoConsoleCommandWithWorld FlightSupportReportCommand(
+	TEXT("Flight.Support.Report"),
+	TEXT("Log the buildings with a support graph along with their broken and collapsed nodes"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UDestructibleSupportSubsystem* Support = World ? World->GetSubsystem<UDestructibleSupportSubsystem>() : nullptr)
+		{
+			Support->LogReport();
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UDestructibleSupportSubsystem::Deinitialize()
+{
+	// The graphs have to outlive the evaluation reading them
+	if (PendingEvaluation.IsValid())
+	{
+		PendingEvaluation.Wait();
+		PendingEvaluation.Reset();
+	}
+
+	Buildings.Empty();
+	Graphs.Empty();
+
+	Super::Deinitialize();
+}
+
+void UDestructibleSupportSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (PendingEvaluation.IsValid())
+	{
+		if (!PendingEvaluation.IsReady())
+		{
+			return;
+		}
+
+		TArray<FSupportEvaluation> Finished = PendingEvaluation.Consume();
+		PendingEvaluation.Reset();
+
+		ApplyEvaluation(Finished);
+	}
+
+	RemoveReleasedBuildings();
+
+	if (CVarFlightSupportEnabled.GetValueOnGameThread())
+	{
+		LaunchEvaluation();
+	}
+}
+
+TStatId UDestructibleSupportSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDestructibleSupportSubsystem, STATGROUP_Steelheart);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Support Functions
+
+void UDestructibleSupportSubsystem::RegisterBuilding(UGeometryCollectionComponent* Collection, UDestructibleSupportGraph* Graph)
+{
+	if (Collection == nullptr || Graph == nullptr || Collection->GetRestCollection() == nullptr)
+	{
+		return;
+	}
+
+	if (Graph->Collection.ToSoftObjectPath() != FSoftObjectPath(Collection->GetRestCollection()))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: support graph %s was baked from another collection, ignored."),
+			*GetNameSafe(Collection->GetOwner()), *Graph->GetName());
+		return;
+	}
+
+	if (Buildings.ContainsByPredicate([Collection](const FSupportBuilding& Building) { return Building.Component == Collection; }))
+	{
+		return;
+	}
+
+	FSupportBuilding& Building = Buildings.AddDefaulted_GetRef();
+	Building.Component = Collection;
+	Building.Graph = Graph;
+	Building.Broken.Init(false, Graph->Nodes.Num());
+	Building.TransformNodes.Init(INDEX_NONE, Collection->GetRestCollection()->NumElements(FGeometryCollection::TransformGroup));
+
+	for (int32 NodeIndex = 0; NodeIndex < Graph->Nodes.Num(); NodeIndex++)
+	{
+		int32 TransformIndex = Graph->Nodes[NodeIndex].TransformIndex;
+		if (Building.TransformNodes.IsValidIndex(TransformIndex))
+		{
+			Building.TransformNodes[TransformIndex] = NodeIndex;
+		}
+	}
+
+	Graphs.AddUnique(Graph);
+
+	Collection->SetNotifyBreaks(true);
+	Collection->OnChaosBreakEvent.AddUniqueDynamic(this, &UDestructibleSupportSubsystem::HandleBreak);
+}
+
+void UDestructibleSupportSubsystem::UnregisterBuilding(UGeometryCollectionComponent* Collection)
+{
+	if (Collection == nullptr)
+	{
+		return;
+	}
+
+	Collection->OnChaosBreakEvent.RemoveDynamic(this, &UDestructibleSupportSubsystem::HandleBreak);
+
+	// Forgotten right away, and removed along with its graph once no evaluation refers to it
+	for (FSupportBuilding& Building : Buildings)
+	{
+		if (Building.Component.Get() == Collection)
+		{
+			Building.Component.Reset();
+			Building.NewlyBroken.Reset();
+		}
+	}
+
+	RemoveReleasedBuildings();
+}
+
+void UDestructibleSupportSubsystem::RemoveReleasedBuildings()
+{
+	if (PendingEvaluation.IsValid())
+	{
+		return;
+	}
+
+	int32 NumRemoved = Buildings.RemoveAll([](const FSupportBuilding& Building) { return !Building.Component.IsValid(); });
+	if (NumRemoved == 0)
+	{
+		return;
+	}
+
+	// Graphs no building uses anymore are let go
+	Graphs.Reset();
+	for (const FSupportBuilding& Building : Buildings)
+	{
+		Graphs.AddUnique(Building.Graph);
+	}
+}
+
+void UDestructibleSupportSubsystem::HandleBreak(const FChaosBreakEvent& BreakEvent)
+{
+	FSupportBuilding* Building = Buildings.FindByPredicate([&BreakEvent](const FSupportBuilding& Candidate)
+	{
+		return Candidate.Component.Get() == BreakEvent.Component;
+	});
+
+	if (Building == nullptr || !Building->TransformNodes.IsValidIndex(BreakEvent.Index))
+	{
+		return;
+	}
+
+	// A cluster broken off takes every piece under it away from the building
+	TSharedPtr<FGeometryCollection, ESPMode::ThreadSafe> RestCollection = Building->Component->GetRestCollection()->GetGeometryCollection();
+
+	TArray<int32, TInlineAllocator<16>> Transforms;
+	Transforms.Add(BreakEvent.Index);
+
+	while (Transforms.Num() > 0)
+	{
+		int32 TransformIndex = Transforms.Pop(false);
+
+		int32 NodeIndex = Building->TransformNodes[TransformIndex];
+		if (NodeIndex != INDEX_NONE && !Building->Broken[NodeIndex])
+		{
+			Building->Broken[NodeIndex] = true;
+			Building->NewlyBroken.Add(NodeIndex);
+			BrokenNodes++;
+		}
+
+		if (RestCollection.IsValid())
+		{
+			Transforms.Append(RestCollection->Children[TransformIndex].Array());
+		}
+	}
+}
+
+void UDestructibleSupportSubsystem::LaunchEvaluation()
+{
+	TArray<FSupportEvaluation> Inputs;
+
+	for (int32 BuildingIndex = 0; BuildingIndex < Buildings.Num(); BuildingIndex++)
+	{
+		FSupportBuilding& Building = Buildings[BuildingIndex];
+		if (Building.NewlyBroken.Num() == 0)
+		{
+			continue;
+		}
+
+		if (!Building.Component.IsValid())
+		{
+			Building.NewlyBroken.Reset();
+			continue;
+		}
+
+		FSupportEvaluation& Input = Inputs.AddDefaulted_GetRef();
+		Input.BuildingIndex = BuildingIndex;
+		Input.Graph = Building.Graph;
+		Input.Broken = Building.Broken;
+
+		// Support can only have been lost next to the nodes broken since the last evaluation
+		for (int32 NodeIndex : Building.NewlyBroken)
+		{
+			for (int32 Neighbour : Building.Graph->GetNeighbours(NodeIndex))
+			{
+				if (!Building.Broken[Neighbour])
+				{
+					Input.Seeds.AddUnique(Neighbour);
+				}
+			}
+		}
+
+		Building.NewlyBroken.Reset();
+	}
+
+	if (Inputs.Num() == 0)
+	{
+		return;
+	}
+
+	Evaluations++;
+
+	PendingEvaluation = Async(EAsyncExecution::ThreadPool, [Inputs = MoveTemp(Inputs)]() mutable
+	{
+		SCOPE_CYCLE_COUNTER(STAT_DestructibleSupportEvaluate);
+
+		for (FSupportEvaluation& Input : Inputs)
+		{
+			Evaluate(Input);
+		}
+
+		return MoveTemp(Inputs);
+	});
+}
+
+void UDestructibleSupportSubsystem::Evaluate(FSupportEvaluation& Evaluation)
+{
+	const UDestructibleSupportGraph* Graph = Evaluation.Graph;
+	int32 NumNodes = Graph->Nodes.Num();
+
+	TBitArray<> Checked(false, NumNodes);
+	TBitArray<> Supported(false, NumNodes);
+
+	TArray<int32> Stack;
+	TArray<int32> Region;
+	TArray<int32, TInlineAllocator<16>> Neighbours;
+
+	// Nodes the bake found no path to an anchor from sort last
+	auto AnchorDistance = [Graph](int32 NodeIndex)
+	{
+		int32 Distance = Graph->Nodes[NodeIndex].AnchorDistance;
+		return Distance == INDEX_NONE ? MAX_int32 : Distance;
+	};
+
+	for (int32 Seed : Evaluation.Seeds)
+	{
+		if (Evaluation.Broken[Seed] || Checked[Seed])
+		{
+			continue;
+		}
+
+		// Walk towards the anchors first, so a supported region is usually left after a handful of nodes
+		// and only a region cut off from every anchor is walked whole
+		bool bSupported = false;
+
+		Region.Reset();
+		Stack.Reset();
+		Stack.Add(Seed);
+		Checked[Seed] = true;
+
+		while (Stack.Num() > 0)
+		{
+			int32 NodeIndex = Stack.Pop(false);
+			Region.Add(NodeIndex);
+
+			if (Graph->IsAnchor(NodeIndex) || Supported[NodeIndex])
+			{
+				bSupported = true;
+				break;
+			}
+
+			Neighbours.Reset();
+			for (int32 Neighbour : Graph->GetNeighbours(NodeIndex))
+			{
+				if (Evaluation.Broken[Neighbour])
+				{
+					continue;
+				}
+
+				// Regions proved supported by an earlier seed are checked already, but reaching one is reaching support
+				if (Supported[Neighbour])
+				{
+					bSupported = true;
+					break;
+				}
+
+				if (!Checked[Neighbour])
+				{
+					Checked[Neighbour] = true;
+					Neighbours.Add(Neighbour);
+				}
+			}
+
+			if (bSupported)
+			{
+				// Neighbours checked before support was found are connected to it as well
+				Stack.Append(Neighbours);
+				break;
+			}
+
+			// The nearest to an anchor is pushed last and popped next
+			Neighbours.Sort([&AnchorDistance](int32 A, int32 B) { return AnchorDistance(A) > AnchorDistance(B); });
+			Stack.Append(Neighbours);
+		}
+
+		Evaluation.Visited += Region.Num();
+
+		if (bSupported)
+		{
+			// Everything reached from the seed is connected to the support found
+			for (int32 NodeIndex : Region)
+			{
+				Supported[NodeIndex] = true;
+			}
+
+			for (int32 NodeIndex : Stack)
+			{
+				Supported[NodeIndex] = true;
+			}
+		}
+		else
+		{
+			Evaluation.Unsupported.Append(Region);
+		}
+	}
+}
+
+void UDestructibleSupportSubsystem::ApplyEvaluation(TArray<FSupportEvaluation>& Finished)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DestructibleSupportApply);
+
+	UFlightFieldSubsystem* Fields = GetWorld()->GetSubsystem<UFlightFieldSubsystem>();
+	float CollapseStrain = CVarFlightSupportCollapseStrain.GetValueOnGameThread();
+
+	for (FSupportEvaluation& Evaluation : Finished)
+	{
+		VisitedNodes += Evaluation.Visited;
+
+		if (!Buildings.IsValidIndex(Evaluation.BuildingIndex))
+		{
+			continue;
+		}
+
+		FSupportBuilding& Building = Buildings[Evaluation.BuildingIndex];
+		UGeometryCollectionComponent* Component = Building.Component.Get();
+		if (Component == nullptr)
+		{
+			continue;
+		}
+
+		const FTransform& ComponentTransform = Component->GetComponentTransform();
+
+		for (int32 NodeIndex : Evaluation.Unsupported)
+		{
+			// Nodes broken off while the evaluation ran need no collapse
+			if (Building.Broken[NodeIndex])
+			{
+				continue;
+			}
+
+			Building.Broken[NodeIndex] = true;
+			Building.CollapsedNodes++;
+			CollapsedNodes++;
+
+			// Every collapse of every building joins the strain field of the frame
+			if (Fields != nullptr)
+			{
+				const FDestructibleSupportNode& Node = Building.Graph->Nodes[NodeIndex];
+				Fields->QueueCollapse(ComponentTransform.TransformPosition(Node.Center), Node.Radius * ComponentTransform.GetMaximumAxisScale(), CollapseStrain);
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UDestructibleSupportSubsystem::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Destructible support: %d buildings, %d evaluations visiting %d nodes, %d nodes broken off, %d collapsed%s"),
+		Buildings.Num(), Evaluations, VisitedNodes, BrokenNodes, CollapsedNodes, PendingEvaluation.IsValid() ? TEXT(", evaluating") : TEXT(""));
+
+	for (const FSupportBuilding& Building : Buildings)
+	{
+		if (Building.Component.IsValid())
+		{
+			UE_LOG(LogTemp, Log, TEXT("  %-40s %d nodes  %d down  %d collapsed"), *Building.Component->GetOwner()->GetName(),
+				Building.Graph->Nodes.Num(), Building.Broken.CountSetBits(), Building.CollapsedNodes);
+		}
+	}
+}
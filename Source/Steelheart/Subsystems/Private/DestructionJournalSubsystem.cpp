@@ -0,0 +1,684 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/DestructionJournalSubsystem.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GeometryCollection/GeometryCollectionAlgo.h"
+#include "GeometryCollection/GeometryCollectionComponent.h"
+#include "GeometryCollection/GeometryCollectionObject.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/DestructibleDebrisSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Destruction Journal Restore"), STAT_DestructionJournalRestore, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<bool> CVarFlightJournalEnabled(
+	TEXT("Flight.Journal.Enabled"),
+	true,
+	TEXT("Record the destruction of flight impacts and restore it when the destructibles stream back in."));
+
+static TAutoConsoleVariable<int32> CVarFlightJournalMapThreshold(
+	TEXT("Flight.Journal.MapThreshold"),
+	1024 * 1024,
+	TEXT("Journal files of at least this many bytes are read through a memory mapped file instead of being copied into memory."));
+
+static TAutoConsoleVariable<float> CVarFlightJournalCompactRatio(
+	TEXT("Flight.Journal.CompactRatio"),
+	2.f,
+	TEXT("The journal file is rewritten with only the latest state of every piece once it grows past this many times its compacted size."));
+
+static UDestructionJournalSubsystem* GetJournal(UWorld* World)
+{
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetSubsystem<UDestructionJournalSubsystem>() : nullptr;
+}
+
+static FAutoConsoleCommandWithWorld FlightJournalReportCommand(
+	TEXT("Flight.Journal.Report"),
+	TEXT("Log the destruction journal along with the records loaded, made and restored"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UDestructionJournalSubsystem* Journal = GetJournal(World))
+		{
+			Journal->LogReport();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld FlightJournalFlushCommand(
+	TEXT("Flight.Journal.Flush"),
+	TEXT("Append the destruction recorded since the last flush to the journal file"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UDestructionJournalSubsystem* Journal = GetJournal(World))
+		{
+			Journal->Flush();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld FlightJournalCompactCommand(
+	TEXT("Flight.Journal.Compact"),
+	TEXT("Rewrite the journal file with only the latest state of every destructible"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UDestructionJournalSubsystem* Journal = GetJournal(World))
+		{
+			Journal->Compact();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld FlightJournalClearCommand(
+	TEXT("Flight.Journal.Clear"),
+	TEXT("Forget the destruction recorded in the open save slot and delete its journal file"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UDestructionJournalSubsystem* Journal = GetJournal(World))
+		{
+			Journal->Clear();
+		}
+	}));
+
+// Journal file layout: a header, then records appended on every flush, each starting with its type
+static constexpr uint32 JournalMagic = 0x4A444853;
+static constexpr uint32 JournalVersion = 1;
+
+static constexpr uint8 JournalImpactRecord = 1;
+static constexpr uint8 JournalPieceRecord = 2;
+
+// Impact count of a destructible, written in place of its impact records when the journal is compacted
+static constexpr uint8 JournalTargetRecord = 3;
+
+// Flags of a piece record
+static constexpr uint8 JournalPieceRemoved = 1 << 0;
+static constexpr uint8 JournalPieceWide = 1 << 1;
+
+// Piece positions are stored in steps of this size as 16 bit integers, or as floats when out of range
+static constexpr float JournalPositionStep = 0.25f;
+
+// Scale given to removed pieces, small enough to vanish while keeping their collision shape valid
+static constexpr float JournalRemovedScale = 0.001f;
+
+// Slot recorded to outside of play in editor when none is given with -JournalSlot= on the command line
+static const TCHAR* JournalDefaultSlot = TEXT("Default");
+
+// Journals smaller than this are never compacted while flushing
+static constexpr int64 JournalCompactMinSize = 64 * 1024;
+
+// Transform of a piece in the space of the collection, resolving the parents first
+static const FTransform& ResolveGlobal(int32 Index, const TManagedArray<FTransform>& Locals, const TManagedArray<int32>& Parents,
+	TArray<FTransform>& Globals, TBitArray<>& Resolved)
+{
+	if (!Resolved[Index])
+	{
+		int32 Parent = Parents[Index];
+		Globals[Index] = Parent == INDEX_NONE ? Locals[Index] : Locals[Index] * ResolveGlobal(Parent, Locals, Parents, Globals, Resolved);
+		Resolved[Index] = true;
+	}
+
+	return Globals[Index];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UDestructionJournalSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Play in editor sessions start over in a slot of their own instead of carrying the destruction of the last one
+	const FWorldContext* WorldContext = GetGameInstance()->GetWorldContext();
+	if (WorldContext != nullptr && WorldContext->WorldType == EWorldType::PIE)
+	{
+		OpenSlot(FString::Printf(TEXT("PIE_%d"), WorldContext->PIEInstance), true);
+	}
+	else
+	{
+		FString InitialSlot = JournalDefaultSlot;
+		FParse::Value(FCommandLine::Get(), TEXT("JournalSlot="), InitialSlot);
+
+		OpenSlot(InitialSlot, FParse::Param(FCommandLine::Get(), TEXT("NewGame")));
+	}
+
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UDestructionJournalSubsystem::HandleLevelRemoved);
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddUObject(this, &UDestructionJournalSubsystem::HandleWorldCleanup);
+}
+
+void UDestructionJournalSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+
+	Flush();
+	FinishWrite();
+
+	Targets.Empty();
+
+	Super::Deinitialize();
+}
+
+void UDestructionJournalSubsystem::HandleLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if (World == nullptr || World->GetGameInstance() != GetGameInstance())
+	{
+		return;
+	}
+
+	// Pieces still moving are recorded where they are, they will not be simulated any further
+	if (UDestructibleDebrisSubsystem* Debris = World->GetSubsystem<UDestructibleDebrisSubsystem>())
+	{
+		Debris->RecordMovingPieces(Level);
+	}
+
+	Flush();
+}
+
+void UDestructionJournalSubsystem::HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	HandleLevelRemoved(nullptr, World);
+}
+
+void UDestructionJournalSubsystem::OpenSlot(const FString& InSlotName, bool bNewGame)
+{
+	// The new slot may read or delete the very file being written
+	if (!SlotName.IsEmpty())
+	{
+		Flush();
+		FinishWrite();
+	}
+
+	Targets.Empty();
+	PendingRecords.Empty();
+
+	SlotName = FPaths::MakeValidFileName(InSlotName);
+	FileSize = 0;
+	CompactedSize = 0;
+	bLoadedMapped = false;
+	LoadedRecords = 0;
+
+	if (bNewGame)
+	{
+		Clear();
+	}
+	else
+	{
+		Load();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Record Functions
+
+uint32 UDestructionJournalSubsystem::GetTargetId(const AActor* Destructible)
+{
+	return FCrc::StrCrc32(*UWorld::RemovePIEPrefix(Destructible->GetPathName()));
+}
+
+void UDestructionJournalSubsystem::RecordImpact(const FVector& Location, float Radius, float StrainMagnitude, float VelocityMagnitude, const TArray<AActor*>& ImpactTargets)
+{
+	if (!CVarFlightJournalEnabled.GetValueOnGameThread())
+	{
+		return;
+	}
+
+	FMemoryWriter Writer(PendingRecords, false, true);
+
+	uint8 RecordType = JournalImpactRecord;
+	FVector3f ImpactLocation(Location);
+	uint16 NumTargets = (uint16)FMath::Min(ImpactTargets.Num(), (int32)MAX_uint16);
+
+	Writer << RecordType << ImpactLocation << Radius << StrainMagnitude << VelocityMagnitude << NumTargets;
+
+	for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++)
+	{
+		uint32 TargetId = GetTargetId(ImpactTargets[TargetIndex]);
+		Writer << TargetId;
+
+		Targets.FindOrAdd(TargetId).Impacts++;
+	}
+
+	RecordedImpacts++;
+}
+
+void UDestructionJournalSubsystem::RecordPiece(const UGeometryCollectionComponent* Collection, int32 PieceIndex, const FTransform& PieceTransform, bool bRemoved)
+{
+	if (!CVarFlightJournalEnabled.GetValueOnGameThread() || Collection->GetOwner() == nullptr || PieceIndex > MAX_uint16)
+	{
+		return;
+	}
+
+	uint32 TargetId = GetTargetId(Collection->GetOwner());
+
+	FJournalPiece& Piece = Targets.FindOrAdd(TargetId).Pieces.FindOrAdd(PieceIndex);
+	Piece.Position = FVector3f(PieceTransform.GetLocation());
+	Piece.Rotation = FQuat4f(PieceTransform.GetRotation().GetNormalized());
+	Piece.bRemoved = bRemoved;
+
+	// The rotation is stored without its real part, which is kept positive so it can be rebuilt from the others
+	if (Piece.Rotation.W < 0.f)
+	{
+		Piece.Rotation = FQuat4f(-Piece.Rotation.X, -Piece.Rotation.Y, -Piece.Rotation.Z, -Piece.Rotation.W);
+	}
+
+	FMemoryWriter Writer(PendingRecords, false, true);
+	WritePieceRecord(Writer, TargetId, PieceIndex, Piece);
+
+	RecordedPieces++;
+}
+
+void UDestructionJournalSubsystem::WritePieceRecord(FArchive& Writer, uint32 TargetId, int32 PieceIndex, const FJournalPiece& Piece)
+{
+	FIntVector Steps(
+		FMath::RoundToInt(Piece.Position.X / JournalPositionStep),
+		FMath::RoundToInt(Piece.Position.Y / JournalPositionStep),
+		FMath::RoundToInt(Piece.Position.Z / JournalPositionStep));
+
+	bool bWide = FMath::Abs(Steps.X) > MAX_int16 || FMath::Abs(Steps.Y) > MAX_int16 || FMath::Abs(Steps.Z) > MAX_int16;
+
+	uint8 RecordType = JournalPieceRecord;
+	uint16 Index = (uint16)PieceIndex;
+	uint8 Flags = (Piece.bRemoved ? JournalPieceRemoved : 0) | (bWide ? JournalPieceWide : 0);
+
+	Writer << RecordType << TargetId << Index << Flags;
+
+	// Removed pieces only need to be hidden at their rest place
+	if (!Piece.bRemoved)
+	{
+		if (bWide)
+		{
+			FVector3f Position = Piece.Position;
+			Writer << Position;
+		}
+		else
+		{
+			int16 X = (int16)Steps.X, Y = (int16)Steps.Y, Z = (int16)Steps.Z;
+			Writer << X << Y << Z;
+		}
+
+		int16 RotationX = (int16)FMath::RoundToInt(Piece.Rotation.X * MAX_int16);
+		int16 RotationY = (int16)FMath::RoundToInt(Piece.Rotation.Y * MAX_int16);
+		int16 RotationZ = (int16)FMath::RoundToInt(Piece.Rotation.Z * MAX_int16);
+		Writer << RotationX << RotationY << RotationZ;
+	}
+}
+
+bool UDestructionJournalSubsystem::HasRecord(const AActor* Destructible) const
+{
+	const FJournalTarget* Target = Destructible != nullptr ? Targets.Find(GetTargetId(Destructible)) : nullptr;
+	return Target != nullptr && Target->Pieces.Num() > 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Restore Functions
+
+bool UDestructionJournalSubsystem::RestoreCollection(UGeometryCollectionComponent* Collection)
+{
+	if (Collection == nullptr || Collection->GetOwner() == nullptr || Collection->GetRestCollection() == nullptr)
+	{
+		return false;
+	}
+
+	const FJournalTarget* Target = Targets.Find(GetTargetId(Collection->GetOwner()));
+	if (Target == nullptr || Target->Pieces.Num() == 0)
+	{
+		return false;
+	}
+
+	TSharedPtr<FGeometryCollection, ESPMode::ThreadSafe> RestCollection = Collection->GetRestCollection()->GetGeometryCollection();
+	if (!RestCollection.IsValid())
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DestructionJournalRestore);
+
+	const TManagedArray<FTransform>& RestLocals = RestCollection->Transform;
+	const TManagedArray<int32>& Parents = RestCollection->Parent;
+	int32 NumPieces = RestLocals.Num();
+
+	// Recorded pieces take the place of their rest transform, the pieces clustered under them follow
+	TArray<FTransform> Globals;
+	Globals.SetNum(NumPieces);
+	TBitArray<> Resolved(false, NumPieces);
+
+	for (const TPair<int32, FJournalPiece>& Piece : Target->Pieces)
+	{
+		if (Piece.Key < NumPieces && !Piece.Value.bRemoved)
+		{
+			Globals[Piece.Key] = FTransform(FQuat(Piece.Value.Rotation), FVector(Piece.Value.Position));
+			Resolved[Piece.Key] = true;
+		}
+	}
+
+	for (const TPair<int32, FJournalPiece>& Piece : Target->Pieces)
+	{
+		if (Piece.Key < NumPieces && Piece.Value.bRemoved)
+		{
+			FTransform Removed = ResolveGlobal(Piece.Key, RestLocals, Parents, Globals, Resolved);
+			Removed.SetScale3D(FVector(JournalRemovedScale));
+			Globals[Piece.Key] = Removed;
+		}
+	}
+
+	TArray<FTransform> Locals = RestLocals.GetConstArray();
+	int32 Restored = 0;
+
+	for (const TPair<int32, FJournalPiece>& Piece : Target->Pieces)
+	{
+		if (Piece.Key < NumPieces)
+		{
+			int32 Parent = Parents[Piece.Key];
+			Locals[Piece.Key] = Parent == INDEX_NONE ? Globals[Piece.Key]
+				: Globals[Piece.Key].GetRelativeTransform(ResolveGlobal(Parent, RestLocals, Parents, Globals, Resolved));
+			Restored++;
+		}
+	}
+
+	Collection->SetRestState(MoveTemp(Locals));
+
+	// Collections already simulating pick the new rest state up with a new physics state
+	if (Collection->IsPhysicsStateCreated())
+	{
+		Collection->RecreatePhysicsState();
+	}
+
+	RestoredCollections++;
+	RestoredPieces += Restored;
+
+	return Restored > 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// File Functions
+
+FString UDestructionJournalSubsystem::GetJournalPath() const
+{
+	return FPaths::ProjectSavedDir() / TEXT("Destruction") / (SlotName + TEXT(".bin"));
+}
+
+void UDestructionJournalSubsystem::Load()
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	FString Path = GetJournalPath();
+
+	FileSize = PlatformFile.FileSize(*Path);
+	if (FileSize <= 0)
+	{
+		FileSize = 0;
+		return;
+	}
+
+	// Large journals are decoded straight from the mapped pages instead of a copy of the whole file
+	if (FileSize >= CVarFlightJournalMapThreshold.GetValueOnGameThread())
+	{
+		TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Path));
+		TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile.IsValid() ? MappedFile->MapRegion(0, FileSize) : nullptr);
+
+		if (MappedRegion.IsValid())
+		{
+			ReadRecords(MakeArrayView(MappedRegion->GetMappedPtr(), (int32)MappedRegion->GetMappedSize()));
+			bLoadedMapped = true;
+		}
+	}
+
+	if (!bLoadedMapped)
+	{
+		TArray<uint8> Bytes;
+		if (FFileHelper::LoadFileToArray(Bytes, *Path))
+		{
+			ReadRecords(Bytes);
+		}
+	}
+
+	// Journals holding more records than their latest state needs are rewritten right away, the mapped file is closed by now
+	int32 LatestRecords = 0;
+	for (const TPair<uint32, FJournalTarget>& Target : Targets)
+	{
+		LatestRecords += (Target.Value.Impacts > 0 ? 1 : 0) + Target.Value.Pieces.Num();
+	}
+
+	if (LoadedRecords > LatestRecords)
+	{
+		Compact();
+	}
+	else
+	{
+		CompactedSize = FileSize;
+	}
+}
+
+void UDestructionJournalSubsystem::ReadRecords(TArrayView<const uint8> Bytes)
+{
+	FMemoryReaderView Reader(Bytes);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+
+	if (Magic != JournalMagic || Version != JournalVersion)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Destruction journal: %s is not a journal of version %u, ignored."), *GetJournalPath(), JournalVersion);
+		return;
+	}
+
+	while (!Reader.AtEnd() && !Reader.IsError())
+	{
+		uint8 RecordType = 0;
+		Reader << RecordType;
+
+		if (RecordType == JournalImpactRecord)
+		{
+			FVector3f Location;
+			float Radius = 0.f, StrainMagnitude = 0.f, VelocityMagnitude = 0.f;
+			uint16 NumTargets = 0;
+			Reader << Location << Radius << StrainMagnitude << VelocityMagnitude << NumTargets;
+
+			for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++)
+			{
+				uint32 TargetId = 0;
+				Reader << TargetId;
+				Targets.FindOrAdd(TargetId).Impacts++;
+			}
+		}
+		else if (RecordType == JournalTargetRecord)
+		{
+			uint32 TargetId = 0;
+			int32 Impacts = 0;
+			Reader << TargetId << Impacts;
+			Targets.FindOrAdd(TargetId).Impacts += Impacts;
+		}
+		else if (RecordType == JournalPieceRecord)
+		{
+			uint32 TargetId = 0;
+			uint16 Index = 0;
+			uint8 Flags = 0;
+			Reader << TargetId << Index << Flags;
+
+			FJournalPiece& Piece = Targets.FindOrAdd(TargetId).Pieces.FindOrAdd(Index);
+			Piece.bRemoved = (Flags & JournalPieceRemoved) != 0;
+
+			if (!Piece.bRemoved)
+			{
+				if (Flags & JournalPieceWide)
+				{
+					Reader << Piece.Position;
+				}
+				else
+				{
+					int16 X = 0, Y = 0, Z = 0;
+					Reader << X << Y << Z;
+					Piece.Position = FVector3f(X, Y, Z) * JournalPositionStep;
+				}
+
+				int16 RotationX = 0, RotationY = 0, RotationZ = 0;
+				Reader << RotationX << RotationY << RotationZ;
+
+				FVector3f Imaginary = FVector3f(RotationX, RotationY, RotationZ) / MAX_int16;
+				float Real = FMath::Sqrt(FMath::Max(1.f - Imaginary.SizeSquared(), 0.f));
+				Piece.Rotation = FQuat4f(Imaginary.X, Imaginary.Y, Imaginary.Z, Real).GetNormalized();
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Destruction journal: unknown record type %u, the rest of the journal is ignored."), RecordType);
+			break;
+		}
+
+		LoadedRecords++;
+	}
+}
+
+void UDestructionJournalSubsystem::Flush()
+{
+	// One write at a time, so records reach the file in the order they were made
+	FinishWrite();
+
+	if (PendingRecords.Num() == 0)
+	{
+		return;
+	}
+
+	// Journals grown well past their compacted size are rewritten instead of appended to
+	int64 CompactThreshold = FMath::Max((int64)(CompactedSize * CVarFlightJournalCompactRatio.GetValueOnGameThread()), JournalCompactMinSize);
+	if (FileSize + PendingRecords.Num() > CompactThreshold)
+	{
+		Compact();
+		return;
+	}
+
+	// Flushes come with levels streaming out, the game thread only hands the records over
+	WritingRecords = MoveTemp(PendingRecords);
+	bWritingCompacted = false;
+
+	PendingWrite = Async(EAsyncExecution::ThreadPool, [Path = GetJournalPath(), Records = WritingRecords]()
+	{
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+
+		if (!FPlatformFileManager::Get().GetPlatformFile().FileExists(*Path))
+		{
+			uint32 Magic = JournalMagic;
+			uint32 Version = JournalVersion;
+			Writer << Magic << Version;
+		}
+
+		Bytes.Append(Records);
+
+		return FFileHelper::SaveArrayToFile(Bytes, *Path, &IFileManager::Get(), FILEWRITE_Append) ? (int64)Bytes.Num() : (int64)INDEX_NONE;
+	});
+}
+
+void UDestructionJournalSubsystem::Compact()
+{
+	FinishWrite();
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = JournalMagic;
+	uint32 Version = JournalVersion;
+	Writer << Magic << Version;
+
+	// The state already holds the records waiting for a flush
+	for (const TPair<uint32, FJournalTarget>& Target : Targets)
+	{
+		uint32 TargetId = Target.Key;
+
+		if (Target.Value.Impacts > 0)
+		{
+			uint8 RecordType = JournalTargetRecord;
+			int32 Impacts = Target.Value.Impacts;
+			Writer << RecordType << TargetId << Impacts;
+		}
+
+		for (const TPair<int32, FJournalPiece>& Piece : Target.Value.Pieces)
+		{
+			WritePieceRecord(Writer, TargetId, Piece.Key, Piece.Value);
+		}
+	}
+
+	WritingRecords = MoveTemp(PendingRecords);
+	bWritingCompacted = true;
+
+	// Written aside first so a failed write leaves the previous journal in place
+	PendingWrite = Async(EAsyncExecution::ThreadPool, [Path = GetJournalPath(), Bytes = MoveTemp(Bytes)]()
+	{
+		FString TempPath = Path + TEXT(".tmp");
+		bool bWritten = FFileHelper::SaveArrayToFile(Bytes, *TempPath) && IFileManager::Get().Move(*Path, *TempPath, true, true);
+
+		return bWritten ? (int64)Bytes.Num() : (int64)INDEX_NONE;
+	});
+}
+
+void UDestructionJournalSubsystem::FinishWrite()
+{
+	if (!PendingWrite.IsValid())
+	{
+		return;
+	}
+
+	int64 Written = PendingWrite.Get();
+	PendingWrite = TFuture<int64>();
+
+	if (Written == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Destruction journal: could not %s %s, the records are kept for the next flush."),
+			bWritingCompacted ? TEXT("rewrite") : TEXT("append to"), *GetJournalPath());
+
+		PendingRecords.Insert(WritingRecords, 0);
+	}
+	else if (bWritingCompacted)
+	{
+		FileSize = Written;
+		CompactedSize = Written;
+		Compactions++;
+	}
+	else
+	{
+		FileSize += Written;
+	}
+
+	WritingRecords.Reset();
+}
+
+void UDestructionJournalSubsystem::Clear()
+{
+	FinishWrite();
+
+	Targets.Empty();
+	PendingRecords.Empty();
+
+	IFileManager::Get().Delete(*GetJournalPath(), false, false, true);
+	FileSize = 0;
+	CompactedSize = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UDestructionJournalSubsystem::LogReport() const
+{
+	int32 RecordedTargetPieces = 0;
+	for (const TPair<uint32, FJournalTarget>& Target : Targets)
+	{
+		RecordedTargetPieces += Target.Value.Pieces.Num();
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Destruction journal of slot %s: %.1f KB on disk (%s), %d bytes waiting for the next flush"),
+		*SlotName, FileSize / 1024.f, bLoadedMapped ? TEXT("loaded mapped") : TEXT("loaded copied"), PendingRecords.Num());
+
+	UE_LOG(LogTemp, Log, TEXT("  %.1f KB when last compacted, %d compactions this session"), CompactedSize / 1024.f, Compactions);
+
+	UE_LOG(LogTemp, Log, TEXT("  %d destructibles with %d recorded pieces, %d records loaded"),
+		Targets.Num(), RecordedTargetPieces, LoadedRecords);
+
+	UE_LOG(LogTemp, Log, TEXT("  This session: %d impacts and %d pieces recorded, %d collections restored with %d pieces"),
+		RecordedImpacts, RecordedPieces, RestoredCollections, RestoredPieces);
+}
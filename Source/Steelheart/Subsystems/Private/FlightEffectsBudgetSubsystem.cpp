@@ -0,0 +1,461 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/FlightEffectsBudgetSubsystem.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+#include "NiagaraTypes.h"
+#include "Steelheart/Components/Public/FlightEffectsComponent.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/FlightTrailSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight FX Budget Update"), STAT_FlightFXBudgetUpdate, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight FX Full"), STAT_FlightFXFull, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight FX Reduced"), STAT_FlightFXReduced, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight FX Culled"), STAT_FlightFXCulled, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<bool> CVarFlightFXBudgetEnabled(
+	TEXT("Flight.FX.Budget.Enabled"),
+	true,
+	TEXT("Rank the active flight effects and enforce the per type caps. When disabled, every effect runs at full quality."));
+
+static TAutoConsoleVariable<float> CVarFlightFXBudgetInterval(
+	TEXT("Flight.FX.Budget.Interval"),
+	0.1f,
+	TEXT("Seconds between two rankings of the active flight effects."));
+
+static TAutoConsoleVariable<int32> CVarFlightFXMaxDashTrails(
+	TEXT("Flight.FX.MaxDashTrails"),
+	6,
+	TEXT("Number of dash trails allowed to run at full quality."));
+
+static TAutoConsoleVariable<int32> CVarFlightFXMaxHover(
+	TEXT("Flight.FX.MaxHover"),
+	6,
+	TEXT("Number of hover and dodge effects allowed to run at full quality."));
+
+static TAutoConsoleVariable<int32> CVarFlightFXMaxSonicBooms(
+	TEXT("Flight.FX.MaxSonicBooms"),
+	4,
+	TEXT("Number of sonic booms allowed to run at full quality."));
+
+static TAutoConsoleVariable<int32> CVarFlightFXMaxDiveTrails(
+	TEXT("Flight.FX.MaxDiveTrails"),
+	4,
+	TEXT("Number of dive trails allowed to run at full quality."));
+
+static TAutoConsoleVariable<int32> CVarFlightFXMaxTakeoffCharges(
+	TEXT("Flight.FX.MaxTakeoffCharges"),
+	4,
+	TEXT("Number of takeoff charges allowed to run at full quality."));
+
+static TAutoConsoleVariable<float> CVarFlightFXReducedCapScale(
+	TEXT("Flight.FX.ReducedCapScale"),
+	1.f,
+	TEXT("Number of instances allowed at reduced quality past the full quality cap, as a multiple of that cap. The rest are culled."));
+
+static TAutoConsoleVariable<float> CVarFlightFXReducedSpawnRate(
+	TEXT("Flight.FX.ReducedSpawnRate"),
+	0.35f,
+	TEXT("Value of the User.SpawnRateScale parameter of reduced quality effects."));
+
+static TAutoConsoleVariable<float> CVarFlightFXCullScreenSize(
+	TEXT("Flight.FX.CullScreenSize"),
+	0.005f,
+	TEXT("Fraction of the screen below which an effect is culled regardless of the caps."));
+
+static TAutoConsoleVariable<float> CVarFlightFXHysteresisTime(
+	TEXT("Flight.FX.HysteresisTime"),
+	0.5f,
+	TEXT("Seconds an effect must stay ranked into another tier before it switches to it."));
+
+static TAutoConsoleVariable<float> CVarFlightFXHysteresisBias(
+	TEXT("Flight.FX.HysteresisBias"),
+	1.2f,
+	TEXT("Score multiplier applied once per tier an effect currently holds above culled, so incumbents are not displaced by near ties."));
+
+static FAutoConsoleCommandWithWorld FlightFXReportCommand(
+	TEXT("Flight.FX.Report"),
+	TEXT("Log the tier of every budgeted flight effect"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UFlightEffectsBudgetSubsystem* EffectsBudget = World ? World->GetSubsystem<UFlightEffectsBudgetSubsystem>() : nullptr)
+		{
+			EffectsBudget->LogReport();
+		}
+	}));
+
+static int32 GetFullQualityCap(EFlightEffectType Type)
+{
+	switch (Type)
+	{
+	case EFlightEffectType::DashTrail:
+		return CVarFlightFXMaxDashTrails.GetValueOnGameThread();
+	case EFlightEffectType::Hover:
+		return CVarFlightFXMaxHover.GetValueOnGameThread();
+	case EFlightEffectType::SonicBoom:
+		return CVarFlightFXMaxSonicBooms.GetValueOnGameThread();
+	case EFlightEffectType::DiveTrail:
+		return CVarFlightFXMaxDiveTrails.GetValueOnGameThread();
+	case EFlightEffectType::TakeoffCharge:
+		return CVarFlightFXMaxTakeoffCharges.GetValueOnGameThread();
+	default:
+		return 0;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UFlightEffectsBudgetSubsystem::Deinitialize()
+{
+	RegisteredEffects.Empty();
+	EffectStates.Empty();
+	SharedTrails.Reset();
+
+	Super::Deinitialize();
+}
+
+void UFlightEffectsBudgetSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate >= CVarFlightFXBudgetInterval.GetValueOnGameThread())
+	{
+		TimeSinceUpdate = 0.f;
+		UpdateBudget();
+	}
+}
+
+TStatId UFlightEffectsBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFlightEffectsBudgetSubsystem, STATGROUP_Steelheart);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Registration Functions
+
+void UFlightEffectsBudgetSubsystem::RegisterEffects(UFlightEffectsComponent* EffectsComponent)
+{
+	RegisteredEffects.AddUnique(EffectsComponent);
+}
+
+void UFlightEffectsBudgetSubsystem::UnregisterEffects(UFlightEffectsComponent* EffectsComponent)
+{
+	RegisteredEffects.RemoveSingleSwap(EffectsComponent);
+}
+
+void UFlightEffectsBudgetSubsystem::RegisterTrails(UFlightTrailSubsystem* TrailSubsystem)
+{
+	SharedTrails = TrailSubsystem;
+	TrailState = FEffectState();
+}
+
+EFlightEffectTier UFlightEffectsBudgetSubsystem::ForgetEffect(USceneComponent* Component)
+{
+	FEffectState State;
+	if (UFXSystemComponent* FXComponent = Cast<UFXSystemComponent>(Component))
+	{
+		if (EffectStates.RemoveAndCopyValue(FXComponent, State) && State.Tier != EFlightEffectTier::Full)
+		{
+			ApplyTier(FXComponent, State, EFlightEffectTier::Full);
+		}
+	}
+
+	return State.Tier;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Budgeting Functions
+
+void UFlightEffectsBudgetSubsystem::UpdateBudget()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightFXBudgetUpdate);
+
+	UpdateCount++;
+
+	bool bBudgetEnabled = CVarFlightFXBudgetEnabled.GetValueOnGameThread();
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	// Gather the active effects of every registered flyer
+	GatheredEffects.Reset();
+	if (bBudgetEnabled && PlayerController != nullptr && PlayerController->PlayerCameraManager != nullptr)
+	{
+		RegisteredEffects.RemoveAllSwap([](const TWeakObjectPtr<UFlightEffectsComponent>& EffectsComponent) { return !EffectsComponent.IsValid(); });
+
+		for (const TWeakObjectPtr<UFlightEffectsComponent>& EffectsComponent : RegisteredEffects)
+		{
+			EffectsComponent->GatherBudgetedEffects(GatheredEffects);
+		}
+	}
+
+	if (GatheredEffects.Num() > 0)
+	{
+		const APlayerCameraManager* CameraManager = PlayerController->PlayerCameraManager;
+		FVector ViewLocation = CameraManager->GetCameraLocation();
+		FVector ViewDirection = CameraManager->GetCameraRotation().Vector();
+		float ViewScale = 1.f / FMath::Tan(FMath::DegreesToRadians(CameraManager->GetFOVAngle() * 0.5f));
+
+		float HysteresisBias = CVarFlightFXHysteresisBias.GetValueOnGameThread();
+		float CullScreenSize = CVarFlightFXCullScreenSize.GetValueOnGameThread();
+
+		for (FFlightBudgetedEffect& Effect : GatheredEffects)
+		{
+			Effect.Score = ScoreEffect(Effect, ViewLocation, ViewDirection, ViewScale);
+
+			// Favour instances already holding a tier so near ties do not swap places every update
+			if (const FEffectState* State = EffectStates.Find(Effect.Component))
+			{
+				Effect.Score *= FMath::Pow(HysteresisBias, 2 - (int32)State->Tier);
+			}
+		}
+
+		// Rank by type, then locally controlled first, then score
+		GatheredEffects.Sort([](const FFlightBudgetedEffect& A, const FFlightBudgetedEffect& B)
+		{
+			if (A.Type != B.Type)
+			{
+				return A.Type < B.Type;
+			}
+
+			if (A.bLocallyControlled != B.bLocallyControlled)
+			{
+				return A.bLocallyControlled;
+			}
+
+			return A.Score > B.Score;
+		});
+
+		float CurrentTime = GetWorld()->GetTimeSeconds();
+		float HysteresisTime = CVarFlightFXHysteresisTime.GetValueOnGameThread();
+		float ReducedCapScale = CVarFlightFXReducedCapScale.GetValueOnGameThread();
+
+		int32 Rank = 0;
+		for (int32 Index = 0; Index < GatheredEffects.Num(); Index++)
+		{
+			const FFlightBudgetedEffect& Effect = GatheredEffects[Index];
+			if (Index > 0 && GatheredEffects[Index - 1].Type != Effect.Type)
+			{
+				Rank = 0;
+			}
+
+			int32 FullCap = FMath::CeilToInt(GetFullQualityCap(Effect.Type) * DetailScale);
+			int32 ReducedCap = FullCap + FMath::CeilToInt(FullCap * ReducedCapScale);
+
+			EFlightEffectTier DesiredTier = EFlightEffectTier::Culled;
+			if (Effect.bLocallyControlled || Rank < FullCap)
+			{
+				DesiredTier = EFlightEffectTier::Full;
+			}
+			else if (Rank < ReducedCap)
+			{
+				DesiredTier = EFlightEffectTier::Reduced;
+			}
+
+			if (!Effect.bLocallyControlled && Effect.Score < CullScreenSize)
+			{
+				DesiredTier = EFlightEffectTier::Culled;
+			}
+
+			Rank++;
+
+			FEffectState* State = EffectStates.Find(Effect.Component);
+			if (State == nullptr)
+			{
+				// Newly activated instances take their tier right away, nothing is on screen to pop yet
+				State = &EffectStates.Add(Effect.Component);
+				State->Type = Effect.Type;
+				State->PendingTier = DesiredTier;
+
+				if (DesiredTier != EFlightEffectTier::Full)
+				{
+					SwitchTier(Effect, *State, DesiredTier);
+				}
+			}
+			else if (DesiredTier == State->Tier)
+			{
+				State->PendingTier = DesiredTier;
+			}
+			else if (DesiredTier != State->PendingTier)
+			{
+				State->PendingTier = DesiredTier;
+				State->PendingSince = CurrentTime;
+			}
+			else if (CurrentTime - State->PendingSince >= HysteresisTime)
+			{
+				SwitchTier(Effect, *State, DesiredTier);
+			}
+
+			State->Score = Effect.Score;
+			State->LastSeenUpdate = UpdateCount;
+		}
+	}
+
+	// Instances that went inactive or left the budget get their full quality back
+	int32 TierCounts[3] = { 0, 0, 0 };
+	for (auto It = EffectStates.CreateIterator(); It; ++It)
+	{
+		if (It.Value().LastSeenUpdate != UpdateCount)
+		{
+			if (UFXSystemComponent* FXComponent = It.Key().Get())
+			{
+				if (It.Value().Tier != EFlightEffectTier::Full)
+				{
+					ApplyTier(FXComponent, It.Value(), EFlightEffectTier::Full);
+				}
+			}
+
+			It.RemoveCurrent();
+		}
+		else
+		{
+			TierCounts[(uint8)It.Value().Tier]++;
+		}
+	}
+
+	UpdateTrailBudget(bBudgetEnabled);
+
+	SET_DWORD_STAT(STAT_FlightFXFull, TierCounts[(uint8)EFlightEffectTier::Full]);
+	SET_DWORD_STAT(STAT_FlightFXReduced, TierCounts[(uint8)EFlightEffectTier::Reduced]);
+	SET_DWORD_STAT(STAT_FlightFXCulled, TierCounts[(uint8)EFlightEffectTier::Culled]);
+}
+
+float UFlightEffectsBudgetSubsystem::ScoreEffect(const FFlightBudgetedEffect& Effect, const FVector& ViewLocation, const FVector& ViewDirection, float ViewScale) const
+{
+	const FBoxSphereBounds& Bounds = Effect.Component->Bounds;
+
+	FVector ToEffect = Bounds.Origin - ViewLocation;
+	float Distance = FMath::Max(ToEffect.Size(), 1.f);
+
+	// Projected radius as a fraction of the screen
+	float ScreenSize = Bounds.SphereRadius * ViewScale / Distance;
+
+	// Effects behind the camera still matter a little, the camera swings around quickly in flight
+	if (FVector::DotProduct(ToEffect, ViewDirection) < -Bounds.SphereRadius)
+	{
+		ScreenSize *= 0.25f;
+	}
+
+	return ScreenSize;
+}
+
+void UFlightEffectsBudgetSubsystem::UpdateTrailBudget(bool bBudgetEnabled)
+{
+	UFlightTrailSubsystem* TrailSubsystem = SharedTrails.Get();
+	UNiagaraComponent* TrailComponent = TrailSubsystem ? TrailSubsystem->GetTrailComponent() : nullptr;
+	if (TrailComponent == nullptr)
+	{
+		return;
+	}
+
+	// The shared system has no screen size of its own, its sources count against the dash trail caps instead.
+	// Sources past the full quality cap lower the spawn rate of the whole system, those past the reduced cap are not drawn
+	EFlightEffectTier DesiredTier = EFlightEffectTier::Full;
+	int32 MaxSources = MAX_int32;
+
+	if (bBudgetEnabled)
+	{
+		int32 FullCap = FMath::CeilToInt(GetFullQualityCap(EFlightEffectType::DashTrail) * DetailScale);
+		MaxSources = FullCap + FMath::CeilToInt(FullCap * CVarFlightFXReducedCapScale.GetValueOnGameThread());
+
+		if (TrailSubsystem->GetSourceCount() > FullCap)
+		{
+			DesiredTier = EFlightEffectTier::Reduced;
+		}
+	}
+
+	TrailSubsystem->SetBudgetedSources(MaxSources);
+
+	// The whole system switches at once, so it goes through the same hysteresis as a single instance
+	float CurrentTime = GetWorld()->GetTimeSeconds();
+	if (DesiredTier == TrailState.Tier)
+	{
+		TrailState.PendingTier = DesiredTier;
+	}
+	else if (DesiredTier != TrailState.PendingTier)
+	{
+		TrailState.PendingTier = DesiredTier;
+		TrailState.PendingSince = CurrentTime;
+	}
+	else if (CurrentTime - TrailState.PendingSince >= CVarFlightFXHysteresisTime.GetValueOnGameThread())
+	{
+		TrailState.Tier = DesiredTier;
+		ApplyTier(TrailComponent, TrailState, DesiredTier);
+	}
+
+	TrailState.Type = EFlightEffectType::DashTrail;
+	TrailState.LastSeenUpdate = UpdateCount;
+}
+
+void UFlightEffectsBudgetSubsystem::SwitchTier(const FFlightBudgetedEffect& Effect, FEffectState& State, EFlightEffectTier Tier) const
+{
+	// One-shots and systems on their way out would stay paused, active and attached for good. They are stopped instead,
+	// keeping their tier until the next update finds them inactive and forgets them
+	UNiagaraComponent* NiagaraComponent = Cast<UNiagaraComponent>(Effect.Component);
+	if (Tier == EFlightEffectTier::Culled && !Effect.bSustained && NiagaraComponent != nullptr)
+	{
+		NiagaraComponent->DeactivateImmediate();
+		return;
+	}
+
+	State.Tier = Tier;
+	ApplyTier(Effect.Component, State, Tier);
+}
+
+void UFlightEffectsBudgetSubsystem::ApplyTier(UFXSystemComponent* Component, FEffectState& State, EFlightEffectTier Tier) const
+{
+	bool bVisible = Tier != EFlightEffectTier::Culled;
+	Component->SetVisibility(bVisible);
+
+	if (UNiagaraComponent* NiagaraComponent = Cast<UNiagaraComponent>(Component))
+	{
+		// Culled systems stop simulating, reduced ones emit fewer particles through their User.SpawnRateScale parameter
+		NiagaraComponent->SetPaused(!bVisible);
+
+		// The offset is looked up once per system rather than by name on every switch
+		if (State.OffsetAsset != NiagaraComponent->GetAsset())
+		{
+			State.OffsetAsset = NiagaraComponent->GetAsset();
+			State.SpawnRateScaleOffset = FindSpawnRateScaleOffset(NiagaraComponent);
+		}
+
+		if (State.SpawnRateScaleOffset != INDEX_NONE)
+		{
+			float SpawnRateScale = Tier == EFlightEffectTier::Reduced ? CVarFlightFXReducedSpawnRate.GetValueOnGameThread() : 1.f;
+			NiagaraComponent->GetOverrideParameters().SetParameterData(reinterpret_cast<const uint8*>(&SpawnRateScale), State.SpawnRateScaleOffset, sizeof(float));
+		}
+	}
+}
+
+int32 UFlightEffectsBudgetSubsystem::FindSpawnRateScaleOffset(UNiagaraComponent* Niagara)
+{
+	// Systems not exposing the parameter are only culled, never reduced
+	const int32* Offset = Niagara->GetOverrideParameters().FindParameterOffset(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("User.SpawnRateScale")));
+	return Offset != nullptr ? *Offset : INDEX_NONE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UFlightEffectsBudgetSubsystem::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Flight effects budget: %d flyers, %d active effects, detail scale %.2f"), RegisteredEffects.Num(), EffectStates.Num(), DetailScale);
+
+	static const TCHAR* TypeNames[] = { TEXT("DashTrail"), TEXT("Hover"), TEXT("SonicBoom"), TEXT("DiveTrail"), TEXT("TakeoffCharge") };
+	static const TCHAR* TierNames[] = { TEXT("Full"), TEXT("Reduced"), TEXT("Culled") };
+
+	if (const UFlightTrailSubsystem* TrailSubsystem = SharedTrails.Get())
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %-14s %-8s %d sources"), TEXT("SharedTrails"), TierNames[(uint8)TrailState.Tier], TrailSubsystem->GetSourceCount());
+	}
+
+	for (const TPair<TWeakObjectPtr<UFXSystemComponent>, FEffectState>& EffectState : EffectStates)
+	{
+		const UFXSystemComponent* FXComponent = EffectState.Key.Get();
+		UE_LOG(LogTemp, Log, TEXT("  %-14s %-8s score %.4f  %s"), TypeNames[(uint8)EffectState.Value.Type], TierNames[(uint8)EffectState.Value.Tier],
+			EffectState.Value.Score, FXComponent ? *GetNameSafe(FXComponent->GetAttachmentRootActor()) : TEXT("None"));
+	}
+}
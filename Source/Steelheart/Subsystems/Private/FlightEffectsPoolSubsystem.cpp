@@ -0,0 +1,491 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/FlightEffectsPoolSubsystem.h"
+#include "Components/AudioComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+#include "Sound/SoundBase.h"
+#include "Sound/SoundConcurrency.h"
+#include "Steelheart/Steelheart.h"
+#include "UObject/UObjectGlobals.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Pool Spawn"), STAT_FlightPoolSpawn, STATGROUP_Steelheart);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Flight Pool Components"), STAT_FlightPoolComponents, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight Pool Components Created"), STAT_FlightPoolCreated, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight Pool Sounds Virtualized"), STAT_FlightPoolVirtualized, STATGROUP_Steelheart);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last GC Time (ms)"), STAT_FlightPoolLastGCTime, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<int32> CVarFlightPoolPrewarmCount(
+	TEXT("Flight.Pool.PrewarmCount"),
+	2,
+	TEXT("Number of instances created for each flight effect and sound when its assets finish streaming in."));
+
+static TAutoConsoleVariable<int32> CVarFlightPoolMaxPerAsset(
+	TEXT("Flight.Pool.MaxPerAsset"),
+	6,
+	TEXT("Maximum number of live instances of one flight effect or sound. Past the cap, the oldest instance is recycled."));
+
+static FAutoConsoleCommandWithWorld FlightPoolReportCommand(
+	TEXT("Flight.Pool.Report"),
+	TEXT("Log the flight effect and audio pools along with the garbage collection timings"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UFlightEffectsPoolSubsystem* EffectsPool = World ? World->GetSubsystem<UFlightEffectsPoolSubsystem>() : nullptr)
+		{
+			EffectsPool->LogReport();
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UFlightEffectsPoolSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PreGarbageCollectHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UFlightEffectsPoolSubsystem::HandlePreGarbageCollect);
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UFlightEffectsPoolSubsystem::HandlePostGarbageCollect);
+}
+
+void UFlightEffectsPoolSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGarbageCollectHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+
+	// Tear down every pooled component along with the world
+	for (TPair<UNiagaraSystem*, FPooledNiagaraInstances>& Pool : NiagaraPools)
+	{
+		DestroyInstances(Pool.Value.Free, Pool.Value.Active);
+	}
+
+	for (TPair<USoundBase*, FPooledAudioInstances>& Pool : AudioPools)
+	{
+		DestroyInstances(Pool.Value.Free, Pool.Value.Active);
+	}
+
+	for (TPair<UClass*, FPooledSceneComponents>& Pool : ComponentPools)
+	{
+		for (USceneComponent* Component : Pool.Value.Free)
+		{
+			Component->DestroyComponent();
+		}
+
+		DEC_DWORD_STAT_BY(STAT_FlightPoolComponents, Pool.Value.Free.Num());
+	}
+
+	NiagaraPools.Empty();
+	AudioPools.Empty();
+	ComponentPools.Empty();
+	ConcurrencyGroups.Empty();
+
+	Super::Deinitialize();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Pool Functions
+
+UNiagaraComponent* UFlightEffectsPoolSubsystem::SpawnSystemAtLocation(UNiagaraSystem* System, FVector Location, FRotator Rotation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightPoolSpawn);
+
+	if (System == nullptr)
+	{
+		return nullptr;
+	}
+
+	FPooledNiagaraInstances& Pool = NiagaraPools.FindOrAdd(System);
+
+	UNiagaraComponent* NiagaraComponent = nullptr;
+	if (Pool.Free.Num() > 0)
+	{
+		NiagaraComponent = Pool.Free.Pop(false);
+		Pool.Reused++;
+	}
+	else if (Pool.Active.Num() >= CVarFlightPoolMaxPerAsset.GetValueOnGameThread())
+	{
+		// Recycle the oldest instance, removed first so its finish callback does not release it
+		NiagaraComponent = Pool.Active[0];
+		Pool.Active.RemoveAt(0, 1, false);
+		NiagaraComponent->DeactivateImmediate();
+		Pool.Stolen++;
+	}
+	else
+	{
+		NiagaraComponent = CreateNiagaraInstance(System);
+		Pool.Spawned++;
+	}
+
+	Pool.Active.Add(NiagaraComponent);
+
+	NiagaraComponent->SetWorldLocationAndRotation(Location, Rotation);
+	NiagaraComponent->Activate(true);
+
+	return NiagaraComponent;
+}
+
+UAudioComponent* UFlightEffectsPoolSubsystem::SpawnSoundAttached(USoundBase* Sound, USceneComponent* AttachToComponent, USoundConcurrency* Concurrency, float MaxDistance)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightPoolSpawn);
+
+	if (Sound == nullptr || AttachToComponent == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Short sounds out of earshot are virtualized by never starting a voice for them
+	if (MaxDistance > 0.f && GetListenerDistance(AttachToComponent->GetComponentLocation()) > MaxDistance)
+	{
+		VirtualizedSounds++;
+		INC_DWORD_STAT(STAT_FlightPoolVirtualized);
+		return nullptr;
+	}
+
+	FPooledAudioInstances& Pool = AudioPools.FindOrAdd(Sound);
+
+	UAudioComponent* AudioComponent = nullptr;
+	if (Pool.Free.Num() > 0)
+	{
+		AudioComponent = Pool.Free.Pop(false);
+		Pool.Reused++;
+	}
+	else if (Pool.Active.Num() >= CVarFlightPoolMaxPerAsset.GetValueOnGameThread())
+	{
+		// Recycle the oldest instance, removed first so its finish callback does not release it
+		AudioComponent = Pool.Active[0];
+		Pool.Active.RemoveAt(0, 1, false);
+		AudioComponent->Stop();
+		Pool.Stolen++;
+	}
+	else
+	{
+		AudioComponent = CreateAudioInstance(Sound);
+		Pool.Spawned++;
+	}
+
+	Pool.Active.Add(AudioComponent);
+
+	// The audio mixer resolves the limit across every voice of the group, whichever flyer played it
+	AudioComponent->ConcurrencySet.Reset();
+	if (Concurrency != nullptr)
+	{
+		AudioComponent->ConcurrencySet.Add(Concurrency);
+	}
+
+	AudioComponent->AttachToComponent(AttachToComponent, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	AudioComponent->Play();
+
+	return AudioComponent;
+}
+
+USoundConcurrency* UFlightEffectsPoolSubsystem::GetConcurrencyGroup(FName GroupName, const FSoundConcurrencySettings& Settings)
+{
+	USoundConcurrency*& Concurrency = ConcurrencyGroups.FindOrAdd(GroupName);
+	if (Concurrency == nullptr)
+	{
+		Concurrency = NewObject<USoundConcurrency>(this, GroupName);
+		Concurrency->Concurrency = Settings;
+	}
+
+	return Concurrency;
+}
+
+float UFlightEffectsPoolSubsystem::GetListenerDistance(const FVector& Location) const
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController == nullptr)
+	{
+		return 0.f;
+	}
+
+	FVector ListenerLocation;
+	FVector ListenerFront;
+	FVector ListenerRight;
+	PlayerController->GetAudioListenerPosition(ListenerLocation, ListenerFront, ListenerRight);
+
+	return FVector::Dist(Location, ListenerLocation);
+}
+
+USceneComponent* UFlightEffectsPoolSubsystem::AcquireComponent(TSubclassOf<USceneComponent> ComponentClass, USceneComponent* AttachToComponent)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightPoolSpawn);
+
+	FPooledSceneComponents& Pool = ComponentPools.FindOrAdd(ComponentClass);
+
+	USceneComponent* Component = nullptr;
+	if (Pool.Free.Num() > 0)
+	{
+		Component = Pool.Free.Pop(false);
+	}
+	else
+	{
+		Component = NewObject<USceneComponent>(GetWorld(), ComponentClass);
+		Component->SetAutoActivate(false);
+		Component->RegisterComponentWithWorld(GetWorld());
+
+		INC_DWORD_STAT(STAT_FlightPoolComponents);
+		INC_DWORD_STAT(STAT_FlightPoolCreated);
+	}
+
+	ComponentsInUse++;
+
+	if (AttachToComponent != nullptr)
+	{
+		Component->AttachToComponent(AttachToComponent, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	}
+
+	return Component;
+}
+
+void UFlightEffectsPoolSubsystem::ReleaseComponent(USceneComponent* Component)
+{
+	if (Component == nullptr)
+	{
+		return;
+	}
+
+	Component->Deactivate();
+	Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	Component->SetUsingAbsoluteLocation(false);
+	Component->SetUsingAbsoluteRotation(false);
+	Component->SetUsingAbsoluteScale(false);
+
+	// Drop the asset so the streamed groups it belongs to can be released
+	if (UNiagaraComponent* NiagaraComponent = Cast<UNiagaraComponent>(Component))
+	{
+		NiagaraComponent->SetAsset(nullptr);
+		NiagaraComponent->bAutoManageAttachment = false;
+	}
+	else if (UAudioComponent* AudioComponent = Cast<UAudioComponent>(Component))
+	{
+		AudioComponent->SetSound(nullptr);
+		AudioComponent->bAutoManageAttachment = false;
+	}
+
+	ComponentsInUse--;
+
+	ComponentPools.FindOrAdd(Component->GetClass()).Free.Add(Component);
+}
+
+void UFlightEffectsPoolSubsystem::PrewarmAssets(const TArray<FSoftObjectPath>& Assets)
+{
+	int32 PrewarmCount = CVarFlightPoolPrewarmCount.GetValueOnGameThread();
+
+	for (const FSoftObjectPath& AssetPath : Assets)
+	{
+		UObject* Asset = AssetPath.ResolveObject();
+
+		if (UNiagaraSystem* System = Cast<UNiagaraSystem>(Asset))
+		{
+			FPooledNiagaraInstances& Pool = NiagaraPools.FindOrAdd(System);
+			Pool.PrewarmRequests++;
+
+			while (Pool.Free.Num() + Pool.Active.Num() < PrewarmCount)
+			{
+				Pool.Free.Add(CreateNiagaraInstance(System));
+			}
+		}
+		else if (USoundBase* Sound = Cast<USoundBase>(Asset))
+		{
+			FPooledAudioInstances& Pool = AudioPools.FindOrAdd(Sound);
+			Pool.PrewarmRequests++;
+
+			while (Pool.Free.Num() + Pool.Active.Num() < PrewarmCount)
+			{
+				Pool.Free.Add(CreateAudioInstance(Sound));
+			}
+		}
+	}
+}
+
+void UFlightEffectsPoolSubsystem::ReleaseAssets(const TArray<FSoftObjectPath>& Assets)
+{
+	for (const FSoftObjectPath& AssetPath : Assets)
+	{
+		UObject* Asset = AssetPath.ResolveObject();
+
+		// The instances reference their asset, so the pool has to go for the asset to be unloaded.
+		// Pools are removed before their instances are destroyed, so finish callbacks find nothing to release to
+		if (UNiagaraSystem* System = Cast<UNiagaraSystem>(Asset))
+		{
+			FPooledNiagaraInstances* Pool = NiagaraPools.Find(System);
+			FPooledNiagaraInstances Dropped;
+
+			if (Pool != nullptr && --Pool->PrewarmRequests <= 0 && NiagaraPools.RemoveAndCopyValue(System, Dropped))
+			{
+				DestroyInstances(Dropped.Free, Dropped.Active);
+			}
+		}
+		else if (USoundBase* Sound = Cast<USoundBase>(Asset))
+		{
+			FPooledAudioInstances* Pool = AudioPools.Find(Sound);
+			FPooledAudioInstances Dropped;
+
+			if (Pool != nullptr && --Pool->PrewarmRequests <= 0 && AudioPools.RemoveAndCopyValue(Sound, Dropped))
+			{
+				DestroyInstances(Dropped.Free, Dropped.Active);
+			}
+		}
+	}
+
+	DropIdleOnDemandPools();
+}
+
+void UFlightEffectsPoolSubsystem::DropIdleOnDemandPools()
+{
+	// Pools created by a spawn of an asset outside of any streamed group would otherwise keep it loaded for good.
+	// Their assets are released along with the groups, a later spawn simply creates the pool again
+	TArray<FPooledNiagaraInstances, TInlineAllocator<8>> DroppedNiagara;
+	for (auto It = NiagaraPools.CreateIterator(); It; ++It)
+	{
+		if (It.Value().PrewarmRequests <= 0 && It.Value().Active.Num() == 0)
+		{
+			DroppedNiagara.Add(MoveTemp(It.Value()));
+			It.RemoveCurrent();
+		}
+	}
+
+	TArray<FPooledAudioInstances, TInlineAllocator<8>> DroppedAudio;
+	for (auto It = AudioPools.CreateIterator(); It; ++It)
+	{
+		if (It.Value().PrewarmRequests <= 0 && It.Value().Active.Num() == 0)
+		{
+			DroppedAudio.Add(MoveTemp(It.Value()));
+			It.RemoveCurrent();
+		}
+	}
+
+	// Pools are removed before their instances are destroyed, as in ReleaseAssets
+	for (const FPooledNiagaraInstances& Dropped : DroppedNiagara)
+	{
+		DestroyInstances(Dropped.Free, Dropped.Active);
+	}
+
+	for (const FPooledAudioInstances& Dropped : DroppedAudio)
+	{
+		DestroyInstances(Dropped.Free, Dropped.Active);
+	}
+}
+
+template<typename T>
+void UFlightEffectsPoolSubsystem::DestroyInstances(const TArray<T*>& Free, const TArray<T*>& Active)
+{
+	// Instances still playing are cut short, their group has gone unwanted for a while by the time it is released
+	for (T* Component : Free)
+	{
+		Component->DestroyComponent();
+	}
+
+	for (T* Component : Active)
+	{
+		Component->DestroyComponent();
+	}
+
+	DEC_DWORD_STAT_BY(STAT_FlightPoolComponents, Free.Num() + Active.Num());
+}
+
+UNiagaraComponent* UFlightEffectsPoolSubsystem::CreateNiagaraInstance(UNiagaraSystem* System)
+{
+	UNiagaraComponent* NiagaraComponent = NewObject<UNiagaraComponent>(GetWorld());
+	NiagaraComponent->SetAutoActivate(false);
+	NiagaraComponent->SetAutoDestroy(false);
+	NiagaraComponent->SetUsingAbsoluteLocation(true);
+	NiagaraComponent->SetUsingAbsoluteRotation(true);
+	NiagaraComponent->SetAsset(System);
+	NiagaraComponent->OnSystemFinished.AddUniqueDynamic(this, &UFlightEffectsPoolSubsystem::ReleaseNiagara);
+	NiagaraComponent->RegisterComponentWithWorld(GetWorld());
+
+	INC_DWORD_STAT(STAT_FlightPoolComponents);
+	INC_DWORD_STAT(STAT_FlightPoolCreated);
+
+	return NiagaraComponent;
+}
+
+UAudioComponent* UFlightEffectsPoolSubsystem::CreateAudioInstance(USoundBase* Sound)
+{
+	UAudioComponent* AudioComponent = NewObject<UAudioComponent>(GetWorld());
+	AudioComponent->bAutoActivate = false;
+	AudioComponent->bAutoDestroy = false;
+	AudioComponent->SetSound(Sound);
+	AudioComponent->OnAudioFinishedNative.AddUObject(this, &UFlightEffectsPoolSubsystem::ReleaseAudio);
+	AudioComponent->RegisterComponentWithWorld(GetWorld());
+
+	INC_DWORD_STAT(STAT_FlightPoolComponents);
+	INC_DWORD_STAT(STAT_FlightPoolCreated);
+
+	return AudioComponent;
+}
+
+void UFlightEffectsPoolSubsystem::ReleaseNiagara(UNiagaraComponent* NiagaraComponent)
+{
+	if (FPooledNiagaraInstances* Pool = NiagaraPools.Find(NiagaraComponent->GetAsset()))
+	{
+		// Instances recycled while still playing are no longer active and stay with their new user
+		if (Pool->Active.RemoveSingle(NiagaraComponent) > 0)
+		{
+			Pool->Free.Add(NiagaraComponent);
+		}
+	}
+}
+
+void UFlightEffectsPoolSubsystem::ReleaseAudio(UAudioComponent* AudioComponent)
+{
+	if (FPooledAudioInstances* Pool = AudioPools.Find(AudioComponent->Sound))
+	{
+		// Instances recycled while still playing are no longer active and stay with their new user
+		if (Pool->Active.RemoveSingle(AudioComponent) > 0)
+		{
+			AudioComponent->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+			Pool->Free.Add(AudioComponent);
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UFlightEffectsPoolSubsystem::HandlePreGarbageCollect()
+{
+	GarbageCollectStartTime = FPlatformTime::Seconds();
+}
+
+void UFlightEffectsPoolSubsystem::HandlePostGarbageCollect()
+{
+	LastGarbageCollectTime = FPlatformTime::Seconds() - GarbageCollectStartTime;
+	TotalGarbageCollectTime += LastGarbageCollectTime;
+	GarbageCollectCount++;
+
+	SET_FLOAT_STAT(STAT_FlightPoolLastGCTime, LastGarbageCollectTime * 1000.0);
+}
+
+void UFlightEffectsPoolSubsystem::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Flight effects pool (max %d per asset):"), CVarFlightPoolMaxPerAsset.GetValueOnGameThread());
+
+	for (const TPair<UNiagaraSystem*, FPooledNiagaraInstances>& Pool : NiagaraPools)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %-40s free %2d  active %2d  spawned %4d  reused %4d  stolen %4d"),
+			*GetNameSafe(Pool.Key), Pool.Value.Free.Num(), Pool.Value.Active.Num(), Pool.Value.Spawned, Pool.Value.Reused, Pool.Value.Stolen);
+	}
+
+	for (const TPair<USoundBase*, FPooledAudioInstances>& Pool : AudioPools)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %-40s free %2d  active %2d  spawned %4d  reused %4d  stolen %4d"),
+			*GetNameSafe(Pool.Key), Pool.Value.Free.Num(), Pool.Value.Active.Num(), Pool.Value.Spawned, Pool.Value.Reused, Pool.Value.Stolen);
+	}
+
+	for (const TPair<UClass*, FPooledSceneComponents>& Pool : ComponentPools)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %-40s idle %2d"), *GetNameSafe(Pool.Key), Pool.Value.Free.Num());
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Attached effect components in use: %d"), ComponentsInUse);
+
+	UE_LOG(LogTemp, Log, TEXT("Sounds virtualized out of earshot: %d, concurrency groups: %d"), VirtualizedSounds, ConcurrencyGroups.Num());
+
+	UE_LOG(LogTemp, Log, TEXT("Garbage collection: %d passes, last %.2f ms, average %.2f ms"), GarbageCollectCount,
+		LastGarbageCollectTime * 1000.0, GarbageCollectCount > 0 ? TotalGarbageCollectTime * 1000.0 / GarbageCollectCount : 0.0);
+}
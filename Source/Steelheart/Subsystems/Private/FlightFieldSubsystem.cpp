@@ -0,0 +1,446 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/FlightFieldSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Field/FieldSystemActor.h"
+#include "Field/FieldSystemComponent.h"
+#include "Field/FieldSystemObjects.h"
+#include "GeometryCollection/GeometryCollectionComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/DestructibleDebrisSubsystem.h"
+#include "Steelheart/Subsystems/Public/DestructibleRegistrySubsystem.h"
+#include "Steelheart/Subsystems/Public/DestructionJournalSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Fields Submit"), STAT_FlightFieldsSubmit, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight Field Impacts"), STAT_FlightFieldImpacts, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<int32> CVarFlightFieldsMaxImpacts(
+	TEXT("Flight.Fields.MaxImpactsPerFrame"),
+	8,
+	TEXT("Maximum number of impacts submitted in a frame. Past the cap, impacts are merged into the nearest queued one."));
+
+static TAutoConsoleVariable<float> CVarFlightFieldsCoalesceScale(
+	TEXT("Flight.Fields.CoalesceScale"),
+	0.5f,
+	TEXT("Impacts closer to a queued impact than this fraction of the larger radius are merged into it."));
+
+static TAutoConsoleVariable<bool> CVarFlightFieldsQueryTargets(
+	TEXT("Flight.Fields.QueryTargets"),
+	true,
+	TEXT("Skip the impacts with no registered destructible within their radius."));
+
+static TAutoConsoleVariable<bool> CVarFlightFieldsShockwaveOverlap(
+	TEXT("Flight.Fields.ShockwaveOverlap"),
+	true,
+	TEXT("Check shockwaves for physics bodies and destructibles with an asynchronous overlap before submitting them."));
+
+static FAutoConsoleCommandWithWorld FlightFieldsReportCommand(
+	TEXT("Flight.Fields.Report"),
+	TEXT("Log the field impacts submitted in the world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UFlightFieldSubsystem* Fields = World ? World->GetSubsystem<UFlightFieldSubsystem>() : nullptr)
+		{
+			Fields->LogReport();
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UFlightFieldSubsystem::Deinitialize()
+{
+	if (FieldActor != nullptr)
+	{
+		FieldActor->Destroy();
+		FieldActor = nullptr;
+	}
+
+	Graphs.Empty();
+	RemovalGraphs.Empty();
+	CollapseGraphs.Empty();
+	PendingImpacts.Empty();
+	PendingShockwaves.Empty();
+	OverlappingShockwaves.Empty();
+	PendingRemovals.Empty();
+	PendingCollapses.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFlightFieldSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	LaunchShockwaveOverlaps();
+
+	if (PendingImpacts.Num() == 0 && PendingRemovals.Num() == 0 && PendingCollapses.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FlightFieldsSubmit);
+
+	SubmittedRemovals += SubmitMasks(Field_Kill, PendingRemovals, RemovalGraphs);
+	SubmittedCollapses += SubmitMasks(Field_ExternalClusterStrain, PendingCollapses, CollapseGraphs);
+
+	if (PendingImpacts.Num() == 0)
+	{
+		return;
+	}
+
+	// A lookup in the destructible index per impact replaces a sphere kept around every flyer
+	if (CVarFlightFieldsQueryTargets.GetValueOnGameThread())
+	{
+		SkippedImpacts += PendingImpacts.RemoveAllSwap([this](const FPendingImpact& Impact) { return !Impact.bTargetsFound && !HasTargetsInRange(Impact); });
+	}
+
+	if (PendingImpacts.Num() == 0)
+	{
+		return;
+	}
+
+	ReserveGraphs(PendingImpacts.Num());
+	if (FieldActor == nullptr || Graphs.Num() < PendingImpacts.Num())
+	{
+		PendingImpacts.Reset();
+		return;
+	}
+
+	// Chain the impacts of the frame into one strain graph and one velocity graph
+	UFieldNodeBase* StrainRoot = nullptr;
+	UFieldNodeBase* VelocityRoot = nullptr;
+
+	for (int32 ImpactIndex = 0; ImpactIndex < PendingImpacts.Num(); ImpactIndex++)
+	{
+		const FPendingImpact& Impact = PendingImpacts[ImpactIndex];
+		const FFlightFieldGraph& Graph = Graphs[ImpactIndex];
+
+		UFieldNodeBase* StrainNode = Graph.RadialFalloff->SetRadialFalloff(Impact.StrainMagnitude, 0.f, 1.f, 0.f,
+			Impact.Radius, Impact.Location, Field_FallOff_None);
+
+		UFieldNodeBase* VectorNode = Graph.RadialVector->SetRadialVector(Impact.VelocityMagnitude, Impact.Location);
+		UFieldNodeBase* VelocityNode = Graph.CullingField->SetCullingField(StrainNode, VectorNode, Field_Culling_Outside);
+
+		StrainRoot = StrainRoot == nullptr ? StrainNode : Graph.StrainSum->SetOperatorField(1.f, StrainRoot, StrainNode, Field_Add);
+		VelocityRoot = VelocityRoot == nullptr ? VelocityNode : Graph.VelocitySum->SetOperatorField(1.f, VelocityRoot, VelocityNode, Field_Add);
+	}
+
+	UFieldSystemComponent* FieldSystem = FieldActor->GetFieldSystemComponent();
+	FieldSystem->ApplyPhysicsField(true, Field_ExternalClusterStrain, nullptr, StrainRoot);
+	FieldSystem->ApplyPhysicsField(true, Field_LinearVelocity, nullptr, VelocityRoot);
+
+	TrackDebris();
+
+	SubmittedImpacts += PendingImpacts.Num();
+	Submissions++;
+
+	SET_DWORD_STAT(STAT_FlightFieldImpacts, PendingImpacts.Num());
+
+	PendingImpacts.Reset();
+}
+
+TStatId UFlightFieldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFlightFieldSubsystem, STATGROUP_Steelheart);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Field Functions
+
+void UFlightFieldSubsystem::QueueImpact(FVector Location, float Radius, float StrainMagnitude, float VelocityMagnitude)
+{
+	if (Radius <= 0.f)
+	{
+		return;
+	}
+
+	QueuedImpacts++;
+
+	FPendingImpact Impact;
+	Impact.Location = Location;
+	Impact.Radius = Radius;
+	Impact.StrainMagnitude = StrainMagnitude;
+	Impact.VelocityMagnitude = VelocityMagnitude;
+	Impact.Impacts = 1;
+
+	if (AddImpact(PendingImpacts, Impact))
+	{
+		CoalescedImpacts++;
+	}
+}
+
+void UFlightFieldSubsystem::QueueShockwave(FVector Location, float Radius, float StrainMagnitude, float VelocityMagnitude)
+{
+	if (Radius <= 0.f)
+	{
+		return;
+	}
+
+	QueuedShockwaves++;
+
+	FPendingImpact Shockwave;
+	Shockwave.Location = Location;
+	Shockwave.Radius = Radius;
+	Shockwave.StrainMagnitude = StrainMagnitude;
+	Shockwave.VelocityMagnitude = VelocityMagnitude;
+	Shockwave.Impacts = 1;
+
+	// Simultaneous landings share one overlap and one place in the submission
+	if (AddImpact(PendingShockwaves, Shockwave))
+	{
+		CoalescedImpacts++;
+	}
+}
+
+bool UFlightFieldSubsystem::AddImpact(TArray<FPendingImpact>& Pending, const FPendingImpact& Impact)
+{
+	// Merge into an overlapping impact, or into the nearest one once the frame is full
+	float CoalesceScale = CVarFlightFieldsCoalesceScale.GetValueOnGameThread();
+	bool bFull = Pending.Num() >= FMath::Max(CVarFlightFieldsMaxImpacts.GetValueOnGameThread(), 1);
+
+	FPendingImpact* Nearest = nullptr;
+	float NearestDistance = TNumericLimits<float>::Max();
+
+	for (FPendingImpact& Queued : Pending)
+	{
+		float Distance = FVector::Dist(Queued.Location, Impact.Location);
+		if (Distance < NearestDistance)
+		{
+			Nearest = &Queued;
+			NearestDistance = Distance;
+		}
+	}
+
+	if (Nearest != nullptr && (bFull || NearestDistance < FMath::Max(Nearest->Radius, Impact.Radius) * CoalesceScale))
+	{
+		MergeImpact(*Nearest, Impact);
+		return true;
+	}
+
+	Pending.Add(Impact);
+	return false;
+}
+
+void UFlightFieldSubsystem::MergeImpact(FPendingImpact& Into, const FPendingImpact& Impact)
+{
+	float Distance = FVector::Dist(Into.Location, Impact.Location);
+
+	// Center on the impacts merged so far and grow to cover both
+	Into.Location = FMath::Lerp(Into.Location, Impact.Location, (float)Impact.Impacts / (Into.Impacts + Impact.Impacts));
+	Into.Radius = FMath::Max(Into.Radius, Impact.Radius) + Distance * 0.5f;
+	Into.StrainMagnitude = FMath::Max(Into.StrainMagnitude, Impact.StrainMagnitude);
+	Into.VelocityMagnitude = FMath::Max(Into.VelocityMagnitude, Impact.VelocityMagnitude);
+	Into.Impacts += Impact.Impacts;
+	Into.bTargetsFound |= Impact.bTargetsFound;
+}
+
+void UFlightFieldSubsystem::LaunchShockwaveOverlaps()
+{
+	if (PendingShockwaves.Num() == 0)
+	{
+		return;
+	}
+
+	if (!CVarFlightFieldsShockwaveOverlap.GetValueOnGameThread())
+	{
+		for (const FPendingImpact& Shockwave : PendingShockwaves)
+		{
+			AddImpact(PendingImpacts, Shockwave);
+		}
+
+		PendingShockwaves.Reset();
+		return;
+	}
+
+	if (!ShockwaveOverlapDelegate.IsBound())
+	{
+		ShockwaveOverlapDelegate.BindUObject(this, &UFlightFieldSubsystem::HandleShockwaveOverlap);
+	}
+
+	// Bodies the velocity field can push, the destructibles themselves are found through the registry
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+	ObjectParams.AddObjectTypesToQuery(ECC_Destructible);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FlightShockwaveOverlap));
+	QueryParams.MobilityType = EQueryMobilityType::Dynamic;
+
+	for (const FPendingImpact& Shockwave : PendingShockwaves)
+	{
+		FTraceHandle TraceHandle = GetWorld()->AsyncOverlapByObjectType(Shockwave.Location, FQuat::Identity, ObjectParams,
+			FCollisionShape::MakeSphere(Shockwave.Radius), QueryParams, &ShockwaveOverlapDelegate);
+
+		OverlappingShockwaves.Emplace(TraceHandle, Shockwave);
+	}
+
+	PendingShockwaves.Reset();
+}
+
+void UFlightFieldSubsystem::HandleShockwaveOverlap(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum)
+{
+	int32 ShockwaveIndex = OverlappingShockwaves.IndexOfByPredicate([&TraceHandle](const TPair<FTraceHandle, FPendingImpact>& Overlapping)
+	{
+		return Overlapping.Key == TraceHandle;
+	});
+
+	if (ShockwaveIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FPendingImpact Shockwave = OverlappingShockwaves[ShockwaveIndex].Value;
+	OverlappingShockwaves.RemoveAtSwap(ShockwaveIndex);
+
+	// Only whether anything was found matters, however many bodies the shockwave reaches
+	Shockwave.bTargetsFound = OverlapDatum.OutOverlaps.Num() > 0;
+	if (!Shockwave.bTargetsFound && !HasTargetsInRange(Shockwave))
+	{
+		EmptyShockwaves++;
+		return;
+	}
+
+	Shockwave.bTargetsFound = true;
+	AddImpact(PendingImpacts, Shockwave);
+}
+
+void UFlightFieldSubsystem::QueueRemoval(FVector Location, float Radius)
+{
+	if (Radius > 0.f)
+	{
+		PendingRemovals.Add({ FSphere(Location, Radius), 1.f });
+	}
+}
+
+void UFlightFieldSubsystem::QueueCollapse(FVector Location, float Radius, float StrainMagnitude)
+{
+	if (Radius > 0.f)
+	{
+		PendingCollapses.Add({ FSphere(Location, Radius), StrainMagnitude });
+	}
+}
+
+int32 UFlightFieldSubsystem::SubmitMasks(EFieldPhysicsType FieldType, TArray<FPendingMask>& Pending, TArray<FFlightMaskGraph>& MaskGraphs)
+{
+	int32 Submitted = Pending.Num();
+	if (Submitted == 0 || !EnsureFieldActor())
+	{
+		Pending.Reset();
+		return 0;
+	}
+
+	while (MaskGraphs.Num() < Pending.Num())
+	{
+		FFlightMaskGraph& Graph = MaskGraphs.AddDefaulted_GetRef();
+		Graph.RadialFalloff = NewObject<URadialFalloff>(FieldActor);
+		Graph.Sum = NewObject<UOperatorField>(FieldActor);
+	}
+
+	// The falloff is zero outside of every sphere, so the field leaves every other piece alone
+	UFieldNodeBase* MaskRoot = nullptr;
+
+	for (int32 MaskIndex = 0; MaskIndex < Pending.Num(); MaskIndex++)
+	{
+		const FPendingMask& Mask = Pending[MaskIndex];
+		const FFlightMaskGraph& Graph = MaskGraphs[MaskIndex];
+
+		UFieldNodeBase* MaskNode = Graph.RadialFalloff->SetRadialFalloff(Mask.Magnitude, 0.f, 1.f, 0.f, Mask.Sphere.W, Mask.Sphere.Center, Field_FallOff_None);
+		MaskRoot = MaskRoot == nullptr ? MaskNode : Graph.Sum->SetOperatorField(1.f, MaskRoot, MaskNode, Field_Add);
+	}
+
+	FieldActor->GetFieldSystemComponent()->ApplyPhysicsField(true, FieldType, nullptr, MaskRoot);
+
+	Pending.Reset();
+	return Submitted;
+}
+
+void UFlightFieldSubsystem::TrackDebris()
+{
+	UDestructibleDebrisSubsystem* Debris = GetWorld()->GetSubsystem<UDestructibleDebrisSubsystem>();
+	const UDestructibleRegistrySubsystem* Destructibles = GetWorld()->GetSubsystem<UDestructibleRegistrySubsystem>();
+	if (Debris == nullptr || Destructibles == nullptr)
+	{
+		return;
+	}
+
+	UDestructionJournalSubsystem* Journal = GetWorld()->GetGameInstance() ? GetWorld()->GetGameInstance()->GetSubsystem<UDestructionJournalSubsystem>() : nullptr;
+
+	for (const FPendingImpact& Impact : PendingImpacts)
+	{
+		FoundDestructibles.Reset();
+		Destructibles->FindInRadius(Impact.Location, Impact.Radius, FoundDestructibles);
+
+		if (Journal != nullptr && FoundDestructibles.Num() > 0)
+		{
+			Journal->RecordImpact(Impact.Location, Impact.Radius, Impact.StrainMagnitude, Impact.VelocityMagnitude, FoundDestructibles);
+		}
+
+		for (AActor* Destructible : FoundDestructibles)
+		{
+			TInlineComponentArray<UGeometryCollectionComponent*> Collections(Destructible);
+			for (UGeometryCollectionComponent* Collection : Collections)
+			{
+				Debris->TrackCollection(Collection);
+			}
+		}
+	}
+}
+
+bool UFlightFieldSubsystem::HasTargetsInRange(const FPendingImpact& Impact) const
+{
+	const UDestructibleRegistrySubsystem* Destructibles = GetWorld()->GetSubsystem<UDestructibleRegistrySubsystem>();
+	return Destructibles == nullptr || Destructibles->AnyInRadius(Impact.Location, Impact.Radius);
+}
+
+bool UFlightFieldSubsystem::EnsureFieldActor()
+{
+	if (FieldActor == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		FieldActor = GetWorld()->SpawnActor<AFieldSystemActor>(SpawnParams);
+	}
+
+	return FieldActor != nullptr;
+}
+
+void UFlightFieldSubsystem::ReserveGraphs(int32 Count)
+{
+	if (!EnsureFieldActor())
+	{
+		return;
+	}
+
+	// Not clamped to the impacts per frame, the setting may have been lowered while more impacts were pending
+	while (Graphs.Num() < Count)
+	{
+		FFlightFieldGraph& Graph = Graphs.AddDefaulted_GetRef();
+		Graph.RadialFalloff = NewObject<URadialFalloff>(FieldActor);
+		Graph.RadialVector = NewObject<URadialVector>(FieldActor);
+		Graph.CullingField = NewObject<UCullingField>(FieldActor);
+		Graph.StrainSum = NewObject<UOperatorField>(FieldActor);
+		Graph.VelocitySum = NewObject<UOperatorField>(FieldActor);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UFlightFieldSubsystem::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Flight fields: %d impacts queued, %d coalesced, %d skipped with nothing in range"),
+		QueuedImpacts, CoalescedImpacts, SkippedImpacts);
+
+	UE_LOG(LogTemp, Log, TEXT("  %d impacts submitted in %d batches, %d field graphs built"),
+		SubmittedImpacts, Submissions, Graphs.Num());
+
+	UE_LOG(LogTemp, Log, TEXT("  %d landing shockwaves queued, %d with nothing in range, %d waiting for their overlap"),
+		QueuedShockwaves, EmptyShockwaves, OverlappingShockwaves.Num());
+
+	UE_LOG(LogTemp, Log, TEXT("  %d debris pieces removed, %d removal graphs built"), SubmittedRemovals, RemovalGraphs.Num());
+	UE_LOG(LogTemp, Log, TEXT("  %d pieces collapsed, %d collapse graphs built"), SubmittedCollapses, CollapseGraphs.Num());
+}
@@ -0,0 +1,276 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/FlightImpactSubsystem.h"
+#include "Components/DecalComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "ProceduralMeshComponent.h"
+#include "Steelheart/Steelheart.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Impact Stamp"), STAT_FlightImpactStamp, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<int32> CVarFlightImpactsMaxStamps(
+	TEXT("Flight.Impacts.MaxStamps"),
+	32,
+	TEXT("Number of landing craters kept in the world. Past the cap, the oldest crater is recycled."));
+
+static TAutoConsoleVariable<float> CVarFlightImpactsMergeScale(
+	TEXT("Flight.Impacts.MergeScale"),
+	0.75f,
+	TEXT("Landings closer to an existing crater than this fraction of their summed radii widen it instead of stamping a new one."));
+
+static TAutoConsoleVariable<float> CVarFlightImpactsMaxMergedScale(
+	TEXT("Flight.Impacts.MaxMergedScale"),
+	2.f,
+	TEXT("Largest a crater can grow through merged landings, as a multiple of the radius of a single landing."));
+
+static TAutoConsoleVariable<bool> CVarFlightImpactsDeform(
+	TEXT("Flight.Impacts.Deform"),
+	true,
+	TEXT("Press craters into the vertices of the procedural meshes landed on."));
+
+static FAutoConsoleCommandWithWorld FlightImpactsReportCommand(
+	TEXT("Flight.Impacts.Report"),
+	TEXT("Log the landing craters of the world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UFlightImpactSubsystem* Impacts = World ? World->GetSubsystem<UFlightImpactSubsystem>() : nullptr)
+		{
+			Impacts->LogReport();
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UFlightImpactSubsystem::Deinitialize()
+{
+	for (FFlightImpactStamp& Stamp : Stamps)
+	{
+		if (Stamp.Decal != nullptr)
+		{
+			Stamp.Decal->DestroyComponent();
+		}
+	}
+
+	Stamps.Empty();
+
+	Super::Deinitialize();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Stamping Functions
+
+void UFlightImpactSubsystem::StampImpact(FVector Location, float Radius, float Depth, UMaterialInterface* Material)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlightImpactStamp);
+
+	if (Radius <= 0.f)
+	{
+		return;
+	}
+
+	// Find the surface under the landing
+	FHitResult Hit;
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(FlightImpactStamp));
+	FVector TraceStart = Location + FVector::UpVector * Depth;
+	FVector TraceEnd = Location - FVector::UpVector * (Radius + Depth);
+	if (!GetWorld()->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, ECC_Visibility, TraceParams))
+	{
+		return;
+	}
+
+	if (CVarFlightImpactsDeform.GetValueOnGameThread())
+	{
+		if (UProceduralMeshComponent* ProcMesh = Cast<UProceduralMeshComponent>(Hit.GetComponent()))
+		{
+			DeformProcMesh(ProcMesh, Hit.ImpactPoint, Hit.ImpactNormal, Radius, Depth);
+		}
+	}
+
+	int32 MaxStamps = CVarFlightImpactsMaxStamps.GetValueOnGameThread();
+	if (Material == nullptr || MaxStamps <= 0)
+	{
+		return;
+	}
+
+	// Widen the nearest crater if the landing overlaps it
+	float MergeScale = CVarFlightImpactsMergeScale.GetValueOnGameThread();
+	for (int32 StampIndex = 0; StampIndex < Stamps.Num(); StampIndex++)
+	{
+		FFlightImpactStamp Stamp = Stamps[StampIndex];
+		if (Stamp.Decal != nullptr && FVector::Dist(Stamp.Location, Hit.ImpactPoint) < (Stamp.Radius + Radius) * MergeScale)
+		{
+			float MaxRadius = Radius * CVarFlightImpactsMaxMergedScale.GetValueOnGameThread();
+
+			Stamp.Impacts++;
+			Stamp.Location = FMath::Lerp(Stamp.Location, FVector(Hit.ImpactPoint), 1.f / Stamp.Impacts);
+			Stamp.Radius = FMath::Min(FMath::Max(Stamp.Radius, Radius) * 1.15f, FMath::Max(MaxRadius, Stamp.Radius));
+			UpdateStampDecal(Stamp, Hit.ImpactNormal, Depth, Material);
+
+			// The refreshed crater becomes the most recent one, so it is the last to be recycled
+			Stamps.RemoveAt(StampIndex, 1, false);
+			Stamps.Add(Stamp);
+
+			MergedImpacts++;
+			return;
+		}
+	}
+
+	// Otherwise add a stamp, recycling the decal of the least recently stamped crater once the cap is reached
+	FFlightImpactStamp Stamp;
+	if (Stamps.Num() >= MaxStamps)
+	{
+		Stamp = Stamps[0];
+		Stamps.RemoveAt(0, 1, false);
+		RecycledStamps++;
+	}
+
+	Stamp.Location = Hit.ImpactPoint;
+	Stamp.Radius = Radius;
+	Stamp.Impacts = 1;
+	UpdateStampDecal(Stamp, Hit.ImpactNormal, Depth, Material);
+
+	Stamps.Add(Stamp);
+}
+
+void UFlightImpactSubsystem::UpdateStampDecal(FFlightImpactStamp& Stamp, const FVector& Normal, float Depth, UMaterialInterface* Material)
+{
+	if (Stamp.Decal == nullptr)
+	{
+		Stamp.Decal = NewObject<UDecalComponent>(GetWorld());
+		Stamp.Decal->SetUsingAbsoluteLocation(true);
+		Stamp.Decal->SetUsingAbsoluteRotation(true);
+		Stamp.Decal->SetUsingAbsoluteScale(true);
+		Stamp.Decal->SetFadeScreenSize(0.002f);
+		Stamp.Decal->RegisterComponentWithWorld(GetWorld());
+	}
+
+	if (Stamp.Decal->GetDecalMaterial() != Material)
+	{
+		Stamp.Decal->SetDecalMaterial(Material);
+	}
+
+	// Decals project along their X axis, into the surface
+	Stamp.Decal->DecalSize = FVector(Depth, Stamp.Radius, Stamp.Radius);
+	Stamp.Decal->SetWorldLocationAndRotation(Stamp.Location, (-Normal).Rotation());
+	Stamp.Decal->MarkRenderStateDirty();
+}
+
+void UFlightImpactSubsystem::DeformProcMesh(UProceduralMeshComponent* ProcMesh, const FVector& Location, const FVector& Normal, float Radius, float Depth) const
+{
+	const FTransform& MeshTransform = ProcMesh->GetComponentTransform();
+	FVector LocalCenter = MeshTransform.InverseTransformPosition(Location);
+	FVector LocalPush = MeshTransform.InverseTransformVector(-Normal * Depth);
+	float LocalRadius = Radius / FMath::Max(MeshTransform.GetMaximumAxisScale(), KINDA_SMALL_NUMBER);
+
+	for (int32 SectionIndex = 0; SectionIndex < ProcMesh->GetNumSections(); SectionIndex++)
+	{
+		FProcMeshSection* Section = ProcMesh->GetProcMeshSection(SectionIndex);
+		if (Section == nullptr || !Section->SectionLocalBox.ExpandBy(LocalRadius).IsInside(LocalCenter))
+		{
+			continue;
+		}
+
+		// Vertices are moved in place with a smooth falloff, so the section never grows
+		TBitArray<> Moved(false, Section->ProcVertexBuffer.Num());
+		bool bDeformed = false;
+		for (int32 VertexIndex = 0; VertexIndex < Section->ProcVertexBuffer.Num(); VertexIndex++)
+		{
+			FProcMeshVertex& Vertex = Section->ProcVertexBuffer[VertexIndex];
+			float Distance = FVector::Dist(Vertex.Position, LocalCenter);
+			if (Distance < LocalRadius)
+			{
+				float Falloff = 1.f - FMath::SmoothStep(0.f, LocalRadius, Distance);
+				Vertex.Position += LocalPush * Falloff;
+				Moved[VertexIndex] = true;
+				bDeformed = true;
+			}
+		}
+
+		if (!bDeformed)
+		{
+			continue;
+		}
+
+		RecomputeNormals(*Section, Moved);
+
+		// The section box is written back as is, it bounds the component and the next landings tested against it
+		Section->SectionLocalBox = FBox(ForceInit);
+		for (const FProcMeshVertex& Vertex : Section->ProcVertexBuffer)
+		{
+			Section->SectionLocalBox += Vertex.Position;
+		}
+
+		ProcMesh->SetProcMeshSection(SectionIndex, *Section);
+	}
+}
+
+void UFlightImpactSubsystem::RecomputeNormals(FProcMeshSection& Section, const TBitArray<>& Moved)
+{
+	const TArray<uint32>& Indices = Section.ProcIndexBuffer;
+	TArray<FProcMeshVertex>& Vertices = Section.ProcVertexBuffer;
+
+	// Vertices sharing a triangle with a moved vertex are tilted too
+	TBitArray<> Affected(false, Vertices.Num());
+	for (int32 Index = 0; Index + 2 < Indices.Num(); Index += 3)
+	{
+		if (Moved[Indices[Index]] || Moved[Indices[Index + 1]] || Moved[Indices[Index + 2]])
+		{
+			Affected[Indices[Index]] = true;
+			Affected[Indices[Index + 1]] = true;
+			Affected[Indices[Index + 2]] = true;
+		}
+	}
+
+	// Sum the area weighted normals of every triangle around those vertices, with the winding of the procedural mesh library
+	TArray<FVector> Normals;
+	Normals.SetNumZeroed(Vertices.Num());
+	for (int32 Index = 0; Index + 2 < Indices.Num(); Index += 3)
+	{
+		uint32 A = Indices[Index];
+		uint32 B = Indices[Index + 1];
+		uint32 C = Indices[Index + 2];
+		if (!Affected[A] && !Affected[B] && !Affected[C])
+		{
+			continue;
+		}
+
+		FVector FaceNormal = (Vertices[C].Position - Vertices[A].Position) ^ (Vertices[B].Position - Vertices[A].Position);
+		Normals[A] += FaceNormal;
+		Normals[B] += FaceNormal;
+		Normals[C] += FaceNormal;
+	}
+
+	for (int32 VertexIndex = 0; VertexIndex < Vertices.Num(); VertexIndex++)
+	{
+		if (!Affected[VertexIndex] || Normals[VertexIndex].IsNearlyZero())
+		{
+			continue;
+		}
+
+		// Seams and caps keep their own vertices, so they stay hard edges
+		FProcMeshVertex& Vertex = Vertices[VertexIndex];
+		Vertex.Normal = Normals[VertexIndex].GetSafeNormal();
+
+		// Keep the tangent, made orthogonal to the new normal
+		FVector TangentX = Vertex.Tangent.TangentX - Vertex.Normal * FVector::DotProduct(Vertex.Tangent.TangentX, Vertex.Normal);
+		if (!TangentX.IsNearlyZero())
+		{
+			Vertex.Tangent.TangentX = TangentX.GetSafeNormal();
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UFlightImpactSubsystem::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Flight impacts: %d of %d stamps used, %d landings merged, %d stamps recycled"),
+		Stamps.Num(), CVarFlightImpactsMaxStamps.GetValueOnGameThread(), MergedImpacts, RecycledStamps);
+
+	for (const FFlightImpactStamp& Stamp : Stamps)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %s  radius %.0f  landings %d"), *Stamp.Location.ToString(), Stamp.Radius, Stamp.Impacts);
+	}
+}
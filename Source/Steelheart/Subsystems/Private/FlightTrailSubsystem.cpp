@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/FlightTrailSubsystem.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "NiagaraComponent.h"
+#include "NiagaraDataInterfaceArrayFunctionLibrary.h"
+#include "NiagaraSystem.h"
+#include "Steelheart/Steelheart.h"
+#include "Steelheart/Subsystems/Public/FlightEffectsBudgetSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flight Trails Write"), STAT_FlightTrailsWrite, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight Trail Points"), STAT_FlightTrailPoints, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<int32> CVarFlightTrailsMaxSources(
+	TEXT("Flight.Trails.MaxSources"),
+	32,
+	TEXT("Maximum number of dash trails written to the shared trail system each frame. Past the cap, the trails nearest to the view are kept."));
+
+static FAutoConsoleCommandWithWorld FlightTrailsReportCommand(
+	TEXT("Flight.Trails.Report"),
+	TEXT("Log the sources of the shared trail system"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UFlightTrailSubsystem* Trails = World ? World->GetSubsystem<UFlightTrailSubsystem>() : nullptr)
+		{
+			Trails->LogReport();
+		}
+	}));
+
+// Names of the user arrays of the shared trail system
+static const FName TrailPositionsName(TEXT("User.TrailPositions"));
+static const FName TrailVelocitiesName(TEXT("User.TrailVelocities"));
+static const FName TrailKindsName(TEXT("User.TrailKinds"));
+static const FName TrailSourcesName(TEXT("User.TrailSources"));
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UFlightTrailSubsystem::Deinitialize()
+{
+	if (TrailComponent != nullptr)
+	{
+		TrailComponent->DestroyComponent();
+		TrailComponent = nullptr;
+	}
+
+	Sources.Empty();
+	PendingPuffs.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFlightTrailSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (TrailComponent == nullptr || (!bWroteLastFrame && Sources.Num() == 0 && PendingPuffs.Num() == 0))
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FlightTrailsWrite);
+
+	Sources.RemoveAllSwap([](const FTrailSource& Source) { return !Source.Component.IsValid(); });
+	CullDistantSources(FMath::Min(CVarFlightTrailsMaxSources.GetValueOnGameThread(), BudgetedSources));
+
+	Positions.Reset();
+	Velocities.Reset();
+	Kinds.Reset();
+	SourceIds.Reset();
+
+	// One point per followed source
+	for (int32 SourceIndex : WrittenSources)
+	{
+		const FTrailSource& Source = Sources[SourceIndex];
+		const USceneComponent* Component = Source.Component.Get();
+
+		Positions.Add(Component->GetComponentTransform().TransformPosition(Source.RelativeOffset));
+		Velocities.Add(Component->GetOwner() ? Component->GetOwner()->GetVelocity() : FVector::ZeroVector);
+		Kinds.Add((int32)Source.Kind);
+		SourceIds.Add(Source.Id);
+	}
+
+	// One point per puff queued since the last frame, puffs have no ribbon to continue
+	for (const FTrailPuff& Puff : PendingPuffs)
+	{
+		Positions.Add(Puff.Location);
+		Velocities.Add(Puff.Velocity);
+		Kinds.Add((int32)Puff.Kind);
+		SourceIds.Add(INDEX_NONE);
+	}
+
+	PendingPuffs.Reset();
+
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(TrailComponent, TrailPositionsName, Positions);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(TrailComponent, TrailVelocitiesName, Velocities);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(TrailComponent, TrailKindsName, Kinds);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(TrailComponent, TrailSourcesName, SourceIds);
+
+	bWroteLastFrame = Positions.Num() > 0;
+
+	SET_DWORD_STAT(STAT_FlightTrailPoints, Positions.Num());
+}
+
+TStatId UFlightTrailSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFlightTrailSubsystem, STATGROUP_Steelheart);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Trail Functions
+
+bool UFlightTrailSubsystem::SetTrailSystem(UNiagaraSystem* System)
+{
+	if (System == nullptr)
+	{
+		return false;
+	}
+
+	if (TrailComponent == nullptr)
+	{
+		CreateTrailComponent(System);
+	}
+
+	return TrailComponent->GetAsset() == System;
+}
+
+int32 UFlightTrailSubsystem::AddTrailSource(USceneComponent* Source, FVector RelativeOffset, EFlightTrailKind Kind)
+{
+	FTrailSource& NewSource = Sources.AddDefaulted_GetRef();
+	NewSource.Component = Source;
+	NewSource.RelativeOffset = RelativeOffset;
+	NewSource.Kind = Kind;
+	NewSource.Id = NextSourceId++;
+
+	return NewSource.Id;
+}
+
+void UFlightTrailSubsystem::RemoveTrailSource(int32 SourceId)
+{
+	Sources.RemoveAllSwap([SourceId](const FTrailSource& Source) { return Source.Id == SourceId; });
+}
+
+void UFlightTrailSubsystem::AddPuff(FVector Location, FVector Velocity, EFlightTrailKind Kind)
+{
+	if (TrailComponent != nullptr)
+	{
+		PendingPuffs.Add({ Location, Velocity, Kind });
+	}
+}
+
+void UFlightTrailSubsystem::CreateTrailComponent(UNiagaraSystem* System)
+{
+	// The trail points are written in world space, so the component stays at the origin
+	TrailComponent = NewObject<UNiagaraComponent>(GetWorld());
+	TrailComponent->SetAutoActivate(false);
+	TrailComponent->SetAutoDestroy(false);
+	TrailComponent->SetUsingAbsoluteLocation(true);
+	TrailComponent->SetUsingAbsoluteRotation(true);
+	TrailComponent->SetAsset(System);
+	TrailComponent->RegisterComponentWithWorld(GetWorld());
+	TrailComponent->Activate(true);
+
+	// The budget lowers the spawn rate of the whole system and the sources it draws as the dash trails pile up
+	if (UFlightEffectsBudgetSubsystem* EffectsBudget = GetWorld()->GetSubsystem<UFlightEffectsBudgetSubsystem>())
+	{
+		EffectsBudget->RegisterTrails(this);
+	}
+}
+
+void UFlightTrailSubsystem::CullDistantSources(int32 MaxSources)
+{
+	WrittenSources.Reset();
+	for (int32 SourceIndex = 0; SourceIndex < Sources.Num(); SourceIndex++)
+	{
+		WrittenSources.Add(SourceIndex);
+	}
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (WrittenSources.Num() <= MaxSources || PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr)
+	{
+		return;
+	}
+
+	FVector ViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	WrittenSources.Sort([this, &ViewLocation](int32 A, int32 B)
+	{
+		return FVector::DistSquared(Sources[A].Component->GetComponentLocation(), ViewLocation)
+			< FVector::DistSquared(Sources[B].Component->GetComponentLocation(), ViewLocation);
+	});
+
+	WrittenSources.SetNum(MaxSources, false);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UFlightTrailSubsystem::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Flight trails: system %s, %d sources (%d budgeted), %d points written last frame (capacity %d)"),
+		TrailComponent ? *GetNameSafe(TrailComponent->GetAsset()) : TEXT("None"), Sources.Num(), BudgetedSources, Positions.Num(), Positions.Max());
+
+	for (const FTrailSource& Source : Sources)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %3d  %s"), Source.Id, *GetNameSafe(Source.Component.IsValid() ? Source.Component->GetOwner() : nullptr));
+	}
+}
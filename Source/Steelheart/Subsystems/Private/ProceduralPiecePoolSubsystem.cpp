@@ -0,0 +1,309 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Steelheart/Subsystems/Public/ProceduralPiecePoolSubsystem.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "ProceduralMeshComponent.h"
+#include "Steelheart/Slicing/Public/MeshSlicer.h"
+#include "Steelheart/Steelheart.h"
+
+DECLARE_CYCLE_STAT(TEXT("Piece Pool Write Sections"), STAT_PiecePoolWriteSections, STATGROUP_Steelheart);
+DECLARE_CYCLE_STAT(TEXT("Piece Pool Update"), STAT_PiecePoolUpdate, STATGROUP_Steelheart);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Piece Pool Pieces"), STAT_PiecePoolPieces, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Piece Pool Pieces Created"), STAT_PiecePoolCreated, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Piece Pool Buffer Allocations"), STAT_PiecePoolBufferAllocations, STATGROUP_Steelheart);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Piece Pool Pieces Refused"), STAT_PiecePoolRefused, STATGROUP_Steelheart);
+
+static TAutoConsoleVariable<int32> CVarFlightPiecePoolMaxPieces(
+	TEXT("Flight.PiecePool.MaxPieces"),
+	64,
+	TEXT("Procedural pieces in use across the world. Past it, the oldest falling piece out of sight, or else asleep, is taken back for the new one."));
+
+static TAutoConsoleVariable<float> CVarFlightPiecePoolInterval(
+	TEXT("Flight.PiecePool.Interval"),
+	1.f,
+	TEXT("Seconds between two sweeps of the pieces in use for the ones fallen below the kill plane or asleep out of sight."));
+
+static TAutoConsoleVariable<float> CVarFlightPiecePoolOutOfSightTime(
+	TEXT("Flight.PiecePool.OutOfSightTime"),
+	5.f,
+	TEXT("Seconds a falling piece goes unrendered before it counts as out of sight."));
+
+static FAutoConsoleCommandWithWorld FlightPiecePoolReportCommand(
+	TEXT("Flight.PiecePool.Report"),
+	TEXT("Log the procedural piece pool along with the components and buffers allocated and reused"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UProceduralPiecePoolSubsystem* PiecePool = World ? World->GetSubsystem<UProceduralPiecePoolSubsystem>() : nullptr)
+		{
+			PiecePool->LogReport();
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// Lifecycle Functions
+
+void UProceduralPiecePoolSubsystem::Deinitialize()
+{
+	// Tear down every pooled piece along with the world
+	for (UProceduralMeshComponent* Piece : Free)
+	{
+		if (IsValid(Piece))
+		{
+			Piece->DestroyComponent();
+		}
+	}
+
+	for (const FPooledPiece& Used : Active)
+	{
+		if (IsValid(Used.Piece))
+		{
+			Used.Piece->DestroyComponent();
+		}
+	}
+
+	DEC_DWORD_STAT_BY(STAT_PiecePoolPieces, Free.Num() + Active.Num());
+
+	Free.Empty();
+	Active.Empty();
+
+	Super::Deinitialize();
+}
+
+void UProceduralPiecePoolSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TimeSinceUpdate += DeltaTime;
+	if (Active.Num() == 0 || TimeSinceUpdate < CVarFlightPiecePoolInterval.GetValueOnGameThread())
+	{
+		return;
+	}
+
+	TimeSinceUpdate = 0.f;
+
+	SCOPE_CYCLE_COUNTER(STAT_PiecePoolUpdate);
+
+	ReleaseLostPieces();
+}
+
+TStatId UProceduralPiecePoolSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProceduralPiecePoolSubsystem, STATGROUP_Steelheart);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Pool Functions
+
+UProceduralMeshComponent* UProceduralPiecePoolSubsystem::AcquirePiece(const FTransform& Transform, AActor* Owner, const UProceduralMeshComponent* Template)
+{
+	// Pieces destroyed outside of the pool, by a blueprint or along with the level, are dropped
+	Free.RemoveAll([](const UProceduralMeshComponent* Piece) { return !IsValid(Piece); });
+	Active.RemoveAll([](const FPooledPiece& Used) { return !IsValid(Used.Piece); });
+
+	// Pieces in use stay where they are, only released pieces are ever handed out again
+	UProceduralMeshComponent* Piece = nullptr;
+	if (Free.Num() > 0)
+	{
+		Piece = Free.Pop(false);
+		Reused++;
+	}
+	else if (Active.Num() < CVarFlightPiecePoolMaxPieces.GetValueOnGameThread())
+	{
+		Piece = CreatePiece();
+		Created++;
+	}
+	else if (UProceduralMeshComponent* Recyclable = FindRecyclablePiece(Template))
+	{
+		// The piece goes through a release so its owner, collision and physics are reset like any other
+		ReleasePiece(Recyclable);
+		Piece = Free.Pop(false);
+		Recycled++;
+	}
+	else
+	{
+		Refused++;
+		INC_DWORD_STAT(STAT_PiecePoolRefused);
+		return nullptr;
+	}
+
+	FPooledPiece& Used = Active.AddDefaulted_GetRef();
+	Used.Piece = Piece;
+	Used.Owner = Owner;
+
+	if (Owner != nullptr)
+	{
+		Owner->OnEndPlay.AddUniqueDynamic(this, &UProceduralPiecePoolSubsystem::HandleOwnerEndPlay);
+	}
+
+	if (Template != nullptr)
+	{
+		// Custom profiles keep their settings out of the profile name, the object type and responses are copied too
+		// so the piece still answers the traces of the slicer and the flight impacts
+		Piece->bUseComplexAsSimpleCollision = Template->bUseComplexAsSimpleCollision;
+		Piece->SetCollisionProfileName(Template->GetCollisionProfileName());
+		Piece->SetCollisionObjectType(Template->GetCollisionObjectType());
+		Piece->SetCollisionResponseToChannels(Template->GetCollisionResponseToChannels());
+		Piece->SetCollisionEnabled(Template->GetCollisionEnabled());
+	}
+	else
+	{
+		Piece->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	}
+
+	Piece->SetWorldTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	Piece->SetVisibility(true);
+
+	return Piece;
+}
+
+void UProceduralPiecePoolSubsystem::ReleasePiece(UProceduralMeshComponent* Piece)
+{
+	// Pieces the pool did not hand out, or already released, are left alone
+	if (Piece == nullptr || Active.RemoveAll([Piece](const FPooledPiece& Used) { return Used.Piece == Piece; }) == 0)
+	{
+		return;
+	}
+
+	// The sections are hidden along with the piece, their buffers are kept for the next user
+	Piece->SetSimulatePhysics(false);
+	Piece->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Piece->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	Piece->SetVisibility(false);
+
+	Released++;
+
+	Free.Add(Piece);
+}
+
+UProceduralMeshComponent* UProceduralPiecePoolSubsystem::FindRecyclablePiece(const UProceduralMeshComponent* Exclude) const
+{
+	// Only pieces left to fall apart are taken, pieces not simulating are held in place by their actor
+	float OutOfSightTime = CVarFlightPiecePoolOutOfSightTime.GetValueOnGameThread();
+
+	UProceduralMeshComponent* Asleep = nullptr;
+	for (const FPooledPiece& Used : Active)
+	{
+		UProceduralMeshComponent* Piece = Used.Piece;
+		if (Piece == Exclude || !IsValid(Piece) || !Piece->IsSimulatingPhysics())
+		{
+			continue;
+		}
+
+		if (!Piece->WasRecentlyRendered(OutOfSightTime))
+		{
+			return Piece;
+		}
+
+		if (Asleep == nullptr && !Piece->RigidBodyIsAwake())
+		{
+			Asleep = Piece;
+		}
+	}
+
+	return Asleep;
+}
+
+void UProceduralPiecePoolSubsystem::ReleaseLostPieces()
+{
+	AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings();
+	bool bKillZ = WorldSettings != nullptr && WorldSettings->bEnableWorldBoundsChecks;
+	float KillZ = bKillZ ? WorldSettings->KillZ : 0.f;
+	float OutOfSightTime = CVarFlightPiecePoolOutOfSightTime.GetValueOnGameThread();
+
+	// Pieces fallen out of the world, or settled where nobody has seen them for a while, would otherwise hold their
+	// place in the budget for good
+	TArray<UProceduralMeshComponent*, TInlineAllocator<16>> LostPieces;
+	for (const FPooledPiece& Used : Active)
+	{
+		UProceduralMeshComponent* Piece = Used.Piece;
+		if (!IsValid(Piece) || !Piece->IsSimulatingPhysics())
+		{
+			continue;
+		}
+
+		bool bBelowKillZ = bKillZ && Piece->GetComponentLocation().Z < KillZ;
+		bool bAsleepOutOfSight = !Piece->RigidBodyIsAwake() && !Piece->WasRecentlyRendered(OutOfSightTime);
+		if (bBelowKillZ || bAsleepOutOfSight)
+		{
+			LostPieces.Add(Piece);
+		}
+	}
+
+	for (UProceduralMeshComponent* Piece : LostPieces)
+	{
+		ReleasePiece(Piece);
+	}
+
+	Lost += LostPieces.Num();
+}
+
+AActor* UProceduralPiecePoolSubsystem::GetPieceOwner(const UProceduralMeshComponent* Piece) const
+{
+	const FPooledPiece* Used = Active.FindByPredicate([Piece](const FPooledPiece& Candidate) { return Candidate.Piece == Piece; });
+	return Used != nullptr ? Used->Owner.Get() : nullptr;
+}
+
+void UProceduralPiecePoolSubsystem::HandleOwnerEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	// Pieces live in the world rather than in their actor, so they would otherwise outlive it
+	TArray<UProceduralMeshComponent*> OwnedPieces;
+	for (const FPooledPiece& Used : Active)
+	{
+		if (Used.Owner.Get() == Actor)
+		{
+			OwnedPieces.Add(Used.Piece);
+		}
+	}
+
+	for (UProceduralMeshComponent* Piece : OwnedPieces)
+	{
+		ReleasePiece(Piece);
+	}
+}
+
+void UProceduralPiecePoolSubsystem::WriteSections(UProceduralMeshComponent* ProcMesh, const FSlicerMesh& Mesh, const UProceduralMeshComponent* Source, UMaterialInterface* CapMaterial)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PiecePoolWriteSections);
+
+	int32 Allocations = Mesh.CopyTo(ProcMesh, Source, CapMaterial);
+
+	SectionWrites++;
+	BufferAllocations += Allocations;
+
+	INC_DWORD_STAT_BY(STAT_PiecePoolBufferAllocations, Allocations);
+}
+
+UProceduralMeshComponent* UProceduralPiecePoolSubsystem::CreatePiece()
+{
+	// Pieces are named after the pool, one name per piece
+	FName PieceName = MakeUniqueObjectName(GetWorld(), UProceduralMeshComponent::StaticClass(), TEXT("ProcPiece"));
+
+	UProceduralMeshComponent* Piece = NewObject<UProceduralMeshComponent>(GetWorld(), PieceName, RF_Transient);
+
+	// Every write of a piece recooks its collision, which is kept off the game thread
+	Piece->bUseAsyncCooking = true;
+	Piece->RegisterComponentWithWorld(GetWorld());
+
+	INC_DWORD_STAT(STAT_PiecePoolPieces);
+	INC_DWORD_STAT(STAT_PiecePoolCreated);
+
+	return Piece;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Reporting Functions
+
+void UProceduralPiecePoolSubsystem::LogReport() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Procedural piece pool (max %d): free %d  active %d"),
+		CVarFlightPiecePoolMaxPieces.GetValueOnGameThread(), Free.Num(), Active.Num());
+
+	UE_LOG(LogTemp, Log, TEXT("  components: created %d  reused %d  released %d  lost %d  recycled past the budget %d  refused past the budget %d"),
+		Created, Reused, Released, Lost, Recycled, Refused);
+
+	UE_LOG(LogTemp, Log, TEXT("  sections: %d writes, %d buffer allocations, %.2f per write"), SectionWrites, BufferAllocations,
+		SectionWrites > 0 ? (float)BufferAllocations / SectionWrites : 0.f);
+}
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DestructibleDebrisSubsystem.generated.h"
+
+// Forward declarations
+class UGeometryCollectionComponent;
+
+/**
+ * World level lifecycle of the pieces broken off destructibles by flight impacts.
+ * A few times per second, freezes the pieces that have settled, small pieces much sooner than large ones,
+ * and removes the oldest and farthest moving pieces past a global budget, so the bodies left for the solver stay bounded
+ * however much of the world has been destroyed.
+ */
+UCLASS()
+class STEELHEART_API UDestructibleDebrisSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	// Start tracking the pieces of a collection struck by a flight impact
+	void TrackCollection(UGeometryCollectionComponent* Collection);
+
+	// Record the pieces still moving in the collections of a level to the destruction journal, every level if null
+	void RecordMovingPieces(ULevel* Level);
+
+	// Log the tracked collections along with their moving, frozen and removed pieces
+	void LogReport() const;
+
+private:
+	// Pieces of one collection, indexed by transform
+	struct FTrackedCollection
+	{
+		TWeakObjectPtr<UGeometryCollectionComponent> Component;
+
+		// Radius of the rest bounds of each piece
+		TArray<float> PieceRadii;
+
+		// Position each piece was last seen moving from
+		TArray<FVector> LastPositions;
+
+		// Time each piece was first seen moving, negative until then
+		TArray<float> MovingSince;
+
+		// Time each piece last moved
+		TArray<float> StillSince;
+
+		// Pieces frozen or removed, never considered again
+		TBitArray<> Retired;
+
+		// Last time any piece of the collection was seen moving
+		float LastMovingTime = 0.f;
+
+		int32 MovingPieces = 0;
+	};
+
+	// Moving piece over the budget candidates for removal
+	struct FMovingPiece
+	{
+		int32 CollectionIndex = INDEX_NONE;
+
+		int32 PieceIndex = INDEX_NONE;
+
+		FVector Location = FVector::ZeroVector;
+
+		// Priority of removal, higher for older and farther pieces
+		float Score = 0.f;
+	};
+
+	// Freeze the settled pieces of a collection and gather its moving ones
+	void UpdateCollection(int32 CollectionIndex, float CurrentTime);
+
+	// Remove the moving pieces past the budget, oldest and farthest first
+	void EnforceBudget();
+
+	TArray<FTrackedCollection> Collections;
+
+	// Moving pieces of the last update, kept between updates so gathering them does not allocate
+	TArray<FMovingPiece> MovingPieces;
+
+	// Flyer locations of the last update
+	TArray<FVector> FlyerLocations;
+
+	float TimeSinceUpdate = 0.f;
+
+	int32 FrozenPieces = 0;
+
+	int32 RemovedPieces = 0;
+
+	int32 ReleasedCollections = 0;
+};
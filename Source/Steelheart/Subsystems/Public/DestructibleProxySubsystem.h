@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DestructibleProxySubsystem.generated.h"
+
+// Forward declarations
+class ADestructibleProxyActor;
+
+/**
+ * World level driver of the destructible proxies.
+ * A few times per second, swaps in the live collection of the proxies within a speed scaled radius of every flyer,
+ * and swaps back out the undamaged ones no flyer has come near for a while.
+ * Also routes impacts on proxies to their recorded fractures, falling back to the simulation.
+ */
+UCLASS()
+class STEELHEART_API UDestructibleProxySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	// Add or remove a proxy driven by this subsystem
+	void RegisterProxy(ADestructibleProxyActor* Proxy);
+
+	void UnregisterProxy(ADestructibleProxyActor* Proxy);
+
+	/**
+	 * Requests the live collection of a destructible, if it is a proxy.
+	 *
+	 * @param Destructible The destructible wanted live.
+	 * @param bImmediate If true, a collection already loaded is swapped in within this call.
+	 * @return True if the destructible can be struck now, false if it is a proxy whose collection is still streaming in.
+	 */
+	bool RequestLive(AActor* Destructible, bool bImmediate);
+
+	/**
+	 * Plays back the recorded fracture of a destructible for an impact, if it is a live proxy with one recorded.
+	 *
+	 * @param Destructible The destructible struck.
+	 * @param ImpactVelocity Velocity of the flyer striking it.
+	 * @return True if a recording is played back, false if the fracture is left to the simulation.
+	 */
+	bool PlayImpact(AActor* Destructible, const FVector& ImpactVelocity);
+
+	// Log the live and swapped out proxies along with the bodies and memory of the live collections
+	void LogReport() const;
+
+private:
+	// Swap in the proxies near every flyer
+	void RequestProxiesNearFlyers();
+
+	// Swap out the proxies unwanted for long enough
+	void ReturnIdleProxies();
+
+	TArray<TWeakObjectPtr<ADestructibleProxyActor>> Proxies;
+
+	// Destructibles found near a flyer, kept between updates so finding them does not allocate
+	TArray<AActor*> FoundDestructibles;
+
+	float TimeSinceUpdate = 0.f;
+
+	int32 SwapsIn = 0;
+
+	int32 SwapsOut = 0;
+
+	// Impacts on proxies played back from a recording and left to the simulation
+	int32 CachedImpacts = 0;
+	int32 SimulatedImpacts = 0;
+};
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "Math/GenericOctree.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "DestructibleRegistrySubsystem.generated.h"
+
+/**
+ * World level registry of the destructible actors, indexed by their bounds.
+ * Actors register through a UDestructibleMarkerComponent or, for older content, by carrying a tag scanned once per world.
+ * Answers whether an actor is destructible in constant time, and which destructibles lie within a radius or along a segment
+ * through an octree updated incrementally as they are added, moved and removed.
+ */
+UCLASS()
+class STEELHEART_API UDestructibleRegistrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	// Add an actor to the registry, or refresh its bounds if already registered
+	void RegisterDestructible(AActor* Actor);
+
+	void UnregisterDestructible(AActor* Actor);
+
+	// Register the actors carrying a tag, now and whenever they are spawned or streamed in later
+	void RegisterTaggedActors(FName Tag);
+
+	// Add object types dashes strike, as a bitfield of collision channels, warning about the destructibles none of them match
+	void AddStrikableObjectTypes(int32 ObjectTypes);
+
+	// Check whether an actor is registered as destructible
+	FORCEINLINE bool IsDestructible(const AActor* Actor) const { return ElementIds.Contains(Actor); }
+
+	// Number of registered destructibles
+	FORCEINLINE int32 Num() const { return ElementIds.Num(); }
+
+	/**
+	 * Finds the destructibles whose bounds overlap a sphere.
+	 *
+	 * @param Center Center of the sphere.
+	 * @param Radius Radius of the sphere.
+	 * @param OutActors Destructibles found, appended to the array.
+	 */
+	void FindInRadius(const FVector& Center, float Radius, TArray<AActor*>& OutActors) const;
+
+	// Check whether any destructible bounds overlap a sphere
+	bool AnyInRadius(const FVector& Center, float Radius) const;
+
+	/**
+	 * Finds the destructibles whose bounds are within a radius of a segment, or of its start if it has no length.
+	 *
+	 * @param Start Start of the segment.
+	 * @param End End of the segment.
+	 * @param Radius Distance to the segment, zero for a line.
+	 * @param OutActors Destructibles found, appended to the array.
+	 */
+	void FindAlongSegment(const FVector& Start, const FVector& End, float Radius, TArray<AActor*>& OutActors) const;
+
+	// Log the registered destructibles along with the size of the index
+	void LogReport() const;
+
+private:
+	// Destructible stored in the octree
+	struct FDestructibleElement
+	{
+		TWeakObjectPtr<AActor> Actor;
+
+		TObjectKey<AActor> Key;
+
+		FBox Bounds;
+
+		// Identifiers of the registry, kept up to date as the octree moves elements between nodes
+		TMap<TObjectKey<AActor>, FOctreeElementId2>* ElementIds = nullptr;
+	};
+
+	struct FDestructibleOctreeSemantics
+	{
+		enum { MaxElementsPerLeaf = 16 };
+		enum { MinInclusiveElementsPerNode = 7 };
+		enum { MaxNodeDepth = 12 };
+
+		typedef TInlineAllocator<MaxElementsPerLeaf> ElementAllocator;
+
+		FORCEINLINE static FBoxCenterAndExtent GetBoundingBox(const FDestructibleElement& Element)
+		{
+			return FBoxCenterAndExtent(Element.Bounds);
+		}
+
+		FORCEINLINE static bool AreElementsEqual(const FDestructibleElement& A, const FDestructibleElement& B)
+		{
+			return A.Key == B.Key;
+		}
+
+		FORCEINLINE static void SetElementId(const FDestructibleElement& Element, FOctreeElementId2 Id)
+		{
+			Element.ElementIds->Add(Element.Key, Id);
+		}
+
+		FORCEINLINE static void ApplyOffset(FDestructibleElement& Element, const FVector& Offset)
+		{
+			Element.Bounds = Element.Bounds.ShiftBy(Offset);
+		}
+	};
+
+	// Remove a registered actor from the octree
+	void RemoveElement(const AActor* Actor);
+
+	// Register the actors of a level carrying one of the scanned tags
+	void RegisterTaggedActorsInLevel(ULevel* Level);
+
+	// Register the spawned actors carrying one of the scanned tags
+	void HandleActorSpawned(AActor* Actor);
+
+	void HandleLevelAdded(ULevel* Level, UWorld* World);
+
+	// Keep the bounds of moving destructibles up to date
+	void HandleTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	UFUNCTION()
+		void HandleEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	// Check whether an actor carries one of the scanned tags
+	bool HasScannedTag(const AActor* Actor) const;
+
+	// Warn about a destructible with no colliding component of an object type dashes strike, as it takes no dash impacts
+	void WarnIfNotStrikable(const AActor* Actor) const;
+
+	TOctree2<FDestructibleElement, FDestructibleOctreeSemantics> Octree{ FVector::ZeroVector, HALF_WORLD_MAX };
+
+	// Octree element of each registered actor
+	TMap<TObjectKey<AActor>, FOctreeElementId2> ElementIds;
+
+	// Tags whose actors are registered automatically
+	TArray<FName> ScannedTags;
+
+	// Object types struck by the dashes of any flyer, as a bitfield of collision channels
+	int32 StrikableObjectTypes = 0;
+
+	FDelegateHandle ActorSpawnedHandle;
+
+	FDelegateHandle LevelAddedHandle;
+
+	// Queries are counted from the const query functions
+	mutable int32 Queries = 0;
+
+	int32 BoundsUpdates = 0;
+};
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Chaos/ChaosGameplayEventDispatcher.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DestructibleSupportSubsystem.generated.h"
+
+// Forward declarations
+class UDestructibleSupportGraph;
+class UGeometryCollectionComponent;
+
+/**
+ * World level structural support of the buildings with a baked support graph.
+ * Pieces breaking off a building are marked broken in its graph, and the next evaluation searches for support
+ * from their neighbours only, on a worker thread. Every piece left without a path to an anchor is collapsed,
+ * all buildings at once, through one strain field submitted with the impacts of the frame.
+ */
+UCLASS()
+class STEELHEART_API UDestructibleSupportSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Starts evaluating the support of a building as its pieces break off.
+	 *
+	 * @param Collection The collection of the building.
+	 * @param Graph The support graph baked from the collection.
+	 */
+	void RegisterBuilding(UGeometryCollectionComponent* Collection, UDestructibleSupportGraph* Graph);
+
+	// Stop evaluating the support of a building, before its collection is destroyed or swapped out
+	void UnregisterBuilding(UGeometryCollectionComponent* Collection);
+
+	// Log the buildings along with the nodes broken and collapsed and the work of the evaluations
+	void LogReport() const;
+
+private:
+	// Support state of one building
+	struct FSupportBuilding
+	{
+		TWeakObjectPtr<UGeometryCollectionComponent> Component;
+
+		UDestructibleSupportGraph* Graph = nullptr;
+
+		// Node of each transform of the collection, INDEX_NONE for clusters
+		TArray<int32> TransformNodes;
+
+		// Nodes no longer carrying their neighbours, broken off or collapsed
+		TBitArray<> Broken;
+
+		// Nodes broken since the last evaluation
+		TArray<int32> NewlyBroken;
+
+		int32 CollapsedNodes = 0;
+	};
+
+	// Input of the evaluation of one building, copied so the worker never reads state the game thread writes
+	struct FSupportEvaluation
+	{
+		int32 BuildingIndex = INDEX_NONE;
+
+		const UDestructibleSupportGraph* Graph = nullptr;
+
+		TBitArray<> Broken;
+
+		// Nodes next to the newly broken ones, the only places support can have been lost from
+		TArray<int32> Seeds;
+
+		// Nodes found without support
+		TArray<int32> Unsupported;
+
+		// Nodes visited by the search
+		int32 Visited = 0;
+	};
+
+	// Mark the node of a piece broken off a building
+	UFUNCTION()
+		void HandleBreak(const FChaosBreakEvent& BreakEvent);
+
+	// Drop the unregistered and destroyed buildings, once no evaluation refers to them by index
+	void RemoveReleasedBuildings();
+
+	// Start the evaluation of every building with newly broken nodes
+	void LaunchEvaluation();
+
+	// Collapse the nodes found without support by the finished evaluation
+	void ApplyEvaluation(TArray<FSupportEvaluation>& Evaluations);
+
+	// Search for the support of the seeds of one building, run on a worker thread
+	static void Evaluate(FSupportEvaluation& Evaluation);
+
+	TArray<FSupportBuilding> Buildings;
+
+	// Graphs of the registered buildings, kept loaded while evaluations read them
+	UPROPERTY()
+		TArray<UDestructibleSupportGraph*> Graphs;
+
+	// Evaluation in flight, at most one at a time
+	TFuture<TArray<FSupportEvaluation>> PendingEvaluation;
+
+	int32 Evaluations = 0;
+
+	int32 BrokenNodes = 0;
+
+	int32 CollapsedNodes = 0;
+
+	int32 VisitedNodes = 0;
+};
@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "DestructionJournalSubsystem.generated.h"
+
+// Forward declarations
+class UGeometryCollectionComponent;
+
+/**
+ * Game level journal of the destruction caused by flight impacts, kept across level streaming and reloads.
+ * Impacts and the final state of the pieces they broke off are appended to a compact binary delta log on disk,
+ * later records overriding earlier ones. Collections streaming back in are given their recorded pieces as rest state,
+ * so the destruction reappears without simulating anything. Large journals are read through a memory mapped file.
+ * Each save slot has its own journal, rewritten with only the latest state of every piece once it has grown past it.
+ * The file is written on the thread pool, one write at a time, from a snapshot of the records taken on the game thread.
+ * Play in editor sessions always start from an empty journal of their own.
+ */
+UCLASS()
+class STEELHEART_API UDestructionJournalSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Switches the journal to a save slot, flushing the slot open until now.
+	 *
+	 * @param InSlotName Name of the save slot.
+	 * @param bNewGame True to start the slot over, forgetting the destruction recorded in it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = Destruction)
+		void OpenSlot(const FString& InSlotName, bool bNewGame);
+
+	// Get the name of the save slot the journal is recorded to
+	FORCEINLINE const FString& GetSlotName() const { return SlotName; }
+
+	// Identifier of a destructible, stable across sessions and play in editor instances
+	static uint32 GetTargetId(const AActor* Destructible);
+
+	/**
+	 * Records an impact along with the destructibles within its radius.
+	 *
+	 * @param Location Center of the impact.
+	 * @param Radius Radius of the impact.
+	 * @param StrainMagnitude Strain applied at the center of the impact.
+	 * @param VelocityMagnitude Outward velocity given to the pieces.
+	 * @param ImpactTargets Destructibles within the radius.
+	 */
+	void RecordImpact(const FVector& Location, float Radius, float StrainMagnitude, float VelocityMagnitude, const TArray<AActor*>& ImpactTargets);
+
+	/**
+	 * Records the final state of a piece of a collection.
+	 *
+	 * @param Collection The collection the piece belongs to.
+	 * @param PieceIndex Transform index of the piece.
+	 * @param PieceTransform Transform of the piece in the space of the collection.
+	 * @param bRemoved True if the piece was removed from the world.
+	 */
+	void RecordPiece(const UGeometryCollectionComponent* Collection, int32 PieceIndex, const FTransform& PieceTransform, bool bRemoved);
+
+	// Check whether any destruction is recorded for a destructible
+	bool HasRecord(const AActor* Destructible) const;
+
+	/**
+	 * Gives a collection the recorded state of its pieces as rest state.
+	 * Called before the physics state of the collection is created when possible, recreated otherwise.
+	 *
+	 * @param Collection The collection streaming in.
+	 * @return True if any recorded piece was restored.
+	 */
+	bool RestoreCollection(UGeometryCollectionComponent* Collection);
+
+	// Append the records made since the last flush to the journal file, on the thread pool
+	void Flush();
+
+	// Rewrite the journal file with only the latest state of every destructible, on the thread pool
+	void Compact();
+
+	// Forget every record and delete the journal file
+	void Clear();
+
+	// Log the journal size along with the records loaded, made and restored
+	void LogReport() const;
+
+private:
+	// Recorded state of one piece, in the space of its collection
+	struct FJournalPiece
+	{
+		FVector3f Position = FVector3f::ZeroVector;
+
+		FQuat4f Rotation = FQuat4f::Identity;
+
+		bool bRemoved = false;
+	};
+
+	// Recorded destruction of one destructible
+	struct FJournalTarget
+	{
+		TMap<int32, FJournalPiece> Pieces;
+
+		int32 Impacts = 0;
+	};
+
+	// Read the journal file, memory mapped past the size threshold
+	void Load();
+
+	// Decode records into the journal state
+	void ReadRecords(TArrayView<const uint8> Bytes);
+
+	// Encode the state of a piece as a piece record
+	static void WritePieceRecord(FArchive& Writer, uint32 TargetId, int32 PieceIndex, const FJournalPiece& Piece);
+
+	// Path of the journal file of the open slot
+	FString GetJournalPath() const;
+
+	// Wait for the write in flight and account for it, putting its records back in front of the pending ones if it failed
+	void FinishWrite();
+
+	// Flush the records of a level streaming out, once the debris subsystem has recorded its pieces still moving
+	void HandleLevelRemoved(ULevel* Level, UWorld* World);
+
+	void HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+
+	TMap<uint32, FJournalTarget> Targets;
+
+	// Save slot the journal is recorded to
+	FString SlotName;
+
+	// Records made since the last flush, encoded as they are appended to the file
+	TArray<uint8> PendingRecords;
+
+	// Write of the journal file in flight, giving the bytes written or INDEX_NONE if it failed
+	TFuture<int64> PendingWrite;
+
+	// Records taken by the write in flight, kept until it succeeds
+	TArray<uint8> WritingRecords;
+
+	// True if the write in flight rewrites the whole journal rather than appending to it
+	bool bWritingCompacted = false;
+
+	FDelegateHandle LevelRemovedHandle;
+
+	FDelegateHandle WorldCleanupHandle;
+
+	int64 FileSize = 0;
+
+	// Size of the journal file when it was last loaded or rewritten without redundant records
+	int64 CompactedSize = 0;
+
+	bool bLoadedMapped = false;
+
+	int32 LoadedRecords = 0;
+
+	int32 RecordedImpacts = 0;
+
+	int32 RecordedPieces = 0;
+
+	int32 RestoredCollections = 0;
+
+	int32 RestoredPieces = 0;
+
+	int32 Compactions = 0;
+};
@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FlightEffectsBudgetSubsystem.generated.h"
+
+// Forward declarations
+class UFXSystemComponent;
+class UFlightEffectsComponent;
+class UFlightTrailSubsystem;
+class UNiagaraComponent;
+class UNiagaraSystem;
+
+// Flight effect types budgeted separately from each other
+enum class EFlightEffectType : uint8
+{
+	DashTrail,
+	Hover,
+	SonicBoom,
+	DiveTrail,
+	TakeoffCharge,
+	Count
+};
+
+// Quality an effect instance is allowed to run at
+enum class EFlightEffectTier : uint8
+{
+	Full,
+	Reduced,
+	Culled
+};
+
+/**
+ * One active effect instance offered to the budget by a flyer.
+ */
+struct FFlightBudgetedEffect
+{
+	UFXSystemComponent* Component = nullptr;
+
+	EFlightEffectType Type = EFlightEffectType::DashTrail;
+
+	// Effects of the locally controlled flyer always rank first
+	bool bLocallyControlled = false;
+
+	// False for one-shots and effects asked to deactivate, which are stopped rather than culled as a paused system never finishes
+	bool bSustained = true;
+
+	// Filled in by the budget when ranking
+	float Score = 0.f;
+};
+
+/**
+ * World level budget of the attached flight effects.
+ * Ranks every active effect by its screen size a few times per second and, for each effect type,
+ * keeps the best ranked instances at full quality, lowers the spawn rate of the next ones and culls the rest.
+ * The sources of the shared trail system count against the dash trail caps.
+ */
+UCLASS()
+class STEELHEART_API UFlightEffectsBudgetSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	// Add or remove a flyer whose effects are budgeted
+	void RegisterEffects(UFlightEffectsComponent* EffectsComponent);
+
+	void UnregisterEffects(UFlightEffectsComponent* EffectsComponent);
+
+	// Budget the sources of the shared trail system along with the dash trails of the flyers
+	void RegisterTrails(UFlightTrailSubsystem* TrailSubsystem);
+
+	/**
+	 * Restores an effect component to full quality and drops its budgeting state, before it is deactivated or goes back to the pool.
+	 *
+	 * @param Component The effect component.
+	 * @return The tier the component was held at, full if it was not budgeted.
+	 */
+	EFlightEffectTier ForgetEffect(USceneComponent* Component);
+
+	// Scale the full quality caps of every effect type, lowered by the local flyer at high speed
+	FORCEINLINE void SetDetailScale(float Scale) { DetailScale = Scale; }
+
+	// Log the tier of every budgeted effect instance
+	void LogReport() const;
+
+private:
+	// Budgeting state of one effect instance
+	struct FEffectState
+	{
+		EFlightEffectTier Tier = EFlightEffectTier::Full;
+
+		// Tier the instance is ranked into but has not held long enough to switch to
+		EFlightEffectTier PendingTier = EFlightEffectTier::Full;
+
+		float PendingSince = 0.f;
+
+		float Score = 0.f;
+
+		EFlightEffectType Type = EFlightEffectType::DashTrail;
+
+		uint32 LastSeenUpdate = 0;
+
+		// Offset of User.SpawnRateScale in the override parameters, cached for the system it was found in
+		int32 SpawnRateScaleOffset = INDEX_NONE;
+
+		const UNiagaraSystem* OffsetAsset = nullptr;
+	};
+
+	// Rank the active effects and move them between tiers
+	void UpdateBudget();
+
+	// Screen size based score of an effect instance as seen from the given view
+	float ScoreEffect(const FFlightBudgetedEffect& Effect, const FVector& ViewLocation, const FVector& ViewDirection, float ViewScale) const;
+
+	// Give the shared trail system the number of sources it may draw and the tier it draws them at
+	void UpdateTrailBudget(bool bBudgetEnabled);
+
+	// Move a gathered effect instance to a tier, stopping it instead if it is culled and not sustained
+	void SwitchTier(const FFlightBudgetedEffect& Effect, FEffectState& State, EFlightEffectTier Tier) const;
+
+	// Apply the quality of a tier to an effect instance
+	void ApplyTier(UFXSystemComponent* Component, FEffectState& State, EFlightEffectTier Tier) const;
+
+	/**
+	 * Finds the offset of User.SpawnRateScale in the override parameters of a Niagara component.
+	 *
+	 * @param Niagara The component, holding an initialized system.
+	 * @return The offset, or INDEX_NONE if the system does not expose the parameter.
+	 */
+	static int32 FindSpawnRateScaleOffset(UNiagaraComponent* Niagara);
+
+	TArray<TWeakObjectPtr<UFlightEffectsComponent>> RegisteredEffects;
+
+	TWeakObjectPtr<UFlightTrailSubsystem> SharedTrails;
+
+	// Budgeting state of the shared trail component, never culled as it draws every flyer
+	FEffectState TrailState;
+
+	TMap<TWeakObjectPtr<UFXSystemComponent>, FEffectState> EffectStates;
+
+	// Scratch list of the effects gathered on each update
+	TArray<FFlightBudgetedEffect> GatheredEffects;
+
+	float TimeSinceUpdate = 0.f;
+
+	float DetailScale = 1.f;
+
+	uint32 UpdateCount = 0;
+};
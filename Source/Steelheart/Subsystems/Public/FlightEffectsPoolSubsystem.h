@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FlightEffectsPoolSubsystem.generated.h"
+
+// Forward declarations
+class UAudioComponent;
+class UNiagaraComponent;
+class UNiagaraSystem;
+class USceneComponent;
+class USoundBase;
+class USoundConcurrency;
+struct FSoundConcurrencySettings;
+
+/**
+ * Recycled instances of one Niagara system.
+ */
+USTRUCT()
+struct FPooledNiagaraInstances
+{
+	GENERATED_BODY()
+
+	// Instances ready to be handed out
+	UPROPERTY()
+		TArray<UNiagaraComponent*> Free;
+
+	// Instances currently playing, oldest first
+	UPROPERTY()
+		TArray<UNiagaraComponent*> Active;
+
+	// Streamed groups the system was prewarmed for, the pool is dropped once none holds it anymore
+	int32 PrewarmRequests = 0;
+
+	int32 Spawned = 0;
+
+	int32 Reused = 0;
+
+	int32 Stolen = 0;
+};
+
+/**
+ * Recycled instances of one sound.
+ */
+USTRUCT()
+struct FPooledAudioInstances
+{
+	GENERATED_BODY()
+
+	// Instances ready to be handed out
+	UPROPERTY()
+		TArray<UAudioComponent*> Free;
+
+	// Instances currently playing, oldest first
+	UPROPERTY()
+		TArray<UAudioComponent*> Active;
+
+	// Streamed groups the sound was prewarmed for, the pool is dropped once none holds it anymore
+	int32 PrewarmRequests = 0;
+
+	int32 Spawned = 0;
+
+	int32 Reused = 0;
+
+	int32 Stolen = 0;
+};
+
+/**
+ * Idle effect components of one class, kept registered so reuse skips creation and registration.
+ */
+USTRUCT()
+struct FPooledSceneComponents
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<USceneComponent*> Free;
+};
+
+/**
+ * World level pool of the flight effects and sounds.
+ * Hands out prewarmed one-shot components that return to the pool by themselves once they finish playing,
+ * and recycles the attached effect components characters release when idle.
+ */
+UCLASS()
+class STEELHEART_API UFlightEffectsPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Plays a Niagara system at a world location using a pooled component.
+	 *
+	 * @param System The system to play.
+	 * @param Location World location of the effect.
+	 * @param Rotation World rotation of the effect.
+	 * @return The playing component, owned by the pool and released automatically when the system finishes.
+	 */
+	UNiagaraComponent* SpawnSystemAtLocation(UNiagaraSystem* System, FVector Location, FRotator Rotation = FRotator::ZeroRotator);
+
+	/**
+	 * Plays a sound attached to a component using a pooled audio component.
+	 *
+	 * @param Sound The sound to play.
+	 * @param AttachToComponent Component the sound follows while playing.
+	 * @param Concurrency Concurrency group limiting the voices of the sound, if any.
+	 * @param MaxDistance Distance from the listener past which the sound is not played at all, unlimited if zero.
+	 * @return The playing component, owned by the pool and released automatically when the sound finishes.
+	 */
+	UAudioComponent* SpawnSoundAttached(USoundBase* Sound, USceneComponent* AttachToComponent, USoundConcurrency* Concurrency = nullptr, float MaxDistance = 0.f);
+
+	/**
+	 * Finds or creates the concurrency group of the given name, shared by every flyer of the world.
+	 *
+	 * @param GroupName Name of the group.
+	 * @param Settings Settings of the group, only used when it is created.
+	 * @return The concurrency object of the group.
+	 */
+	USoundConcurrency* GetConcurrencyGroup(FName GroupName, const FSoundConcurrencySettings& Settings);
+
+	// Distance between a location and the audio listener of the first local player, or zero without a listener
+	float GetListenerDistance(const FVector& Location) const;
+
+	/**
+	 * Hands out an idle effect component of the given class, creating and registering one if none is free.
+	 *
+	 * @param ComponentClass Class of the effect component.
+	 * @param AttachToComponent Component the effect component is attached to, if any.
+	 * @return The component, inactive and without an asset.
+	 */
+	USceneComponent* AcquireComponent(TSubclassOf<USceneComponent> ComponentClass, USceneComponent* AttachToComponent);
+
+	template<typename T>
+	T* AcquireComponent(USceneComponent* AttachToComponent)
+	{
+		return Cast<T>(AcquireComponent(T::StaticClass(), AttachToComponent));
+	}
+
+	// Deactivate, detach and clear an effect component handed out by AcquireComponent and keep it for reuse
+	void ReleaseComponent(USceneComponent* Component);
+
+	// Create pooled instances of every Niagara system and sound among the given assets, up to the prewarm count
+	void PrewarmAssets(const TArray<FSoftObjectPath>& Assets);
+
+	// Undo a PrewarmAssets call, destroying the pools of the assets no other prewarm holds so they can be unloaded,
+	// along with the idle pools created on demand for assets never prewarmed
+	void ReleaseAssets(const TArray<FSoftObjectPath>& Assets);
+
+	// Log the state of the pools along with the garbage collection timings
+	void LogReport() const;
+
+private:
+	// Create a new pooled Niagara component for the given system
+	UNiagaraComponent* CreateNiagaraInstance(UNiagaraSystem* System);
+
+	// Create a new pooled audio component for the given sound
+	UAudioComponent* CreateAudioInstance(USoundBase* Sound);
+
+	// Return a finished Niagara component to its pool
+	UFUNCTION()
+		void ReleaseNiagara(UNiagaraComponent* NiagaraComponent);
+
+	// Return a finished audio component to its pool
+	void ReleaseAudio(UAudioComponent* AudioComponent);
+
+	// Destroy the pools created on demand, never prewarmed, with no instance playing
+	void DropIdleOnDemandPools();
+
+	// Destroy every instance of a dropped pool
+	template<typename T>
+	void DestroyInstances(const TArray<T*>& Free, const TArray<T*>& Active);
+
+	// Garbage collection timing callbacks
+	void HandlePreGarbageCollect();
+
+	void HandlePostGarbageCollect();
+
+	UPROPERTY()
+		TMap<UNiagaraSystem*, FPooledNiagaraInstances> NiagaraPools;
+
+	UPROPERTY()
+		TMap<USoundBase*, FPooledAudioInstances> AudioPools;
+
+	UPROPERTY()
+		TMap<UClass*, FPooledSceneComponents> ComponentPools;
+
+	// Transient concurrency objects of the flight sounds
+	UPROPERTY()
+		TMap<FName, USoundConcurrency*> ConcurrencyGroups;
+
+	int32 VirtualizedSounds = 0;
+
+	int32 ComponentsInUse = 0;
+
+	FDelegateHandle PreGarbageCollectHandle;
+	FDelegateHandle PostGarbageCollectHandle;
+
+	double GarbageCollectStartTime = 0.0;
+	double LastGarbageCollectTime = 0.0;
+	double TotalGarbageCollectTime = 0.0;
+
+	int32 GarbageCollectCount = 0;
+};
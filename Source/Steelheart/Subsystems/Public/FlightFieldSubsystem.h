@@ -0,0 +1,232 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Field/FieldSystemTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "FlightFieldSubsystem.generated.h"
+
+// Forward declarations
+class AFieldSystemActor;
+class UCullingField;
+class UOperatorField;
+class URadialFalloff;
+class URadialVector;
+
+/**
+ * Field nodes of one impact, built once and updated in place on every submission.
+ */
+USTRUCT()
+struct FFlightFieldGraph
+{
+	GENERATED_BODY()
+
+	// Strain falloff around the impact
+	UPROPERTY()
+		URadialFalloff* RadialFalloff = nullptr;
+
+	// Outward push from the impact
+	UPROPERTY()
+		URadialVector* RadialVector = nullptr;
+
+	// Push culled to the falloff radius
+	UPROPERTY()
+		UCullingField* CullingField = nullptr;
+
+	// Strain of this impact added to the strain of the previous impacts of the batch
+	UPROPERTY()
+		UOperatorField* StrainSum = nullptr;
+
+	// Push of this impact added to the push of the previous impacts of the batch
+	UPROPERTY()
+		UOperatorField* VelocitySum = nullptr;
+};
+
+/**
+ * Field nodes of one sphere of a masked field, a debris removal or a structural collapse, built once and updated in place on every submission.
+ */
+USTRUCT()
+struct FFlightMaskGraph
+{
+	GENERATED_BODY()
+
+	// Mask over the sphere
+	UPROPERTY()
+		URadialFalloff* RadialFalloff = nullptr;
+
+	// Mask of this sphere added to the masks of the previous spheres of the batch
+	UPROPERTY()
+		UOperatorField* Sum = nullptr;
+};
+
+/**
+ * World level submission of the Chaos fields of the dash impacts of every flyer.
+ * Impacts queued during a frame are coalesced and submitted together at the end of it as one strain field and one velocity field,
+ * built from field graphs kept between frames so an impact only updates node parameters.
+ * Landing shockwaves are checked for anything to act on by one asynchronous overlap each, then join the impacts of the frame their result arrives in.
+ * Debris removals and structural collapses are batched the same way into one kill field and one strain field,
+ * and the collections an impact reaches are handed to the debris subsystem.
+ */
+UCLASS()
+class STEELHEART_API UFlightFieldSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Queues an impact for the batched field submission of this frame.
+	 * Impacts overlapping one already queued are merged into it.
+	 *
+	 * @param Location Center of the impact.
+	 * @param Radius Radius of the impact.
+	 * @param StrainMagnitude Strain applied to the clusters at the center of the impact.
+	 * @param VelocityMagnitude Outward velocity given to the pieces within the radius.
+	 */
+	void QueueImpact(FVector Location, float Radius, float StrainMagnitude, float VelocityMagnitude);
+
+	/**
+	 * Queues a shockwave, submitted along with the impacts of a later frame once an asynchronous overlap has found anything within it.
+	 * Shockwaves of the same frame overlapping each other are merged before their overlap is issued.
+	 *
+	 * @param Location Center of the shockwave.
+	 * @param Radius Radius of the shockwave.
+	 * @param StrainMagnitude Strain applied to the clusters at the center of the shockwave.
+	 * @param VelocityMagnitude Outward velocity given to the pieces and physics props within the radius.
+	 */
+	void QueueShockwave(FVector Location, float Radius, float StrainMagnitude, float VelocityMagnitude);
+
+	/**
+	 * Queues the removal of the debris pieces within a sphere for the batched kill field of this frame.
+	 *
+	 * @param Location Center of the piece removed.
+	 * @param Radius Radius covering the piece.
+	 */
+	void QueueRemoval(FVector Location, float Radius);
+
+	/**
+	 * Queues the collapse of the pieces within a sphere for the batched strain field of this frame.
+	 * Unlike an impact, a collapse is never merged with another, so it reaches nothing but the pieces it covers.
+	 *
+	 * @param Location Center of the piece collapsing.
+	 * @param Radius Radius covering the piece.
+	 * @param StrainMagnitude Strain breaking the piece free of its cluster.
+	 */
+	void QueueCollapse(FVector Location, float Radius, float StrainMagnitude);
+
+	// Spawn the actor submitting the fields, and build the field graphs up to the given count
+	// Called ahead of expected impacts so the frame of the impact does not create them
+	void ReserveGraphs(int32 Count);
+
+	// Log the impacts submitted so far along with the number coalesced and skipped
+	void LogReport() const;
+
+private:
+	// Impact waiting for the next submission
+	struct FPendingImpact
+	{
+		FVector Location = FVector::ZeroVector;
+
+		float Radius = 0.f;
+
+		float StrainMagnitude = 0.f;
+
+		float VelocityMagnitude = 0.f;
+
+		// Number of impacts merged into this one
+		int32 Impacts = 0;
+
+		// Set once an overlap has found something within the radius, skipping the destructible query
+		bool bTargetsFound = false;
+	};
+
+	// Merge an impact into an overlapping or nearest pending one, or add it to the pending ones
+	// Returns true if it was merged
+	static bool AddImpact(TArray<FPendingImpact>& Pending, const FPendingImpact& Impact);
+
+	// Merge an impact into a pending one
+	static void MergeImpact(FPendingImpact& Into, const FPendingImpact& Impact);
+
+	// Issue the overlaps of the shockwaves queued this frame
+	void LaunchShockwaveOverlaps();
+
+	// Queue a shockwave as an impact once its overlap has found something within it
+	void HandleShockwaveOverlap(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum);
+
+	// Sphere of a masked field waiting for the next submission
+	struct FPendingMask
+	{
+		FSphere Sphere;
+
+		float Magnitude = 0.f;
+	};
+
+	// Chain the queued spheres of a masked field into one field of a type, returns the number submitted
+	int32 SubmitMasks(EFieldPhysicsType FieldType, TArray<FPendingMask>& Pending, TArray<FFlightMaskGraph>& MaskGraphs);
+
+	// Hand the collections within the submitted impacts to the debris subsystem, and record the impacts to the destruction journal
+	void TrackDebris();
+
+	// Spawn the actor submitting the fields if needed
+	bool EnsureFieldActor();
+
+	// True if there is anything for the field to act on within the radius of an impact
+	bool HasTargetsInRange(const FPendingImpact& Impact) const;
+
+	UPROPERTY()
+		AFieldSystemActor* FieldActor;
+
+	UPROPERTY()
+		TArray<FFlightFieldGraph> Graphs;
+
+	UPROPERTY()
+		TArray<FFlightMaskGraph> RemovalGraphs;
+
+	UPROPERTY()
+		TArray<FFlightMaskGraph> CollapseGraphs;
+
+	TArray<FPendingImpact> PendingImpacts;
+
+	// Shockwaves queued this frame, waiting for their overlap to be issued
+	TArray<FPendingImpact> PendingShockwaves;
+
+	// Shockwaves waiting for the result of their overlap
+	TArray<TPair<FTraceHandle, FPendingImpact>> OverlappingShockwaves;
+
+	FOverlapDelegate ShockwaveOverlapDelegate;
+
+	// Spheres of the debris pieces waiting for the next kill field
+	TArray<FPendingMask> PendingRemovals;
+
+	// Spheres of the collapsing pieces waiting for the next strain field
+	TArray<FPendingMask> PendingCollapses;
+
+	// Destructibles found within an impact, kept between frames so finding them does not allocate
+	TArray<AActor*> FoundDestructibles;
+
+	int32 QueuedImpacts = 0;
+
+	int32 CoalescedImpacts = 0;
+
+	int32 SkippedImpacts = 0;
+
+	int32 SubmittedImpacts = 0;
+
+	int32 Submissions = 0;
+
+	int32 SubmittedRemovals = 0;
+
+	int32 SubmittedCollapses = 0;
+
+	int32 QueuedShockwaves = 0;
+
+	// Shockwaves whose overlap found nothing to act on
+	int32 EmptyShockwaves = 0;
+};
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FlightImpactSubsystem.generated.h"
+
+// Forward declarations
+class UDecalComponent;
+class UMaterialInterface;
+class UProceduralMeshComponent;
+struct FProcMeshSection;
+
+/**
+ * One crater stamped on the ground.
+ */
+USTRUCT()
+struct FFlightImpactStamp
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		UDecalComponent* Decal = nullptr;
+
+	FVector Location = FVector::ZeroVector;
+
+	float Radius = 0.f;
+
+	// Number of landings merged into this stamp
+	int32 Impacts = 0;
+};
+
+/**
+ * World level crater stamping of the divebomb and hard landings.
+ * Stamps live in a fixed number of decals: landings close to an existing crater widen and refresh it,
+ * other landings recycle the least recently stamped one, so memory and draw calls stay flat over long sessions.
+ * Landings on procedural meshes also press a crater into their vertices.
+ */
+UCLASS()
+class STEELHEART_API UFlightImpactSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/**
+	 * Stamps a crater on the ground under a landing location.
+	 *
+	 * @param Location Landing location.
+	 * @param Radius Radius of the crater.
+	 * @param Depth Depth of the crater, used for the decal projection and the mesh deformation.
+	 * @param Material Decal material of the crater, or null to only deform the procedural mesh landed on.
+	 */
+	void StampImpact(FVector Location, float Radius, float Depth, UMaterialInterface* Material);
+
+	// Log the stamps along with the number of landings merged and recycled
+	void LogReport() const;
+
+private:
+	// Place the decal of a stamp
+	void UpdateStampDecal(FFlightImpactStamp& Stamp, const FVector& Normal, float Depth, UMaterialInterface* Material);
+
+	// Press a crater into the vertices of a procedural mesh, without adding any
+	void DeformProcMesh(UProceduralMeshComponent* ProcMesh, const FVector& Location, const FVector& Normal, float Radius, float Depth) const;
+
+	// Recompute the normals of the moved vertices and of the vertices sharing a triangle with them
+	static void RecomputeNormals(FProcMeshSection& Section, const TBitArray<>& Moved);
+
+	// Stamps ordered from the least to the most recently stamped
+	UPROPERTY()
+		TArray<FFlightImpactStamp> Stamps;
+
+	int32 MergedImpacts = 0;
+
+	int32 RecycledStamps = 0;
+};
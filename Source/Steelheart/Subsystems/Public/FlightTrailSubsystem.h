@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FlightTrailSubsystem.generated.h"
+
+// Forward declarations
+class UNiagaraComponent;
+class UNiagaraSystem;
+
+// Kinds of trail points written to the shared trail system
+enum class EFlightTrailKind : uint8
+{
+	DashTrail,
+	HoverPuff
+};
+
+/**
+ * World level renderer of the dash trails and hover puffs of every flyer.
+ * A single Niagara system instance is fed each frame through array data interfaces with one point per active trail source
+ * and one per pending puff, so the effect cost scales with the particles drawn rather than with the number of flyers.
+ */
+UCLASS()
+class STEELHEART_API UFlightTrailSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Sets the system drawing the shared trails. The first system set is kept for the lifetime of the world.
+	 *
+	 * @param System The shared trail system.
+	 * @return True if the given system is the one drawing the trails.
+	 */
+	bool SetTrailSystem(UNiagaraSystem* System);
+
+	/**
+	 * Starts writing a trail point following a component every frame.
+	 *
+	 * @param Source The component followed by the trail.
+	 * @param RelativeOffset Offset of the trail point in the space of the component.
+	 * @param Kind Kind of the trail.
+	 * @return Identifier of the trail source, also used as the ribbon identifier in the system.
+	 */
+	int32 AddTrailSource(USceneComponent* Source, FVector RelativeOffset, EFlightTrailKind Kind);
+
+	// Stop writing the trail point of a source added with AddTrailSource
+	void RemoveTrailSource(int32 SourceId);
+
+	// Write a single trail point on the next frame only
+	void AddPuff(FVector Location, FVector Velocity, EFlightTrailKind Kind);
+
+	// Set the number of trail sources the effects budget allows to be written, on top of the cap of the console variable
+	FORCEINLINE void SetBudgetedSources(int32 MaxSources) { BudgetedSources = MaxSources; }
+
+	// Get the component drawing the shared trails, null until a system is set
+	FORCEINLINE UNiagaraComponent* GetTrailComponent() const { return TrailComponent; }
+
+	// Get the number of trail sources followed, written or not
+	FORCEINLINE int32 GetSourceCount() const { return Sources.Num(); }
+
+	// Log the trail sources and the size of the arrays written each frame
+	void LogReport() const;
+
+private:
+	// Create and activate the shared trail component
+	void CreateTrailComponent(UNiagaraSystem* System);
+
+	// Keep the trail sources nearest to the view when there are more than the cap
+	void CullDistantSources(int32 MaxSources);
+
+	// Trail point followed every frame
+	struct FTrailSource
+	{
+		TWeakObjectPtr<USceneComponent> Component;
+
+		FVector RelativeOffset = FVector::ZeroVector;
+
+		EFlightTrailKind Kind = EFlightTrailKind::DashTrail;
+
+		int32 Id = INDEX_NONE;
+	};
+
+	// Trail point written for a single frame
+	struct FTrailPuff
+	{
+		FVector Location = FVector::ZeroVector;
+
+		FVector Velocity = FVector::ZeroVector;
+
+		EFlightTrailKind Kind = EFlightTrailKind::HoverPuff;
+	};
+
+	UPROPERTY()
+		UNiagaraComponent* TrailComponent;
+
+	TArray<FTrailSource> Sources;
+
+	TArray<FTrailPuff> PendingPuffs;
+
+	// Arrays written to the data interfaces, kept between frames so writing them does not allocate
+	TArray<FVector> Positions;
+
+	TArray<FVector> Velocities;
+
+	TArray<int32> Kinds;
+
+	TArray<int32> SourceIds;
+
+	// Indices of the sources written this frame
+	TArray<int32> WrittenSources;
+
+	int32 NextSourceId = 0;
+
+	// Trail sources allowed by the effects budget
+	int32 BudgetedSources = MAX_int32;
+
+	// True if the arrays written last frame were not empty
+	bool bWroteLastFrame = false;
+};
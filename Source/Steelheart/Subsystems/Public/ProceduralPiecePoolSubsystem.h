@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProceduralPiecePoolSubsystem.generated.h"
+
+// Forward declarations
+class UMaterialInterface;
+class UProceduralMeshComponent;
+struct FSlicerMesh;
+
+/**
+ * Piece handed out by the pool along with the actor it belongs to.
+ */
+USTRUCT()
+struct FPooledPiece
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		UProceduralMeshComponent* Piece = nullptr;
+
+	UPROPERTY()
+		TWeakObjectPtr<AActor> Owner;
+};
+
+/**
+ * World level pool of the procedural mesh pieces created by slicing and destruction.
+ * Pieces stay registered between uses and keep their section buffers, which are filled in place by the next user,
+ * so once the pool is warm, cutting a mesh creates no component and grows no buffer. Each piece in use belongs to
+ * an actor and returns to the pool when released, when that actor ends play, or once it falls below the kill plane
+ * or lies asleep out of sight. Past the piece budget, the oldest falling piece out of sight, or else asleep, is taken
+ * back for the new one.
+ */
+UCLASS()
+class STEELHEART_API UProceduralPiecePoolSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Hands out a visible piece, creating and registering one if none is free.
+	 *
+	 * @param Transform World transform of the piece.
+	 * @param Owner Actor the piece belongs to, released along with it when it ends play.
+	 * @param Template Mesh the collision settings of the piece are copied from, if any.
+	 * @return The piece, holding the sections of its previous use until they are written, or null past the piece budget
+	 * when no piece in use can be taken back.
+	 */
+	UProceduralMeshComponent* AcquirePiece(const FTransform& Transform, AActor* Owner, const UProceduralMeshComponent* Template = nullptr);
+
+	// Stop the simulation of a piece handed out by AcquirePiece, hide it and keep it for reuse
+	UFUNCTION(BlueprintCallable, Category = Slicing)
+		void ReleasePiece(UProceduralMeshComponent* Piece);
+
+	// Get the actor a piece in use belongs to, null for pieces the pool did not hand out
+	AActor* GetPieceOwner(const UProceduralMeshComponent* Piece) const;
+
+	/**
+	 * Writes a sliced mesh to a procedural mesh, reusing the buffers of its sections.
+	 *
+	 * @param ProcMesh The mesh written to, pooled or not.
+	 * @param Mesh The sliced mesh.
+	 * @param Source The mesh the materials of the sections are read from.
+	 * @param CapMaterial Material of the caps.
+	 */
+	void WriteSections(UProceduralMeshComponent* ProcMesh, const FSlicerMesh& Mesh, const UProceduralMeshComponent* Source, UMaterialInterface* CapMaterial);
+
+	// Log the pieces of the pool along with the components and buffers allocated and reused
+	void LogReport() const;
+
+private:
+	// Create a new registered piece
+	UProceduralMeshComponent* CreatePiece();
+
+	// Find the oldest simulated piece in use, other than the one given, that has been out of sight or else is asleep
+	UProceduralMeshComponent* FindRecyclablePiece(const UProceduralMeshComponent* Exclude) const;
+
+	// Release the simulated pieces below the kill plane or asleep out of sight
+	void ReleaseLostPieces();
+
+	// Release the pieces of an actor ending play
+	UFUNCTION()
+		void HandleOwnerEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	// Pieces ready to be handed out
+	UPROPERTY()
+		TArray<UProceduralMeshComponent*> Free;
+
+	// Pieces in use, oldest first
+	UPROPERTY()
+		TArray<FPooledPiece> Active;
+
+	int32 Created = 0;
+
+	int32 Reused = 0;
+
+	int32 Refused = 0;
+
+	int32 Released = 0;
+
+	int32 Recycled = 0;
+
+	int32 Lost = 0;
+
+	float TimeSinceUpdate = 0.f;
+
+	int32 SectionWrites = 0;
+
+	int32 BufferAllocations = 0;
+};
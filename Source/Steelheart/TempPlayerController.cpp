@@ -3,26 +3,38 @@
 
 #include "TempPlayerController.h"
 #include "ProceduralMeshComponent.h"
+#include "Steelheart/Subsystems/Public/ProceduralPiecePoolSubsystem.h"
 
 UProceduralMeshComponent* ATempPlayerController::CreateProceduralMeshComponent(AActor* Owning, const FName& AttachSocket)
 {
-	FName YourObjectName("Proc");
-
-	//CompClass can be a BP
-	UProceduralMeshComponent* ProcComp = NewObject<UProceduralMeshComponent>(Owning, UProceduralMeshComponent::StaticClass(), YourObjectName);
+	UProceduralPiecePoolSubsystem* PiecePool = GetWorld()->GetSubsystem<UProceduralPiecePoolSubsystem>();
+	if (!PiecePool || !Owning)
+	{
+		return NULL;
+	}
 
+	//Pieces come registered from the pool and go back to it when Owning ends play, none past its budget unless a fallen one can be taken back
+	UProceduralMeshComponent* ProcComp = PiecePool->AcquirePiece(Owning->GetActorTransform(), Owning);
 	if (!ProcComp)
 	{
 		return NULL;
 	}
-	//~~~~~~~~~~~~~
 
-	ProcComp->RegisterComponent();        //You must ConstructObject with a valid Outer that has world, see above	 
-	
 	FAttachmentTransformRules AttachmentTransformRules(EAttachmentRule::SnapToTarget, false);
 	ProcComp->AttachToComponent(Owning->GetDefaultAttachComponent(), AttachmentTransformRules, AttachSocket);
-	Owning->AddInstanceComponent(ProcComp);
 	//could use different than Root Comp
 
 	return ProcComp;
 }
+
+void ATempPlayerController::ReleaseProceduralMeshComponent(UProceduralMeshComponent* ProcComp)
+{
+	UProceduralPiecePoolSubsystem* PiecePool = GetWorld()->GetSubsystem<UProceduralPiecePoolSubsystem>();
+	if (!PiecePool)
+	{
+		return;
+	}
+
+	//Hidden and kept for the next CreateProceduralMeshComponent instead of destroyed
+	PiecePool->ReleasePiece(ProcComp);
+}
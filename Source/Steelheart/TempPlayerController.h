@@ -6,6 +6,8 @@
 #include "GameFramework/PlayerController.h"
 #include "TempPlayerController.generated.h"
 
+class UProceduralMeshComponent;
+
 /**
  * 
  */
@@ -17,4 +19,7 @@ class STEELHEART_API ATempPlayerController : public APlayerController
 public:
 	UFUNCTION(BlueprintCallable)
 	UProceduralMeshComponent* CreateProceduralMeshComponent(AActor* Owning, const FName& AttachSocket = NAME_None);
+
+	UFUNCTION(BlueprintCallable)
+	void ReleaseProceduralMeshComponent(UProceduralMeshComponent* ProcComp);
 };